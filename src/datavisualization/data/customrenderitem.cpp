@@ -49,8 +49,16 @@ CustomRenderItem::CustomRenderItem()
       m_textureWidth(0),
       m_textureHeight(0),
       m_textureDepth(0),
+      m_levelWidth(0),
+      m_levelHeight(0),
+      m_levelDepth(0),
+      m_levelOfDetail(0),
+      m_interactiveTexture(0),
       m_isVolume(false),
       m_textureFormat(QImage::Format_ARGB32),
+      m_sampleFormat(QCustom3DVolume::SampleFormatImage),
+      m_windowLevel(0.5f),
+      m_windowWidth(1.0f),
       m_sliceIndexX(-1),
       m_sliceIndexY(-1),
       m_sliceIndexZ(-1),
@@ -58,8 +66,9 @@ CustomRenderItem::CustomRenderItem()
       m_preserveOpacity(true),
       m_useHighDefShader(true),
       m_drawSlices(false),
-      m_drawSliceFrames(false)
-
+      m_drawSliceFrames(false),
+      m_brickTexture(0),
+      m_occupiedMax(oneVector)
 {
 }
 
@@ -89,6 +98,18 @@ void CustomRenderItem::setColorTable(const QVector<QRgb> &colors)
     }
 }
 
+// Returns the offset and the scale that map the sampled texel value into the color table
+QVector2D CustomRenderItem::valueWindow() const
+{
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatImage)
+        return QVector2D(0.0f, 1.0f);
+
+    // 16-bit textures are normalized when sampled
+    float range = (m_sampleFormat == QCustom3DVolume::SampleFormatUInt16) ? 65535.0f : 1.0f;
+    float windowStart = m_windowLevel - m_windowWidth / 2.0f;
+    return QVector2D(windowStart / range, range / m_windowWidth);
+}
+
 void CustomRenderItem::setMinBounds(const QVector3D &bounds)
 {
     m_minBounds = bounds;
@@ -107,6 +128,47 @@ void CustomRenderItem::setMaxBounds(const QVector3D &bounds)
     m_maxBoundsNormal = 0.5f * (m_maxBoundsNormal + oneVector);
 }
 
+void CustomRenderItem::setBricks(const QVector<uchar> &occupancy, int countX, int countY,
+                                 int countZ, const QVector3D &brickSize)
+{
+    m_brickSize = brickSize;
+    m_brickCount = QVector3D(float(countX), float(countY), float(countZ));
+
+    // Find the box that contains all occupied bricks
+    int minX = countX;
+    int minY = countY;
+    int minZ = countZ;
+    int maxX = -1;
+    int maxY = -1;
+    int maxZ = -1;
+    int index = 0;
+    for (int z = 0; z < countZ; z++) {
+        for (int y = 0; y < countY; y++) {
+            for (int x = 0; x < countX; x++) {
+                if (occupancy.at(index++)) {
+                    minX = qMin(minX, x);
+                    minY = qMin(minY, y);
+                    minZ = qMin(minZ, z);
+                    maxX = qMax(maxX, x);
+                    maxY = qMax(maxY, y);
+                    maxZ = qMax(maxZ, z);
+                }
+            }
+        }
+    }
+    if (maxX < 0) {
+        // Nothing visible, so every ray is discarded
+        m_occupiedMin = QVector3D();
+        m_occupiedMax = QVector3D();
+    } else {
+        m_occupiedMin = QVector3D(minX * brickSize.x(), minY * brickSize.y(),
+                                  minZ * brickSize.z());
+        m_occupiedMax = QVector3D(qMin(1.0f, (maxX + 1) * brickSize.x()),
+                                  qMin(1.0f, (maxY + 1) * brickSize.y()),
+                                  qMin(1.0f, (maxZ + 1) * brickSize.z()));
+    }
+}
+
 void CustomRenderItem::setSliceFrameColor(const QColor &color)
 {
     const QRgb &rgb = color.rgba();
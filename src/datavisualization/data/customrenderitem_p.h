@@ -42,9 +42,11 @@
 
 #include "abstractrenderitem_p.h"
 #include "objecthelper_p.h"
+#include "qcustom3dvolume.h"
 #include <QtGui/QRgb>
 #include <QtGui/QImage>
 #include <QtGui/QColor>
+#include <QtGui/QVector2D>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -99,6 +101,24 @@ public:
     inline void setTextureDepth(int depth) { m_textureDepth = depth; setSliceIndexZ(m_sliceIndexZ); }
     inline int textureDepth() const { return m_textureDepth; }
     inline int textureSize() const { return m_textureWidth * m_textureHeight * m_textureDepth; }
+    inline void setLevelDimensions(int width, int height, int depth)
+    {
+        m_levelWidth = width;
+        m_levelHeight = height;
+        m_levelDepth = depth;
+    }
+    inline int levelWidth() const { return m_levelWidth; }
+    inline int levelHeight() const { return m_levelHeight; }
+    inline int levelDepth() const { return m_levelDepth; }
+    inline void setLevelOfDetail(int level) { m_levelOfDetail = level; }
+    inline int levelOfDetail() const { return m_levelOfDetail; }
+    inline void setInteractiveTexture(GLuint texture) { m_interactiveTexture = texture; }
+    inline GLuint interactiveTexture() const { return m_interactiveTexture; }
+    inline void setInteractiveDimensions(int width, int height, int depth)
+    {
+        m_interactiveDimensions = QVector3D(width, height, depth);
+    }
+    inline const QVector3D &interactiveDimensions() const { return m_interactiveDimensions; }
     inline void setColorTable(const QVector<QVector4D> &colors) { m_colorTable = colors; }
     void setColorTable(const QVector<QRgb> &colors);
     inline const QVector<QVector4D> &colorTable() const { return m_colorTable; }
@@ -106,6 +126,15 @@ public:
     inline bool isVolume() const { return m_isVolume; }
     inline void setTextureFormat(QImage::Format format) { m_textureFormat = format; }
     inline QImage::Format textureFormat() const { return m_textureFormat; }
+    inline void setSampleFormat(QCustom3DVolume::SampleFormat format) { m_sampleFormat = format; }
+    inline QCustom3DVolume::SampleFormat sampleFormat() const { return m_sampleFormat; }
+    inline bool isColorTableUsed() const
+    {
+        return m_sampleFormat != QCustom3DVolume::SampleFormatImage
+                || m_textureFormat == QImage::Format_Indexed8;
+    }
+    inline void setWindow(float level, float width) { m_windowLevel = level; m_windowWidth = width; }
+    QVector2D valueWindow() const;
     inline void setSliceIndexX(int index)
     {
         m_sliceIndexX = index;
@@ -149,6 +178,14 @@ public:
     inline const QVector3D &sliceFrameGaps() const { return m_sliceFrameGaps; }
     inline void setSliceFrameThicknesses(const QVector3D &thicknesses) { m_sliceFrameThicknesses = thicknesses; }
     inline const QVector3D &sliceFrameThicknesses() const { return m_sliceFrameThicknesses; }
+    inline void setBrickTexture(GLuint texture) { m_brickTexture = texture; }
+    inline GLuint brickTexture() const { return m_brickTexture; }
+    void setBricks(const QVector<uchar> &occupancy, int countX, int countY, int countZ,
+                   const QVector3D &brickSize);
+    inline const QVector3D &brickSize() const { return m_brickSize; }
+    inline const QVector3D &brickCount() const { return m_brickCount; }
+    inline const QVector3D &occupiedMin() const { return m_occupiedMin; }
+    inline const QVector3D &occupiedMax() const { return m_occupiedMax; }
 
 private:
     Q_DISABLE_COPY(CustomRenderItem)
@@ -175,9 +212,18 @@ private:
     int m_textureWidth;
     int m_textureHeight;
     int m_textureDepth;
+    int m_levelWidth; // Dimensions of the uploaded level of detail
+    int m_levelHeight;
+    int m_levelDepth;
+    int m_levelOfDetail;
+    GLuint m_interactiveTexture; // Downsampled texture used while the camera moves
+    QVector3D m_interactiveDimensions;
     QVector<QVector4D> m_colorTable;
     bool m_isVolume;
     QImage::Format m_textureFormat;
+    QCustom3DVolume::SampleFormat m_sampleFormat;
+    float m_windowLevel;
+    float m_windowWidth;
     int m_sliceIndexX;
     int m_sliceIndexY;
     int m_sliceIndexZ;
@@ -195,6 +241,11 @@ private:
     QVector3D m_sliceFrameWidths;
     QVector3D m_sliceFrameGaps;
     QVector3D m_sliceFrameThicknesses;
+    GLuint m_brickTexture;
+    QVector3D m_brickSize; // In texture coordinates
+    QVector3D m_brickCount;
+    QVector3D m_occupiedMin; // Box of the bricks with visible texels, in texture coordinates
+    QVector3D m_occupiedMax;
 };
 typedef QHash<QCustom3DItem *, CustomRenderItem *> CustomRenderItemArray;
 
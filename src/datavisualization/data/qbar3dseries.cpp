@@ -29,6 +29,7 @@
 
 #include "qbar3dseries_p.h"
 #include "bars3dcontroller_p.h"
+#include "qbardataproxy_p.h"
 #include <QtCore/qmath.h>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
@@ -382,7 +383,8 @@ void QBar3DSeriesPrivate::createItemLabel()
     QCategory3DAxis *categoryAxisZ = static_cast<QCategory3DAxis *>(m_controller->axisZ());
     QCategory3DAxis *categoryAxisX = static_cast<QCategory3DAxis *>(m_controller->axisX());
     QValue3DAxis *valueAxis = static_cast<QValue3DAxis *>(m_controller->axisY());
-    qreal selectedBarValue = qreal(qptr()->dataProxy()->itemAt(m_selectedBar)->value());
+    qreal selectedBarValue = qreal(qptr()->dataProxy()->dptrc()->item(m_selectedBar.x(),
+                                                                      m_selectedBar.y()).value());
 
     // Custom format expects printf format specifier. There is no tag for it.
     m_itemLabel = valueAxis->formatter()->stringForValue(selectedBarValue, m_itemLabelFormat);
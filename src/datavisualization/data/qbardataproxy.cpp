@@ -56,6 +56,10 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
  * This enables the option of having row labels that relate to the position of the data in the
  * array rather than the data itself.
  *
+ * Rows of equal length without rotated bars can instead be given as a value array with
+ * resetValueArray(). The values are stored row by row in one contiguous vector, and
+ * changing rows or items only touches the affected values.
+ *
  * \sa {Qt Data Visualization Data Handling}
  */
 
@@ -191,6 +195,65 @@ void QBarDataProxy::resetArray(QBarDataArray *newArray, const QStringList &rowLa
     emit rowCountChanged(rowCount());
 }
 
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Resets the proxy to a value array. The bar \a values of rows with
+ * \a columnCount columns are stored row by row, so the number of values must be
+ * a multiple of \a columnCount.
+ *
+ * Only the values are stored, in one contiguous vector instead of a separately
+ * allocated row per bar row. Rows and items set, added, or inserted later are
+ * copied into the vector as long as they have \a columnCount items and none of
+ * the bars is rotated. Otherwise the value array is converted to an item array
+ * first, emitting arrayReset(). Accessing the data with array(), rowAt(), or
+ * itemAt() creates the items of the whole array.
+ *
+ * \note Once created, the items are kept up to date with the values, so the
+ * rows returned by array() and rowAt() stay valid when rows are added or
+ * inserted, like with an item array. A row becomes invalid when it is set,
+ * removed, or when the array is reset.
+ *
+ * \sa valueArray()
+ */
+void QBarDataProxy::resetValueArray(const QVector<float> &values, int columnCount)
+{
+    dptr()->resetValueArray(values, columnCount, 0, 0);
+    emit arrayReset();
+    emit rowCountChanged(rowCount());
+}
+
+/*!
+ * \since QtDataVisualization 1.4
+ * \overload resetValueArray()
+ *
+ * Resets the proxy to a value array of \a values with \a columnCount columns,
+ * and replaces the row and column labels with \a rowLabels and \a columnLabels.
+ */
+void QBarDataProxy::resetValueArray(const QVector<float> &values, int columnCount,
+                                    const QStringList &rowLabels,
+                                    const QStringList &columnLabels)
+{
+    dptr()->resetValueArray(values, columnCount, &rowLabels, &columnLabels);
+    emit arrayReset();
+    emit rowCountChanged(rowCount());
+}
+
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Returns the pointer to the value array, or \c nullptr if the proxy holds an
+ * item array.
+ *
+ * \sa resetValueArray()
+ */
+const QVector<float> *QBarDataProxy::valueArray() const
+{
+    if (!dptrc()->isValueArray())
+        return nullptr;
+    return &dptrc()->m_values;
+}
+
 /*!
  * Changes an existing row by replacing the row at the position \a rowIndex
  * with the new row specified by \a row. The new row can be
@@ -390,7 +453,7 @@ void QBarDataProxy::removeRows(int rowIndex, int removeCount, bool removeLabels)
  */
 int QBarDataProxy::rowCount() const
 {
-    return dptrc()->m_dataArray->size();
+    return dptrc()->rowCount();
 }
 
 /*!
@@ -440,7 +503,7 @@ void QBarDataProxy::setColumnLabels(const QStringList &labels)
  */
 const QBarDataArray *QBarDataProxy::array() const
 {
-    return dptrc()->m_dataArray;
+    return dptrc()->itemArray();
 }
 
 /*!
@@ -449,7 +512,7 @@ const QBarDataArray *QBarDataProxy::array() const
  */
 const QBarDataRow *QBarDataProxy::rowAt(int rowIndex) const
 {
-    const QBarDataArray &dataArray = *dptrc()->m_dataArray;
+    const QBarDataArray &dataArray = *dptrc()->itemArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex < dataArray.size());
     return dataArray[rowIndex];
 }
@@ -461,7 +524,7 @@ const QBarDataRow *QBarDataProxy::rowAt(int rowIndex) const
  */
 const QBarDataItem *QBarDataProxy::itemAt(int rowIndex, int columnIndex) const
 {
-    const QBarDataArray &dataArray = *dptrc()->m_dataArray;
+    const QBarDataArray &dataArray = *dptrc()->itemArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex < dataArray.size());
     const QBarDataRow &dataRow = *dataArray[rowIndex];
     Q_ASSERT(columnIndex >= 0 && columnIndex < dataRow.size());
@@ -554,7 +617,9 @@ const QBarDataProxyPrivate *QBarDataProxy::dptrc() const
 
 QBarDataProxyPrivate::QBarDataProxyPrivate(QBarDataProxy *q)
     : QAbstractDataProxyPrivate(q, QAbstractDataProxy::DataTypeBar),
-      m_dataArray(new QBarDataArray)
+      m_dataArray(new QBarDataArray),
+      m_valueColumnCount(0),
+      m_itemsCreated(false)
 {
 }
 
@@ -578,14 +643,92 @@ void QBarDataProxyPrivate::resetArray(QBarDataArray *newArray, const QStringList
         clearArray();
         m_dataArray = newArray;
     }
+    m_values.clear();
+    m_valueColumnCount = 0;
+    m_itemsCreated = false;
+}
+
+void QBarDataProxyPrivate::resetValueArray(const QVector<float> &values, int columnCount,
+                                           const QStringList *rowLabels,
+                                           const QStringList *columnLabels)
+{
+    resetArray(0, rowLabels, columnLabels);
+
+    if (values.size()) {
+        Q_ASSERT(columnCount > 0 && values.size() % columnCount == 0);
+        m_values = values;
+        m_valueColumnCount = columnCount;
+    }
+}
+
+// Returns the item array, creating the items of the value array on the first call
+const QBarDataArray *QBarDataProxyPrivate::itemArray() const
+{
+    if (isValueArray() && !m_itemsCreated) {
+        m_itemsCreated = true;
+        const int rows = rowCount();
+        const float *values = m_values.constData();
+        m_dataArray->reserve(rows);
+        for (int i = 0; i < rows; i++) {
+            QBarDataRow *row = new QBarDataRow(m_valueColumnCount);
+            for (int j = 0; j < m_valueColumnCount; j++)
+                (*row)[j].setValue(*values++);
+            m_dataArray->append(row);
+        }
+    }
+    return m_dataArray;
+}
+
+int QBarDataProxyPrivate::rowCount() const
+{
+    if (isValueArray())
+        return m_values.size() / m_valueColumnCount;
+    return m_dataArray->size();
+}
+
+int QBarDataProxyPrivate::rowSize(int rowIndex) const
+{
+    if (isValueArray())
+        return m_valueColumnCount;
+    const QBarDataRow *row = m_dataArray->at(rowIndex);
+    return row ? row->size() : 0;
+}
+
+int QBarDataProxyPrivate::maxRowSize() const
+{
+    if (isValueArray())
+        return m_valueColumnCount;
+    int maxSize = 0;
+    for (int i = 0; i < m_dataArray->size(); i++) {
+        const QBarDataRow *row = m_dataArray->at(i);
+        if (row && maxSize < row->size())
+            maxSize = row->size();
+    }
+    return maxSize;
+}
+
+QBarDataItem QBarDataProxyPrivate::item(int rowIndex, int columnIndex) const
+{
+    Q_ASSERT(rowIndex >= 0 && rowIndex < rowCount());
+    Q_ASSERT(columnIndex >= 0 && columnIndex < rowSize(rowIndex));
+    if (isValueArray())
+        return QBarDataItem(m_values.at(rowIndex * m_valueColumnCount + columnIndex));
+    return m_dataArray->at(rowIndex)->at(columnIndex);
 }
 
 void QBarDataProxyPrivate::setRow(int rowIndex, QBarDataRow *row, const QString *label)
 {
-    Q_ASSERT(rowIndex >= 0 && rowIndex < m_dataArray->size());
+    Q_ASSERT(rowIndex >= 0 && rowIndex < rowCount());
 
     if (label)
         fixRowLabels(rowIndex, 1, QStringList(*label), false);
+    if (isValueArray()) {
+        if (fitsValueArray(row)) {
+            storeRowValues(rowIndex, row);
+            return;
+        }
+        convertValueArray();
+    }
     if (row != m_dataArray->at(rowIndex)) {
         clearRow(rowIndex);
         (*m_dataArray)[rowIndex] = row;
@@ -596,9 +739,17 @@ void QBarDataProxyPrivate::setRows(int rowIndex, const QBarDataArray &rows,
                                    const QStringList *labels)
 {
     QBarDataArray &dataArray = *m_dataArray;
-    Q_ASSERT(rowIndex >= 0 && (rowIndex + rows.size()) <= dataArray.size());
+    Q_ASSERT(rowIndex >= 0 && (rowIndex + rows.size()) <= rowCount());
     if (labels)
         fixRowLabels(rowIndex, rows.size(), *labels, false);
+    if (isValueArray()) {
+        if (fitsValueArray(rows)) {
+            for (int i = 0; i < rows.size(); i++)
+                storeRowValues(rowIndex + i, rows.at(i));
+            return;
+        }
+        convertValueArray();
+    }
     for (int i = 0; i < rows.size(); i++) {
         if (rows.at(i) != dataArray.at(rowIndex)) {
             clearRow(rowIndex);
@@ -610,6 +761,17 @@ void QBarDataProxyPrivate::setRows(int rowIndex, const QBarDataArray &rows,
 
 void QBarDataProxyPrivate::setItem(int rowIndex, int columnIndex, const QBarDataItem &item)
 {
+    if (isValueArray()) {
+        if (item.rotation() == 0.0f) {
+            Q_ASSERT(rowIndex >= 0 && rowIndex < rowCount());
+            Q_ASSERT(columnIndex >= 0 && columnIndex < m_valueColumnCount);
+            m_values[rowIndex * m_valueColumnCount + columnIndex] = item.value();
+            if (m_itemsCreated)
+                (*(*m_dataArray)[rowIndex])[columnIndex] = item;
+            return;
+        }
+        convertValueArray();
+    }
     Q_ASSERT(rowIndex >= 0 && rowIndex < m_dataArray->size());
     QBarDataRow &row = *(*m_dataArray)[rowIndex];
     Q_ASSERT(columnIndex < row.size());
@@ -618,18 +780,39 @@ void QBarDataProxyPrivate::setItem(int rowIndex, int columnIndex, const QBarData
 
 int QBarDataProxyPrivate::addRow(QBarDataRow *row, const QString *label)
 {
-    int currentSize = m_dataArray->size();
+    int currentSize = rowCount();
     if (label)
         fixRowLabels(currentSize, 1, QStringList(*label), false);
+    if (isValueArray()) {
+        if (fitsValueArray(row)) {
+            m_values.resize(m_values.size() + m_valueColumnCount);
+            if (m_itemsCreated)
+                m_dataArray->append(0);
+            storeRowValues(currentSize, row);
+            return currentSize;
+        }
+        convertValueArray();
+    }
     m_dataArray->append(row);
     return currentSize;
 }
 
 int QBarDataProxyPrivate::addRows(const QBarDataArray &rows, const QStringList *labels)
 {
-    int currentSize = m_dataArray->size();
+    int currentSize = rowCount();
     if (labels)
         fixRowLabels(currentSize, rows.size(), *labels, false);
+    if (isValueArray()) {
+        if (fitsValueArray(rows)) {
+            m_values.resize(m_values.size() + rows.size() * m_valueColumnCount);
+            if (m_itemsCreated)
+                m_dataArray->resize(m_dataArray->size() + rows.size());
+            for (int i = 0; i < rows.size(); i++)
+                storeRowValues(currentSize + i, rows.at(i));
+            return currentSize;
+        }
+        convertValueArray();
+    }
     for (int i = 0; i < rows.size(); i++)
         m_dataArray->append(rows.at(i));
     return currentSize;
@@ -637,18 +820,40 @@ int QBarDataProxyPrivate::addRows(const QBarDataArray &rows, const QStringList *
 
 void QBarDataProxyPrivate::insertRow(int rowIndex, QBarDataRow *row, const QString *label)
 {
-    Q_ASSERT(rowIndex >= 0 && rowIndex <= m_dataArray->size());
+    Q_ASSERT(rowIndex >= 0 && rowIndex <= rowCount());
     if (label)
         fixRowLabels(rowIndex, 1, QStringList(*label), true);
+    if (isValueArray()) {
+        if (fitsValueArray(row)) {
+            m_values.insert(rowIndex * m_valueColumnCount, m_valueColumnCount, 0.0f);
+            if (m_itemsCreated)
+                m_dataArray->insert(rowIndex, 0);
+            storeRowValues(rowIndex, row);
+            return;
+        }
+        convertValueArray();
+    }
     m_dataArray->insert(rowIndex, row);
 }
 
 void QBarDataProxyPrivate::insertRows(int rowIndex, const QBarDataArray &rows,
                                       const QStringList *labels)
 {
-    Q_ASSERT(rowIndex >= 0 && rowIndex <= m_dataArray->size());
+    Q_ASSERT(rowIndex >= 0 && rowIndex <= rowCount());
     if (labels)
         fixRowLabels(rowIndex, rows.size(), *labels, true);
+    if (isValueArray()) {
+        if (fitsValueArray(rows)) {
+            m_values.insert(rowIndex * m_valueColumnCount, rows.size() * m_valueColumnCount,
+                            0.0f);
+            if (m_itemsCreated)
+                m_dataArray->insert(rowIndex, rows.size(), 0);
+            for (int i = 0; i < rows.size(); i++)
+                storeRowValues(rowIndex + i, rows.at(i));
+            return;
+        }
+        convertValueArray();
+    }
     for (int i = 0; i < rows.size(); i++)
         m_dataArray->insert(rowIndex++, rows.at(i));
 }
@@ -656,12 +861,18 @@ void QBarDataProxyPrivate::insertRows(int rowIndex, const QBarDataArray &rows,
 void QBarDataProxyPrivate::removeRows(int rowIndex, int removeCount, bool removeLabels)
 {
     Q_ASSERT(rowIndex >= 0);
-    int maxRemoveCount = m_dataArray->size() - rowIndex;
+    int maxRemoveCount = rowCount() - rowIndex;
     removeCount = qMin(removeCount, maxRemoveCount);
+    bool valueArray = isValueArray();
+    if (valueArray)
+        m_values.remove(rowIndex * m_valueColumnCount, removeCount * m_valueColumnCount);
+    bool removeItems = !valueArray || m_itemsCreated;
     bool labelsChanged = false;
     for (int i = 0; i < removeCount; i++) {
-        clearRow(rowIndex);
-        m_dataArray->removeAt(rowIndex);
+        if (removeItems) {
+            clearRow(rowIndex);
+            m_dataArray->removeAt(rowIndex);
+        }
         if (removeLabels && m_rowLabels.size() > rowIndex) {
             m_rowLabels.removeAt(rowIndex);
             labelsChanged = true;
@@ -676,6 +887,57 @@ QBarDataProxy *QBarDataProxyPrivate::qptr()
     return static_cast<QBarDataProxy *>(q_ptr);
 }
 
+// The value array can hold full rows of bars that are not rotated
+bool QBarDataProxyPrivate::fitsValueArray(const QBarDataRow *row) const
+{
+    if (!row || row->size() != m_valueColumnCount)
+        return false;
+    for (int i = 0; i < row->size(); i++) {
+        if (row->at(i).rotation() != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool QBarDataProxyPrivate::fitsValueArray(const QBarDataArray &rows) const
+{
+    for (int i = 0; i < rows.size(); i++) {
+        if (!fitsValueArray(rows.at(i)))
+            return false;
+    }
+    return true;
+}
+
+// Copies the values of the row into the value array. The row is kept if the items of the value
+// array have been created, and deleted otherwise.
+void QBarDataProxyPrivate::storeRowValues(int rowIndex, QBarDataRow *row)
+{
+    float *values = m_values.data() + rowIndex * m_valueColumnCount;
+    for (int j = 0; j < m_valueColumnCount; j++)
+        values[j] = row->at(j).value();
+
+    if (!m_itemsCreated) {
+        delete row;
+    } else if (row != m_dataArray->at(rowIndex)) {
+        clearRow(rowIndex);
+        (*m_dataArray)[rowIndex] = row;
+    }
+}
+
+// Replaces the value array with the corresponding items, so that they can hold rotations and
+// rows of any length
+void QBarDataProxyPrivate::convertValueArray()
+{
+    if (!isValueArray())
+        return;
+
+    itemArray();
+    m_values.clear();
+    m_valueColumnCount = 0;
+    m_itemsCreated = false;
+    emit qptr()->arrayReset();
+}
+
 void QBarDataProxyPrivate::clearRow(int rowIndex)
 {
     if (m_dataArray->at(rowIndex)) {
@@ -762,6 +1024,20 @@ QPair<GLfloat, GLfloat> QBarDataProxyPrivate::limitValues(int startRow, int endR
                                                           int startColumn, int endColumn) const
 {
     QPair<GLfloat, GLfloat> limits = qMakePair(0.0f, 0.0f);
+    if (isValueArray()) {
+        endRow = qMin(endRow, rowCount() - 1);
+        endColumn = qMin(endColumn, m_valueColumnCount - 1);
+        for (int i = startRow; i <= endRow; i++) {
+            const float *values = m_values.constData() + i * m_valueColumnCount;
+            for (int j = startColumn; j <= endColumn; j++) {
+                if (limits.second < values[j])
+                    limits.second = values[j];
+                if (limits.first > values[j])
+                    limits.first = values[j];
+            }
+        }
+        return limits;
+    }
     endRow = qMin(endRow, m_dataArray->size() - 1);
     for (int i = startRow; i <= endRow; i++) {
         QBarDataRow *row = m_dataArray->at(i);
@@ -75,6 +75,11 @@ public:
     void resetArray(QBarDataArray *newArray, const QStringList &rowLabels,
                     const QStringList &columnLabels);
 
+    void resetValueArray(const QVector<float> &values, int columnCount);
+    void resetValueArray(const QVector<float> &values, int columnCount,
+                         const QStringList &rowLabels, const QStringList &columnLabels);
+    const QVector<float> *valueArray() const;
+
     void setRow(int rowIndex, QBarDataRow *row);
     void setRow(int rowIndex, QBarDataRow *row, const QString &label);
     void setRows(int rowIndex, const QBarDataArray &rows);
@@ -117,6 +122,8 @@ private:
     Q_DISABLE_COPY(QBarDataProxy)
 
     friend class Bars3DController;
+    friend class Bars3DRenderer;
+    friend class QBar3DSeriesPrivate;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -54,6 +54,18 @@ public:
 
     void resetArray(QBarDataArray *newArray, const QStringList *rowLabels,
                     const QStringList *columnLabels);
+    void resetValueArray(const QVector<float> &values, int columnCount,
+                         const QStringList *rowLabels, const QStringList *columnLabels);
+    const QBarDataArray *itemArray() const;
+    inline bool isValueArray() const { return m_valueColumnCount > 0; }
+    int rowCount() const;
+    int rowSize(int rowIndex) const;
+    int maxRowSize() const;
+    QBarDataItem item(int rowIndex, int columnIndex) const;
+    inline const float *rowValues(int rowIndex) const
+    {
+        return m_values.constData() + rowIndex * m_valueColumnCount;
+    }
     void setRow(int rowIndex, QBarDataRow *row, const QString *label);
     void setRows(int rowIndex, const QBarDataArray &rows, const QStringList *labels);
     void setItem(int rowIndex, int columnIndex, const QBarDataItem &item);
@@ -70,11 +82,19 @@ public:
 
 private:
     QBarDataProxy *qptr();
+    bool fitsValueArray(const QBarDataRow *row) const;
+    bool fitsValueArray(const QBarDataArray &rows) const;
+    void storeRowValues(int rowIndex, QBarDataRow *row);
+    void convertValueArray();
     void clearRow(int rowIndex);
     void clearArray();
     void fixRowLabels(int startIndex, int count, const QStringList &newLabels, bool isInsert);
 
-    QBarDataArray *m_dataArray;
+    QBarDataArray *m_dataArray; // Items created on demand from the value array, if any
+    QVector<float> m_values; // Bar values stored row by row in value array mode
+    int m_valueColumnCount; // Zero if the proxy holds an item array
+    // The items of the value array have been created, and are kept in step with the values
+    mutable bool m_itemsCreated;
     QStringList m_rowLabels;
     QStringList m_columnLabels;
 
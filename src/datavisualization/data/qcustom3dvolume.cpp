@@ -30,6 +30,10 @@
 #include "qcustom3dvolume_p.h"
 #include "utils_p.h"
 
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 /*!
@@ -47,6 +51,8 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
  * with the amount of pixels that the volume occupies on the screen, so showing the volume in a
  * smaller view or limiting the zoom level of the graph are easy ways to improve performance.
  * Similarly, the volume texture dimensions have a large impact on performance.
+ * Regions of the volume that are fully transparent after the color table lookup are skipped
+ * when ray-tracing, so sparse volumes render considerably faster than dense ones.
  * If the frame rate is more important than pixel-perfect rendering of the volume contents, consider
  * turning the high definition shader off by setting the useHighDefShader property to \c{false}.
  *
@@ -146,6 +152,52 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
  * \sa QCustom3DVolume::textureData, drawSlices, drawSliceFrames
  */
 
+/*!
+ * \qmlproperty Custom3DVolume.SampleFormat Custom3DVolume::sampleFormat
+ * \since QtDataVisualization 1.4
+ *
+ * The format of the samples in the texture data. If the format is anything else than
+ * \c{Custom3DVolume.SampleFormatImage}, each texel is a single scalar value that is mapped
+ * to a color of the colorTable through the window defined by windowLevel and windowWidth.
+ * Defaults to \c{Custom3DVolume.SampleFormatImage}.
+ *
+ * \sa windowLevel, windowWidth
+ */
+
+/*!
+ * \qmlproperty real Custom3DVolume::windowLevel
+ * \since QtDataVisualization 1.4
+ *
+ * The sample value at the center of the window that is mapped to the color table
+ * when sampleFormat is not \c{Custom3DVolume.SampleFormatImage}.
+ * Defaults to \c{0.5}.
+ *
+ * \sa windowWidth, sampleFormat
+ */
+
+/*!
+ * \qmlproperty real Custom3DVolume::windowWidth
+ * \since QtDataVisualization 1.4
+ *
+ * The range of sample values that is mapped to the color table
+ * when sampleFormat is not \c{Custom3DVolume.SampleFormatImage}.
+ * The value must be positive.
+ * Defaults to \c{1.0}.
+ *
+ * \sa windowLevel, sampleFormat
+ */
+
+/*!
+ * \qmlproperty int Custom3DVolume::textureMemoryBudget
+ * \since QtDataVisualization 1.4
+ *
+ * The maximum amount of graphics memory in megabytes used for the volume texture.
+ * If the texture data does not fit in the budget, the volume is rendered at a lower
+ * level of detail that does. The level is built in a background thread, and the volume is not
+ * drawn until it is ready. The value must not be negative, and \c{0} removes the limit.
+ * Defaults to \c{0}.
+ */
+
 /*!
  * \qmlproperty real Custom3DVolume::alphaMultiplier
  *
@@ -189,6 +241,22 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
  * Defaults to \c{true}.
  */
 
+/*!
+ * \qmlproperty int Custom3DVolume::interactiveDownsampling
+ * \since QtDataVisualization 1.4
+ *
+ * The factor by which the volume texture resolution is reduced while the camera moves.
+ * The full resolution texture is used again once the camera has been still for a short while.
+ * The texels of the downsampled texture are averages of the texels of the texture in use, with
+ * the colors of ARGB32 textures weighted by their alpha, or the most opaque of them for indexed
+ * textures.
+ * Valid values are \c{1}, \c{2}, \c{4}, and \c{8}. The value \c{1} disables downsampling.
+ *
+ * \note This value does not affect the rendering of the slices of the volume.
+ *
+ * Defaults to \c{1}.
+ */
+
 /*!
  * \qmlproperty bool Custom3DVolume::drawSlices
  *
@@ -312,8 +380,10 @@ void QCustom3DVolume::setTextureWidth(int value)
 {
     if (value >= 0) {
         if (dptr()->m_textureWidth != value) {
+            dptr()->discardTextureLevel();
             dptr()->m_textureWidth = value;
             dptr()->m_dirtyBitsVolume.textureDimensionsDirty = true;
+            dptr()->invalidateBricks();
             emit textureWidthChanged(value);
             emit dptr()->needUpdate();
         }
@@ -343,8 +413,10 @@ void QCustom3DVolume::setTextureHeight(int value)
 {
     if (value >= 0) {
         if (dptr()->m_textureHeight != value) {
+            dptr()->discardTextureLevel();
             dptr()->m_textureHeight = value;
             dptr()->m_dirtyBitsVolume.textureDimensionsDirty = true;
+            dptr()->invalidateBricks();
             emit textureHeightChanged(value);
             emit dptr()->needUpdate();
         }
@@ -375,8 +447,10 @@ void QCustom3DVolume::setTextureDepth(int value)
 {
     if (value >= 0) {
         if (dptr()->m_textureDepth != value) {
+            dptr()->discardTextureLevel();
             dptr()->m_textureDepth = value;
             dptr()->m_dirtyBitsVolume.textureDimensionsDirty = true;
+            dptr()->invalidateBricks();
             emit textureDepthChanged(value);
             emit dptr()->needUpdate();
         }
@@ -405,19 +479,13 @@ void QCustom3DVolume::setTextureDimensions(int width, int height, int depth)
 
 /*!
  * Returns the actual texture data width. When the texture format is QImage::Format_Indexed8,
- * this value equals textureWidth aligned to a 32-bit boundary. Otherwise, this
- * value equals four times textureWidth.
+ * this value equals textureWidth aligned to a 32-bit boundary. When sampleFormat is
+ * QCustom3DVolume::SampleFormatUInt16, this value equals two times textureWidth aligned to
+ * a 32-bit boundary. Otherwise, this value equals four times textureWidth.
  */
 int QCustom3DVolume::textureDataWidth() const
 {
-    int dataWidth = dptrc()->m_textureWidth;
-
-    if (dptrc()->m_textureFormat == QImage::Format_Indexed8)
-        dataWidth += dataWidth % 4;
-    else
-        dataWidth *= 4;
-
-    return dataWidth;
+    return dptrc()->lineSize(dptrc()->m_textureWidth);
 }
 
 /*! \property QCustom3DVolume::sliceIndexX
@@ -529,6 +597,7 @@ void QCustom3DVolume::setSliceIndices(int x, int y, int z)
 void QCustom3DVolume::setColorTable(const QVector<QRgb> &colors)
 {
     if (dptr()->m_colorTable != colors) {
+        dptr()->discardTextureLevel();
         dptr()->m_colorTable = colors;
         dptr()->m_dirtyBitsVolume.colorTableDirty = true;
         emit colorTableChanged();
@@ -566,19 +635,32 @@ QVector<QRgb> QCustom3DVolume::colorTable() const
  * count. The padding bytes should indicate a fully transparent color to avoid
  * rendering artifacts.
  *
+ * If sampleFormat is not QCustom3DVolume::SampleFormatImage, the array contains
+ * one native endian 16-bit unsigned integer or 32-bit float per texel instead,
+ * and textureFormat is ignored.
+ *
+ * Setting the texture data unmaps the file set with setTextureDataFile().
+ *
  * Defaults to \c{0}.
  *
- * \sa colorTable, setTextureFormat(), setSubTextureData(), textureDataWidth()
+ * \sa colorTable, setTextureFormat(), sampleFormat, setSubTextureData(), textureDataWidth()
  */
 void QCustom3DVolume::setTextureData(QVector<uchar> *data)
 {
+    dptr()->discardTextureLevel();
     if (dptr()->m_textureData != data)
         delete dptr()->m_textureData;
 
+    if (dptr()->m_textureDataFile) {
+        dptr()->unmapTextureDataFile();
+        emit textureDataFileChanged(QString());
+    }
+
     // Even if the pointer is same as previously, consider this property changed, as the values
     // can be changed unbeknownst to us via the array pointer.
     dptr()->m_textureData = data;
     dptr()->m_dirtyBitsVolume.textureDataDirty = true;
+    dptr()->invalidateBricks();
     emit textureDataChanged(data);
     emit dptr()->needUpdate();
 }
@@ -650,6 +732,7 @@ QVector<uchar> *QCustom3DVolume::createTextureData(const QVector<QImage *> &imag
             setColorTable(images.at(0)->colorTable());
         setTextureData(newTextureData);
         setTextureFormat(imageFormat);
+        setSampleFormat(SampleFormatImage);
         setTextureWidth(imageWidth);
         setTextureHeight(imageHeight);
         setTextureDepth(imageCount);
@@ -667,12 +750,74 @@ QVector<uchar> *QCustom3DVolume::textureData() const
     return dptrc()->m_textureData;
 }
 
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Maps the file \a fileName to memory and uses its contents as the texture data, starting
+ * at the byte \a offset. The file contents must be laid out like the textureData array,
+ * and the file must remain unchanged while it is mapped. The textureData property is
+ * deleted and set to \c{0}.
+ *
+ * The file is read to memory by the operating system as its pages are accessed, so volumes
+ * that are too large to load to memory can be shown. When the full resolution texture does not
+ * fit in textureMemoryBudget or exceeds the maximum 3D texture size of the graphics hardware,
+ * the volume is rendered at a lower level of detail that does. The level is point sampled from
+ * every second, fourth, or further line of every second, fourth, or further slice of the file,
+ * so the pages of the file that contain no sampled lines are not read. Otherwise the whole file is
+ * read when the texture is created.
+ * setSubTextureData() cannot be used with a mapped file.
+ *
+ * Returns \c true if the file could be mapped. Otherwise, the volume has no texture
+ * data afterwards.
+ *
+ * \sa textureDataFile(), textureMemoryBudget, textureData
+ */
+bool QCustom3DVolume::setTextureDataFile(const QString &fileName, qint64 offset)
+{
+    dptr()->discardTextureLevel();
+    delete dptr()->m_textureData;
+    dptr()->m_textureData = 0;
+
+    bool mapped = dptr()->mapTextureDataFile(fileName, offset);
+    if (!mapped)
+        qWarning() << __FUNCTION__ << "Failed to map texture data file:" << fileName;
+
+    dptr()->m_dirtyBitsVolume.textureDataDirty = true;
+    dptr()->invalidateBricks();
+    emit textureDataChanged(0);
+    emit textureDataFileChanged(mapped ? fileName : QString());
+    emit dptr()->needUpdate();
+    return mapped;
+}
+
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Returns the name of the file mapped as the texture data, or an empty string if
+ * no file is mapped.
+ *
+ * \sa setTextureDataFile()
+ */
+QString QCustom3DVolume::textureDataFile() const
+{
+    return dptrc()->m_textureDataFile ? dptrc()->m_textureDataFile->fileName() : QString();
+}
+
+/*!
+ * \fn void QCustom3DVolume::textureDataFileChanged(const QString &fileName)
+ * \since QtDataVisualization 1.4
+ *
+ * This signal is emitted when the mapped texture data file changes to \a fileName.
+ *
+ * \sa setTextureDataFile()
+ */
+
 /*!
  * Sets a single 2D subtexture of the 3D texture along the specified
  * \a axis of the volume.
  * The \a index parameter specifies the subtexture to set.
  * The texture \a data must be in the format specified by the textureFormat
- * property and have the size of
+ * or sampleFormat property and have the size of
  * the cross-section of the volume texture along the specified axis multiplied by
  * the texture format color depth in bytes.
  * The \a data is expected to be ordered similarly to the data in images
@@ -689,11 +834,13 @@ QVector<uchar> *QCustom3DVolume::textureData() const
  */
 void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *data)
 {
-    if (data) {
+    if (!dptr()->m_textureData) {
+        qWarning() << __FUNCTION__ << "No texture data array to set the subtexture to.";
+    } else if (data) {
         int lineSize = textureDataWidth();
         int frameSize = lineSize * dptr()->m_textureHeight;
         int dataSize = dptr()->m_textureData->size();
-        int pixelWidth = (dptr()->m_textureFormat == QImage::Format_Indexed8) ? 1 : 4;
+        int pixelWidth = dptr()->bytesPerSample();
         int targetIndex;
         uchar *dataPtr = dptr()->m_textureData->data();
         bool invalid = (index < 0);
@@ -716,6 +863,7 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *d
         if (invalid) {
             qWarning() << __FUNCTION__ << "Attempted to set invalid subtexture.";
         } else {
+            dptr()->discardTextureLevel();
             const uchar *sourcePtr = data;
             uchar *targetPtr = dataPtr + targetIndex;
             if (axis == Qt::XAxis) {
@@ -741,6 +889,7 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *d
                 memcpy(subTexPtr, static_cast<const void *>(data), frameSize);
             }
             dptr()->m_dirtyBitsVolume.textureDataDirty = true;
+            dptr()->invalidateBricks(axis, index);
             emit textureDataChanged(dptr()->m_textureData);
             emit dptr()->needUpdate();
         }
@@ -758,6 +907,8 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const uchar *d
  * to that format. The image must have the size of the cross-section of the volume texture along
  * the specified axis. The orientation of the image should correspond to the orientation of
  * the slice image produced by renderSlice() method along the same axis.
+ * Images cannot be used to set the data when sampleFormat is not
+ * QCustom3DVolume::SampleFormatImage.
  *
  * \note Each x-dimension line of the data needs to be 32-bit aligned when
  * targeting the y-axis or z-axis. If textureFormat is QImage::Format_Indexed8
@@ -787,6 +938,7 @@ void QCustom3DVolume::setSubTextureData(Qt::Axis axis, int index, const QImage &
 
     if (sourceWidth == targetWidth
             && sourceHeight == targetHeight
+            && dptr()->m_sampleFormat == SampleFormatImage
             && (image.format() == dptr()->m_textureFormat
                 || dptr()->m_textureFormat == QImage::Format_ARGB32)) {
         QImage convertedImage;
@@ -818,8 +970,10 @@ void QCustom3DVolume::setTextureFormat(QImage::Format format)
 {
     if (format == QImage::Format_ARGB32 || format == QImage::Format_Indexed8) {
         if (dptr()->m_textureFormat != format) {
+            dptr()->discardTextureLevel();
             dptr()->m_textureFormat = format;
             dptr()->m_dirtyBitsVolume.textureFormatDirty = true;
+            dptr()->invalidateBricks();
             emit textureFormatChanged(format);
             emit dptr()->needUpdate();
         }
@@ -846,6 +1000,165 @@ QImage::Format QCustom3DVolume::textureFormat() const
  * \sa setTextureFormat()
  */
 
+/*!
+ * \enum QCustom3DVolume::SampleFormat
+ * \since QtDataVisualization 1.4
+ *
+ * The format of the samples in the texture data.
+ *
+ * \value SampleFormatImage
+ *        Texels are colors in the format specified by textureFormat.
+ * \value SampleFormatUInt16
+ *        Texels are unsigned 16-bit integers.
+ * \value SampleFormatFloat32
+ *        Texels are 32-bit floating point numbers.
+ */
+
+/*!
+ * \property QCustom3DVolume::sampleFormat
+ * \since QtDataVisualization 1.4
+ *
+ * \brief The format of the samples in the texture data.
+ *
+ * If the format is anything else than QCustom3DVolume::SampleFormatImage, each texel of
+ * textureData is a single scalar value, such as a density from a CT scan or a simulation, and
+ * textureFormat is ignored. The values are uploaded to the graphics hardware as is and mapped
+ * to the colorTable at the render time: the window defined by windowLevel and windowWidth is
+ * mapped linearly to the 256 colors of the table, and the values outside the window get the
+ * first or the last color.
+ *
+ * Scalar sample formats require OpenGL 3.0 or the ARB_texture_rg extension.
+ *
+ * Defaults to QCustom3DVolume::SampleFormatImage.
+ *
+ * \sa textureData, colorTable, windowLevel, windowWidth
+ */
+void QCustom3DVolume::setSampleFormat(SampleFormat format)
+{
+    if (dptr()->m_sampleFormat != format) {
+        dptr()->discardTextureLevel();
+        dptr()->m_sampleFormat = format;
+        dptr()->m_dirtyBitsVolume.textureFormatDirty = true;
+        dptr()->invalidateBricks();
+        emit sampleFormatChanged(format);
+        emit dptr()->needUpdate();
+    }
+}
+
+QCustom3DVolume::SampleFormat QCustom3DVolume::sampleFormat() const
+{
+    return dptrc()->m_sampleFormat;
+}
+
+/*!
+ * \property QCustom3DVolume::windowLevel
+ * \since QtDataVisualization 1.4
+ *
+ * \brief The sample value at the center of the window that is mapped to the color table.
+ *
+ * The value is in the units of the samples, so for QCustom3DVolume::SampleFormatUInt16
+ * it is usually between \c{0} and \c{65535}.
+ * This property is only used when sampleFormat is not QCustom3DVolume::SampleFormatImage.
+ * Defaults to \c{0.5f}.
+ *
+ * \sa windowWidth, sampleFormat, setWindow()
+ */
+void QCustom3DVolume::setWindowLevel(float level)
+{
+    if (dptr()->m_windowLevel != level) {
+        dptr()->m_windowLevel = level;
+        dptr()->m_dirtyBitsVolume.windowDirty = true;
+        emit windowLevelChanged(level);
+        emit dptr()->needUpdate();
+    }
+}
+
+float QCustom3DVolume::windowLevel() const
+{
+    return dptrc()->m_windowLevel;
+}
+
+/*!
+ * \property QCustom3DVolume::windowWidth
+ * \since QtDataVisualization 1.4
+ *
+ * \brief The range of sample values that is mapped to the color table.
+ *
+ * The value is in the units of the samples and must be positive.
+ * This property is only used when sampleFormat is not QCustom3DVolume::SampleFormatImage.
+ * Defaults to \c{1.0f}.
+ *
+ * \sa windowLevel, sampleFormat, setWindow()
+ */
+void QCustom3DVolume::setWindowWidth(float width)
+{
+    if (width > 0.0f) {
+        if (dptr()->m_windowWidth != width) {
+            dptr()->m_windowWidth = width;
+            dptr()->m_dirtyBitsVolume.windowDirty = true;
+            emit windowWidthChanged(width);
+            emit dptr()->needUpdate();
+        }
+    } else {
+        qWarning() << __FUNCTION__ << "Attempted to set non-positive window width.";
+    }
+}
+
+float QCustom3DVolume::windowWidth() const
+{
+    return dptrc()->m_windowWidth;
+}
+
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * A convenience function for setting the window \a level and \a width at once.
+ *
+ * \sa windowLevel, windowWidth
+ */
+void QCustom3DVolume::setWindow(float level, float width)
+{
+    setWindowLevel(level);
+    setWindowWidth(width);
+}
+
+/*!
+ * \property QCustom3DVolume::textureMemoryBudget
+ * \since QtDataVisualization 1.4
+ *
+ * \brief The maximum amount of graphics memory in megabytes used for the volume texture.
+ *
+ * If the texture data does not fit in the budget, the volume is rendered at the finest level of
+ * detail that does. Each level halves the resolution of the previous one along every axis, and
+ * the texels are point sampled from the full resolution data. The level is built in a background
+ * thread, and the volume is not drawn until the level is ready. The texels of such a level are also
+ * kept in system memory, so that the texture used while the camera moves can be downsampled from
+ * them.
+ * The value must not be negative. Setting the value to \c{0} removes the limit.
+ * Defaults to \c{0}.
+ *
+ * \sa setTextureDataFile()
+ */
+void QCustom3DVolume::setTextureMemoryBudget(int megabytes)
+{
+    if (megabytes >= 0) {
+        if (dptr()->m_textureMemoryBudget != megabytes) {
+            dptr()->discardTextureLevel();
+            dptr()->m_textureMemoryBudget = megabytes;
+            dptr()->m_dirtyBitsVolume.textureDataDirty = true;
+            emit textureMemoryBudgetChanged(megabytes);
+            emit dptr()->needUpdate();
+        }
+    } else {
+        qWarning() << __FUNCTION__ << "Attempted to set negative texture memory budget.";
+    }
+}
+
+int QCustom3DVolume::textureMemoryBudget() const
+{
+    return dptrc()->m_textureMemoryBudget;
+}
+
 /*!
  * \property QCustom3DVolume::alphaMultiplier
  *
@@ -944,6 +1257,48 @@ bool QCustom3DVolume::useHighDefShader() const
     return dptrc()->m_useHighDefShader;
 }
 
+/*!
+ * \property QCustom3DVolume::interactiveDownsampling
+ * \since QtDataVisualization 1.4
+ *
+ * \brief The factor by which the volume texture resolution is reduced while the camera moves.
+ *
+ * While the camera is rotated, zoomed, or otherwise moved, the volume is rendered from a
+ * texture downsampled by this factor along every axis, which also reduces the number of samples
+ * taken per ray. The full resolution texture is used again once the camera has been still for a
+ * short while. The downsampled texture is created in addition to the full resolution one, so it
+ * takes additional graphics memory. It is downsampled from the texture that is already in use,
+ * which is the full resolution texture unless it is limited by textureMemoryBudget, so the
+ * texture data is not read again. Its texels are averages of the texels of that texture, with
+ * the colors of QImage::Format_ARGB32 textures weighted by their alpha, or the most opaque of
+ * them for indexed textures.
+ *
+ * Valid values are \c{1}, \c{2}, \c{4}, and \c{8}. The value \c{1} disables downsampling.
+ * Defaults to \c{1}.
+ *
+ * \note This value does not affect the rendering of the slices of the volume.
+ *
+ * \sa useHighDefShader, textureMemoryBudget
+ */
+void QCustom3DVolume::setInteractiveDownsampling(int factor)
+{
+    if (factor == 1 || factor == 2 || factor == 4 || factor == 8) {
+        if (dptr()->m_interactiveDownsampling != factor) {
+            dptr()->m_interactiveDownsampling = factor;
+            dptr()->m_dirtyBitsVolume.interactiveDirty = true;
+            emit interactiveDownsamplingChanged(factor);
+            emit dptr()->needUpdate();
+        }
+    } else {
+        qWarning() << __FUNCTION__ << "Attempted to set invalid downsampling factor:" << factor;
+    }
+}
+
+int QCustom3DVolume::interactiveDownsampling() const
+{
+    return dptrc()->m_interactiveDownsampling;
+}
+
 /*!
  * \property QCustom3DVolume::drawSlices
  *
@@ -1125,7 +1480,9 @@ QVector3D QCustom3DVolume::sliceFrameThicknesses() const
 /*!
  * Renders the slice specified by \a index along the axis specified by \a axis
  * into an image.
- * The texture format of this object is used.
+ * The texture format of this object is used. If sampleFormat is not
+ * QCustom3DVolume::SampleFormatImage, the samples are mapped to the colorTable through
+ * the window and the image is in the QImage::Format_Indexed8 format.
  *
  * Returns the rendered image of the slice, or a null image if an invalid index is
  * specified.
@@ -1153,6 +1510,37 @@ const QCustom3DVolumePrivate *QCustom3DVolume::dptrc() const
     return static_cast<const QCustom3DVolumePrivate *>(d_ptr.data());
 }
 
+class QCustom3DVolumePrivate::LevelTask : public QRunnable
+{
+public:
+    LevelTask(QCustom3DVolumePrivate *volume, int maxTextureSize, int generation)
+        : m_volume(volume),
+          m_maxTextureSize(maxTextureSize),
+          m_generation(generation)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        m_volume->textureLevel(m_maxTextureSize, m_level);
+        QMetaObject::invokeMethod(m_volume, "handleTextureLevelFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, m_generation));
+        m_finished.release();
+    }
+
+    void waitForFinished() { m_finished.acquire(); }
+    int maxTextureSize() const { return m_maxTextureSize; }
+    const TextureLevel &level() const { return m_level; }
+
+private:
+    QCustom3DVolumePrivate *m_volume;
+    int m_maxTextureSize;
+    int m_generation;
+    TextureLevel m_level;
+    QSemaphore m_finished;
+};
+
 QCustom3DVolumePrivate::QCustom3DVolumePrivate(QCustom3DVolume *q) :
     QCustom3DItemPrivate(q),
     m_textureWidth(0),
@@ -1163,15 +1551,30 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(QCustom3DVolume *q) :
     m_sliceIndexZ(-1),
     m_textureFormat(QImage::Format_ARGB32),
     m_textureData(0),
+    m_textureDataFile(0),
+    m_mappedData(0),
+    m_mappedSize(0),
+    m_textureMemoryBudget(0),
+    m_sampleFormat(QCustom3DVolume::SampleFormatImage),
+    m_windowLevel(0.5f),
+    m_windowWidth(1.0f),
     m_alphaMultiplier(1.0f),
     m_preserveOpacity(true),
     m_useHighDefShader(true),
+    m_interactiveDownsampling(1),
     m_drawSlices(false),
     m_drawSliceFrames(false),
     m_sliceFrameColor(Qt::black),
     m_sliceFrameWidths(QVector3D(0.01f, 0.01f, 0.01f)),
     m_sliceFrameGaps(QVector3D(0.01f, 0.01f, 0.01f)),
-    m_sliceFrameThicknesses(QVector3D(0.01f, 0.01f, 0.01f))
+    m_sliceFrameThicknesses(QVector3D(0.01f, 0.01f, 0.01f)),
+    m_brickCountX(0),
+    m_brickCountY(0),
+    m_brickCountZ(0),
+    m_brickLevel(0),
+    m_levelTask(0),
+    m_levelGeneration(0),
+    m_levelReady(false)
 {
     m_isVolumeItem = true;
     m_meshFile = QStringLiteral(":/defaultMeshes/barFull");
@@ -1194,15 +1597,30 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(QCustom3DVolume *q, const QVector
     m_textureFormat(textureFormat),
     m_colorTable(colorTable),
     m_textureData(textureData),
+    m_textureDataFile(0),
+    m_mappedData(0),
+    m_mappedSize(0),
+    m_textureMemoryBudget(0),
+    m_sampleFormat(QCustom3DVolume::SampleFormatImage),
+    m_windowLevel(0.5f),
+    m_windowWidth(1.0f),
     m_alphaMultiplier(1.0f),
     m_preserveOpacity(true),
     m_useHighDefShader(true),
+    m_interactiveDownsampling(1),
     m_drawSlices(false),
     m_drawSliceFrames(false),
     m_sliceFrameColor(Qt::black),
     m_sliceFrameWidths(QVector3D(0.01f, 0.01f, 0.01f)),
     m_sliceFrameGaps(QVector3D(0.01f, 0.01f, 0.01f)),
-    m_sliceFrameThicknesses(QVector3D(0.01f, 0.01f, 0.01f))
+    m_sliceFrameThicknesses(QVector3D(0.01f, 0.01f, 0.01f)),
+    m_brickCountX(0),
+    m_brickCountY(0),
+    m_brickCountZ(0),
+    m_brickLevel(0),
+    m_levelTask(0),
+    m_levelGeneration(0),
+    m_levelReady(false)
 {
     m_isVolumeItem = true;
     m_shadowCasting = false;
@@ -1221,7 +1639,10 @@ QCustom3DVolumePrivate::QCustom3DVolumePrivate(QCustom3DVolume *q, const QVector
 
 QCustom3DVolumePrivate::~QCustom3DVolumePrivate()
 {
+    // The finished notification posted by the task is discarded with this object
+    discardTextureLevel();
     delete m_textureData;
+    unmapTextureDataFile();
 }
 
 void QCustom3DVolumePrivate::resetDirtyBits()
@@ -1235,11 +1656,496 @@ void QCustom3DVolumePrivate::resetDirtyBits()
     m_dirtyBitsVolume.textureFormatDirty = false;
     m_dirtyBitsVolume.alphaDirty = false;
     m_dirtyBitsVolume.shaderDirty = false;
+    m_dirtyBitsVolume.windowDirty = false;
+    m_dirtyBitsVolume.interactiveDirty = false;
+}
+
+int QCustom3DVolumePrivate::lineSize(int width) const
+{
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatUInt16)
+        return (width * 2 + 3) & ~3;
+    else if (m_sampleFormat == QCustom3DVolume::SampleFormatImage
+             && m_textureFormat == QImage::Format_Indexed8)
+        return width + width % 4;
+    else
+        return width * 4;
+}
+
+int QCustom3DVolumePrivate::texelWidth(int width) const
+{
+    // Indexed lines are uploaded with their padding
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatImage
+            && m_textureFormat == QImage::Format_Indexed8) {
+        return width + width % 4;
+    }
+    return width;
+}
+
+const uchar *QCustom3DVolumePrivate::texelData() const
+{
+    if (m_mappedData)
+        return m_mappedData;
+    else if (m_textureData)
+        return m_textureData->constData();
+    else
+        return 0;
+}
+
+bool QCustom3DVolumePrivate::isTexelDataValid() const
+{
+    if (!texelData() || !m_textureWidth || !m_textureHeight || !m_textureDepth)
+        return false;
+    qint64 size = m_mappedData ? m_mappedSize : qint64(m_textureData->size());
+    return size >= qint64(lineSize(m_textureWidth)) * m_textureHeight * m_textureDepth;
+}
+
+bool QCustom3DVolumePrivate::mapTextureDataFile(const QString &fileName, qint64 offset)
+{
+    unmapTextureDataFile();
+
+    m_textureDataFile = new QFile(fileName);
+    if (m_textureDataFile->open(QIODevice::ReadOnly) && offset >= 0
+            && offset < m_textureDataFile->size()) {
+        m_mappedSize = m_textureDataFile->size() - offset;
+        m_mappedData = m_textureDataFile->map(offset, m_mappedSize);
+    }
+    if (!m_mappedData) {
+        unmapTextureDataFile();
+        return false;
+    }
+    return true;
+}
+
+void QCustom3DVolumePrivate::unmapTextureDataFile()
+{
+    // Closing the file unmaps it
+    delete m_textureDataFile;
+    m_textureDataFile = 0;
+    m_mappedData = 0;
+    m_mappedSize = 0;
+}
+
+// Finds the finest level of detail that fits in the texture memory budget and sets its dimensions
+bool QCustom3DVolumePrivate::levelDimensions(int maxTextureSize, TextureLevel &level) const
+{
+    if (!isTexelDataValid())
+        return false;
+
+    qint64 budget = qint64(m_textureMemoryBudget) * 1024 * 1024;
+    int factor = 1;
+    level.level = 0;
+    forever {
+        level.width = (m_textureWidth + factor - 1) / factor;
+        level.height = (m_textureHeight + factor - 1) / factor;
+        level.depth = (m_textureDepth + factor - 1) / factor;
+        qint64 size = qint64(lineSize(level.width)) * level.height * level.depth;
+        bool fits = (!budget || size <= budget) && size < (qint64(1) << 31)
+                && (maxTextureSize <= 0 || (level.width <= maxTextureSize
+                                            && level.height <= maxTextureSize
+                                            && level.depth <= maxTextureSize));
+        if (fits || (level.width == 1 && level.height == 1 && level.depth == 1))
+            break;
+        level.level++;
+        factor *= 2;
+    }
+    return true;
+}
+
+// Downsampled levels are point sampled from the full resolution data. Only every factor-th line
+// of every factor-th slice is sampled, so the pages of a mapped file between them are not read.
+bool QCustom3DVolumePrivate::textureLevel(int maxTextureSize, TextureLevel &level) const
+{
+    if (!levelDimensions(maxTextureSize, level))
+        return false;
+
+    if (!level.level) {
+        level.data = texelData();
+        level.storage.clear();
+        return true;
+    }
+
+    int factor = 1 << level.level;
+    int pixelWidth = bytesPerSample();
+    int targetLineSize = lineSize(level.width);
+    qint64 sourceLineSize = lineSize(m_textureWidth);
+    qint64 sourceFrameSize = sourceLineSize * m_textureHeight;
+    allocateLevel(level);
+
+    const uchar *source = texelData();
+    uchar *target = level.storage.data();
+    for (int z = 0; z < level.depth; z++) {
+        for (int y = 0; y < level.height; y++) {
+            const uchar *sourceLine = source + sourceFrameSize * (z * factor)
+                    + sourceLineSize * (y * factor);
+            uchar *targetTexel = target + (z * level.height + y) * targetLineSize;
+            for (int x = 0; x < level.width; x++) {
+                memcpy(targetTexel, sourceLine + (x * factor) * pixelWidth, pixelWidth);
+                targetTexel += pixelWidth;
+            }
+        }
+    }
+    level.data = level.storage.constData();
+    return true;
+}
+
+// Returns the level of detail to create the texture from. The full resolution level is the texel
+// data itself. Downsampled levels are built in the thread pool, and false is returned until the
+// level is ready, at which point the texture data is marked dirty so that the level is taken.
+bool QCustom3DVolumePrivate::takeTextureLevel(int maxTextureSize, TextureLevel &level)
+{
+    if (m_levelTask && m_levelTask->maxTextureSize() == maxTextureSize) {
+        if (!m_levelReady)
+            return false;
+        level = m_levelTask->level();
+        delete m_levelTask;
+        m_levelTask = 0;
+        m_levelReady = false;
+        return level.data != 0;
+    }
+    discardTextureLevel();
+
+    if (!levelDimensions(maxTextureSize, level))
+        return false;
+    if (!level.level) {
+        level.data = texelData();
+        level.storage.clear();
+        return true;
+    }
+
+    m_levelTask = new LevelTask(this, maxTextureSize, ++m_levelGeneration);
+    QThreadPool::globalInstance()->start(m_levelTask);
+    return false;
+}
+
+// Waits for the level being built and drops it, so that the texture is created again with a new
+// one. Must be called before changing anything the level is built from.
+void QCustom3DVolumePrivate::discardTextureLevel()
+{
+    if (m_levelTask) {
+        if (!m_levelReady)
+            m_levelTask->waitForFinished();
+        delete m_levelTask;
+        m_levelTask = 0;
+        m_levelReady = false;
+        m_dirtyBitsVolume.textureDataDirty = true;
+    }
+}
+
+// The task notifies right before it finishes, so the wait is short
+void QCustom3DVolumePrivate::handleTextureLevelFinished(int generation)
+{
+    // Notifications of discarded levels have nothing to take
+    if (!m_levelTask || generation != m_levelGeneration)
+        return;
+    m_levelTask->waitForFinished();
+    m_levelReady = true;
+    m_dirtyBitsVolume.textureDataDirty = true;
+    emit needUpdate();
+}
+
+// Box filters the source level by factor, which must be a power of two. Only the texels of the
+// source level are read, so a level downsampled from the resident level doesn't touch the texture
+// data again.
+bool QCustom3DVolumePrivate::downsampledLevel(const TextureLevel &source, int factor,
+                                              TextureLevel &level) const
+{
+    if (!source.data || factor <= 1)
+        return false;
+
+    level.level = source.level;
+    for (int i = factor; i > 1; i /= 2)
+        level.level++;
+    level.width = (source.width + factor - 1) / factor;
+    level.height = (source.height + factor - 1) / factor;
+    level.depth = (source.depth + factor - 1) / factor;
+    allocateLevel(level);
+
+    int pixelWidth = bytesPerSample();
+    int targetLineSize = lineSize(level.width);
+    uchar *target = level.storage.data();
+    for (int z = 0; z < level.depth; z++) {
+        for (int y = 0; y < level.height; y++) {
+            uchar *targetTexel = target + (z * level.height + y) * targetLineSize;
+            for (int x = 0; x < level.width; x++) {
+                filterBox(source, x * factor, y * factor, z * factor, factor, targetTexel);
+                targetTexel += pixelWidth;
+            }
+        }
+    }
+    level.data = level.storage.constData();
+    return true;
+}
+
+// Allocates the storage of a downsampled level. Line padding of indexed data must be transparent.
+void QCustom3DVolumePrivate::allocateLevel(TextureLevel &level) const
+{
+    level.storage.resize(lineSize(level.width) * level.height * level.depth);
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatImage
+            && m_textureFormat == QImage::Format_Indexed8) {
+        uchar transparentIndex = 0;
+        for (int i = 0; i < m_colorTable.size() && i < 256; i++) {
+            if (!qAlpha(m_colorTable.at(i))) {
+                transparentIndex = uchar(i);
+                break;
+            }
+        }
+        level.storage.fill(transparentIndex);
+    }
+}
+
+void QCustom3DVolumePrivate::invalidateBricks()
+{
+    m_brickRanges.clear();
+    m_interactiveBrickRanges.clear();
+    m_dirtyBricks.clear();
+}
+
+void QCustom3DVolumePrivate::invalidateBricks(Qt::Axis axis, int index)
+{
+    // Nothing to do if the whole grid is rebuilt anyway
+    if (m_brickRanges.isEmpty())
+        return;
+
+    // Downsampled levels are rebuilt as a whole
+    if (m_brickLevel) {
+        invalidateBricks();
+        return;
+    }
+
+    int brickIndex = index / brickSize;
+    for (int z = 0; z < m_brickCountZ; z++) {
+        if (axis == Qt::ZAxis && z != brickIndex)
+            continue;
+        for (int y = 0; y < m_brickCountY; y++) {
+            if (axis == Qt::YAxis && y != brickIndex)
+                continue;
+            for (int x = 0; x < m_brickCountX; x++) {
+                if (axis == Qt::XAxis && x != brickIndex)
+                    continue;
+                m_dirtyBricks.setBit((z * m_brickCountY + y) * m_brickCountX + x);
+            }
+        }
+    }
+}
+
+float QCustom3DVolumePrivate::sampleValue(const uchar *texel) const
+{
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatUInt16) {
+        quint16 sample;
+        memcpy(&sample, texel, sizeof(sample));
+        return float(sample);
+    } else if (m_sampleFormat == QCustom3DVolume::SampleFormatFloat32) {
+        float sample;
+        memcpy(&sample, texel, sizeof(sample));
+        return sample;
+    } else if (m_textureFormat == QImage::Format_Indexed8) {
+        return float(*texel);
+    } else {
+        QRgb color;
+        memcpy(&color, texel, sizeof(color));
+        return float(qAlpha(color));
+    }
+}
+
+// Averages the texels of the source level in the box of factor^3 texels starting at x, y, z to
+// target. The colors of ARGB32 texels are weighted by their alpha, so that the colors of
+// transparent texels don't bleed into the visible ones. Indexes can't be averaged, so the most
+// opaque texel of indexed data is taken instead.
+void QCustom3DVolumePrivate::filterBox(const TextureLevel &source, int x, int y, int z,
+                                       int factor, uchar *target) const
+{
+    int pixelWidth = bytesPerSample();
+    int sourceLineSize = lineSize(source.width);
+    int sourceFrameSize = sourceLineSize * source.height;
+    int endX = qMin(x + factor, source.width);
+    int endY = qMin(y + factor, source.height);
+    int endZ = qMin(z + factor, source.depth);
+    bool indexed = (m_sampleFormat == QCustom3DVolume::SampleFormatImage
+                    && m_textureFormat == QImage::Format_Indexed8);
+
+    int bestAlpha = -1;
+    double sums[4] = {0.0, 0.0, 0.0, 0.0};
+    for (int sz = z; sz < endZ; sz++) {
+        for (int sy = y; sy < endY; sy++) {
+            const uchar *texel = source.data + sourceFrameSize * sz + sourceLineSize * sy
+                    + x * pixelWidth;
+            for (int sx = x; sx < endX; sx++) {
+                if (indexed) {
+                    int alpha = (*texel < m_colorTable.size()) ? qAlpha(m_colorTable.at(*texel))
+                                                               : 0;
+                    if (alpha > bestAlpha) {
+                        bestAlpha = alpha;
+                        *target = *texel;
+                    }
+                } else if (m_sampleFormat == QCustom3DVolume::SampleFormatImage) {
+                    QRgb color;
+                    memcpy(&color, texel, sizeof(color));
+                    int alpha = qAlpha(color);
+                    sums[0] += qRed(color) * alpha;
+                    sums[1] += qGreen(color) * alpha;
+                    sums[2] += qBlue(color) * alpha;
+                    sums[3] += alpha;
+                } else {
+                    sums[0] += sampleValue(texel);
+                }
+                texel += pixelWidth;
+            }
+        }
+    }
+    if (indexed)
+        return;
+
+    double count = double((endX - x) * (endY - y) * (endZ - z));
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatUInt16) {
+        quint16 sample = quint16(sums[0] / count + 0.5);
+        memcpy(target, &sample, sizeof(sample));
+    } else if (m_sampleFormat == QCustom3DVolume::SampleFormatFloat32) {
+        float sample = float(sums[0] / count);
+        memcpy(target, &sample, sizeof(sample));
+    } else {
+        QRgb color = 0;
+        if (sums[3] > 0.0) {
+            color = qRgba(int(sums[0] / sums[3] + 0.5), int(sums[1] / sums[3] + 0.5),
+                          int(sums[2] / sums[3] + 0.5), int(sums[3] / count + 0.5));
+        }
+        memcpy(target, &color, sizeof(color));
+    }
+}
+
+void QCustom3DVolumePrivate::updateBrickRanges(const TextureLevel &level)
+{
+    int width = texelWidth(level.width);
+    int bricks;
+    if (m_brickRanges.isEmpty() || m_brickLevel != level.level) {
+        m_brickLevel = level.level;
+        m_brickCountX = (width + brickSize - 1) / brickSize;
+        m_brickCountY = (level.height + brickSize - 1) / brickSize;
+        m_brickCountZ = (level.depth + brickSize - 1) / brickSize;
+        bricks = m_brickCountX * m_brickCountY * m_brickCountZ;
+        m_brickRanges.resize(bricks);
+        m_dirtyBricks.fill(true, bricks);
+    } else {
+        bricks = m_brickRanges.size();
+    }
+
+    for (int i = 0; i < bricks; i++) {
+        if (!m_dirtyBricks.testBit(i))
+            continue;
+        m_brickRanges[i] = brickRange(level, i);
+        m_dirtyBricks.clearBit(i);
+    }
+}
+
+// The texels of the interactive level are averages that can be outside the ranges of the texels
+// they are drawn over, so the brick occupancy takes the maximum of the ranges of both levels
+// An empty level removes the interactive ranges.
+void QCustom3DVolumePrivate::updateInteractiveBrickRanges(const TextureLevel &level)
+{
+    if (!level.data) {
+        m_interactiveBrickRanges.clear();
+        return;
+    }
+    m_interactiveBrickRanges.resize(m_brickRanges.size());
+    for (int i = 0; i < m_brickRanges.size(); i++)
+        m_interactiveBrickRanges[i] = brickRange(level, i);
+}
+
+// Range of the texels of the level in a brick. The level can be coarser than the level of the
+// bricks by at most the brick size.
+QCustom3DVolumePrivate::BrickRange QCustom3DVolumePrivate::brickRange(const TextureLevel &level,
+                                                                      int brick) const
+{
+    int size = brickSize >> (level.level - m_brickLevel);
+    int width = texelWidth(level.width);
+    int brickX = (brick % m_brickCountX) * size;
+    int brickY = ((brick / m_brickCountX) % m_brickCountY) * size;
+    int brickZ = (brick / (m_brickCountX * m_brickCountY)) * size;
+    int endX = qMin(brickX + size, width);
+    int endY = qMin(brickY + size, level.height);
+    int endZ = qMin(brickZ + size, level.depth);
+
+    int pixelWidth = bytesPerSample();
+    int levelLineSize = lineSize(level.width);
+    int frameSize = levelLineSize * level.height;
+    BrickRange range;
+    range.min = FLT_MAX;
+    range.max = -FLT_MAX;
+    for (int z = brickZ; z < endZ; z++) {
+        for (int y = brickY; y < endY; y++) {
+            const uchar *p = level.data + z * frameSize + y * levelLineSize + brickX * pixelWidth;
+            for (int x = brickX; x < endX; x++) {
+                float value = sampleValue(p);
+                range.min = qMin(range.min, value);
+                range.max = qMax(range.max, value);
+                p += pixelWidth;
+            }
+        }
+    }
+    return range;
+}
+
+QVector<uchar> QCustom3DVolumePrivate::brickOccupancy()
+{
+    QVector<uchar> occupancy(m_brickRanges.size());
+    if (occupancy.isEmpty())
+        return occupancy;
+
+    QVector<BrickRange> ranges = m_brickRanges;
+    if (m_interactiveBrickRanges.size() == ranges.size()) {
+        for (int i = 0; i < ranges.size(); i++) {
+            ranges[i].min = qMin(ranges.at(i).min, m_interactiveBrickRanges.at(i).min);
+            ranges[i].max = qMax(ranges.at(i).max, m_interactiveBrickRanges.at(i).max);
+        }
+    }
+
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatImage
+            && m_textureFormat != QImage::Format_Indexed8) {
+        // Range is the range of alpha values
+        for (int i = 0; i < ranges.size(); i++)
+            occupancy[i] = (ranges.at(i).max > 0.0f) ? 255 : 0;
+        return occupancy;
+    }
+
+    // Count visible colors up to each color table index, so that any index range can be checked
+    // for visible colors without iterating it
+    int visibleColors[257];
+    visibleColors[0] = 0;
+    for (int i = 0; i < 256; i++) {
+        bool visible = i < m_colorTable.size() && qAlpha(m_colorTable.at(i)) > 0;
+        visibleColors[i + 1] = visibleColors[i] + (visible ? 1 : 0);
+    }
+
+    bool indexed = (m_sampleFormat == QCustom3DVolume::SampleFormatImage);
+    for (int i = 0; i < ranges.size(); i++) {
+        const BrickRange &range = ranges.at(i);
+        int first = 0;
+        int last = 255;
+        if (indexed) {
+            first = int(range.min);
+            last = int(range.max);
+        } else if (range.min <= range.max) {
+            // Widen the range by one color, as the shaders map the values with less precision
+            first = qMax(0, windowedIndex(range.min) - 1);
+            last = qMin(255, windowedIndex(range.max) + 1);
+        }
+        occupancy[i] = (visibleColors[last + 1] > visibleColors[first]) ? 255 : 0;
+    }
+    return occupancy;
+}
+
+int QCustom3DVolumePrivate::bytesPerSample() const
+{
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatUInt16)
+        return 2;
+    else if (m_sampleFormat == QCustom3DVolume::SampleFormatFloat32)
+        return 4;
+    else
+        return (m_textureFormat == QImage::Format_Indexed8) ? 1 : 4;
 }
 
 QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
 {
-    if (index < 0)
+    if (index < 0 || !isTexelDataValid())
         return QImage();
 
     int x;
@@ -1262,20 +2168,21 @@ QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
     }
 
     int padding = 0;
-    int pixelWidth = 4;
+    int pixelWidth = bytesPerSample();
     int dataWidth = qptr()->textureDataWidth();
-    if (m_textureFormat == QImage::Format_Indexed8) {
+    if (m_sampleFormat == QCustom3DVolume::SampleFormatImage
+            && m_textureFormat == QImage::Format_Indexed8) {
         padding = x % 4;
-        pixelWidth = 1;
     }
     QVector<uchar> data((x + padding) * y * pixelWidth);
-    int frameSize = qptr()->textureDataWidth() * m_textureHeight;
+    // Mapped texture data can exceed the int range
+    qint64 frameSize = qint64(qptr()->textureDataWidth()) * m_textureHeight;
+    const uchar *texels = texelData();
 
     int dataIndex = 0;
     if (axis == Qt::XAxis) {
         for (int i = 0; i < y; i++) {
-            const uchar *p = m_textureData->constData()
-                    + (index * pixelWidth) + (dataWidth * i);
+            const uchar *p = texels + (index * pixelWidth) + (dataWidth * i);
             for (int j = 0; j < x; j++) {
                 for (int k = 0; k < pixelWidth; k++)
                     data[dataIndex++] = *(p + k);
@@ -1284,8 +2191,7 @@ QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
         }
     } else if (axis == Qt::YAxis) {
         for (int i = y - 1; i >= 0; i--) {
-            const uchar *p = m_textureData->constData() + (index * dataWidth)
-                    + (frameSize * i);
+            const uchar *p = texels + (index * dataWidth) + (frameSize * i);
             for (int j = 0; j < (x * pixelWidth); j++) {
                 data[dataIndex++] = *p;
                 p++;
@@ -1293,7 +2199,7 @@ QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
         }
     } else {
         for (int i = 0; i < y; i++) {
-            const uchar *p = m_textureData->constData() + (index * frameSize) + (dataWidth * i);
+            const uchar *p = texels + (index * frameSize) + (dataWidth * i);
             for (int j = 0; j < (x * pixelWidth); j++) {
                 data[dataIndex++] = *p;
                 p++;
@@ -1301,14 +2207,36 @@ QImage QCustom3DVolumePrivate::renderSlice(Qt::Axis axis, int index)
         }
     }
 
-    if (m_textureFormat != QImage::Format_Indexed8 && m_alphaMultiplier != 1.0f) {
+    QImage image;
+    if (m_sampleFormat != QCustom3DVolume::SampleFormatImage) {
+        // Map the samples to the color table like the volume shaders do
+        image = QImage(x, y, QImage::Format_Indexed8);
+        const uchar *p = data.constData();
+        for (int i = 0; i < y; i++) {
+            uchar *line = image.scanLine(i);
+            for (int j = 0; j < x; j++) {
+                float value;
+                if (m_sampleFormat == QCustom3DVolume::SampleFormatUInt16) {
+                    quint16 sample;
+                    memcpy(&sample, p, sizeof(sample));
+                    value = float(sample);
+                } else {
+                    memcpy(&value, p, sizeof(value));
+                }
+                line[j] = uchar(windowedIndex(value));
+                p += pixelWidth;
+            }
+        }
+    } else if (m_textureFormat != QImage::Format_Indexed8 && m_alphaMultiplier != 1.0f) {
         for (int i = pixelWidth - 1; i < data.size(); i += pixelWidth)
             data[i] = static_cast<uchar>(multipliedAlphaValue(data.at(i)));
     }
 
-    QImage image(data.constData(), x, y, x * pixelWidth, m_textureFormat);
-    image.bits(); // Call bits() to detach the new image from local data
-    if (m_textureFormat == QImage::Format_Indexed8) {
+    if (image.isNull()) {
+        image = QImage(data.constData(), x, y, x * pixelWidth, m_textureFormat);
+        image.bits(); // Call bits() to detach the new image from local data
+    }
+    if (image.format() == QImage::Format_Indexed8) {
         QVector<QRgb> colorTable = m_colorTable;
         if (m_alphaMultiplier != 1.0f) {
             for (int i = 0; i < colorTable.size(); i++) {
@@ -1334,6 +2262,13 @@ int QCustom3DVolumePrivate::multipliedAlphaValue(int alpha)
     return modifiedAlpha;
 }
 
+int QCustom3DVolumePrivate::windowedIndex(float value) const
+{
+    float windowStart = m_windowLevel - m_windowWidth / 2.0f;
+    float index = (value - windowStart) / m_windowWidth * 255.0f;
+    return int(qBound(0.0f, index, 255.0f));
+}
+
 QCustom3DVolume *QCustom3DVolumePrivate::qptr()
 {
     return static_cast<QCustom3DVolume *>(q_ptr);
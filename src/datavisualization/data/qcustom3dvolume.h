@@ -42,6 +42,7 @@ class QCustom3DVolumePrivate;
 class QT_DATAVISUALIZATION_EXPORT QCustom3DVolume : public QCustom3DItem
 {
     Q_OBJECT
+    Q_ENUMS(SampleFormat)
     Q_PROPERTY(int textureWidth READ textureWidth WRITE setTextureWidth NOTIFY textureWidthChanged)
     Q_PROPERTY(int textureHeight READ textureHeight WRITE setTextureHeight NOTIFY textureHeightChanged)
     Q_PROPERTY(int textureDepth READ textureDepth WRITE setTextureDepth NOTIFY textureDepthChanged)
@@ -50,9 +51,14 @@ class QT_DATAVISUALIZATION_EXPORT QCustom3DVolume : public QCustom3DItem
     Q_PROPERTY(int sliceIndexZ READ sliceIndexZ WRITE setSliceIndexZ NOTIFY sliceIndexZChanged)
     Q_PROPERTY(QVector<QRgb> colorTable READ colorTable WRITE setColorTable NOTIFY colorTableChanged)
     Q_PROPERTY(QVector<uchar> *textureData READ textureData WRITE setTextureData NOTIFY textureDataChanged)
+    Q_PROPERTY(SampleFormat sampleFormat READ sampleFormat WRITE setSampleFormat NOTIFY sampleFormatChanged)
+    Q_PROPERTY(float windowLevel READ windowLevel WRITE setWindowLevel NOTIFY windowLevelChanged)
+    Q_PROPERTY(float windowWidth READ windowWidth WRITE setWindowWidth NOTIFY windowWidthChanged)
+    Q_PROPERTY(int textureMemoryBudget READ textureMemoryBudget WRITE setTextureMemoryBudget NOTIFY textureMemoryBudgetChanged)
     Q_PROPERTY(float alphaMultiplier READ alphaMultiplier WRITE setAlphaMultiplier NOTIFY alphaMultiplierChanged)
     Q_PROPERTY(bool preserveOpacity READ preserveOpacity WRITE setPreserveOpacity NOTIFY preserveOpacityChanged)
     Q_PROPERTY(bool useHighDefShader READ useHighDefShader WRITE setUseHighDefShader NOTIFY useHighDefShaderChanged)
+    Q_PROPERTY(int interactiveDownsampling READ interactiveDownsampling WRITE setInteractiveDownsampling NOTIFY interactiveDownsamplingChanged)
     Q_PROPERTY(bool drawSlices READ drawSlices WRITE setDrawSlices NOTIFY drawSlicesChanged)
     Q_PROPERTY(bool drawSliceFrames READ drawSliceFrames WRITE setDrawSliceFrames NOTIFY drawSliceFramesChanged)
     Q_PROPERTY(QColor sliceFrameColor READ sliceFrameColor WRITE setSliceFrameColor NOTIFY sliceFrameColorChanged)
@@ -61,6 +67,11 @@ class QT_DATAVISUALIZATION_EXPORT QCustom3DVolume : public QCustom3DItem
     Q_PROPERTY(QVector3D sliceFrameThicknesses READ sliceFrameThicknesses WRITE setSliceFrameThicknesses NOTIFY sliceFrameThicknessesChanged)
 
 public:
+    enum SampleFormat {
+        SampleFormatImage = 0,
+        SampleFormatUInt16,
+        SampleFormatFloat32
+    };
 
     explicit QCustom3DVolume(QObject *parent = nullptr);
     explicit QCustom3DVolume(const QVector3D &position, const QVector3D &scaling,
@@ -93,12 +104,25 @@ public:
     void setTextureData(QVector<uchar> *data);
     QVector<uchar> *createTextureData(const QVector<QImage *> &images);
     QVector<uchar> *textureData() const;
+    bool setTextureDataFile(const QString &fileName, qint64 offset = 0);
+    QString textureDataFile() const;
     void setSubTextureData(Qt::Axis axis, int index, const uchar *data);
     void setSubTextureData(Qt::Axis axis, int index, const QImage &image);
 
     void setTextureFormat(QImage::Format format);
     QImage::Format textureFormat() const;
 
+    void setSampleFormat(SampleFormat format);
+    SampleFormat sampleFormat() const;
+    void setWindowLevel(float level);
+    float windowLevel() const;
+    void setWindowWidth(float width);
+    float windowWidth() const;
+    void setWindow(float level, float width);
+
+    void setTextureMemoryBudget(int megabytes);
+    int textureMemoryBudget() const;
+
     void setAlphaMultiplier(float mult);
     float alphaMultiplier() const;
     void setPreserveOpacity(bool enable);
@@ -106,6 +130,8 @@ public:
 
     void setUseHighDefShader(bool enable);
     bool useHighDefShader() const;
+    void setInteractiveDownsampling(int factor);
+    int interactiveDownsampling() const;
 
     void setDrawSlices(bool enable);
     bool drawSlices() const;
@@ -132,10 +158,16 @@ Q_SIGNALS:
     void sliceIndexZChanged(int value);
     void colorTableChanged();
     void textureDataChanged(QVector<uchar> *data);
+    void textureDataFileChanged(const QString &fileName);
     void textureFormatChanged(QImage::Format format);
+    void sampleFormatChanged(QCustom3DVolume::SampleFormat format);
+    void windowLevelChanged(float level);
+    void windowWidthChanged(float width);
+    void textureMemoryBudgetChanged(int megabytes);
     void alphaMultiplierChanged(float mult);
     void preserveOpacityChanged(bool enabled);
     void useHighDefShaderChanged(bool enabled);
+    void interactiveDownsamplingChanged(int factor);
     void drawSlicesChanged(bool enabled);
     void drawSliceFramesChanged(bool enabled);
     void sliceFrameColorChanged(const QColor &color);
@@ -42,6 +42,8 @@
 
 #include "qcustom3dvolume.h"
 #include "qcustom3ditem_p.h"
+#include <QtCore/QBitArray>
+#include <QtCore/QFile>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -53,6 +55,8 @@ struct QCustomVolumeDirtyBitField {
     bool textureFormatDirty     : 1;
     bool alphaDirty             : 1;
     bool shaderDirty            : 1;
+    bool windowDirty            : 1;
+    bool interactiveDirty       : 1;
 
     QCustomVolumeDirtyBitField()
         : textureDimensionsDirty(false),
@@ -61,15 +65,29 @@ struct QCustomVolumeDirtyBitField {
           textureDataDirty(false),
           textureFormatDirty(false),
           alphaDirty(false),
-          shaderDirty(false)
+          shaderDirty(false),
+          windowDirty(false),
+          interactiveDirty(false)
     {
     }
 };
 
-class QCustom3DVolumePrivate : public QCustom3DItemPrivate
+class QT_DATAVISUALIZATION_EXPORT QCustom3DVolumePrivate : public QCustom3DItemPrivate
 {
     Q_OBJECT
 
+public:
+    // Texture data at a level of detail, each level halving the resolution of the previous one
+    struct TextureLevel {
+        TextureLevel() : data(0), width(0), height(0), depth(0), level(0) {}
+        const uchar *data;
+        int width;
+        int height;
+        int depth;
+        int level;
+        QVector<uchar> storage; // Downsampled data, empty for the full resolution level
+    };
+
 public:
     QCustom3DVolumePrivate(QCustom3DVolume *q);
     QCustom3DVolumePrivate(QCustom3DVolume *q, const QVector3D &position, const QVector3D &scaling,
@@ -79,10 +97,30 @@ public:
     virtual ~QCustom3DVolumePrivate();
 
     void resetDirtyBits();
+    int bytesPerSample() const;
+    int lineSize(int width) const;
+    int texelWidth(int width) const;
+    const uchar *texelData() const;
+    bool isTexelDataValid() const;
+    bool mapTextureDataFile(const QString &fileName, qint64 offset);
+    void unmapTextureDataFile();
+    bool levelDimensions(int maxTextureSize, TextureLevel &level) const;
+    bool textureLevel(int maxTextureSize, TextureLevel &level) const;
+    bool takeTextureLevel(int maxTextureSize, TextureLevel &level);
+    void discardTextureLevel();
+    bool downsampledLevel(const TextureLevel &source, int factor, TextureLevel &level) const;
+    void invalidateBricks();
+    void invalidateBricks(Qt::Axis axis, int index);
+    void updateBrickRanges(const TextureLevel &level);
+    void updateInteractiveBrickRanges(const TextureLevel &level);
+    QVector<uchar> brickOccupancy();
     QImage renderSlice(Qt::Axis axis, int index);
 
     QCustom3DVolume *qptr();
 
+public Q_SLOTS:
+    void handleTextureLevelFinished(int generation);
+
 public:
     int m_textureWidth;
     int m_textureHeight;
@@ -94,10 +132,18 @@ public:
     QImage::Format m_textureFormat;
     QVector<QRgb> m_colorTable;
     QVector<uchar> *m_textureData;
+    QFile *m_textureDataFile;
+    const uchar *m_mappedData;
+    qint64 m_mappedSize;
+    int m_textureMemoryBudget;
+    QCustom3DVolume::SampleFormat m_sampleFormat;
+    float m_windowLevel;
+    float m_windowWidth;
 
     float m_alphaMultiplier;
     bool m_preserveOpacity;
     bool m_useHighDefShader;
+    int m_interactiveDownsampling;
 
     bool m_drawSlices;
     bool m_drawSliceFrames;
@@ -108,8 +154,40 @@ public:
 
     QCustomVolumeDirtyBitField m_dirtyBitsVolume;
 
+    // Level of detail the texture was last created from, kept for downsampling the interactive
+    // level from it
+    TextureLevel m_residentLevel;
+
+    // The uploaded texture data is divided into bricks of brickSize^3 texels for empty space
+    // skipping
+    static const int brickSize = 8;
+    int m_brickLevel;
+    int m_brickCountX;
+    int m_brickCountY;
+    int m_brickCountZ;
+
 private:
+    class LevelTask;
+
     int multipliedAlphaValue(int alpha);
+    int windowedIndex(float value) const;
+    float sampleValue(const uchar *texel) const;
+    void allocateLevel(TextureLevel &level) const;
+    void filterBox(const TextureLevel &source, int x, int y, int z, int factor,
+                   uchar *target) const;
+
+    // Range of the sample values, or the alpha values for ARGB32 textures, in a brick
+    struct BrickRange {
+        float min;
+        float max;
+    };
+    BrickRange brickRange(const TextureLevel &level, int brick) const;
+    QVector<BrickRange> m_brickRanges;
+    QVector<BrickRange> m_interactiveBrickRanges; // Empty if there is no interactive level
+    QBitArray m_dirtyBricks;
+    LevelTask *m_levelTask; // Downsampled level being built or not taken yet
+    int m_levelGeneration; // Identifies the notifications of the current task
+    bool m_levelReady;
 
     friend class QCustom3DVolume;
 };
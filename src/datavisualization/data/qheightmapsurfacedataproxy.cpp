@@ -28,12 +28,24 @@
 ****************************************************************************/
 
 #include "qheightmapsurfacedataproxy_p.h"
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <float.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 // Default ranges correspond value axis defaults
 const float defaultMinValue = 0.0f;
 const float defaultMaxValue = 10.0f;
+// Height arrays with fewer heights than this per task are converted on the calling thread only
+const int conversionTaskMinSize = 65536;
+// Height maps with fewer pixels than this are resolved on the GUI thread
+const qint64 resolveTaskMinSize = 512 * 512;
 
 /*!
  * \class QHeightMapSurfaceDataProxy
@@ -47,11 +59,28 @@ const float defaultMaxValue = 10.0f;
  * Since height maps do not contain values for X or Z axes, those values need to be given
  * separately using minXValue, maxXValue, minZValue, and maxZValue properties. X-value corresponds
  * to image horizontal direction and Z-value to the vertical. Setting any of these
- * properties triggers asynchronous re-resolving of any existing height map.
+ * properties asynchronously rescales the X and Z values of any existing height map data
+ * without resolving the heights again.
+ *
+ * Images with 16 bits per color component, as well as raw files of 16-bit integer or
+ * 32-bit floating point heights, are converted to a height array without any intermediate
+ * image, see QSurfaceDataProxy::resetHeightArray() and setRawHeightMapFile().
  *
  * \sa QSurfaceDataProxy, {Qt Data Visualization Data Handling}
  */
 
+/*!
+ * \enum QHeightMapSurfaceDataProxy::RawHeightFormat
+ * \since QtDataVisualization 1.4
+ *
+ * The format of the heights in a raw height map file.
+ *
+ * \value RawHeightUInt16
+ *        Unsigned 16-bit integers.
+ * \value RawHeightFloat32
+ *        32-bit floating point numbers.
+ */
+
 /*!
  * \qmltype HeightMapSurfaceDataProxy
  * \inqmlmodule QtDataVisualization
@@ -89,7 +118,8 @@ const float defaultMaxValue = 10.0f;
  * Since height maps do not contain values for X or Z axes, those values need to be given
  * separately using minXValue, maxXValue, minZValue, and maxZValue properties. X-value corresponds
  * to image horizontal direction and Z-value to the vertical. Setting any of these
- * properties triggers asynchronous re-resolving of any existing height map.
+ * properties asynchronously rescales the X and Z values of any existing height map data
+ * without resolving the heights again.
  *
  * Not recommended formats: all mono formats (for example QImage::Format_Mono).
  */
@@ -196,16 +226,21 @@ QHeightMapSurfaceDataProxy::~QHeightMapSurfaceDataProxy()
  *
  * Not recommended formats: all mono formats (for example QImage::Format_Mono).
  *
- * The height map is resolved asynchronously. QSurfaceDataProxy::arrayReset() is emitted when the
- * data has been resolved.
+ * Images with 16 bits per color component, such as QImage::Format_Grayscale16 and
+ * QImage::Format_RGBA64, are read without conversion into a height array of the
+ * 16-bit values. These formats require Qt 5.13 or later.
+ *
+ * The height map is resolved asynchronously. Large height maps are converted in a worker thread,
+ * so the current data stays in the proxy until the new data replaces it.
+ * QSurfaceDataProxy::arrayReset() is emitted when the data has been resolved.
  */
 void QHeightMapSurfaceDataProxy::setHeightMap(const QImage &image)
 {
     dptr()->m_heightMap = image;
+    dptr()->m_rawFile.clear();
 
     // We do resolving asynchronously to make qml onArrayReset handlers actually get the initial reset
-    if (!dptr()->m_resolveTimer.isActive())
-        dptr()->m_resolveTimer.start(0);
+    dptr()->scheduleResolve(true);
 }
 
 QImage QHeightMapSurfaceDataProxy::heightMap() const
@@ -237,6 +272,35 @@ QString QHeightMapSurfaceDataProxy::heightMapFile() const
     return dptrc()->m_heightMapFile;
 }
 
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Replaces current data with the heights of the raw file specified by \a filename.
+ * The file holds rows of \a columnCount heights in \a format, in the byte order of the host,
+ * without any header. The number of rows is the file size divided by the size of a row.
+ * Like with images, the first row of the file has the maximum Z value.
+ *
+ * The file is memory mapped and converted in parallel to a height array, see
+ * QSurfaceDataProxy::resetHeightArray(). The heights are resolved asynchronously.
+ * QSurfaceDataProxy::arrayReset() is emitted when the data has been resolved.
+ *
+ * \sa heightMapFile
+ */
+void QHeightMapSurfaceDataProxy::setRawHeightMapFile(const QString &filename, int columnCount,
+                                                     RawHeightFormat format)
+{
+    if (!dptrc()->m_heightMapFile.isEmpty()) {
+        dptr()->m_heightMapFile.clear();
+        emit heightMapFileChanged(QString());
+    }
+    dptr()->m_heightMap = QImage();
+    dptr()->m_rawFile = filename;
+    dptr()->m_rawColumnCount = columnCount;
+    dptr()->m_rawFormat = format;
+
+    dptr()->scheduleResolve(true);
+}
+
 /*!
  * A convenience function for setting all minimum (\a minX and \a minZ) and maximum
  * (\a maxX and \a maxZ) values at the same time. The minimum values must be smaller than the
@@ -345,12 +409,47 @@ const QHeightMapSurfaceDataProxyPrivate *QHeightMapSurfaceDataProxy::dptrc() con
 
 //  QHeightMapSurfaceDataProxyPrivate
 
+class QHeightMapSurfaceDataProxyPrivate::ResolveTask : public QRunnable
+{
+public:
+    ResolveTask(QHeightMapSurfaceDataProxyPrivate *proxy, const ResolveInput &input)
+        : m_proxy(proxy),
+          m_input(input)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        resolve(m_input, m_result);
+        QMetaObject::invokeMethod(m_proxy, "handleResolveFinished", Qt::QueuedConnection);
+        m_finished.release();
+    }
+
+    void waitForFinished() { m_finished.acquire(); }
+    const ResolveInput &input() const { return m_input; }
+    ResolveResult &result() { return m_result; }
+
+private:
+    QHeightMapSurfaceDataProxyPrivate *m_proxy;
+    ResolveInput m_input;
+    ResolveResult m_result;
+    QSemaphore m_finished;
+};
+
 QHeightMapSurfaceDataProxyPrivate::QHeightMapSurfaceDataProxyPrivate(QHeightMapSurfaceDataProxy *q)
     : QSurfaceDataProxyPrivate(q),
+      m_rawColumnCount(0),
+      m_rawFormat(QHeightMapSurfaceDataProxy::RawHeightUInt16),
       m_minXValue(defaultMinValue),
       m_maxXValue(defaultMaxValue),
       m_minZValue(defaultMinValue),
-      m_maxZValue(defaultMaxValue)
+      m_maxZValue(defaultMaxValue),
+      m_heightsDirty(true),
+      m_resolvePending(false),
+      m_resolvedColumns(0),
+      m_resolvedRows(0),
+      m_resolveTask(0)
 {
     m_resolveTimer.setSingleShot(true);
     QObject::connect(&m_resolveTimer, &QTimer::timeout,
@@ -359,6 +458,12 @@ QHeightMapSurfaceDataProxyPrivate::QHeightMapSurfaceDataProxyPrivate(QHeightMapS
 
 QHeightMapSurfaceDataProxyPrivate::~QHeightMapSurfaceDataProxyPrivate()
 {
+    // The finished notification posted by the task is discarded with this object
+    if (m_resolveTask) {
+        m_resolveTask->waitForFinished();
+        delete m_resolveTask->result().array;
+        delete m_resolveTask;
+    }
 }
 
 QHeightMapSurfaceDataProxy *QHeightMapSurfaceDataProxyPrivate::qptr()
@@ -413,8 +518,8 @@ void QHeightMapSurfaceDataProxyPrivate::setValueRanges(float minX, float maxX,
     if (maxZChanged)
         emit qptr()->maxZValueChanged(m_maxZValue);
 
-    if ((minXChanged || minZChanged || maxXChanged || maxZChanged) && !m_resolveTimer.isActive())
-        m_resolveTimer.start(0);
+    if (minXChanged || minZChanged || maxXChanged || maxZChanged)
+        scheduleResolve(false);
 }
 
 void QHeightMapSurfaceDataProxyPrivate::setMinXValue(float min)
@@ -434,8 +539,7 @@ void QHeightMapSurfaceDataProxyPrivate::setMinXValue(float min)
         if (maxChanged)
             emit qptr()->maxXValueChanged(m_maxXValue);
 
-        if (!m_resolveTimer.isActive())
-            m_resolveTimer.start(0);
+        scheduleResolve(false);
     }
 }
 
@@ -456,8 +560,7 @@ void QHeightMapSurfaceDataProxyPrivate::setMaxXValue(float max)
         if (minChanged)
             emit qptr()->minXValueChanged(m_minXValue);
 
-        if (!m_resolveTimer.isActive())
-            m_resolveTimer.start(0);
+        scheduleResolve(false);
     }
 }
 
@@ -478,8 +581,7 @@ void QHeightMapSurfaceDataProxyPrivate::setMinZValue(float min)
         if (maxChanged)
             emit qptr()->maxZValueChanged(m_maxZValue);
 
-        if (!m_resolveTimer.isActive())
-            m_resolveTimer.start(0);
+        scheduleResolve(false);
     }
 }
 
@@ -500,40 +602,193 @@ void QHeightMapSurfaceDataProxyPrivate::setMaxZValue(float max)
         if (minChanged)
             emit qptr()->minZValueChanged(m_minZValue);
 
-        if (!m_resolveTimer.isActive())
-            m_resolveTimer.start(0);
+        scheduleResolve(false);
     }
 }
 
+// Returns the step between columns or rows so that the last one doesn't exceed the maximum,
+// which could prevent it from being rendered
+static float gridStep(float minValue, float maxValue, int count)
+{
+    if (count < 2)
+        return 1.0f;
+    float step = (maxValue - minValue) / float(count - 1);
+    if (minValue + float(count - 1) * step > maxValue)
+        step -= step * FLT_EPSILON;
+    return step;
+}
+
+// Heights need resolving when the height map changes. Changing only the value ranges rescales
+// the X and Z values of the resolved data.
+void QHeightMapSurfaceDataProxyPrivate::scheduleResolve(bool heightsChanged)
+{
+    if (heightsChanged)
+        m_heightsDirty = true;
+    if (!m_resolveTimer.isActive())
+        m_resolveTimer.start(0);
+}
+
 void QHeightMapSurfaceDataProxyPrivate::handlePendingResolve()
 {
-    QImage heightImage = m_heightMap;
+    // A conversion still running in the thread pool resolves again when it has finished
+    if (m_resolveTask) {
+        m_resolvePending = true;
+        return;
+    }
+
+    if (!m_heightsDirty && rescale())
+        return;
+
+    ResolveInput input;
+    input.image = m_heightMap;
+    input.rawFile = m_rawFile;
+    input.rawColumnCount = m_rawColumnCount;
+    input.rawFormat = m_rawFormat;
+    input.minXValue = m_minXValue;
+    input.maxXValue = m_maxXValue;
+    input.minZValue = m_minZValue;
+    input.maxZValue = m_maxZValue;
+    m_heightsDirty = false;
+
+    // Small height maps are resolved right away, so that the data is there when the event loop
+    // has processed the resolve
+    qint64 size = qint64(input.image.width()) * input.image.height();
+    if (!input.rawFile.isEmpty()) {
+        const int sampleSize =
+                input.rawFormat == QHeightMapSurfaceDataProxy::RawHeightFloat32 ? 4 : 2;
+        size = QFileInfo(input.rawFile).size() / sampleSize;
+    }
+    if (size < resolveTaskMinSize) {
+        ResolveResult result;
+        resolve(input, result);
+        applyResult(input, result);
+        return;
+    }
+
+    m_resolveTask = new ResolveTask(this, input);
+    QThreadPool::globalInstance()->start(m_resolveTask);
+}
+
+void QHeightMapSurfaceDataProxyPrivate::handleResolveFinished()
+{
+    ResolveTask *task = m_resolveTask;
+    m_resolveTask = 0;
+    task->waitForFinished();
+
+    if (m_heightsDirty) {
+        // The height map changed while it was being resolved
+        delete task->result().array;
+    } else {
+        applyResult(task->input(), task->result());
+    }
+    delete task;
+
+    if (m_resolvePending) {
+        m_resolvePending = false;
+        handlePendingResolve();
+    }
+}
+
+// Hands the resolved data over to the proxy
+void QHeightMapSurfaceDataProxyPrivate::applyResult(const ResolveInput &input,
+                                                    ResolveResult &result)
+{
+    if (result.array) {
+        qptr()->resetArray(result.array);
+        m_resolvedRows = result.array->size();
+    } else if (result.heights.size()) {
+        qptr()->resetHeightArray(result.heights, result.columnCount, input.minXValue,
+                                 input.minZValue,
+                                 gridStep(input.minXValue, input.maxXValue, result.columnCount),
+                                 gridStep(input.minZValue, input.maxZValue, result.rowCount));
+        m_resolvedRows = result.rowCount;
+    } else {
+        qptr()->resetArray(0);
+        m_resolvedRows = 0;
+    }
+    m_resolvedColumns = result.columnCount;
+    result.array = 0;
+
+    if (input.rawFile.isEmpty())
+        emit qptr()->heightMapChanged(m_heightMap);
+}
+
+// Moves the resolved data to the current value ranges without touching the heights. Returns false
+// if the data no longer has the resolved dimensions.
+bool QHeightMapSurfaceDataProxyPrivate::rescale()
+{
+    if (!m_heightGrid.isNull()) {
+        if (m_heightGrid.columnCount != m_resolvedColumns
+                || m_heightGrid.heights.size() != m_resolvedColumns * m_resolvedRows) {
+            return false;
+        }
+        // Shares the heights with the current grid, which is reset first
+        const QVector<float> heights = m_heightGrid.heights;
+        qptr()->resetHeightArray(heights, m_resolvedColumns, m_minXValue, m_minZValue,
+                                 gridStep(m_minXValue, m_maxXValue, m_resolvedColumns),
+                                 gridStep(m_minZValue, m_maxZValue, m_resolvedRows));
+        return true;
+    }
+
+    if (m_dataArray->size() != m_resolvedRows)
+        return false;
+    foreach (QSurfaceDataRow *row, *m_dataArray) {
+        if (row->size() != m_resolvedColumns)
+            return false;
+    }
+
+    const float xMul = (m_maxXValue - m_minXValue) / float(m_resolvedColumns - 1);
+    const float zMul = (m_maxZValue - m_minZValue) / float(m_resolvedRows - 1);
+    const int lastRow = m_resolvedRows - 1;
+    const int lastCol = m_resolvedColumns - 1;
+    for (int i = 0; i < m_resolvedRows; i++) {
+        QSurfaceDataRow &row = *m_dataArray->at(i);
+        const float zVal = i == lastRow ? m_maxZValue : (float(i) * zMul) + m_minZValue;
+        for (int j = 0; j < m_resolvedColumns; j++) {
+            const float xVal = j == lastCol ? m_maxXValue : (float(j) * xMul) + m_minXValue;
+            row[j].setPosition(QVector3D(xVal, row.at(j).y(), zVal));
+        }
+    }
+    qptr()->resetArray(m_dataArray);
+    return true;
+}
+
+// Resolves the height map of the input. Only reads the input, so it can be run in a worker thread.
+void QHeightMapSurfaceDataProxyPrivate::resolve(const ResolveInput &input, ResolveResult &result)
+{
+    if (!input.rawFile.isEmpty())
+        resolveRawFile(input, result);
+    else if (!resolveHighBitDepthImage(input.image, result))
+        result.array = convertImage(input, result.columnCount);
+}
+
+QSurfaceDataArray *QHeightMapSurfaceDataProxyPrivate::convertImage(const ResolveInput &input,
+                                                                   int &columnCount)
+{
+    QImage heightImage = input.image;
 
     // Convert to RGB32 to be sure we're reading the right bytes
     if (heightImage.format() != QImage::Format_RGB32)
         heightImage = heightImage.convertToFormat(QImage::Format_RGB32);
 
-    uchar *bits = heightImage.bits();
+    const uchar *bits = heightImage.constBits();
 
     int imageHeight = heightImage.height();
     int imageWidth = heightImage.width();
     int bitCount = imageWidth * 4 * (imageHeight - 1);
     int widthBits = imageWidth * 4;
     float height = 0;
+    columnCount = imageWidth;
 
-    // Do not recreate array if dimensions have not changed
-    QSurfaceDataArray *dataArray = m_dataArray;
-    if (imageWidth != qptr()->columnCount() || imageHeight != dataArray->size()) {
-        dataArray = new QSurfaceDataArray;
-        dataArray->reserve(imageHeight);
-        for (int i = 0; i < imageHeight; i++) {
-            QSurfaceDataRow *newProxyRow = new QSurfaceDataRow(imageWidth);
-            dataArray->append(newProxyRow);
-        }
+    QSurfaceDataArray *dataArray = new QSurfaceDataArray;
+    dataArray->reserve(imageHeight);
+    for (int i = 0; i < imageHeight; i++) {
+        QSurfaceDataRow *newProxyRow = new QSurfaceDataRow(imageWidth);
+        dataArray->append(newProxyRow);
     }
 
-    float xMul = (m_maxXValue - m_minXValue) / float(imageWidth - 1);
-    float zMul = (m_maxZValue - m_minZValue) / float(imageHeight - 1);
+    float xMul = (input.maxXValue - input.minXValue) / float(imageWidth - 1);
+    float zMul = (input.maxZValue - input.minZValue) / float(imageHeight - 1);
 
     // Last row and column are explicitly set to max values, as relying
     // on multiplier can cause rounding errors, resulting in the value being
@@ -548,15 +803,15 @@ void QHeightMapSurfaceDataProxyPrivate::handlePendingResolve()
             QSurfaceDataRow &newRow = *dataArray->at(i);
             float zVal;
             if (i == lastRow)
-                zVal = m_maxZValue;
+                zVal = input.maxZValue;
             else
-                zVal = (float(i) * zMul) + m_minZValue;
+                zVal = (float(i) * zMul) + input.minZValue;
             int j = 0;
             for (; j < lastCol; j++)
-                newRow[j].setPosition(QVector3D((float(j) * xMul) + m_minXValue,
+                newRow[j].setPosition(QVector3D((float(j) * xMul) + input.minXValue,
                                                 float(bits[bitCount + (j * 4)]),
                                       zVal));
-            newRow[j].setPosition(QVector3D(m_maxXValue,
+            newRow[j].setPosition(QVector3D(input.maxXValue,
                                             float(bits[bitCount + (j * 4)]),
                                   zVal));
         }
@@ -566,9 +821,9 @@ void QHeightMapSurfaceDataProxyPrivate::handlePendingResolve()
             QSurfaceDataRow &newRow = *dataArray->at(i);
             float zVal;
             if (i == lastRow)
-                zVal = m_maxZValue;
+                zVal = input.maxZValue;
             else
-                zVal = (float(i) * zMul) + m_minZValue;
+                zVal = (float(i) * zMul) + input.minZValue;
             int j = 0;
             int nextpixel = 0;
             for (; j < lastCol; j++) {
@@ -576,7 +831,7 @@ void QHeightMapSurfaceDataProxyPrivate::handlePendingResolve()
                 height = (float(bits[bitCount + nextpixel])
                         + float(bits[1 + bitCount + nextpixel])
                         + float(bits[2 + bitCount + nextpixel]));
-                newRow[j].setPosition(QVector3D((float(j) * xMul) + m_minXValue,
+                newRow[j].setPosition(QVector3D((float(j) * xMul) + input.minXValue,
                                                 height / 3.0f,
                                                 zVal));
             }
@@ -584,14 +839,172 @@ void QHeightMapSurfaceDataProxyPrivate::handlePendingResolve()
             height = (float(bits[bitCount + nextpixel])
                     + float(bits[1 + bitCount + nextpixel])
                     + float(bits[2 + bitCount + nextpixel]));
-            newRow[j].setPosition(QVector3D(m_maxXValue,
+            newRow[j].setPosition(QVector3D(input.maxXValue,
                                             height / 3.0f,
                                             zVal));
         }
     }
 
-    qptr()->resetArray(dataArray);
-    emit qptr()->heightMapChanged(m_heightMap);
+    return dataArray;
+}
+
+// Reads images with 16 bits per color component straight into a height array. Returns false
+// for other formats.
+bool QHeightMapSurfaceDataProxyPrivate::resolveHighBitDepthImage(const QImage &image,
+                                                                 ResolveResult &result)
+{
+    HeightSamples samples;
+    switch (image.format()) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+        samples.format = SampleUInt16;
+        break;
+    case QImage::Format_RGBX64:
+    case QImage::Format_RGBA64:
+    case QImage::Format_RGBA64_Premultiplied:
+        samples.format = SampleRgba64;
+        break;
+#endif
+    default:
+        return false;
+    }
+
+    samples.data = image.constBits();
+    samples.bytesPerLine = image.bytesPerLine();
+    samples.columns = image.width();
+    samples.rows = image.height();
+    resolveSamples(samples, result);
+    return true;
+}
+
+void QHeightMapSurfaceDataProxyPrivate::resolveRawFile(const ResolveInput &input,
+                                                       ResolveResult &result)
+{
+    QFile file(input.rawFile);
+    const qint64 sampleSize =
+            input.rawFormat == QHeightMapSurfaceDataProxy::RawHeightFloat32 ? 4 : 2;
+    const qint64 bytesPerLine = qint64(qMax(input.rawColumnCount, 0)) * sampleSize;
+    if (!bytesPerLine || !file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Warning: Cannot read raw height map file" << input.rawFile
+                   << "with" << input.rawColumnCount << "columns.";
+        return;
+    }
+
+    HeightSamples samples;
+    samples.bytesPerLine = bytesPerLine;
+    samples.format = sampleSize == 4 ? SampleFloat32 : SampleUInt16;
+    samples.columns = input.rawColumnCount;
+    samples.rows = int(file.size() / bytesPerLine);
+    if (!samples.rows)
+        return;
+
+    // Mapping the file lets the rows be converted straight from the page cache. Reading the
+    // file is the fallback for file systems that don't support mapping.
+    const qint64 size = bytesPerLine * samples.rows;
+    QByteArray contents;
+    samples.data = file.map(0, size);
+    if (!samples.data) {
+        contents = file.read(size);
+        samples.data = reinterpret_cast<const uchar *>(contents.constData());
+    }
+    resolveSamples(samples, result);
+}
+
+class QHeightMapSurfaceDataProxyPrivate::ConversionTask : public QRunnable
+{
+public:
+    ConversionTask(const HeightSamples &samples, float *heights, int fromRow, int toRow,
+                   QSemaphore &done)
+        : m_samples(samples),
+          m_heights(heights),
+          m_fromRow(fromRow),
+          m_toRow(toRow),
+          m_done(done)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        convertRows(m_samples, m_heights, m_fromRow, m_toRow);
+        m_done.release();
+    }
+
+private:
+    const HeightSamples &m_samples;
+    float *m_heights;
+    int m_fromRow;
+    int m_toRow;
+    QSemaphore &m_done;
+};
+
+// Converts the samples to a height array, splitting large arrays into row ranges converted in
+// parallel in the global thread pool, with the last range done on the calling thread.
+// The calling thread may itself be a pool thread, so ranges that no pool thread has picked up
+// by the time it is done are converted on the calling thread too, instead of waiting for them.
+void QHeightMapSurfaceDataProxyPrivate::resolveSamples(const HeightSamples &samples,
+                                                       ResolveResult &result)
+{
+    QVector<float> &heights = result.heights;
+    heights.resize(samples.columns * samples.rows);
+    float *data = heights.data();
+
+    const int taskCount = qMin(QThread::idealThreadCount(),
+                               heights.size() / conversionTaskMinSize);
+    int fromRow = 0;
+    if (taskCount > 1) {
+        QThreadPool *pool = QThreadPool::globalInstance();
+        const int rangeSize = samples.rows / taskCount;
+        QSemaphore done;
+        QVector<ConversionTask *> tasks;
+        for (int i = 1; i < taskCount; i++) {
+            ConversionTask *task = new ConversionTask(samples, data, fromRow,
+                                                      fromRow + rangeSize, done);
+            tasks.append(task);
+            pool->start(task);
+            fromRow += rangeSize;
+        }
+        convertRows(samples, data, fromRow, samples.rows);
+        foreach (ConversionTask *task, tasks) {
+            if (pool->tryTake(task))
+                task->run();
+        }
+        done.acquire(taskCount - 1);
+        qDeleteAll(tasks);
+    } else {
+        convertRows(samples, data, fromRow, samples.rows);
+    }
+
+    result.columnCount = samples.columns;
+    result.rowCount = samples.rows;
+}
+
+// Converts the sample rows to the height array rows fromRow to toRow. The last sample row is the
+// first height array row, as it has the minimum Z value.
+void QHeightMapSurfaceDataProxyPrivate::convertRows(const HeightSamples &samples, float *heights,
+                                                    int fromRow, int toRow)
+{
+    for (int i = fromRow; i < toRow; i++) {
+        const uchar *line = samples.data + qint64(samples.rows - 1 - i) * samples.bytesPerLine;
+        float *row = heights + qint64(i) * samples.columns;
+        switch (samples.format) {
+        case SampleUInt16: {
+            const quint16 *values = reinterpret_cast<const quint16 *>(line);
+            for (int j = 0; j < samples.columns; j++)
+                row[j] = float(values[j]);
+            break;
+        }
+        case SampleRgba64: {
+            const quint16 *values = reinterpret_cast<const quint16 *>(line);
+            for (int j = 0; j < samples.columns; j++, values += 4)
+                row[j] = (float(values[0]) + float(values[1]) + float(values[2])) / 3.0f;
+            break;
+        }
+        case SampleFloat32:
+            memcpy(row, line, samples.columns * sizeof(float));
+            break;
+        }
+    }
 }
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -41,6 +41,7 @@ class QHeightMapSurfaceDataProxyPrivate;
 class QT_DATAVISUALIZATION_EXPORT QHeightMapSurfaceDataProxy : public QSurfaceDataProxy
 {
     Q_OBJECT
+    Q_ENUMS(RawHeightFormat)
 
     Q_PROPERTY(QImage heightMap READ heightMap WRITE setHeightMap NOTIFY heightMapChanged)
     Q_PROPERTY(QString heightMapFile READ heightMapFile WRITE setHeightMapFile NOTIFY heightMapFileChanged)
@@ -50,6 +51,11 @@ class QT_DATAVISUALIZATION_EXPORT QHeightMapSurfaceDataProxy : public QSurfaceDa
     Q_PROPERTY(float maxZValue READ maxZValue WRITE setMaxZValue NOTIFY maxZValueChanged)
 
 public:
+    enum RawHeightFormat {
+        RawHeightUInt16,
+        RawHeightFloat32
+    };
+
     explicit QHeightMapSurfaceDataProxy(QObject *parent = nullptr);
     explicit QHeightMapSurfaceDataProxy(const QImage &image, QObject *parent = nullptr);
     explicit QHeightMapSurfaceDataProxy(const QString &filename, QObject *parent = nullptr);
@@ -59,6 +65,7 @@ public:
     QImage heightMap() const;
     void setHeightMapFile(const QString &filename);
     QString heightMapFile() const;
+    void setRawHeightMapFile(const QString &filename, int columnCount, RawHeightFormat format);
 
     void setValueRanges(float minX, float maxX, float minZ, float maxZ);
     void setMinXValue(float min);
@@ -59,12 +59,68 @@ public:
     void setMaxXValue(float max);
     void setMinZValue(float min);
     void setMaxZValue(float max);
+
+public Q_SLOTS:
+    void handleResolveFinished();
+
 private:
+    class ConversionTask;
+    class ResolveTask;
+
+    enum SampleFormat {
+        SampleUInt16,
+        SampleRgba64, // Height is the average of the 16-bit red, green, and blue components
+        SampleFloat32
+    };
+
+    // Rows of height samples, top row first like in images
+    struct HeightSamples {
+        const uchar *data;
+        qint64 bytesPerLine;
+        SampleFormat format;
+        int columns;
+        int rows;
+    };
+
+    // Copy of the height map and value ranges, so that they can be resolved in a worker thread
+    struct ResolveInput {
+        QImage image;
+        QString rawFile;
+        int rawColumnCount;
+        QHeightMapSurfaceDataProxy::RawHeightFormat rawFormat;
+        float minXValue;
+        float maxXValue;
+        float minZValue;
+        float maxZValue;
+    };
+
+    // Item array for 8-bit images, heights for everything else
+    struct ResolveResult {
+        ResolveResult() : array(0), columnCount(0), rowCount(0) {}
+        QSurfaceDataArray *array;
+        QVector<float> heights;
+        int columnCount;
+        int rowCount;
+    };
+
     QHeightMapSurfaceDataProxy *qptr();
+    void scheduleResolve(bool heightsChanged);
     void handlePendingResolve();
+    void applyResult(const ResolveInput &input, ResolveResult &result);
+    bool rescale();
+    static void resolve(const ResolveInput &input, ResolveResult &result);
+    static QSurfaceDataArray *convertImage(const ResolveInput &input, int &columnCount);
+    static bool resolveHighBitDepthImage(const QImage &image, ResolveResult &result);
+    static void resolveRawFile(const ResolveInput &input, ResolveResult &result);
+    static void resolveSamples(const HeightSamples &samples, ResolveResult &result);
+    static void convertRows(const HeightSamples &samples, float *heights, int fromRow,
+                            int toRow);
 
     QImage m_heightMap;
     QString m_heightMapFile;
+    QString m_rawFile;
+    int m_rawColumnCount;
+    QHeightMapSurfaceDataProxy::RawHeightFormat m_rawFormat;
     QTimer m_resolveTimer;
 
     float m_minXValue;
@@ -72,6 +128,12 @@ private:
     float m_minZValue;
     float m_maxZValue;
 
+    bool m_heightsDirty;
+    bool m_resolvePending;
+    int m_resolvedColumns;
+    int m_resolvedRows;
+    ResolveTask *m_resolveTask;
+
     friend class QHeightMapSurfaceDataProxy;
 };
 
@@ -46,6 +46,9 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
  * QtDataVisualization::QScatterDataArray and QScatterDataItem objects passed to
  * it.
  *
+ * Alternatively, the proxy can borrow item data from a caller owned float
+ * buffer without copying it. See setExternalBuffer() for details.
+ *
  * \sa {Qt Data Visualization Data Handling}
  */
 
@@ -122,9 +125,12 @@ QScatter3DSeries *QScatterDataProxy::series() const
  * just triggers the arrayReset() signal.
  *
  * Passing a null array deletes the old array and creates a new empty array.
+ *
+ * If an external buffer is set, it is released.
  */
 void QScatterDataProxy::resetArray(QScatterDataArray *newArray)
 {
+    dptr()->releaseExternalBuffer();
     if (dptr()->m_dataArray != newArray)
         dptr()->resetArray(newArray);
 
@@ -137,6 +143,10 @@ void QScatterDataProxy::resetArray(QScatterDataArray *newArray)
  */
 void QScatterDataProxy::setItem(int index, const QScatterDataItem &item)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return;
+    }
     dptr()->setItem(index, item);
     emit itemsChanged(index, 1);
 }
@@ -147,17 +157,31 @@ void QScatterDataProxy::setItem(int index, const QScatterDataItem &item)
  */
 void QScatterDataProxy::setItems(int index, const QScatterDataArray &items)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return;
+    }
     dptr()->setItems(index, items);
     emit itemsChanged(index, items.size());
 }
 
 /*!
- * Adds the item \a item to the end of the array.
+ * Adds the item \a item to the end of the array. If a ring buffer capacity is
+ * set and the array is full, the item replaces the oldest item instead.
  *
  * Returns the index of the added item.
+ *
+ * \sa setRingBufferCapacity()
  */
 int QScatterDataProxy::addItem(const QScatterDataItem &item)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return -1;
+    }
+    if (dptrc()->m_ringBufferCapacity)
+        return dptr()->addRingBufferItems(QScatterDataArray() << item);
+
     int addIndex = dptr()->addItem(item);
     emit itemsAdded(addIndex, 1);
     emit itemCountChanged(itemCount());
@@ -165,12 +189,23 @@ int QScatterDataProxy::addItem(const QScatterDataItem &item)
 }
 
 /*!
- * Adds the items specified by \a items to the end of the array.
+ * Adds the items specified by \a items to the end of the array. If a ring
+ * buffer capacity is set, the items that do not fit replace the oldest items
+ * instead.
  *
  * Returns the index of the first added item.
+ *
+ * \sa setRingBufferCapacity()
  */
 int QScatterDataProxy::addItems(const QScatterDataArray &items)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return -1;
+    }
+    if (dptrc()->m_ringBufferCapacity)
+        return dptr()->addRingBufferItems(items);
+
     int addIndex = dptr()->addItems(items);
     emit itemsAdded(addIndex, items.size());
     emit itemCountChanged(itemCount());
@@ -183,6 +218,10 @@ int QScatterDataProxy::addItems(const QScatterDataArray &items)
  */
 void QScatterDataProxy::insertItem(int index, const QScatterDataItem &item)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return;
+    }
     dptr()->insertItem(index, item);
     emit itemsInserted(index, 1);
     emit itemCountChanged(itemCount());
@@ -194,6 +233,10 @@ void QScatterDataProxy::insertItem(int index, const QScatterDataItem &item)
  */
 void QScatterDataProxy::insertItems(int index, const QScatterDataArray &items)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return;
+    }
     dptr()->insertItems(index, items);
     emit itemsInserted(index, items.size());
     emit itemCountChanged(itemCount());
@@ -206,6 +249,11 @@ void QScatterDataProxy::insertItems(int index, const QScatterDataArray &items)
  */
 void QScatterDataProxy::removeItems(int index, int removeCount)
 {
+    if (dptrc()->hasExternalBuffer()) {
+        qWarning() << __FUNCTION__ << "Cannot modify items while an external buffer is set.";
+        return;
+    }
+
     if (index >= dptr()->m_dataArray->size())
         return;
 
@@ -221,11 +269,14 @@ void QScatterDataProxy::removeItems(int index, int removeCount)
  */
 int QScatterDataProxy::itemCount() const
 {
-    return dptrc()->m_dataArray->size();
+    return dptrc()->itemCount();
 }
 
 /*!
- * Returns the pointer to the data array.
+ * Returns the pointer to the data array. The array is empty while an external
+ * buffer is set.
+ *
+ * \sa setExternalBuffer()
  */
 const QScatterDataArray *QScatterDataProxy::array() const
 {
@@ -235,10 +286,142 @@ const QScatterDataArray *QScatterDataProxy::array() const
 /*!
  * Returns the pointer to the item at the index \a index. It is guaranteed to be
  * valid only until the next call that modifies data.
+ *
+ * While an external buffer is set, the returned item is a copy of the buffer
+ * contents that is valid only until the next call to this function.
  */
 const QScatterDataItem *QScatterDataProxy::itemAt(int index) const
 {
-    return &dptrc()->m_dataArray->at(index);
+    const QScatterDataProxyPrivate *d = dptrc();
+    if (d->hasExternalBuffer()) {
+        d->m_externalItem.setPosition(d->m_externalBuffer.positionAt(index));
+        d->m_externalItem.setRotation(d->m_externalBuffer.rotationAt(index));
+        return &d->m_externalItem;
+    }
+    return &d->m_dataArray->at(index);
+}
+
+/*!
+ * Makes the proxy use the caller owned buffer \a positions for its \a count
+ * items instead of its own data array, so that the data does not need to be
+ * copied. The existing data array is cleared.
+ *
+ * Each item position is read as three consecutive floats for x, y, and z, and
+ * consecutive items are \a positionStride floats apart. Optionally, item
+ * rotations are read from \a rotations as four consecutive floats for x, y, z,
+ * and scalar, with consecutive items \a rotationStride floats apart. If
+ * \a rotations is null, no item is rotated.
+ *
+ * The proxy does not take ownership of the buffers. They must stay valid until
+ * releaseExternalBuffer(), resetArray(), or this function is called again, or
+ * the proxy is deleted. The graph reads the buffers when it synchronizes data
+ * for rendering, so the caller can modify their contents between frames and
+ * then call invalidateExternalBuffer() for the changed items, or this function
+ * if the item count or the buffer addresses change.
+ *
+ * Functions that add, change, or remove individual items are not supported
+ * while an external buffer is set.
+ *
+ * \sa invalidateExternalBuffer(), releaseExternalBuffer()
+ */
+void QScatterDataProxy::setExternalBuffer(const float *positions, int count, int positionStride,
+                                          const float *rotations, int rotationStride)
+{
+    if (!positions || count < 0 || positionStride < 3 || (rotations && rotationStride < 4)) {
+        qWarning() << __FUNCTION__ << "Invalid external buffer.";
+        return;
+    }
+
+    dptr()->setExternalBuffer(positions, count, positionStride, rotations, rotationStride);
+
+    emit arrayReset();
+    emit itemCountChanged(itemCount());
+}
+
+/*!
+ * Notifies the graph that the caller has changed the contents of the external
+ * buffer for \a count items starting at the position \a startIndex.
+ *
+ * \sa setExternalBuffer()
+ */
+void QScatterDataProxy::invalidateExternalBuffer(int startIndex, int count)
+{
+    const QScatterDataProxyPrivate *d = dptrc();
+    if (!d->hasExternalBuffer())
+        return;
+
+    startIndex = qMax(startIndex, 0);
+    count = qMin(count, d->itemCount() - startIndex);
+    if (count > 0)
+        emit itemsChanged(startIndex, count);
+}
+
+/*!
+ * Stops using the external buffer and reverts the proxy to an empty data array.
+ * After this function returns, the caller is free to delete the buffer.
+ *
+ * \sa setExternalBuffer()
+ */
+void QScatterDataProxy::releaseExternalBuffer()
+{
+    if (!dptrc()->hasExternalBuffer())
+        return;
+
+    dptr()->releaseExternalBuffer();
+
+    emit arrayReset();
+    emit itemCountChanged(itemCount());
+}
+
+/*!
+ * Sets the ring buffer capacity of the proxy to \a capacity items. Once the
+ * array holds \a capacity items, addItem() and addItems() overwrite the oldest
+ * items instead of growing the array, and the overwritten items are reported
+ * with the itemsChanged() signal. This makes the proxy suitable for rolling
+ * window displays of streamed data, as the graph only needs to update the
+ * overwritten items.
+ *
+ * If the array holds more items than the new capacity, the oldest items are
+ * removed. Setting the capacity to zero, which is the default, disables the
+ * ring buffer. Inserting or removing items restarts overwriting from the
+ * beginning of the array.
+ *
+ * \sa ringBufferCapacity()
+ */
+void QScatterDataProxy::setRingBufferCapacity(int capacity)
+{
+    if (capacity < 0) {
+        qWarning() << __FUNCTION__ << "Cannot set negative value.";
+        return;
+    }
+    if (capacity == dptrc()->m_ringBufferCapacity)
+        return;
+
+    if (dptr()->setRingBufferCapacity(capacity)) {
+        emit arrayReset();
+        emit itemCountChanged(itemCount());
+    }
+}
+
+/*!
+ * Returns the ring buffer capacity of the proxy, or zero if the ring buffer is
+ * disabled.
+ *
+ * \sa setRingBufferCapacity()
+ */
+int QScatterDataProxy::ringBufferCapacity() const
+{
+    return dptrc()->m_ringBufferCapacity;
+}
+
+/*!
+ * Returns \c true if the proxy currently uses an external buffer.
+ *
+ * \sa setExternalBuffer()
+ */
+bool QScatterDataProxy::hasExternalBuffer() const
+{
+    return dptrc()->hasExternalBuffer();
 }
 
 /*!
@@ -306,7 +489,9 @@ const QScatterDataProxyPrivate *QScatterDataProxy::dptrc() const
 
 QScatterDataProxyPrivate::QScatterDataProxyPrivate(QScatterDataProxy *q)
     : QAbstractDataProxyPrivate(q, QAbstractDataProxy::DataTypeScatter),
-      m_dataArray(new QScatterDataArray)
+      m_dataArray(new QScatterDataArray),
+      m_ringBufferCapacity(0),
+      m_ringBufferHead(0)
 {
 }
 
@@ -326,6 +511,10 @@ void QScatterDataProxyPrivate::resetArray(QScatterDataArray *newArray)
         delete m_dataArray;
         m_dataArray = newArray;
     }
+
+    m_ringBufferHead = 0;
+    if (m_ringBufferCapacity && m_dataArray->size() > m_ringBufferCapacity)
+        m_dataArray->remove(0, m_dataArray->size() - m_ringBufferCapacity);
 }
 
 void QScatterDataProxyPrivate::setItem(int index, const QScatterDataItem &item)
@@ -359,6 +548,7 @@ void QScatterDataProxyPrivate::insertItem(int index, const QScatterDataItem &ite
 {
     Q_ASSERT(index >= 0 && index <= m_dataArray->size());
     m_dataArray->insert(index, item);
+    m_ringBufferHead = 0;
 }
 
 void QScatterDataProxyPrivate::insertItems(int index, const QScatterDataArray &items)
@@ -366,6 +556,7 @@ void QScatterDataProxyPrivate::insertItems(int index, const QScatterDataArray &i
     Q_ASSERT(index >= 0 && index <= m_dataArray->size());
     for (int i = 0; i < items.size(); i++)
         m_dataArray->insert(index++, items.at(i));
+    m_ringBufferHead = 0;
 }
 
 void QScatterDataProxyPrivate::removeItems(int index, int removeCount)
@@ -374,16 +565,97 @@ void QScatterDataProxyPrivate::removeItems(int index, int removeCount)
     int maxRemoveCount = m_dataArray->size() - index;
     removeCount = qMin(removeCount, maxRemoveCount);
     m_dataArray->remove(index, removeCount);
+    m_ringBufferHead = 0;
+}
+
+// Adds items to a proxy with a ring buffer capacity and emits the signals for the items that
+// were appended and overwritten.
+int QScatterDataProxyPrivate::addRingBufferItems(const QScatterDataArray &items)
+{
+    QScatterDataProxy *q = qptr();
+    int source = 0;
+    int count = items.size();
+    int firstIndex = -1;
+
+    // Items that would be overwritten by later items of the same call are skipped
+    if (count > m_ringBufferCapacity) {
+        source = count - m_ringBufferCapacity;
+        count = m_ringBufferCapacity;
+    }
+
+    const int currentSize = m_dataArray->size();
+    const int appendCount = qMin(count, m_ringBufferCapacity - currentSize);
+    if (appendCount > 0) {
+        firstIndex = currentSize;
+        m_dataArray->reserve(currentSize + appendCount);
+        for (int i = 0; i < appendCount; i++)
+            m_dataArray->append(items.at(source++));
+        count -= appendCount;
+        emit q->itemsAdded(currentSize, appendCount);
+        emit q->itemCountChanged(m_dataArray->size());
+    }
+
+    while (count > 0) {
+        const int writeCount = qMin(count, m_ringBufferCapacity - m_ringBufferHead);
+        if (firstIndex < 0)
+            firstIndex = m_ringBufferHead;
+        for (int i = 0; i < writeCount; i++)
+            (*m_dataArray)[m_ringBufferHead + i] = items.at(source++);
+        count -= writeCount;
+        emit q->itemsChanged(m_ringBufferHead, writeCount);
+        m_ringBufferHead = (m_ringBufferHead + writeCount) % m_ringBufferCapacity;
+    }
+
+    return firstIndex;
+}
+
+// Returns true if the array had to be reordered or truncated to fit the new capacity.
+bool QScatterDataProxyPrivate::setRingBufferCapacity(int capacity)
+{
+    bool arrayChanged = false;
+    if (m_ringBufferHead) {
+        // Move the oldest items to the beginning of the array
+        *m_dataArray = m_dataArray->mid(m_ringBufferHead) + m_dataArray->mid(0, m_ringBufferHead);
+        m_ringBufferHead = 0;
+        arrayChanged = true;
+    }
+
+    m_ringBufferCapacity = capacity;
+    if (capacity && m_dataArray->size() > capacity) {
+        m_dataArray->remove(0, m_dataArray->size() - capacity);
+        arrayChanged = true;
+    }
+
+    return arrayChanged;
+}
+
+void QScatterDataProxyPrivate::setExternalBuffer(const float *positions, int count,
+                                                 int positionStride, const float *rotations,
+                                                 int rotationStride)
+{
+    m_dataArray->clear();
+
+    m_externalBuffer.positions = positions;
+    m_externalBuffer.positionStride = positionStride;
+    m_externalBuffer.rotations = rotations;
+    m_externalBuffer.rotationStride = rotationStride;
+    m_externalBuffer.itemCount = count;
+}
+
+void QScatterDataProxyPrivate::releaseExternalBuffer()
+{
+    m_externalBuffer = ScatterBufferSource();
 }
 
 void QScatterDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxValues,
                                            QAbstract3DAxis *axisX, QAbstract3DAxis *axisY,
                                            QAbstract3DAxis *axisZ) const
 {
-    if (m_dataArray->isEmpty())
+    const int count = itemCount();
+    if (!count)
         return;
 
-    const QVector3D &firstPos = m_dataArray->at(0).position();
+    const QVector3D firstPos = positionAt(0);
 
     float minX = firstPos.x();
     float maxX = minX;
@@ -392,9 +664,9 @@ void QScatterDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxV
     float minZ = firstPos.z();
     float maxZ = minZ;
 
-    if (m_dataArray->size() > 1) {
-        for (int i = 1; i < m_dataArray->size(); i++) {
-            const QVector3D &pos = m_dataArray->at(i).position();
+    if (count > 1) {
+        for (int i = 1; i < count; i++) {
+            const QVector3D pos = positionAt(i);
 
             float value = pos.x();
             if (qIsNaN(value) || qIsInf(value))
@@ -71,6 +71,15 @@ public:
 
     void removeItems(int index, int removeCount);
 
+    void setExternalBuffer(const float *positions, int count, int positionStride = 3,
+                           const float *rotations = nullptr, int rotationStride = 4);
+    void invalidateExternalBuffer(int startIndex, int count);
+    void releaseExternalBuffer();
+    bool hasExternalBuffer() const;
+
+    void setRingBufferCapacity(int capacity);
+    int ringBufferCapacity() const;
+
 Q_SIGNALS:
     void arrayReset();
     void itemsAdded(int startIndex, int count);
@@ -90,6 +99,7 @@ private:
     Q_DISABLE_COPY(QScatterDataProxy)
 
     friend class Scatter3DController;
+    friend class Scatter3DRenderer;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -48,6 +48,56 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 class QAbstract3DAxis;
 
+// Item access for caller owned data in external buffer mode. Strides are in floats and
+// rotations are stored as x, y, z, and scalar.
+struct ScatterBufferSource
+{
+    ScatterBufferSource()
+        : positions(0),
+          positionStride(3),
+          rotations(0),
+          rotationStride(4),
+          itemCount(0)
+    {
+    }
+
+    inline QVector3D positionAt(int index) const
+    {
+        const float *position = positions + index * positionStride;
+        return QVector3D(position[0], position[1], position[2]);
+    }
+    inline bool hasRotations() const { return rotations; }
+    inline QQuaternion rotationAt(int index) const
+    {
+        if (!rotations)
+            return QQuaternion();
+        const float *rotation = rotations + index * rotationStride;
+        return QQuaternion(rotation[3], rotation[0], rotation[1], rotation[2]);
+    }
+
+    const float *positions;
+    int positionStride;
+    const float *rotations;
+    int rotationStride;
+    int itemCount;
+};
+
+// Item access for proxy owned data, with the same interface as ScatterBufferSource so that
+// item loops can be written once for both.
+struct ScatterArraySource
+{
+    explicit ScatterArraySource(const QScatterDataArray &array)
+        : items(array.constData())
+    {
+    }
+
+    inline QVector3D positionAt(int index) const { return items[index].position(); }
+    inline bool hasRotations() const { return true; }
+    inline QQuaternion rotationAt(int index) const { return items[index].rotation(); }
+
+    const QScatterDataItem *items;
+};
+
 class QScatterDataProxyPrivate : public QAbstractDataProxyPrivate
 {
     Q_OBJECT
@@ -63,14 +113,41 @@ public:
     void insertItem(int index, const QScatterDataItem &item);
     void insertItems(int index, const QScatterDataArray &items);
     void removeItems(int index, int removeCount);
+    int addRingBufferItems(const QScatterDataArray &items);
+    bool setRingBufferCapacity(int capacity);
     void limitValues(QVector3D &minValues, QVector3D &maxValues, QAbstract3DAxis *axisX,
                      QAbstract3DAxis *axisY, QAbstract3DAxis *axisZ) const;
     bool isValidValue(float axisValue, float value, QAbstract3DAxis *axis) const;
 
+    void setExternalBuffer(const float *positions, int count, int positionStride,
+                           const float *rotations, int rotationStride);
+    void releaseExternalBuffer();
+    inline bool hasExternalBuffer() const { return m_externalBuffer.positions; }
+    inline const ScatterBufferSource &externalBuffer() const { return m_externalBuffer; }
+    inline const QScatterDataArray &dataArray() const { return *m_dataArray; }
+    inline int itemCount() const
+    {
+        return hasExternalBuffer() ? m_externalBuffer.itemCount : m_dataArray->size();
+    }
+    inline QVector3D positionAt(int index) const
+    {
+        return hasExternalBuffer() ? m_externalBuffer.positionAt(index)
+                                   : m_dataArray->at(index).position();
+    }
+    inline QQuaternion rotationAt(int index) const
+    {
+        return hasExternalBuffer() ? m_externalBuffer.rotationAt(index)
+                                   : m_dataArray->at(index).rotation();
+    }
+
     virtual void setSeries(QAbstract3DSeries *series);
 private:
     QScatterDataProxy *qptr();
     QScatterDataArray *m_dataArray;
+    ScatterBufferSource m_externalBuffer; // Not owned
+    mutable QScatterDataItem m_externalItem; // Returned by itemAt() in external buffer mode
+    int m_ringBufferCapacity; // Zero if items are always appended
+    int m_ringBufferHead; // Index of the oldest item in a full ring buffer
 
     friend class QScatterDataProxy;
 };
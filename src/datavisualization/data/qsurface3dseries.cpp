@@ -29,6 +29,7 @@
 
 #include "qsurface3dseries_p.h"
 #include "surface3dcontroller_p.h"
+#include "qsurfacedataproxy_p.h"
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -469,6 +470,8 @@ void QSurface3DSeriesPrivate::connectControllerAndProxy(Abstract3DController *ne
                          &Surface3DController::handleRowsInserted);
         QObject::connect(surfaceDataProxy, &QSurfaceDataProxy::itemChanged, controller,
                          &Surface3DController::handleItemChanged);
+        QObject::connect(surfaceDataProxy, &QSurfaceDataProxy::rowsShifted, controller,
+                         &Surface3DController::handleRowsShifted);
         QObject::connect(qptr(), &QSurface3DSeries::dataProxyChanged, controller,
                          &Surface3DController::handleArrayReset);
     }
@@ -492,7 +495,9 @@ void QSurface3DSeriesPrivate::createItemLabel()
     QValue3DAxis *axisX = static_cast<QValue3DAxis *>(m_controller->axisX());
     QValue3DAxis *axisY = static_cast<QValue3DAxis *>(m_controller->axisY());
     QValue3DAxis *axisZ = static_cast<QValue3DAxis *>(m_controller->axisZ());
-    QVector3D selectedPosition = qptr()->dataProxy()->itemAt(m_selectedPoint)->position();
+    // Height arrays don't store the items, so they are not accessed via itemAt()
+    const SurfaceDataView data = qptr()->dataProxy()->dptrc()->dataView();
+    QVector3D selectedPosition = data.item(m_selectedPoint.x(), m_selectedPoint.y()).position();
 
     m_itemLabel = m_itemLabelFormat;
 
@@ -59,6 +59,10 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
  * Similarly, the z-value of each successive item in all columns must be either ascending or
  * descending throughout the column.
  *
+ * Data on an evenly spaced grid can instead be given as a height array with
+ * resetHeightArray(). Only the heights are stored, and the graph uses them without
+ * copying them.
+ *
  * \note Currently only surfaces with straight rows and columns are fully supported. Any row
  * with items that do not have the exact same z-value or any column with items
  * that do not have the exact same x-value may get clipped incorrectly if the
@@ -167,14 +171,66 @@ QSurface3DSeries *QSurfaceDataProxy::series() const
  */
 void QSurfaceDataProxy::resetArray(QSurfaceDataArray *newArray)
 {
-    if (dptr()->m_dataArray != newArray) {
-        dptr()->resetArray(newArray);
-    }
+    dptr()->resetArray(newArray);
     emit arrayReset();
     emit rowCountChanged(rowCount());
     emit columnCountChanged(columnCount());
 }
 
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Resets the proxy to a height array. The \a heights of an evenly spaced grid
+ * with \a columnCount columns are stored row by row, so the number of heights
+ * must be a multiple of \a columnCount.
+ *
+ * The x-value of the items in column \c j is \a originX + \c j * \a stepX,
+ * and the z-value of the items in row \c i is \a originZ + \c i * \a stepZ.
+ *
+ * Only the heights are stored, which takes a fraction of the memory of the
+ * corresponding item array. The graph shares the heights with the proxy instead
+ * of copying them.
+ *
+ * Functions that modify rows or items convert the height array to an item array
+ * first, emitting arrayReset(). Until then, array() returns an empty array, and
+ * itemAt() creates the requested item from its height.
+ *
+ * If \a columnCount is not positive or the number of heights is not a multiple
+ * of it, the proxy is not changed.
+ *
+ * \sa heightArray()
+ */
+void QSurfaceDataProxy::resetHeightArray(const QVector<float> &heights, int columnCount,
+                                         float originX, float originZ,
+                                         float stepX, float stepZ)
+{
+    if (heights.size() && (columnCount <= 0 || heights.size() % columnCount)) {
+        qWarning() << __FUNCTION__ << "Height count must be a multiple of the column count:"
+                   << heights.size() << columnCount;
+        return;
+    }
+
+    dptr()->resetHeightArray(heights, columnCount, originX, originZ, stepX, stepZ);
+    emit arrayReset();
+    emit rowCountChanged(rowCount());
+    emit columnCountChanged(this->columnCount());
+}
+
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Returns the pointer to the height array, or \c nullptr if the proxy holds an
+ * item array.
+ *
+ * \sa resetHeightArray()
+ */
+const QVector<float> *QSurfaceDataProxy::heightArray() const
+{
+    if (dptrc()->m_heightGrid.isNull())
+        return nullptr;
+    return &dptrc()->m_heightGrid.heights;
+}
+
 /*!
  * Changes an existing row by replacing the row at the position \a rowIndex
  * with the new row specified by \a row. The new row can be the same as the
@@ -288,8 +344,51 @@ void QSurfaceDataProxy::removeRows(int rowIndex, int removeCount)
     }
 }
 
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Adds the new row \a row to the end of an array and removes the first row,
+ * so the number of rows stays the same. The new row must have the same number
+ * of columns as the rows in the initial array.
+ *
+ * Shifting is meant for data that scrolls, such as waterfall or spectrogram
+ * displays. If the x and y axis ranges stay the same and the z axis range keeps
+ * its length, a smooth surface only processes and uploads the new row instead of
+ * the whole surface.
+ *
+ * \sa shiftRows(), rowsShifted()
+ */
+void QSurfaceDataProxy::shiftRow(QSurfaceDataRow *row)
+{
+    dptr()->shiftRows(QSurfaceDataArray() << row);
+    emit rowsShifted(1);
+}
+
+/*!
+ * \since QtDataVisualization 1.4
+ *
+ * Adds new \a rows to the end of an array and removes the same number of rows
+ * from its start, so the number of rows stays the same. The new rows must have
+ * the same number of columns as the rows in the initial array, and there can't
+ * be more of them than there are rows in the array.
+ *
+ * \sa shiftRow(), rowsShifted()
+ */
+void QSurfaceDataProxy::shiftRows(const QSurfaceDataArray &rows)
+{
+    if (rows.size()) {
+        dptr()->shiftRows(rows);
+        emit rowsShifted(rows.size());
+    }
+}
+
 /*!
  * Returns the pointer to the data array.
+ *
+ * If the proxy holds a height array set with resetHeightArray(), the returned
+ * array is empty, as the items are not stored. The heights can be read with
+ * heightArray() or itemAt(), and they are converted to items by the functions
+ * that modify rows or items.
  */
 const QSurfaceDataArray *QSurfaceDataProxy::array() const
 {
@@ -300,10 +399,21 @@ const QSurfaceDataArray *QSurfaceDataProxy::array() const
  * Returns the pointer to the item at the position specified by \a rowIndex and
  * \a columnIndex. It is guaranteed to be valid only
  * until the next call that modifies data.
+ *
+ * If the proxy holds a height array, the item is created from its height, and
+ * the pointer is valid only until the next call to this function.
  */
 const QSurfaceDataItem *QSurfaceDataProxy::itemAt(int rowIndex, int columnIndex) const
 {
-    const QSurfaceDataArray &dataArray = *dptrc()->m_dataArray;
+    const QSurfaceDataProxyPrivate *d = dptrc();
+    if (!d->m_heightGrid.isNull()) {
+        Q_ASSERT(rowIndex >= 0 && rowIndex < d->m_heightGrid.rowCount());
+        Q_ASSERT(columnIndex >= 0 && columnIndex < d->m_heightGrid.columnCount);
+        d->m_heightGridItem = d->m_heightGrid.item(rowIndex, columnIndex);
+        return &d->m_heightGridItem;
+    }
+
+    const QSurfaceDataArray &dataArray = *d->m_dataArray;
     Q_ASSERT(rowIndex >= 0 && rowIndex < dataArray.size());
     const QSurfaceDataRow &dataRow = *dataArray[rowIndex];
     Q_ASSERT(columnIndex >= 0 && columnIndex < dataRow.size());
@@ -327,6 +437,8 @@ const QSurfaceDataItem *QSurfaceDataProxy::itemAt(const QPoint &position) const
  */
 int QSurfaceDataProxy::rowCount() const
 {
+    if (!dptrc()->m_heightGrid.isNull())
+        return dptrc()->m_heightGrid.rowCount();
     return dptrc()->m_dataArray->size();
 }
 
@@ -337,7 +449,9 @@ int QSurfaceDataProxy::rowCount() const
  */
 int QSurfaceDataProxy::columnCount() const
 {
-    if (dptrc()->m_dataArray->size() > 0)
+    if (!dptrc()->m_heightGrid.isNull())
+        return dptrc()->m_heightGrid.columnCount;
+    else if (dptrc()->m_dataArray->size() > 0)
         return dptrc()->m_dataArray->at(0)->size();
     else
         return 0;
@@ -415,6 +529,17 @@ const QSurfaceDataProxyPrivate *QSurfaceDataProxy::dptrc() const
  * this signal needs to be emitted to update the graph.
  */
 
+/*!
+ * \fn void QSurfaceDataProxy::rowsShifted(int count)
+ * \since QtDataVisualization 1.4
+ *
+ * This signal is emitted when the number of rows specified by \a count is
+ * added to the end of the array and the same number of rows is removed from
+ * its start.
+ * If rows are shifted in the array without calling shiftRow() or shiftRows(),
+ * this signal needs to be emitted to update the graph.
+ */
+
 //  QSurfaceDataProxyPrivate
 
 QSurfaceDataProxyPrivate::QSurfaceDataProxyPrivate(QSurfaceDataProxy *q)
@@ -437,10 +562,47 @@ void QSurfaceDataProxyPrivate::resetArray(QSurfaceDataArray *newArray)
         clearArray();
         m_dataArray = newArray;
     }
+    m_heightGrid = SurfaceHeightGrid();
+}
+
+void QSurfaceDataProxyPrivate::resetHeightArray(const QVector<float> &heights, int columnCount,
+                                                float originX, float originZ,
+                                                float stepX, float stepZ)
+{
+    resetArray(0);
+
+    if (heights.size()) {
+        m_heightGrid.heights = heights;
+        m_heightGrid.columnCount = columnCount;
+        m_heightGrid.originX = originX;
+        m_heightGrid.originZ = originZ;
+        m_heightGrid.stepX = stepX;
+        m_heightGrid.stepZ = stepZ;
+    }
+}
+
+// Replaces the height grid with the corresponding items, so that they can be modified
+void QSurfaceDataProxyPrivate::convertHeightArray()
+{
+    if (m_heightGrid.isNull())
+        return;
+
+    const int rowCount = m_heightGrid.rowCount();
+    const int columnCount = m_heightGrid.columnCount;
+    m_dataArray->reserve(rowCount);
+    for (int i = 0; i < rowCount; i++) {
+        QSurfaceDataRow *row = new QSurfaceDataRow(columnCount);
+        for (int j = 0; j < columnCount; j++)
+            (*row)[j] = m_heightGrid.item(i, j);
+        m_dataArray->append(row);
+    }
+    m_heightGrid = SurfaceHeightGrid();
+    emit qptr()->arrayReset();
 }
 
 void QSurfaceDataProxyPrivate::setRow(int rowIndex, QSurfaceDataRow *row)
 {
+    convertHeightArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex < m_dataArray->size());
     Q_ASSERT(m_dataArray->at(rowIndex)->size() == row->size());
 
@@ -452,6 +614,7 @@ void QSurfaceDataProxyPrivate::setRow(int rowIndex, QSurfaceDataRow *row)
 
 void QSurfaceDataProxyPrivate::setRows(int rowIndex, const QSurfaceDataArray &rows)
 {
+    convertHeightArray();
     QSurfaceDataArray &dataArray = *m_dataArray;
     Q_ASSERT(rowIndex >= 0 && (rowIndex + rows.size()) <= dataArray.size());
 
@@ -467,6 +630,7 @@ void QSurfaceDataProxyPrivate::setRows(int rowIndex, const QSurfaceDataArray &ro
 
 void QSurfaceDataProxyPrivate::setItem(int rowIndex, int columnIndex, const QSurfaceDataItem &item)
 {
+    convertHeightArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex < m_dataArray->size());
     QSurfaceDataRow &row = *(*m_dataArray)[rowIndex];
     Q_ASSERT(columnIndex < row.size());
@@ -475,6 +639,7 @@ void QSurfaceDataProxyPrivate::setItem(int rowIndex, int columnIndex, const QSur
 
 int QSurfaceDataProxyPrivate::addRow(QSurfaceDataRow *row)
 {
+    convertHeightArray();
     Q_ASSERT(m_dataArray->at(0)->size() == row->size());
     int currentSize = m_dataArray->size();
     m_dataArray->append(row);
@@ -483,6 +648,7 @@ int QSurfaceDataProxyPrivate::addRow(QSurfaceDataRow *row)
 
 int QSurfaceDataProxyPrivate::addRows(const QSurfaceDataArray &rows)
 {
+    convertHeightArray();
     int currentSize = m_dataArray->size();
     for (int i = 0; i < rows.size(); i++) {
         Q_ASSERT(m_dataArray->at(0)->size() == rows.at(i)->size());
@@ -493,6 +659,7 @@ int QSurfaceDataProxyPrivate::addRows(const QSurfaceDataArray &rows)
 
 void QSurfaceDataProxyPrivate::insertRow(int rowIndex, QSurfaceDataRow *row)
 {
+    convertHeightArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex <= m_dataArray->size());
     Q_ASSERT(m_dataArray->at(0)->size() == row->size());
     m_dataArray->insert(rowIndex, row);
@@ -500,6 +667,7 @@ void QSurfaceDataProxyPrivate::insertRow(int rowIndex, QSurfaceDataRow *row)
 
 void QSurfaceDataProxyPrivate::insertRows(int rowIndex, const QSurfaceDataArray &rows)
 {
+    convertHeightArray();
     Q_ASSERT(rowIndex >= 0 && rowIndex <= m_dataArray->size());
 
     for (int i = 0; i < rows.size(); i++) {
@@ -510,6 +678,7 @@ void QSurfaceDataProxyPrivate::insertRows(int rowIndex, const QSurfaceDataArray
 
 void QSurfaceDataProxyPrivate::removeRows(int rowIndex, int removeCount)
 {
+    convertHeightArray();
     Q_ASSERT(rowIndex >= 0);
     int maxRemoveCount = m_dataArray->size() - rowIndex;
     removeCount = qMin(removeCount, maxRemoveCount);
@@ -519,6 +688,19 @@ void QSurfaceDataProxyPrivate::removeRows(int rowIndex, int removeCount)
     }
 }
 
+void QSurfaceDataProxyPrivate::shiftRows(const QSurfaceDataArray &rows)
+{
+    convertHeightArray();
+    Q_ASSERT(rows.size() <= m_dataArray->size());
+
+    for (int i = 0; i < rows.size(); i++) {
+        Q_ASSERT(m_dataArray->at(0)->size() == rows.at(i)->size());
+        clearRow(0);
+        m_dataArray->removeFirst();
+        m_dataArray->append(rows.at(i));
+    }
+}
+
 QSurfaceDataProxy *QSurfaceDataProxyPrivate::qptr()
 {
     return static_cast<QSurfaceDataProxy *>(q_ptr);
@@ -528,6 +710,11 @@ void QSurfaceDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxV
                                            QAbstract3DAxis *axisX, QAbstract3DAxis *axisY,
                                            QAbstract3DAxis *axisZ) const
 {
+    if (!m_heightGrid.isNull()) {
+        limitHeightGridValues(minValues, maxValues, axisX, axisY, axisZ);
+        return;
+    }
+
     float min = 0.0f;
     float max = 0.0f;
 
@@ -605,6 +792,44 @@ void QSurfaceDataProxyPrivate::limitValues(QVector3D &minValues, QVector3D &maxV
     }
 }
 
+void QSurfaceDataProxyPrivate::limitHeightGridValues(QVector3D &minValues, QVector3D &maxValues,
+                                                     QAbstract3DAxis *axisX,
+                                                     QAbstract3DAxis *axisY,
+                                                     QAbstract3DAxis *axisZ) const
+{
+    const QVector<float> &heights = m_heightGrid.heights;
+    float min = heights.at(0);
+    float max = heights.at(0);
+    for (int i = 0; i < heights.size(); i++) {
+        const float itemValue = heights.at(i);
+        if (qIsNaN(itemValue) || qIsInf(itemValue))
+            continue;
+        if (min > itemValue && isValidValue(itemValue, axisY))
+            min = itemValue;
+        if (max < itemValue)
+            max = itemValue;
+    }
+    minValues.setY(min);
+    maxValues.setY(max);
+
+    // Rows and columns of the grid are straight, so the corners give the x and z ranges
+    const QSurfaceDataItem first = m_heightGrid.item(0, 0);
+    const QSurfaceDataItem last = m_heightGrid.item(m_heightGrid.rowCount() - 1,
+                                                    m_heightGrid.columnCount - 1);
+    float xLow = qMin(first.x(), last.x());
+    float xHigh = qMax(first.x(), last.x());
+    float zLow = qMin(first.z(), last.z());
+    float zHigh = qMax(first.z(), last.z());
+    if (!isValidValue(xLow, axisX))
+        xLow = xHigh;
+    if (!isValidValue(zLow, axisZ))
+        zLow = zHigh;
+    minValues.setX(xLow);
+    minValues.setZ(zLow);
+    maxValues.setX(xHigh);
+    maxValues.setZ(zHigh);
+}
+
 bool QSurfaceDataProxyPrivate::isValidValue(float value, QAbstract3DAxis *axis) const
 {
     return (value > 0.0f || (value == 0.0f && axis->d_ptr->allowZero())
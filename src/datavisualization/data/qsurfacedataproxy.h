@@ -63,6 +63,9 @@ public:
     const QSurfaceDataItem *itemAt(const QPoint &position) const;
 
     void resetArray(QSurfaceDataArray *newArray);
+    void resetHeightArray(const QVector<float> &heights, int columnCount,
+                          float originX, float originZ, float stepX, float stepZ);
+    const QVector<float> *heightArray() const;
 
     void setRow(int rowIndex, QSurfaceDataRow *row);
     void setRows(int rowIndex, const QSurfaceDataArray &rows);
@@ -78,6 +81,9 @@ public:
 
     void removeRows(int rowIndex, int removeCount);
 
+    void shiftRow(QSurfaceDataRow *row);
+    void shiftRows(const QSurfaceDataArray &rows);
+
 Q_SIGNALS:
     void arrayReset();
     void rowsAdded(int startIndex, int count);
@@ -85,6 +91,7 @@ Q_SIGNALS:
     void rowsRemoved(int startIndex, int count);
     void rowsInserted(int startIndex, int count);
     void itemChanged(int rowIndex, int columnIndex);
+    void rowsShifted(int count);
 
     void rowCountChanged(int count);
     void columnCountChanged(int count);
@@ -99,6 +106,8 @@ private:
     Q_DISABLE_COPY(QSurfaceDataProxy)
 
     friend class Surface3DController;
+    friend class Surface3DRenderer;
+    friend class QSurface3DSeriesPrivate;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
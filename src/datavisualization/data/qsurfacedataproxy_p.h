@@ -42,11 +42,84 @@
 
 #include "qsurfacedataproxy.h"
 #include "qabstractdataproxy_p.h"
+#include <QtCore/QRect>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 class QAbstract3DAxis;
 
+// Heights of an evenly spaced grid, stored row by row. The x and z values of the items are
+// implicit in the grid origin and step.
+struct SurfaceHeightGrid
+{
+    SurfaceHeightGrid()
+        : columnCount(0),
+          originX(0.0f),
+          originZ(0.0f),
+          stepX(1.0f),
+          stepZ(1.0f)
+    {
+    }
+
+    inline bool isNull() const { return columnCount == 0; }
+    inline int rowCount() const { return columnCount ? heights.size() / columnCount : 0; }
+    inline QSurfaceDataItem item(int row, int column) const
+    {
+        return QSurfaceDataItem(QVector3D(originX + float(column) * stepX,
+                                          heights.at(row * columnCount + column),
+                                          originZ + float(row) * stepZ));
+    }
+
+    QVector<float> heights;
+    int columnCount;
+    float originX;
+    float originZ;
+    float stepX;
+    float stepZ;
+};
+
+// Read-only access to the items of either a data array or a rectangle of a height grid
+class SurfaceDataView
+{
+public:
+    SurfaceDataView(const QSurfaceDataArray &array)
+        : m_array(&array),
+          m_grid(0)
+    {
+    }
+    SurfaceDataView(const SurfaceHeightGrid &grid)
+        : m_array(0),
+          m_grid(&grid),
+          m_rect(0, 0, grid.columnCount, grid.rowCount())
+    {
+    }
+    SurfaceDataView(const SurfaceHeightGrid &grid, const QRect &rect)
+        : m_array(0),
+          m_grid(&grid),
+          m_rect(rect)
+    {
+    }
+
+    inline int rowCount() const { return m_array ? m_array->size() : m_rect.height(); }
+    inline int columnCount() const
+    {
+        if (m_array)
+            return m_array->size() ? m_array->at(0)->size() : 0;
+        return m_rect.width();
+    }
+    inline QSurfaceDataItem item(int row, int column) const
+    {
+        if (m_array)
+            return m_array->at(row)->at(column);
+        return m_grid->item(row + m_rect.y(), column + m_rect.x());
+    }
+
+private:
+    const QSurfaceDataArray *m_array;
+    const SurfaceHeightGrid *m_grid;
+    QRect m_rect;
+};
+
 class QSurfaceDataProxyPrivate : public QAbstractDataProxyPrivate
 {
     Q_OBJECT
@@ -55,6 +128,15 @@ public:
     virtual ~QSurfaceDataProxyPrivate();
 
     void resetArray(QSurfaceDataArray *newArray);
+    void resetHeightArray(const QVector<float> &heights, int columnCount,
+                          float originX, float originZ, float stepX, float stepZ);
+    void convertHeightArray();
+    inline SurfaceDataView dataView() const
+    {
+        if (m_heightGrid.isNull())
+            return SurfaceDataView(*m_dataArray);
+        return SurfaceDataView(m_heightGrid);
+    }
     void setRow(int rowIndex, QSurfaceDataRow *row);
     void setRows(int rowIndex, const QSurfaceDataArray &rows);
     void setItem(int rowIndex, int columnIndex, const QSurfaceDataItem &item);
@@ -63,6 +145,7 @@ public:
     void insertRow(int rowIndex, QSurfaceDataRow *row);
     void insertRows(int rowIndex, const QSurfaceDataArray &rows);
     void removeRows(int rowIndex, int removeCount);
+    void shiftRows(const QSurfaceDataArray &rows);
     void limitValues(QVector3D &minValues, QVector3D &maxValues, QAbstract3DAxis *axisX,
                      QAbstract3DAxis *axisY, QAbstract3DAxis *axisZ) const;
     bool isValidValue(float value, QAbstract3DAxis *axis) const;
@@ -70,10 +153,15 @@ public:
     virtual void setSeries(QAbstract3DSeries *series);
 
 protected:
-    QSurfaceDataArray *m_dataArray;
+    QSurfaceDataArray *m_dataArray; // Empty while the height grid is used
+    SurfaceHeightGrid m_heightGrid;
+    mutable QSurfaceDataItem m_heightGridItem; // Last item returned from the height grid
 
 private:
     QSurfaceDataProxy *qptr();
+    void limitHeightGridValues(QVector3D &minValues, QVector3D &maxValues,
+                               QAbstract3DAxis *axisX, QAbstract3DAxis *axisY,
+                               QAbstract3DAxis *axisZ) const;
     void clearRow(int rowIndex);
     void clearArray();
 
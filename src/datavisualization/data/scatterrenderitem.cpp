@@ -48,4 +48,48 @@ ScatterRenderItem::~ScatterRenderItem()
 {
 }
 
+ScatterRenderItemArray::ScatterRenderItemArray()
+{
+}
+
+void ScatterRenderItemArray::resize(int size)
+{
+    m_x.resize(size);
+    m_y.resize(size);
+    m_z.resize(size);
+    if (!m_rotations.isEmpty())
+        m_rotations.resize(size);
+    m_visibility.resize(size);
+}
+
+void ScatterRenderItemArray::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_rotations.clear();
+    m_visibility.clear();
+}
+
+void ScatterRenderItemArray::setRotation(int index, const QQuaternion &rotation)
+{
+    if (m_rotations.isEmpty()) {
+        // Rotations are allocated only when the first rotated item is set
+        if (rotation.isIdentity())
+            return;
+        m_rotations.fill(identityQuaternion, m_x.size());
+    }
+    m_rotations[index] = rotation;
+}
+
+void ScatterRenderItemArray::detach()
+{
+    // Non-const access copies shared data
+    m_x.data();
+    m_y.data();
+    m_z.data();
+    m_rotations.data();
+    m_visibility.data();
+}
+
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -65,7 +65,62 @@ protected:
     QVector3D m_position;
     bool m_visible;
 };
-typedef QVector<ScatterRenderItem> ScatterRenderItemArray;
+
+// Render items of a scatter series stored as a structure of arrays. Translation components
+// are kept in separate packed arrays, rotations are only allocated once some item is rotated,
+// and visibility is stored as a byte mask.
+class QT_DATAVISUALIZATION_EXPORT ScatterRenderItemArray
+{
+public:
+    ScatterRenderItemArray();
+
+    inline int size() const { return m_x.size(); }
+    void resize(int size);
+    void clear();
+
+    inline QVector3D translation(int index) const
+    {
+        return QVector3D(m_x.at(index), m_y.at(index), m_z.at(index));
+    }
+    inline void setTranslation(int index, const QVector3D &translation)
+    {
+        m_x[index] = translation.x();
+        m_y[index] = translation.y();
+        m_z[index] = translation.z();
+    }
+    inline const float *xData() const { return m_x.constData(); }
+    inline const float *yData() const { return m_y.constData(); }
+    inline const float *zData() const { return m_z.constData(); }
+    inline float *xData() { return m_x.data(); }
+    inline float *yData() { return m_y.data(); }
+    inline float *zData() { return m_z.data(); }
+
+    inline bool hasRotations() const { return !m_rotations.isEmpty(); }
+    inline QQuaternion rotation(int index) const
+    {
+        return m_rotations.isEmpty() ? identityQuaternion : m_rotations.at(index);
+    }
+    void setRotation(int index, const QQuaternion &rotation);
+    inline void clearRotations() { m_rotations.clear(); }
+    inline QQuaternion *rotationData() { return m_rotations.data(); }
+
+    inline bool isVisible(int index) const { return m_visibility.at(index); }
+    inline void setVisible(int index, bool visible) { m_visibility[index] = visible; }
+    inline int visibleCount() const { return m_visibility.count(1); }
+    // One byte per item, 1 if the item is visible and 0 otherwise
+    inline uchar *visibilityData() { return m_visibility.data(); }
+
+    // Makes sure no storage is shared, so that disjoint index ranges can be written from
+    // separate threads
+    void detach();
+
+private:
+    QVector<float> m_x;
+    QVector<float> m_y;
+    QVector<float> m_z;
+    QVector<QQuaternion> m_rotations; // Empty if no item is rotated
+    QVector<uchar> m_visibility;
+};
 
 QT_END_NAMESPACE_DATAVISUALIZATION
 
@@ -96,6 +96,11 @@ Abstract3DController::Abstract3DController(QRect initialViewport, Q3DScene *scen
     setActiveInputHandler(inputHandler);
     connect(m_scene->d_ptr.data(), &Q3DScenePrivate::needRender, this,
             &Abstract3DController::emitNeedRender);
+
+    m_delayedRenderTimer.setSingleShot(true);
+    m_delayedRenderTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_delayedRenderTimer, &QTimer::timeout, this,
+            &Abstract3DController::emitNeedRender);
 }
 
 Abstract3DController::~Abstract3DController()
@@ -1245,6 +1250,12 @@ void Abstract3DController::handleRequestShadowQuality(QAbstract3DGraph::ShadowQu
     setShadowQuality(quality);
 }
 
+// Renders once after delay milliseconds, unless another delayed render is requested meanwhile
+void Abstract3DController::handleRequestDelayedRender(int delay)
+{
+    m_delayedRenderTimer.start(delay);
+}
+
 void Abstract3DController::setMeasureFps(bool enable)
 {
     if (m_measureFps != enable) {
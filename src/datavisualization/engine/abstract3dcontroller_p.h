@@ -51,6 +51,7 @@
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QLocale>
 #include <QtCore/QMutex>
+#include <QtCore/QTimer>
 
 QT_FORWARD_DECLARE_CLASS(QOpenGLFramebufferObject)
 
@@ -205,6 +206,7 @@ protected:
     bool m_isCustomItemDirty;
     bool m_isSeriesVisualsDirty;
     bool m_renderPending;
+    QTimer m_delayedRenderTimer;
     bool m_isPolar;
     float m_radialLabelOffset;
 
@@ -393,6 +395,7 @@ public Q_SLOTS:
 
     // Renderer callback handlers
     void handleRequestShadowQuality(QAbstract3DGraph::ShadowQuality quality);
+    void handleRequestDelayedRender(int delay);
 
     void updateCustomItem();
 
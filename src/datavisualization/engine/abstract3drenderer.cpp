@@ -52,6 +52,7 @@ const int polarGridRoundness(64);
 const qreal polarGridAngle(doublePi / qreal(polarGridRoundness));
 const float polarGridAngleDegrees(float(360.0 / qreal(polarGridRoundness)));
 const qreal polarGridHalfAngle(polarGridAngle / 2.0);
+const qint64 cameraIdleTime(300); // Milliseconds before full quality volumes are drawn again
 
 Abstract3DRenderer::Abstract3DRenderer(Abstract3DController *controller)
     : QObject(0),
@@ -122,11 +123,13 @@ Abstract3DRenderer::Abstract3DRenderer(Abstract3DController *controller)
       m_funcs_2_1(0),
 #endif
       m_context(0),
-      m_isOpenGLES(true)
+      m_isOpenGLES(true),
+      m_isInstancingSupported(false)
 
 {
     initializeOpenGLFunctions();
     m_isOpenGLES = Utils::isOpenGLES();
+    m_isInstancingSupported = Utils::isInstancingSupported();
 #if !defined(QT_OPENGL_ES_2)
     if (!m_isOpenGLES) {
         // Discard warnings about deprecated functions
@@ -148,6 +151,8 @@ Abstract3DRenderer::Abstract3DRenderer(Abstract3DController *controller)
                      &Abstract3DController::needRender, Qt::QueuedConnection);
     QObject::connect(this, &Abstract3DRenderer::requestShadowQuality, controller,
                      &Abstract3DController::handleRequestShadowQuality, Qt::QueuedConnection);
+    QObject::connect(this, &Abstract3DRenderer::requestDelayedRender, controller,
+                     &Abstract3DController::handleRequestDelayedRender, Qt::QueuedConnection);
 }
 
 Abstract3DRenderer::~Abstract3DRenderer()
@@ -174,6 +179,10 @@ Abstract3DRenderer::~Abstract3DRenderer()
     foreach (CustomRenderItem *item, m_customRenderCache) {
         GLuint texture = item->texture();
         m_textureHelper->deleteTexture(&texture);
+        texture = item->brickTexture();
+        m_textureHelper->deleteTexture(&texture);
+        texture = item->interactiveTexture();
+        m_textureHelper->deleteTexture(&texture);
         delete item;
     }
     m_customRenderCache.clear();
@@ -290,6 +299,18 @@ void Abstract3DRenderer::initStaticSelectedItemShaders(const QString &vertexShad
     Q_UNUSED(gradientFragmentShader)
 }
 
+void Abstract3DRenderer::initStaticInstancedShaders(const QString &vertexShader,
+                                                    const QString &fragmentShader,
+                                                    const QString &gradientVertexShader,
+                                                    const QString &gradientFragmentShader)
+{
+    // Do nothing by default
+    Q_UNUSED(vertexShader)
+    Q_UNUSED(fragmentShader)
+    Q_UNUSED(gradientVertexShader)
+    Q_UNUSED(gradientFragmentShader)
+}
+
 void Abstract3DRenderer::initCustomItemShaders(const QString &vertexShader,
                                                const QString &fragmentShader)
 {
@@ -387,7 +408,17 @@ void Abstract3DRenderer::updateScene(Q3DScene *scene)
                                   logicalGraphPosition.y() * m_devicePixelRatio);
 
     // Synchronize the renderer scene to controller scene
+    Q3DCamera *camera = m_cachedScene->activeCamera();
+    float xRotation = camera->xRotation();
+    float yRotation = camera->yRotation();
+    float zoomLevel = camera->zoomLevel();
+    QVector3D target = camera->target();
     scene->d_ptr->sync(*m_cachedScene->d_ptr);
+    camera = m_cachedScene->activeCamera();
+    if (xRotation != camera->xRotation() || yRotation != camera->yRotation()
+            || zoomLevel != camera->zoomLevel() || target != camera->target()) {
+        m_cameraMotionTimer.start();
+    }
 
     updateCameraViewport();
 
@@ -429,19 +460,37 @@ void Abstract3DRenderer::reInitShaders()
         if (m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone) {
             if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
                     && qobject_cast<Scatter3DRenderer *>(this)) {
-                initGradientShaders(QStringLiteral(":/shaders/vertexShadow"),
-                                    QStringLiteral(":/shaders/fragmentShadow"));
+                if (m_isInstancingSupported) {
+                    initGradientShaders(QStringLiteral(":/shaders/vertexShadowInstanced"),
+                                        QStringLiteral(":/shaders/fragmentShadow"));
+                } else {
+                    initGradientShaders(QStringLiteral(":/shaders/vertexShadow"),
+                                        QStringLiteral(":/shaders/fragmentShadow"));
+                }
                 initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertexShadow"),
                                               QStringLiteral(":/shaders/fragmentShadowNoTex"),
                                               QStringLiteral(":/shaders/vertexShadow"),
                                               QStringLiteral(":/shaders/fragmentShadowNoTexColorOnY"));
-                initShaders(QStringLiteral(":/shaders/vertexShadowNoMatrices"),
-                            QStringLiteral(":/shaders/fragmentShadowNoTex"));
+                if (m_isInstancingSupported) {
+                    initShaders(QStringLiteral(":/shaders/vertexShadowInstanced"),
+                                QStringLiteral(":/shaders/fragmentShadowNoTex"));
+                } else {
+                    initShaders(QStringLiteral(":/shaders/vertexShadowNoMatrices"),
+                                QStringLiteral(":/shaders/fragmentShadowNoTex"));
+                }
             } else {
                 initGradientShaders(QStringLiteral(":/shaders/vertexShadow"),
                                     QStringLiteral(":/shaders/fragmentShadowNoTexColorOnY"));
                 initShaders(QStringLiteral(":/shaders/vertexShadow"),
                             QStringLiteral(":/shaders/fragmentShadowNoTex"));
+                if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+                        && m_isInstancingSupported) {
+                    initStaticInstancedShaders(
+                                QStringLiteral(":/shaders/vertexBarShadowInstanced"),
+                                QStringLiteral(":/shaders/fragmentShadowNoTex"),
+                                QStringLiteral(":/shaders/vertexBarShadowInstanced"),
+                                QStringLiteral(":/shaders/fragmentShadow"));
+                }
             }
             initBackgroundShaders(QStringLiteral(":/shaders/vertexShadow"),
                                   QStringLiteral(":/shaders/fragmentShadowNoTex"));
@@ -450,19 +499,36 @@ void Abstract3DRenderer::reInitShaders()
         } else {
             if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
                     && qobject_cast<Scatter3DRenderer *>(this)) {
-                initGradientShaders(QStringLiteral(":/shaders/vertexTexture"),
-                                    QStringLiteral(":/shaders/fragmentTexture"));
+                if (m_isInstancingSupported) {
+                    initGradientShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                                        QStringLiteral(":/shaders/fragmentTexture"));
+                } else {
+                    initGradientShaders(QStringLiteral(":/shaders/vertexTexture"),
+                                        QStringLiteral(":/shaders/fragmentTexture"));
+                }
                 initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertex"),
                                               QStringLiteral(":/shaders/fragment"),
                                               QStringLiteral(":/shaders/vertex"),
                                               QStringLiteral(":/shaders/fragmentColorOnY"));
-                initShaders(QStringLiteral(":/shaders/vertexNoMatrices"),
-                            QStringLiteral(":/shaders/fragment"));
+                if (m_isInstancingSupported) {
+                    initShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                                QStringLiteral(":/shaders/fragment"));
+                } else {
+                    initShaders(QStringLiteral(":/shaders/vertexNoMatrices"),
+                                QStringLiteral(":/shaders/fragment"));
+                }
             } else {
                 initGradientShaders(QStringLiteral(":/shaders/vertex"),
                                     QStringLiteral(":/shaders/fragmentColorOnY"));
                 initShaders(QStringLiteral(":/shaders/vertex"),
                             QStringLiteral(":/shaders/fragment"));
+                if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+                        && m_isInstancingSupported) {
+                    initStaticInstancedShaders(QStringLiteral(":/shaders/vertexBarInstanced"),
+                                               QStringLiteral(":/shaders/fragment"),
+                                               QStringLiteral(":/shaders/vertexBarInstanced"),
+                                               QStringLiteral(":/shaders/fragmentTexture"));
+                }
             }
             initBackgroundShaders(QStringLiteral(":/shaders/vertex"),
                                   QStringLiteral(":/shaders/fragment"));
@@ -478,19 +544,36 @@ void Abstract3DRenderer::reInitShaders()
     } else  {
         if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
                 && qobject_cast<Scatter3DRenderer *>(this)) {
-            initGradientShaders(QStringLiteral(":/shaders/vertexTexture"),
-                                QStringLiteral(":/shaders/fragmentTextureES2"));
+            if (m_isInstancingSupported) {
+                initGradientShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                                    QStringLiteral(":/shaders/fragmentTextureES2"));
+            } else {
+                initGradientShaders(QStringLiteral(":/shaders/vertexTexture"),
+                                    QStringLiteral(":/shaders/fragmentTextureES2"));
+            }
             initStaticSelectedItemShaders(QStringLiteral(":/shaders/vertex"),
                                           QStringLiteral(":/shaders/fragmentES2"),
                                           QStringLiteral(":/shaders/vertex"),
                                           QStringLiteral(":/shaders/fragmentColorOnYES2"));
-            initShaders(QStringLiteral(":/shaders/vertexNoMatrices"),
-                        QStringLiteral(":/shaders/fragmentES2"));
+            if (m_isInstancingSupported) {
+                initShaders(QStringLiteral(":/shaders/vertexInstanced"),
+                            QStringLiteral(":/shaders/fragmentES2"));
+            } else {
+                initShaders(QStringLiteral(":/shaders/vertexNoMatrices"),
+                            QStringLiteral(":/shaders/fragmentES2"));
+            }
         } else {
             initGradientShaders(QStringLiteral(":/shaders/vertex"),
                                 QStringLiteral(":/shaders/fragmentColorOnYES2"));
             initShaders(QStringLiteral(":/shaders/vertex"),
                         QStringLiteral(":/shaders/fragmentES2"));
+            if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+                    && m_isInstancingSupported) {
+                initStaticInstancedShaders(QStringLiteral(":/shaders/vertexBarInstanced"),
+                                           QStringLiteral(":/shaders/fragmentES2"),
+                                           QStringLiteral(":/shaders/vertexBarInstanced"),
+                                           QStringLiteral(":/shaders/fragmentTextureES2"));
+            }
         }
         initBackgroundShaders(QStringLiteral(":/shaders/vertex"),
                               QStringLiteral(":/shaders/fragmentES2"));
@@ -755,6 +838,10 @@ void Abstract3DRenderer::updateCustomData(const QList<QCustom3DItem *> &customIt
             m_customRenderCache.remove(renderItem->itemPointer());
             GLuint texture = renderItem->texture();
             m_textureHelper->deleteTexture(&texture);
+            texture = renderItem->brickTexture();
+            m_textureHelper->deleteTexture(&texture);
+            texture = renderItem->interactiveTexture();
+            m_textureHelper->deleteTexture(&texture);
             delete renderItem;
         }
     }
@@ -1164,16 +1251,16 @@ CustomRenderItem *Abstract3DRenderer::addCustomItem(QCustom3DItem *item)
         newItem->setTextureWidth(volumeItem->textureWidth());
         newItem->setTextureHeight(volumeItem->textureHeight());
         newItem->setTextureDepth(volumeItem->textureDepth());
-        if (volumeItem->textureFormat() == QImage::Format_Indexed8)
-            newItem->setColorTable(volumeItem->colorTable());
         newItem->setTextureFormat(volumeItem->textureFormat());
+        newItem->setSampleFormat(volumeItem->sampleFormat());
+        newItem->setWindow(volumeItem->windowLevel(), volumeItem->windowWidth());
+        if (newItem->isColorTableUsed())
+            newItem->setColorTable(volumeItem->colorTable());
         newItem->setVolume(true);
         newItem->setBlendNeeded(true);
-        texture = m_textureHelper->create3DTexture(volumeItem->textureData(),
-                                                   volumeItem->textureWidth(),
-                                                   volumeItem->textureHeight(),
-                                                   volumeItem->textureDepth(),
-                                                   volumeItem->textureFormat());
+        texture = createVolumeTexture(volumeItem, newItem);
+        newItem->setTexture(texture);
+        updateInteractiveVolumeTexture(volumeItem, newItem);
         newItem->setSliceIndexX(volumeItem->sliceIndexX());
         newItem->setSliceIndexY(volumeItem->sliceIndexY());
         newItem->setSliceIndexZ(volumeItem->sliceIndexZ());
@@ -1187,6 +1274,7 @@ CustomRenderItem *Abstract3DRenderer::addCustomItem(QCustom3DItem *item)
         newItem->setSliceFrameWidths(volumeItem->sliceFrameWidths());
         newItem->setSliceFrameGaps(volumeItem->sliceFrameGaps());
         newItem->setSliceFrameThicknesses(volumeItem->sliceFrameThicknesses());
+        updateVolumeBricks(volumeItem, newItem);
     }
     recalculateCustomItemScalingAndPos(newItem);
     newItem->setRotation(item->rotation());
@@ -1362,6 +1450,10 @@ void Abstract3DRenderer::updateCustomItem(CustomRenderItem *renderItem)
         }
     } else if (item->d_ptr->m_isVolumeItem && !m_isOpenGLES) {
         QCustom3DVolume *volumeItem = static_cast<QCustom3DVolume *>(item);
+        const QCustomVolumeDirtyBitField &dirtyBits = volumeItem->dptr()->m_dirtyBitsVolume;
+        bool bricksDirty = dirtyBits.colorTableDirty || dirtyBits.textureDimensionsDirty
+                || dirtyBits.textureDataDirty || dirtyBits.textureFormatDirty
+                || dirtyBits.windowDirty || dirtyBits.interactiveDirty;
         if (volumeItem->dptr()->m_dirtyBitsVolume.colorTableDirty) {
             renderItem->setColorTable(volumeItem->colorTable());
             volumeItem->dptr()->m_dirtyBitsVolume.colorTableDirty = false;
@@ -1371,16 +1463,15 @@ void Abstract3DRenderer::updateCustomItem(CustomRenderItem *renderItem)
                 || volumeItem->dptr()->m_dirtyBitsVolume.textureFormatDirty) {
             GLuint oldTexture = renderItem->texture();
             m_textureHelper->deleteTexture(&oldTexture);
-            GLuint texture = m_textureHelper->create3DTexture(volumeItem->textureData(),
-                                                              volumeItem->textureWidth(),
-                                                              volumeItem->textureHeight(),
-                                                              volumeItem->textureDepth(),
-                                                              volumeItem->textureFormat());
-            renderItem->setTexture(texture);
             renderItem->setTextureWidth(volumeItem->textureWidth());
             renderItem->setTextureHeight(volumeItem->textureHeight());
             renderItem->setTextureDepth(volumeItem->textureDepth());
             renderItem->setTextureFormat(volumeItem->textureFormat());
+            renderItem->setSampleFormat(volumeItem->sampleFormat());
+            renderItem->setTexture(createVolumeTexture(volumeItem, renderItem));
+            volumeItem->dptr()->m_dirtyBitsVolume.interactiveDirty = true;
+            if (renderItem->isColorTableUsed() && renderItem->colorTable().isEmpty())
+                renderItem->setColorTable(volumeItem->colorTable());
             volumeItem->dptr()->m_dirtyBitsVolume.textureDimensionsDirty = false;
             volumeItem->dptr()->m_dirtyBitsVolume.textureDataDirty = false;
             volumeItem->dptr()->m_dirtyBitsVolume.textureFormatDirty = false;
@@ -1406,7 +1497,113 @@ void Abstract3DRenderer::updateCustomItem(CustomRenderItem *renderItem)
             renderItem->setUseHighDefShader(volumeItem->useHighDefShader());
             volumeItem->dptr()->m_dirtyBitsVolume.shaderDirty = false;
         }
+        if (volumeItem->dptr()->m_dirtyBitsVolume.windowDirty) {
+            renderItem->setWindow(volumeItem->windowLevel(), volumeItem->windowWidth());
+            volumeItem->dptr()->m_dirtyBitsVolume.windowDirty = false;
+        }
+        if (volumeItem->dptr()->m_dirtyBitsVolume.interactiveDirty) {
+            updateInteractiveVolumeTexture(volumeItem, renderItem);
+            volumeItem->dptr()->m_dirtyBitsVolume.interactiveDirty = false;
+        }
+        if (bricksDirty)
+            updateVolumeBricks(volumeItem, renderItem);
+    }
+}
+
+GLuint Abstract3DRenderer::createVolumeTexture(QCustom3DVolume *volumeItem,
+                                              CustomRenderItem *renderItem)
+{
+    QCustom3DVolumePrivate *volume = volumeItem->dptr();
+    GLint maxTextureSize = 0;
+#if !defined(QT_OPENGL_ES_2)
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+#endif
+
+    // Upload the finest level of detail that fits in the texture memory budget. A downsampled
+    // level is built in the thread pool, and the texture is created again once it is ready.
+    QCustom3DVolumePrivate::TextureLevel level;
+    if (!volume->takeTextureLevel(maxTextureSize, level)) {
+        volume->m_residentLevel = QCustom3DVolumePrivate::TextureLevel();
+        volume->invalidateBricks();
+        renderItem->setLevelDimensions(volumeItem->textureWidth(), volumeItem->textureHeight(),
+                                       volumeItem->textureDepth());
+        renderItem->setLevelOfDetail(0);
+        return 0;
     }
+
+    GLuint texture = m_textureHelper->create3DTexture(level.data, level.width, level.height,
+                                                      level.depth, volumeItem->textureFormat(),
+                                                      volumeItem->sampleFormat());
+    renderItem->setLevelDimensions(level.width, level.height, level.depth);
+    renderItem->setLevelOfDetail(level.level);
+    volume->updateBrickRanges(level);
+    volume->m_residentLevel = level;
+    return texture;
+}
+
+void Abstract3DRenderer::updateInteractiveVolumeTexture(QCustom3DVolume *volumeItem,
+                                                        CustomRenderItem *renderItem)
+{
+    GLuint oldTexture = renderItem->interactiveTexture();
+    m_textureHelper->deleteTexture(&oldTexture);
+    renderItem->setInteractiveTexture(0);
+
+    QCustom3DVolumePrivate *volume = volumeItem->dptr();
+    QCustom3DVolumePrivate::TextureLevel level;
+    int factor = volumeItem->interactiveDownsampling();
+    if (factor <= 1 || !renderItem->texture()) {
+        volume->updateInteractiveBrickRanges(level);
+        return;
+    }
+
+    // Downsampling factor is at most the brick size, so that the texels of the downsampled
+    // level are taken from the bricks they are drawn in, and the same bricks can be skipped.
+    // Thin structures would disappear from a point sampled level, so the resident level is box
+    // filtered.
+    if (!volume->downsampledLevel(volume->m_residentLevel, factor, level)) {
+        volume->updateInteractiveBrickRanges(level);
+        return;
+    }
+
+    renderItem->setInteractiveTexture(
+                m_textureHelper->create3DTexture(level.data, level.width, level.height,
+                                                 level.depth, volumeItem->textureFormat(),
+                                                 volumeItem->sampleFormat()));
+    renderItem->setInteractiveDimensions(level.width, level.height, level.depth);
+    volume->updateInteractiveBrickRanges(level);
+}
+
+bool Abstract3DRenderer::isCameraMoving() const
+{
+    // Camera is considered to be moving until it has been still for a while
+    return m_cameraMotionTimer.isValid() && m_cameraMotionTimer.elapsed() < cameraIdleTime;
+}
+
+void Abstract3DRenderer::updateVolumeBricks(QCustom3DVolume *volumeItem,
+                                            CustomRenderItem *renderItem)
+{
+    GLuint oldTexture = renderItem->brickTexture();
+    m_textureHelper->deleteTexture(&oldTexture);
+
+    // Bricks that have no visible texels after the color lookup are skipped by the shaders
+    QCustom3DVolumePrivate *volume = volumeItem->dptr();
+    QVector<uchar> occupancy = volume->brickOccupancy();
+    if (occupancy.isEmpty()) {
+        renderItem->setBrickTexture(0);
+        return;
+    }
+
+    int brickTexels = QCustom3DVolumePrivate::brickSize;
+    renderItem->setBricks(occupancy, volume->m_brickCountX, volume->m_brickCountY,
+                          volume->m_brickCountZ,
+                          QVector3D(float(brickTexels)
+                                    / float(volume->texelWidth(renderItem->levelWidth())),
+                                    float(brickTexels) / float(renderItem->levelHeight()),
+                                    float(brickTexels) / float(renderItem->levelDepth())));
+    renderItem->setBrickTexture(m_textureHelper->create3DMaskTexture(occupancy,
+                                                                     volume->m_brickCountX,
+                                                                     volume->m_brickCountY,
+                                                                     volume->m_brickCountZ));
 }
 
 void Abstract3DRenderer::updateCustomItemPositions()
@@ -1440,6 +1637,7 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
 
     // Draw custom items - first regular and then volumes
     bool volumeDetected = false;
+    bool interactiveVolumeDrawn = false;
     int loopCount = 0;
     while (loopCount < 2) {
         for (QCustom3DItem *customItem : qAsConst(m_customItemDrawOrder)) {
@@ -1456,33 +1654,19 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                     continue;
                 }
             } else {
-                if (!item->isVolume())
+                // Volumes whose texture level is still being built have nothing to draw
+                if (!item->isVolume() || (!m_isOpenGLES && !item->texture()))
                     continue;
             }
 
-            // If the render item is in data coordinates and not within axis ranges, skip it
-            if (!item->isPositionAbsolute()
-                    && (item->position().x() < m_axisCacheX.min()
-                        || item->position().x() > m_axisCacheX.max()
-                        || item->position().z() < m_axisCacheZ.min()
-                        || item->position().z() > m_axisCacheZ.max()
-                        || item->position().y() < m_axisCacheY.min()
-                        || item->position().y() > m_axisCacheY.max())) {
+            if (!isCustomItemInRange(item))
                 continue;
-            }
 
             QMatrix4x4 modelMatrix;
             QMatrix4x4 itModelMatrix;
             QMatrix4x4 MVPMatrix;
 
-            QQuaternion rotation = item->rotation();
-            // Check if the (label) item should be facing camera, and adjust rotation accordingly
-            if (item->isFacingCamera()) {
-                float camRotationX = m_cachedScene->activeCamera()->xRotation();
-                float camRotationY = m_cachedScene->activeCamera()->yRotation();
-                rotation = QQuaternion::fromAxisAndAngle(0.0f, 1.0f, 0.0f, -camRotationX)
-                        * QQuaternion::fromAxisAndAngle(1.0f, 0.0f, 0.0f, -camRotationY);
-            }
+            QQuaternion rotation = customItemRotation(item);
 
             if (m_reflectionEnabled) {
                 if (reflection < 0.0f) {
@@ -1570,10 +1754,11 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                                       + ((oneVector - cameraPos) * item->minBoundsNormal())
                                       - ((oneVector + cameraPos) * (oneVector - item->maxBoundsNormal())));
                         shader->setUniformValue(shader->cameraPositionRelativeToModel(), cameraPos);
-                        GLint color8Bit = (item->textureFormat() == QImage::Format_Indexed8) ? 1 : 0;
+                        GLint color8Bit = item->isColorTableUsed() ? 1 : 0;
                         if (color8Bit) {
                             shader->setUniformValueArray(shader->colorIndex(),
                                                          item->colorTable().constData(), 256);
+                            shader->setUniformValue(shader->valueWindow(), item->valueWindow());
                         }
                         shader->setUniformValue(shader->color8Bit(), color8Bit);
                         shader->setUniformValue(shader->alphaMultiplier(), item->alphaMultiplier());
@@ -1583,31 +1768,57 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                         shader->setUniformValue(shader->minBounds(), item->minBounds());
                         shader->setUniformValue(shader->maxBounds(), item->maxBounds());
 
+                        GLuint volumeTexture = item->texture();
                         if (shader == m_volumeTextureSliceShader) {
                             shader->setUniformValue(shader->volumeSliceIndices(),
                                                     item->sliceFractions());
                         } else {
+                            int levelWidth = item->levelWidth();
+                            int levelHeight = item->levelHeight();
+                            int levelDepth = item->levelDepth();
+                            // Draw the downsampled texture with fewer samples while the camera
+                            // moves, and request a frame to restore full quality after it stops
+                            if (item->interactiveTexture() && isCameraMoving()) {
+                                volumeTexture = item->interactiveTexture();
+                                levelWidth = int(item->interactiveDimensions().x());
+                                levelHeight = int(item->interactiveDimensions().y());
+                                levelDepth = int(item->interactiveDimensions().z());
+                                interactiveVolumeDrawn = true;
+                            }
+
                             // Precalculate texture dimensions so we can optimize
                             // ray stepping to hit every texture layer.
-                            QVector3D textureDimensions(1.0f / float(item->textureWidth()),
-                                                        1.0f / float(item->textureHeight()),
-                                                        1.0f / float(item->textureDepth()));
+                            QVector3D textureDimensions(1.0f / float(levelWidth),
+                                                        1.0f / float(levelHeight),
+                                                        1.0f / float(levelDepth));
 
                             // Worst case scenario sample count
                             int sampleCount;
                             if (shader == m_volumeTextureLowDefShader) {
-                                sampleCount = qMax(item->textureWidth(),
-                                                   qMax(item->textureDepth(), item->textureHeight()));
+                                sampleCount = qMax(levelWidth, qMax(levelDepth, levelHeight));
                                 // Further improve speed with big textures by simply dropping every
                                 // other sample:
                                 if (sampleCount > 256)
                                     sampleCount /= 2;
                             } else {
-                                sampleCount = item->textureWidth() + item->textureHeight()
-                                        + item->textureDepth();
+                                sampleCount = levelWidth + levelHeight + levelDepth;
                             }
                             shader->setUniformValue(shader->textureDimensions(), textureDimensions);
                             shader->setUniformValue(shader->sampleCount(), sampleCount);
+
+                            // Rays only traverse the bricks that have visible texels
+                            shader->setUniformValue(shader->brickMap(), 3);
+                            if (item->brickTexture()) {
+                                shader->setUniformValue(shader->skipEmptyBricks(), 1);
+                                shader->setUniformValue(shader->brickSize(), item->brickSize());
+                                shader->setUniformValue(shader->brickCount(), item->brickCount());
+                                shader->setUniformValue(shader->occupiedMin(), item->occupiedMin());
+                                shader->setUniformValue(shader->occupiedMax(), item->occupiedMax());
+                            } else {
+                                shader->setUniformValue(shader->skipEmptyBricks(), 0);
+                                shader->setUniformValue(shader->occupiedMin(), zeroVector);
+                                shader->setUniformValue(shader->occupiedMax(), oneVector);
+                            }
                         }
                         if (item->drawSliceFrames()) {
                             // Set up the slice frame shader
@@ -1627,7 +1838,20 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
                             glEnable(GL_CULL_FACE);
                             shader->bind();
                         }
-                        m_drawer->drawObject(shader, item->mesh(), 0, 0, item->texture());
+#if !defined(QT_OPENGL_ES_2)
+                        if (item->brickTexture()) {
+                            glActiveTexture(GL_TEXTURE3);
+                            glBindTexture(GL_TEXTURE_3D, item->brickTexture());
+                        }
+#endif
+                        m_drawer->drawObject(shader, item->mesh(), 0, 0, volumeTexture);
+#if !defined(QT_OPENGL_ES_2)
+                        if (item->brickTexture()) {
+                            glActiveTexture(GL_TEXTURE3);
+                            glBindTexture(GL_TEXTURE_3D, 0);
+                            glActiveTexture(GL_TEXTURE0);
+                        }
+#endif
                     } else {
                         shader->setUniformValue(shader->lightS(), m_cachedTheme->lightStrength());
                         m_drawer->drawObject(shader, item->mesh(), item->texture());
@@ -1652,6 +1876,11 @@ void Abstract3DRenderer::drawCustomItems(RenderingState state,
             loopCount++; // Skip second run if no volumes detected
     }
 
+    // Render full quality volumes once the camera has been still long enough, instead of
+    // rendering every frame until then
+    if (interactiveVolumeDrawn)
+        emit requestDelayedRender(int(cameraIdleTime - m_cameraMotionTimer.elapsed()) + 1);
+
     if (RenderingNormal == state) {
         glDisable(GL_BLEND);
         glEnable(GL_CULL_FACE);
@@ -1817,6 +2046,106 @@ void Abstract3DRenderer::queriedGraphPosition(const QMatrix4x4 &projectionViewMa
     m_graphPositionQueryPending = false;
 }
 
+// Calculates the ray from the camera through the selection query position, for item picking
+// on CPU. The direction is normalized.
+void Abstract3DRenderer::selectionRay(const QMatrix4x4 &projectionViewMatrix, QVector3D &origin,
+                                      QVector3D &direction) const
+{
+    const float width = float(m_primarySubViewport.width());
+    const float height = float(m_primarySubViewport.height());
+    const float ndcX = 2.0f * float(m_inputPosition.x()) / width - 1.0f;
+    const float ndcY = 2.0f * float(m_viewport.height() - m_inputPosition.y()) / height - 1.0f;
+
+    const QMatrix4x4 inverseProjectionView = projectionViewMatrix.inverted();
+    origin = inverseProjectionView.map(QVector3D(ndcX, ndcY, -1.0f));
+    direction = (inverseProjectionView.map(QVector3D(ndcX, ndcY, 1.0f)) - origin).normalized();
+}
+
+// Sets the color that identifies the next label drawn for selection. When labels are picked on
+// CPU, the drawer keeps the color of the nearest label hit instead.
+void Abstract3DRenderer::setLabelSelectionColor(ShaderHelper *shader, const QVector4D &color)
+{
+    shader->setUniformValue(shader->color(), color);
+    m_drawer->setLabelPickColor(color);
+}
+
+// Casts the ray against the bounds of the custom item meshes and against the axis labels,
+// which are tested instead of drawn by drawLabels() using the bound labelShader. Returns true
+// with the distance and the selection color of the nearest hit closer than distance, in the
+// range that Utils::getSelection() returns. Direction must be normalized.
+bool Abstract3DRenderer::pickCustomItemsAndLabels(const QVector3D &origin,
+                                                  const QVector3D &direction,
+                                                  const Q3DCamera *activeCamera,
+                                                  const QMatrix4x4 &viewMatrix,
+                                                  const QMatrix4x4 &projectionMatrix,
+                                                  ShaderHelper *labelShader,
+                                                  float &distance, QVector4D &color)
+{
+    bool hit = false;
+    for (QCustom3DItem *customItem : qAsConst(m_customItemDrawOrder)) {
+        CustomRenderItem *item = m_customRenderCache.value(customItem);
+        if (!item->isVisible() || !item->mesh() || !isCustomItemInRange(item))
+            continue;
+
+        // The mesh bounds are scaled, so the ray is only moved and rotated to the item
+        const QQuaternion inverseRotation = customItemRotation(item).normalized().conjugated();
+        const QVector3D itemOrigin = inverseRotation.rotatedVector(origin - item->translation());
+        const QVector3D itemDirection = inverseRotation.rotatedVector(direction);
+        const QVector3D minBounds = item->mesh()->minBounds() * item->scaling();
+        const QVector3D maxBounds = item->mesh()->maxBounds() * item->scaling();
+        const float hitDistance = Utils::rayBoxDistance(
+                    itemOrigin, itemDirection,
+                    QVector3D(qMin(minBounds.x(), maxBounds.x()),
+                              qMin(minBounds.y(), maxBounds.y()),
+                              qMin(minBounds.z(), maxBounds.z())),
+                    QVector3D(qMax(minBounds.x(), maxBounds.x()),
+                              qMax(minBounds.y(), maxBounds.y()),
+                              qMax(minBounds.z(), maxBounds.z())));
+        if (hitDistance >= 0.0f && hitDistance < distance) {
+            distance = hitDistance;
+            color = indexToSelectionColor(item->index());
+            color.setW(customItemAlpha);
+            hit = true;
+        }
+    }
+
+    labelShader->bind();
+    m_drawer->beginLabelPicking(origin, direction, distance);
+    drawLabels(true, activeCamera, viewMatrix, projectionMatrix);
+    QVector4D labelColor;
+    if (m_drawer->endLabelPicking(distance, labelColor)) {
+        color = QVector4D(qRound(labelColor.x() * 255.0f), qRound(labelColor.y() * 255.0f),
+                          qRound(labelColor.z() * 255.0f), qRound(labelColor.w() * 255.0f));
+        hit = true;
+    }
+
+    return hit;
+}
+
+// Returns false if the item is positioned in data coordinates outside the axis ranges
+bool Abstract3DRenderer::isCustomItemInRange(const CustomRenderItem *item) const
+{
+    return item->isPositionAbsolute()
+            || (item->position().x() >= m_axisCacheX.min()
+                && item->position().x() <= m_axisCacheX.max()
+                && item->position().z() >= m_axisCacheZ.min()
+                && item->position().z() <= m_axisCacheZ.max()
+                && item->position().y() >= m_axisCacheY.min()
+                && item->position().y() <= m_axisCacheY.max());
+}
+
+// Returns the rotation of the item, which turns (label) items facing the camera towards it
+QQuaternion Abstract3DRenderer::customItemRotation(const CustomRenderItem *item) const
+{
+    if (!item->isFacingCamera())
+        return item->rotation();
+
+    float camRotationX = m_cachedScene->activeCamera()->xRotation();
+    float camRotationY = m_cachedScene->activeCamera()->yRotation();
+    return QQuaternion::fromAxisAndAngle(0.0f, 1.0f, 0.0f, -camRotationX)
+            * QQuaternion::fromAxisAndAngle(1.0f, 0.0f, 0.0f, -camRotationY);
+}
+
 void Abstract3DRenderer::calculatePolarXZ(const QVector3D &dataPos, float &x, float &z) const
 {
     // x is angular, z is radial
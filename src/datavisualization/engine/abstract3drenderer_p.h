@@ -104,6 +104,10 @@ public:
                                                const QString &fragmentShader,
                                                const QString &gradientVertexShader,
                                                const QString &gradientFragmentShader);
+    virtual void initStaticInstancedShaders(const QString &vertexShader,
+                                            const QString &fragmentShader,
+                                            const QString &gradientVertexShader,
+                                            const QString &gradientFragmentShader);
     virtual void initBackgroundShaders(const QString &vertexShader,
                                        const QString &fragmentShader) = 0;
     virtual void initCustomItemShaders(const QString &vertexShader,
@@ -187,6 +191,7 @@ public:
 Q_SIGNALS:
     void needRender(); // Emit this if something in renderer causes need for another render pass.
     void requestShadowQuality(QAbstract3DGraph::ShadowQuality quality); // For automatic quality adjustments
+    void requestDelayedRender(int delay); // For rendering again once the scene settles
 
 protected:
     Abstract3DRenderer(Abstract3DController *controller);
@@ -237,11 +242,26 @@ protected:
     void updateCameraViewport();
 
     void recalculateCustomItemScalingAndPos(CustomRenderItem *item);
+    GLuint createVolumeTexture(QCustom3DVolume *volumeItem, CustomRenderItem *renderItem);
+    void updateVolumeBricks(QCustom3DVolume *volumeItem, CustomRenderItem *renderItem);
+    void updateInteractiveVolumeTexture(QCustom3DVolume *volumeItem, CustomRenderItem *renderItem);
+    bool isCameraMoving() const;
     virtual void getVisibleItemBounds(QVector3D &minBounds, QVector3D &maxBounds) = 0;
     void drawVolumeSliceFrame(const CustomRenderItem *item, Qt::Axis axis,
                               const QMatrix4x4 &projectionViewMatrix);
     void queriedGraphPosition(const QMatrix4x4 &projectionViewMatrix, const QVector3D &scaling,
                               GLuint defaultFboHandle);
+    void selectionRay(const QMatrix4x4 &projectionViewMatrix, QVector3D &origin,
+                      QVector3D &direction) const;
+    virtual void drawLabels(bool drawSelection, const Q3DCamera *activeCamera,
+                            const QMatrix4x4 &viewMatrix, const QMatrix4x4 &projectionMatrix) = 0;
+    void setLabelSelectionColor(ShaderHelper *shader, const QVector4D &color);
+    bool pickCustomItemsAndLabels(const QVector3D &origin, const QVector3D &direction,
+                                  const Q3DCamera *activeCamera, const QMatrix4x4 &viewMatrix,
+                                  const QMatrix4x4 &projectionMatrix, ShaderHelper *labelShader,
+                                  float &distance, QVector4D &color);
+    bool isCustomItemInRange(const CustomRenderItem *item) const;
+    QQuaternion customItemRotation(const CustomRenderItem *item) const;
 
     bool m_hasNegativeValues;
     Q3DTheme *m_cachedTheme;
@@ -273,6 +293,7 @@ protected:
     bool m_clickResolved;
     bool m_graphPositionQueryPending;
     bool m_graphPositionQueryResolved;
+    QElapsedTimer m_cameraMotionTimer; // Time since the camera last moved
     QAbstract3DSeries *m_clickedSeries;
     QAbstract3DGraph::ElementType m_clickedType;
     int m_selectedLabelIndex;
@@ -338,6 +359,7 @@ protected:
 #endif
     QPointer<QOpenGLContext> m_context; // Not owned
     bool m_isOpenGLES;
+    bool m_isInstancingSupported;
 
 private:
     friend class Abstract3DController;
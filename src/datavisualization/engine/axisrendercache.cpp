@@ -28,6 +28,8 @@
 ****************************************************************************/
 
 #include "axisrendercache_p.h"
+#include "qvalue3daxisformatter_p.h"
+#include "qlogvalue3daxisformatter.h"
 
 #include <QtGui/QFontMetrics>
 
@@ -168,6 +170,37 @@ void AxisRenderCache::updateAllPositions()
     }
 }
 
+// Returns true if positionAt() reduces to value * scale + offset, which is the case when the
+// cached formatter is the default linear formatter. Subclassed formatters may map values
+// arbitrarily, so they always return false.
+bool AxisRenderCache::linearMapping(float &scale, float &offset) const
+{
+    if (!m_formatter || m_formatter->metaObject() != &QValue3DAxisFormatter::staticMetaObject)
+        return false;
+
+    const QValue3DAxisFormatterPrivate *formatterPrivate = m_formatter->d_ptr.data();
+    const float valueScale = m_scale / formatterPrivate->m_rangeNormalizer;
+    if (m_reversed) {
+        scale = -valueScale;
+        offset = m_scale + m_translate + formatterPrivate->m_min * valueScale;
+    } else {
+        scale = valueScale;
+        offset = m_translate - formatterPrivate->m_min * valueScale;
+    }
+    return true;
+}
+
+// Built-in formatters resolve positions without side effects, so their positionAt() can be
+// called from worker threads. User formatters give no such guarantee.
+bool AxisRenderCache::hasBuiltInFormatter() const
+{
+    if (!m_formatter)
+        return false;
+    const QMetaObject *formatterType = m_formatter->metaObject();
+    return formatterType == &QValue3DAxisFormatter::staticMetaObject
+            || formatterType == &QLogValue3DAxisFormatter::staticMetaObject;
+}
+
 void AxisRenderCache::updateTextures()
 {
     m_font = m_drawer->font();
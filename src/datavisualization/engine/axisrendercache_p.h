@@ -46,7 +46,7 @@
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
-class AxisRenderCache : public QObject
+class QT_DATAVISUALIZATION_EXPORT AxisRenderCache : public QObject
 {
     Q_OBJECT
 public:
@@ -104,13 +104,15 @@ public:
     inline float translate() { return m_translate; }
     inline void setScale(float scale) { m_scale = scale; m_positionsDirty = true; }
     inline float scale() { return m_scale; }
-    inline float positionAt(float value)
+    inline float positionAt(float value) const
     {
         if (m_reversed)
             return (1.0f - m_formatter->positionAt(value)) * m_scale + m_translate;
         else
             return m_formatter->positionAt(value) * m_scale + m_translate;
     }
+    bool linearMapping(float &scale, float &offset) const;
+    bool hasBuiltInFormatter() const;
     inline float labelAutoRotation() const { return m_labelAutoRotation; }
     inline void setLabelAutoRotation(float angle) { m_labelAutoRotation = angle; }
     inline bool isTitleVisible() const { return m_titleVisible; }
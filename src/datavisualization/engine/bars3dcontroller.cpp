@@ -35,6 +35,7 @@
 #include "qbar3dseries_p.h"
 #include "thememanager_p.h"
 #include "q3dtheme_p.h"
+#include <QtCore/QBitArray>
 #include <QtCore/QMutexLocker>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
@@ -115,12 +116,14 @@ void Bars3DController::synchDataToRenderer()
         m_renderer->updateRows(m_changedRows);
         m_changeTracker.rowsChanged = false;
         m_changedRows.clear();
+        m_changedRowBits.clear();
     }
 
     if (m_changeTracker.itemChanged) {
         m_renderer->updateItems(m_changedItems);
         m_changeTracker.itemChanged = false;
         m_changedItems.clear();
+        m_changedItemKeys.clear();
     }
 
     if (m_changeTracker.multiSeriesScalingChanged) {
@@ -182,21 +185,17 @@ void Bars3DController::handleRowsAdded(int startIndex, int count)
 void Bars3DController::handleRowsChanged(int startIndex, int count)
 {
     QBar3DSeries *series = static_cast<QBarDataProxy *>(sender())->series();
-    int oldChangeCount = m_changedRows.size();
-    if (!oldChangeCount)
+    if (m_changedRows.isEmpty())
         m_changedRows.reserve(count);
 
+    QBitArray &changedRowBits = m_changedRowBits[series];
+    if (changedRowBits.size() < startIndex + count)
+        changedRowBits.resize(startIndex + count);
+
     for (int i = 0; i < count; i++) {
-        bool newItem = true;
         int candidate = startIndex + i;
-        for (int j = 0; j < oldChangeCount; j++) {
-            const ChangeRow &oldChangeItem = m_changedRows.at(j);
-            if (oldChangeItem.row == candidate && series == oldChangeItem.series) {
-                newItem = false;
-                break;
-            }
-        }
-        if (newItem) {
+        if (!changedRowBits.testBit(candidate)) {
+            changedRowBits.setBit(candidate);
             ChangeRow newChangeItem = {series, candidate};
             m_changedRows.append(newChangeItem);
             if (series == m_selectedBarSeries && m_selectedBar.x() == candidate)
@@ -272,19 +271,21 @@ void Bars3DController::handleItemChanged(int rowIndex, int columnIndex)
 {
     QBar3DSeries *series = static_cast<QBarDataProxy *>(sender())->series();
 
-    bool newItem = true;
+    // Items of rows that are already going to be updated need no separate update
+    const QBitArray changedRowBits = m_changedRowBits.value(series);
+    bool rowChanged = rowIndex < changedRowBits.size() && changedRowBits.testBit(rowIndex);
+
     QPoint candidate(rowIndex, columnIndex);
-    foreach (ChangeItem item, m_changedItems) {
-        if (item.point == candidate && item.series == series) {
-            newItem = false;
-            break;
+    quint64 key = (quint64(quint32(rowIndex)) << 32) | quint32(columnIndex);
+    QSet<quint64> &changedItemKeys = m_changedItemKeys[series];
+
+    if (!changedItemKeys.contains(key)) {
+        changedItemKeys.insert(key);
+        if (!rowChanged) {
+            ChangeItem newItem = {series, candidate};
+            m_changedItems.append(newItem);
+            m_changeTracker.itemChanged = true;
         }
-    }
-
-    if (newItem) {
-        ChangeItem newItem = {series, candidate};
-        m_changedItems.append(newItem);
-        m_changeTracker.itemChanged = true;
 
         if (series == m_selectedBarSeries && m_selectedBar == candidate)
             series->d_ptr->markItemLabelDirty();
@@ -639,12 +640,7 @@ void Bars3DController::adjustAxisRanges()
                     }
 
                     if (adjustX && proxy) {
-                        const QBarDataArray *array = proxy->array();
-                        int columnCount = 0;
-                        for (int i = 0; i < array->size(); i++) {
-                            if (columnCount < array->at(i)->size())
-                                columnCount = array->at(i)->size();
-                        }
+                        int columnCount = proxy->dptrc()->maxRowSize();
                         if (columnCount)
                             columnCount--;
 
@@ -710,8 +706,8 @@ void Bars3DController::adjustSelectionPosition(QPoint &pos, const QBar3DSeries *
 
     if (pos != invalidSelectionPosition()) {
         int maxRow = proxy->rowCount() - 1;
-        int maxCol = (pos.x() <= maxRow && pos.x() >= 0 && proxy->rowAt(pos.x()))
-                ? proxy->rowAt(pos.x())->size() - 1 : -1;
+        int maxCol = (pos.x() <= maxRow && pos.x() >= 0)
+                ? proxy->dptrc()->rowSize(pos.x()) - 1 : -1;
 
         if (pos.x() < 0 || pos.x() > maxRow || pos.y() < 0 || pos.y() > maxCol)
             pos = invalidSelectionPosition();
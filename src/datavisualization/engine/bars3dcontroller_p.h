@@ -42,6 +42,8 @@
 
 #include "datavisualizationglobal_p.h"
 #include "abstract3dcontroller_p.h"
+#include <QtCore/QBitArray>
+#include <QtCore/QSet>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -85,6 +87,9 @@ private:
     Bars3DChangeBitField m_changeTracker;
     QVector<ChangeItem> m_changedItems;
     QVector<ChangeRow> m_changedRows;
+    // Dirty bits of the rows and keys of the items in the change lists, per series
+    QHash<QBar3DSeries *, QBitArray> m_changedRowBits;
+    QHash<QBar3DSeries *, QSet<quint64> > m_changedItemKeys;
 
     // Interaction
     QPoint m_selectedBar;     // Points to row & column in data window.
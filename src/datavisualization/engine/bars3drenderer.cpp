@@ -33,6 +33,8 @@
 #include "texturehelper_p.h"
 #include "utils_p.h"
 #include "barseriesrendercache_p.h"
+#include "barinstancebufferhelper_p.h"
+#include "qbardataproxy_p.h"
 
 #include <QtCore/qmath.h>
 
@@ -55,7 +57,10 @@ Bars3DRenderer::Bars3DRenderer(Bars3DController *controller)
       m_updateLabels(false),
       m_barShader(0),
       m_barGradientShader(0),
+      m_barInstancedShader(0),
+      m_barInstancedGradientShader(0),
       m_depthShader(0),
+      m_instancedDepthShader(0),
       m_selectionShader(0),
       m_backgroundShader(0),
       m_bgrTexture(0),
@@ -103,7 +108,10 @@ Bars3DRenderer::~Bars3DRenderer()
     contextCleanup();
     delete m_barShader;
     delete m_barGradientShader;
+    delete m_barInstancedShader;
+    delete m_barInstancedGradientShader;
     delete m_depthShader;
+    delete m_instancedDepthShader;
     delete m_selectionShader;
     delete m_backgroundShader;
 }
@@ -239,19 +247,16 @@ void Bars3DRenderer::updateData()
             }
 
             if (cache->dataDirty() || dimensionsChanged) {
-                QBarDataProxy *dataProxy = currentSeries->dataProxy();
+                const QBarDataProxyPrivate *dataProxy = currentSeries->dataProxy()->dptrc();
                 dataRowCount = dataProxy->rowCount();
                 if (maxDataRowCount < dataRowCount)
                     maxDataRowCount = qMin(dataRowCount, newRows);
                 int dataRowIndex = minRow;
                 for (int i = 0; i < newRows; i++) {
-                    BarRenderItemRow &renderRow = renderArray[i];
-                    const QBarDataRow *dataRow = 0;
-                    if (dataRowIndex < dataRowCount)
-                        dataRow = dataProxy->rowAt(dataRowIndex);
-                    updateRenderRow(dataRow, renderRow);
+                    updateRenderRow(dataProxy, dataRowIndex, renderArray[i]);
                     dataRowIndex++;
                 }
+                cache->setInstancesDirty(true);
                 cache->setDataDirty(false);
             }
         }
@@ -262,18 +267,28 @@ void Bars3DRenderer::updateData()
                       m_selectedSeriesCache ? m_selectedSeriesCache->series() : 0);
 }
 
-void Bars3DRenderer::updateRenderRow(const QBarDataRow *dataRow, BarRenderItemRow &renderRow)
+void Bars3DRenderer::updateRenderRow(const QBarDataProxyPrivate *dataProxy, int dataRowIndex,
+                                     BarRenderItemRow &renderRow)
 {
     int j = 0;
     int renderRowSize = renderRow.size();
     int startIndex = m_axisCacheX.min();
 
-    if (dataRow) {
-        int updateSize = qMin((dataRow->size() - startIndex), renderRowSize);
-        int dataColIndex = startIndex;
-        for (; j < updateSize ; j++) {
-            updateRenderItem(dataRow->at(dataColIndex), renderRow[j]);
-            dataColIndex++;
+    if (dataRowIndex < dataProxy->rowCount()) {
+        int updateSize = qMin((dataProxy->rowSize(dataRowIndex) - startIndex), renderRowSize);
+        if (dataProxy->isValueArray()) {
+            // Values of a row are contiguous, so they are read without creating items
+            const float *values = dataProxy->rowValues(dataRowIndex) + startIndex;
+            for (; j < updateSize; j++)
+                updateRenderItem(values[j], 0.0f, renderRow[j]);
+        } else {
+            const QBarDataRow *dataRow = dataProxy->itemArray()->at(dataRowIndex);
+            int dataColIndex = startIndex;
+            for (; j < updateSize; j++) {
+                const QBarDataItem &dataItem = dataRow->at(dataColIndex);
+                updateRenderItem(dataItem.value(), dataItem.rotation(), renderRow[j]);
+                dataColIndex++;
+            }
         }
     }
     for (; j < renderRowSize; j++) {
@@ -283,9 +298,8 @@ void Bars3DRenderer::updateRenderRow(const QBarDataRow *dataRow, BarRenderItemRo
     }
 }
 
-void Bars3DRenderer::updateRenderItem(const QBarDataItem &dataItem, BarRenderItem &renderItem)
+void Bars3DRenderer::updateRenderItem(float value, float angle, BarRenderItem &renderItem)
 {
-    float value = dataItem.value();
     float heightValue = m_axisCacheY.formatter()->positionAt(value);
     if (m_noZeroInRange) {
         if (m_hasNegativeValues) {
@@ -305,7 +319,6 @@ void Bars3DRenderer::updateRenderItem(const QBarDataItem &dataItem, BarRenderIte
     renderItem.setValue(value);
     renderItem.setHeight(heightValue);
 
-    float angle = dataItem.rotation();
     if (angle) {
         renderItem.setRotation(
                     QQuaternion::fromAxisAndAngle(
@@ -363,7 +376,7 @@ void Bars3DRenderer::updateRows(const QVector<Bars3DController::ChangeRow> &rows
     int maxRow = m_axisCacheZ.max();
     BarSeriesRenderCache *cache = 0;
     const QBar3DSeries *prevSeries = 0;
-    const QBarDataArray *dataArray = 0;
+    const QBarDataProxyPrivate *dataProxy = 0;
 
     foreach (Bars3DController::ChangeRow item, rows) {
         const int row = item.row;
@@ -373,14 +386,21 @@ void Bars3DRenderer::updateRows(const QVector<Bars3DController::ChangeRow> &rows
         if (currentSeries != prevSeries) {
             cache = static_cast<BarSeriesRenderCache *>(m_renderCacheList.value(currentSeries));
             prevSeries = currentSeries;
-            dataArray = item.series->dataProxy()->array();
+            dataProxy = item.series->dataProxy()->dptrc();
             // Invisible series render caches are not updated, but instead just marked dirty, so that
             // they can be completely recalculated when they are turned visible.
             if (!cache->isVisible() && !cache->dataDirty())
                 cache->setDataDirty(true);
         }
         if (cache->isVisible()) {
-            updateRenderRow(dataArray->at(row), cache->renderArray()[row - minRow]);
+            BarRenderItemRow &renderRow = cache->renderArray()[row - minRow];
+            updateRenderRow(dataProxy, row, renderRow);
+            if (!cache->instancesDirty()) {
+                // Changed bars are uploaded to the instance buffer before drawing
+                const int firstSlot = (row - minRow) * renderRow.size();
+                for (int i = 0; i < renderRow.size(); i++)
+                    cache->instanceUpdateSlots().append(firstSlot + i);
+            }
             if (m_cachedIsSlicingActivated
                     && cache == m_selectedSeriesCache
                     && m_selectedBarPos.x() == row) {
@@ -398,7 +418,7 @@ void Bars3DRenderer::updateItems(const QVector<Bars3DController::ChangeItem> &it
     int maxCol = m_axisCacheX.max();
     BarSeriesRenderCache *cache = 0;
     const QBar3DSeries *prevSeries = 0;
-    const QBarDataArray *dataArray = 0;
+    const QBarDataProxyPrivate *dataProxy = 0;
 
     foreach (Bars3DController::ChangeItem item, items) {
         const int row = item.point.x();
@@ -409,15 +429,21 @@ void Bars3DRenderer::updateItems(const QVector<Bars3DController::ChangeItem> &it
         if (currentSeries != prevSeries) {
             cache = static_cast<BarSeriesRenderCache *>(m_renderCacheList.value(currentSeries));
             prevSeries = currentSeries;
-            dataArray = item.series->dataProxy()->array();
+            dataProxy = item.series->dataProxy()->dptrc();
             // Invisible series render caches are not updated, but instead just marked dirty, so that
             // they can be completely recalculated when they are turned visible.
             if (!cache->isVisible() && !cache->dataDirty())
                 cache->setDataDirty(true);
         }
         if (cache->isVisible()) {
-            updateRenderItem(dataArray->at(row)->at(col),
-                             cache->renderArray()[row - minRow][col - minCol]);
+            BarRenderItemArray &renderArray = cache->renderArray();
+            const QBarDataItem dataItem = dataProxy->item(row, col);
+            updateRenderItem(dataItem.value(), dataItem.rotation(),
+                             renderArray[row - minRow][col - minCol]);
+            if (!cache->instancesDirty()) {
+                cache->instanceUpdateSlots().append((row - minRow) * renderArray.at(0).size()
+                                                    + col - minCol);
+            }
             if (m_cachedIsSlicingActivated
                     && cache == m_selectedSeriesCache
                     && m_selectedBarPos == QPoint(row, col)) {
@@ -456,11 +482,34 @@ void Bars3DRenderer::render(GLuint defaultFboHandle)
     if (m_axisCacheY.positionsDirty())
         m_axisCacheY.updateAllPositions();
 
+    if (isInstancedDrawing()) {
+        updateInstanceBuffers();
+
+        // Large instance buffer loads are uploaded over several frames, drawing the old
+        // buffers until they swap
+        bool uploading = false;
+        foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+            BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
+            BarInstanceBufferHelper *instances = cache->instanceBuffer();
+            if (instances && instances->hasPendingUpload())
+                uploading |= !instances->uploadPending();
+        }
+        if (uploading)
+            emit needRender();
+    }
+
     drawScene(defaultFboHandle);
     if (m_cachedIsSlicingActivated)
         drawSlicedScene();
 }
 
+void Bars3DRenderer::updateOptimizationHint(QAbstract3DGraph::OptimizationHints hint)
+{
+    Abstract3DRenderer::updateOptimizationHint(hint);
+
+    Abstract3DRenderer::reInitShaders();
+}
+
 void Bars3DRenderer::drawSlicedScene()
 {
     if (m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionRow)
@@ -1074,11 +1123,47 @@ void Bars3DRenderer::drawScene(GLuint defaultFboHandle)
         // Draw bars to depth buffer
         QVector3D shadowScaler(m_scaleX * m_seriesScaleX * 0.9f, 0.0f,
                                m_scaleZ * m_seriesScaleZ * 0.9f);
+        const bool instanced = isInstancedDrawing();
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             if (baseCache->isVisible()) {
                 BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
                 float seriesPos = m_seriesStart + m_seriesStep * cache->visualIndex() + 0.5f;
                 ObjectHelper *barObj = cache->object();
+                if (instanced) {
+                    BarInstanceBufferHelper *instances = cache->instanceBuffer();
+                    if (!instances || !instances->instanceCount())
+                        continue;
+                    m_instancedDepthShader->bind();
+                    m_instancedDepthShader->setUniformValue(m_instancedDepthShader->barLayout(),
+                                                            instancedBarLayout(cache));
+                    // Bars above and below the floor are drawn separately, as they are offset
+                    // and culled differently, like when they are drawn one by one
+                    for (int side = 1; side >= -1; side -= 2) {
+                        if (m_cachedTheme->isBackgroundEnabled() && m_reflectionEnabled
+                                && ((m_yFlipped && side > 0) || (!m_yFlipped && side < 0))) {
+                            continue;
+                        }
+                        GLfloat shadowOffset = 0.0f;
+                        if (side > 0 && m_yFlipped)
+                            shadowOffset = 0.015f;
+                        else if (side < 0 && !m_yFlipped)
+                            shadowOffset = -0.015f;
+                        QMatrix4x4 offsetMatrix;
+                        offsetMatrix.translate(0.0f, shadowOffset, 0.0f);
+                        m_instancedDepthShader->setUniformValue(
+                                    m_instancedDepthShader->MVP(),
+                                    depthProjectionViewMatrix * offsetMatrix);
+                        m_instancedDepthShader->setUniformValue(
+                                    m_instancedDepthShader->barScale(),
+                                    QVector4D(shadowScaler.x(), 1.0f, shadowScaler.z(),
+                                              GLfloat(side)));
+                        glCullFace(side > 0 ? GL_BACK : GL_FRONT);
+                        m_drawer->drawObjectInstanced(m_instancedDepthShader, barObj,
+                                                      instances);
+                    }
+                    m_depthShader->bind();
+                    continue;
+                }
                 QQuaternion seriesRotation(cache->meshRotation());
                 const BarRenderItemArray &renderArray = cache->renderArray();
                 for (int row = startRow; row != stopRow; row += stepRow) {
@@ -1456,6 +1541,7 @@ bool Bars3DRenderer::drawBars(BarRenderItem **selectedBar,
     QVector3D modelScaler(m_scaleX * m_seriesScaleX, 0.0f, m_scaleZ * m_seriesScaleZ);
     bool somethingSelected =
             (m_visualSelectedBarPos != Bars3DController::invalidSelectionPosition());
+    const bool instanced = isInstancedDrawing();
     foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
         if (baseCache->isVisible()) {
             BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
@@ -1493,10 +1579,46 @@ bool Bars3DRenderer::drawBars(BarRenderItem **selectedBar,
             }
 
             previousColorStyle = colorStyle;
+
+            if (instanced) {
+                drawInstancedBars(cache, colorStyleIsUniform ? m_barInstancedShader
+                                                             : m_barInstancedGradientShader,
+                                  depthProjectionViewMatrix, projectionViewMatrix, viewMatrix,
+                                  reflection);
+                barShader->bind();
+                // Only the highlighted bars are left to draw one by one
+                if (!somethingSelected || m_cachedSelectionMode == QAbstract3DGraph::SelectionNone)
+                    continue;
+            }
+
             for (int row = startRow; row != stopRow; row += stepRow) {
                 BarRenderItemRow &renderRow = renderArray[row];
-                for (int bar = startBar; bar != stopBar; bar += stepBar) {
+                int firstBar = startBar;
+                int lastBar = stopBar;
+                if (instanced) {
+                    // Only the highlighted bars of the row are visited
+                    Bars3DController::SelectionType highlight =
+                            rowHighlight(row, m_visualSelectedBarPos, m_cachedSelectionMode);
+                    if (highlight == Bars3DController::SelectionNone)
+                        continue;
+                    if (highlight != Bars3DController::SelectionRow) {
+                        firstBar = m_visualSelectedBarPos.y();
+                        if (firstBar < 0 || firstBar >= renderRow.size())
+                            continue;
+                        lastBar = firstBar + stepBar;
+                    }
+                }
+                for (int bar = firstBar; bar != lastBar; bar += stepBar) {
                     BarRenderItem &item = renderRow[bar];
+                    Bars3DController::SelectionType selectionType =
+                            Bars3DController::SelectionNone;
+                    if (somethingSelected
+                            && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone) {
+                        selectionType = isSelected(row, bar, cache);
+                    }
+                    if (instanced && selectionType == Bars3DController::SelectionNone)
+                        continue;
+
                     float adjustedHeight = reflection * item.height();
                     if (adjustedHeight < 0)
                         glCullFace(GL_FRONT);
@@ -1530,11 +1652,6 @@ bool Bars3DRenderer::drawBars(BarRenderItem **selectedBar,
                     GLfloat shadowLightStrength = adjustedLightStrength;
 
                     if (m_cachedSelectionMode > QAbstract3DGraph::SelectionNone) {
-                        Bars3DController::SelectionType selectionType =
-                                Bars3DController::SelectionNone;
-                        if (somethingSelected)
-                            selectionType = isSelected(row, bar, cache);
-
                         switch (selectionType) {
                         case Bars3DController::SelectionItem: {
                             if (colorStyleIsUniform)
@@ -1691,6 +1808,80 @@ bool Bars3DRenderer::drawBars(BarRenderItem **selectedBar,
     return barSelectionFound;
 }
 
+// Draws all bars of the series with a single instanced call. Highlighted bars and bars on the
+// wrong side of the floor for reflections are collapsed in the shader.
+void Bars3DRenderer::drawInstancedBars(BarSeriesRenderCache *cache, ShaderHelper *shader,
+                                       const QMatrix4x4 &depthProjectionViewMatrix,
+                                       const QMatrix4x4 &projectionViewMatrix,
+                                       const QMatrix4x4 &viewMatrix, GLfloat reflection)
+{
+    BarInstanceBufferHelper *instances = cache->instanceBuffer();
+    if (!instances || !instances->instanceCount())
+        return;
+
+    bool colorStyleIsUniform = (cache->colorStyle() == Q3DTheme::ColorStyleUniform);
+
+    shader->bind();
+    shader->setUniformValue(shader->lightP(), m_cachedScene->activeLight()->position());
+    shader->setUniformValue(shader->view(), viewMatrix);
+    shader->setUniformValue(shader->ambientS(), m_cachedTheme->ambientLightStrength());
+    shader->setUniformValue(shader->lightColor(),
+                            Utils::vectorFromColor(m_cachedTheme->lightColor()));
+#ifdef SHOW_DEPTH_TEXTURE_SCENE
+    shader->setUniformValue(shader->MVP(), depthProjectionViewMatrix);
+#else
+    shader->setUniformValue(shader->MVP(), projectionViewMatrix);
+#endif
+    if (colorStyleIsUniform)
+        shader->setUniformValue(shader->color(), cache->baseColor());
+
+    shader->setUniformValue(shader->barLayout(), instancedBarLayout(cache));
+
+    QVector4D selection(-1.0f, -1.0f, 0.0f, 0.0f);
+    if (m_visualSelectedBarPos != Bars3DController::invalidSelectionPosition()
+            && (m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionItem)
+                || m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionRow)
+                || m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionColumn))
+            && ((m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionMultiSeries)
+                 && m_selectedSeriesCache) || cache == m_selectedSeriesCache)) {
+        selection = QVector4D(m_visualSelectedBarPos.x(), m_visualSelectedBarPos.y(),
+                              m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionRow)
+                              ? 1.0f : 0.0f,
+                              m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionColumn)
+                              ? 1.0f : 0.0f);
+    }
+    shader->setUniformValue(shader->barSelection(), selection);
+
+    GLuint gradientTexture = colorStyleIsUniform ? 0 : cache->baseGradientTexture();
+    const bool shadows = m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone
+            && !m_isOpenGLES;
+    if (shadows) {
+        shader->setUniformValue(shader->shadowQ(), m_shadowQualityToShader);
+        shader->setUniformValue(shader->depth(), depthProjectionViewMatrix);
+        shader->setUniformValue(shader->lightS(), m_cachedTheme->lightStrength() / 10.0f);
+    } else {
+        shader->setUniformValue(shader->lightS(), m_cachedTheme->lightStrength());
+    }
+
+    // Flipping bars below the floor reverses the winding of their triangles, so they are drawn
+    // separately with front face culling, like when bars are drawn one by one. Reflections only
+    // draw the bars on one side of the floor.
+    for (int side = 1; side >= -1; side -= 2) {
+        if (reflection != 1.0f && side != (m_yFlipped ? -1 : 1))
+            continue;
+        shader->setUniformValue(shader->barScale(),
+                                QVector4D(m_scaleX * m_seriesScaleX, reflection,
+                                          m_scaleZ * m_seriesScaleZ, GLfloat(side)));
+        glCullFace(side * reflection < 0.0f ? GL_FRONT : GL_BACK);
+        if (shadows) {
+            m_drawer->drawObjectInstanced(shader, cache->object(), instances, gradientTexture,
+                                          m_depthTexture);
+        } else {
+            m_drawer->drawObjectInstanced(shader, cache->object(), instances, gradientTexture);
+        }
+    }
+}
+
 void Bars3DRenderer::drawBackground(GLfloat backgroundRotation,
                                     const QMatrix4x4 &depthProjectionViewMatrix,
                                     const QMatrix4x4 &projectionViewMatrix,
@@ -2612,6 +2803,50 @@ void Bars3DRenderer::calculateSceneScalingFactors()
     updateCustomItemPositions();
 }
 
+// Static bar series are drawn with one instanced call per series when instancing is supported
+bool Bars3DRenderer::isInstancedDrawing() const
+{
+    return m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
+            && m_barInstancedShader;
+}
+
+void Bars3DRenderer::updateInstanceBuffers()
+{
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        BarSeriesRenderCache *cache = static_cast<BarSeriesRenderCache *>(baseCache);
+        if (!cache->isVisible())
+            continue;
+
+        BarInstanceBufferHelper *instances = cache->instanceBuffer();
+        if (!instances) {
+            instances = new BarInstanceBufferHelper();
+            cache->setInstanceBuffer(instances);
+        }
+
+        // Range gradient is scaled by the bar height, object gradient covers each bar
+        float gradientScale = 0.0f;
+        if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
+            gradientScale = 1.0f / m_gradientFraction;
+
+        if (cache->instancesDirty()) {
+            instances->fullLoad(cache, gradientScale);
+            cache->setInstancesDirty(false);
+        } else {
+            instances->update(cache, gradientScale);
+        }
+    }
+}
+
+// Scale and offset from the column and row of a bar to its X and Z position
+QVector4D Bars3DRenderer::instancedBarLayout(BarSeriesRenderCache *cache) const
+{
+    float seriesPos = m_seriesStart + m_seriesStep * cache->visualIndex() + 0.5f;
+    return QVector4D(m_cachedBarSpacing.width() / m_scaleFactor,
+                     (seriesPos * m_cachedBarSpacing.width() - m_rowWidth) / m_scaleFactor,
+                     -m_cachedBarSpacing.height() / m_scaleFactor,
+                     (m_columnDepth - 0.5f * m_cachedBarSpacing.height()) / m_scaleFactor);
+}
+
 void Bars3DRenderer::calculateHeightAdjustment()
 {
     float min = m_axisCacheY.min();
@@ -2655,6 +2890,25 @@ void Bars3DRenderer::calculateHeightAdjustment()
     }
 }
 
+// Returns how the bars of the row are highlighted by the selection at the given visual position:
+// SelectionRow if all of them are, SelectionItem if only the bar in the selected column is, and
+// SelectionNone if none are.
+Bars3DController::SelectionType Bars3DRenderer::rowHighlight(
+        int row, const QPoint &selectedPosition, QAbstract3DGraph::SelectionFlags selectionMode)
+{
+    if (selectedPosition == Bars3DController::invalidSelectionPosition())
+        return Bars3DController::SelectionNone;
+    if (row == selectedPosition.x()) {
+        if (selectionMode.testFlag(QAbstract3DGraph::SelectionRow))
+            return Bars3DController::SelectionRow;
+        if (selectionMode.testFlag(QAbstract3DGraph::SelectionItem))
+            return Bars3DController::SelectionItem;
+    }
+    if (selectionMode.testFlag(QAbstract3DGraph::SelectionColumn))
+        return Bars3DController::SelectionItem;
+    return Bars3DController::SelectionNone;
+}
+
 Bars3DController::SelectionType Bars3DRenderer::isSelected(int row, int bar,
                                                            const BarSeriesRenderCache *cache)
 {
@@ -2774,6 +3028,21 @@ void Bars3DRenderer::initGradientShaders(const QString &vertexShader, const QStr
     m_barGradientShader->initialize();
 }
 
+void Bars3DRenderer::initStaticInstancedShaders(const QString &vertexShader,
+                                                const QString &fragmentShader,
+                                                const QString &gradientVertexShader,
+                                                const QString &gradientFragmentShader)
+{
+    delete m_barInstancedShader;
+    m_barInstancedShader = new ShaderHelper(this, vertexShader, fragmentShader);
+    m_barInstancedShader->initialize();
+
+    delete m_barInstancedGradientShader;
+    m_barInstancedGradientShader = new ShaderHelper(this, gradientVertexShader,
+                                                    gradientFragmentShader);
+    m_barInstancedGradientShader->initialize();
+}
+
 void Bars3DRenderer::initSelectionShader()
 {
     if (m_selectionShader)
@@ -2803,6 +3072,15 @@ void Bars3DRenderer::initDepthShader()
         m_depthShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexDepth"),
                                          QStringLiteral(":/shaders/fragmentDepth"));
         m_depthShader->initialize();
+
+        if (m_isInstancingSupported) {
+            if (m_instancedDepthShader)
+                delete m_instancedDepthShader;
+            m_instancedDepthShader =
+                    new ShaderHelper(this, QStringLiteral(":/shaders/vertexBarDepthInstanced"),
+                                     QStringLiteral(":/shaders/fragmentDepth"));
+            m_instancedDepthShader->initialize();
+        }
     }
 }
 
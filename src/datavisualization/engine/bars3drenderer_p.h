@@ -56,6 +56,7 @@ class ShaderHelper;
 class LabelItem;
 class Q3DScene;
 class BarSeriesRenderCache;
+class QBarDataProxyPrivate;
 
 class QT_DATAVISUALIZATION_EXPORT Bars3DRenderer : public Abstract3DRenderer
 {
@@ -76,7 +77,10 @@ private:
     bool m_updateLabels;
     ShaderHelper *m_barShader;
     ShaderHelper *m_barGradientShader;
+    ShaderHelper *m_barInstancedShader;
+    ShaderHelper *m_barInstancedGradientShader;
     ShaderHelper *m_depthShader;
+    ShaderHelper *m_instancedDepthShader;
     ShaderHelper *m_selectionShader;
     ShaderHelper *m_backgroundShader;
     GLuint m_bgrTexture;
@@ -124,8 +128,12 @@ public:
     SeriesRenderCache *createNewCache(QAbstract3DSeries *series);
     void updateRows(const QVector<Bars3DController::ChangeRow> &rows);
     void updateItems(const QVector<Bars3DController::ChangeItem> &items);
+    static Abstract3DController::SelectionType rowHighlight(
+            int row, const QPoint &selectedPosition,
+            QAbstract3DGraph::SelectionFlags selectionMode);
     void updateScene(Q3DScene *scene);
     void render(GLuint defaultFboHandle = 0);
+    void updateOptimizationHint(QAbstract3DGraph::OptimizationHints hint);
 
     QVector3D convertPositionToTranslation(const QVector3D &position, bool isAbsolute);
 
@@ -158,6 +166,10 @@ public Q_SLOTS:
 private:
     virtual void initShaders(const QString &vertexShader, const QString &fragmentShader);
     virtual void initGradientShaders(const QString &vertexShader, const QString &fragmentShader);
+    virtual void initStaticInstancedShaders(const QString &vertexShader,
+                                            const QString &fragmentShader,
+                                            const QString &gradientVertexShader,
+                                            const QString &gradientFragmentShader);
     virtual void updateShadowQuality(QAbstract3DGraph::ShadowQuality quality);
     virtual void updateTextures();
     virtual void fixMeshFileName(QString &fileName, QAbstract3DSeries::Mesh mesh);
@@ -171,6 +183,10 @@ private:
                   const QMatrix4x4 &projectionViewMatrix, const QMatrix4x4 &viewMatrix,
                   GLint startRow, GLint stopRow, GLint stepRow,
                   GLint startBar, GLint stopBar, GLint stepBar, GLfloat reflection = 1.0f);
+    void drawInstancedBars(BarSeriesRenderCache *cache, ShaderHelper *shader,
+                           const QMatrix4x4 &depthProjectionViewMatrix,
+                           const QMatrix4x4 &projectionViewMatrix, const QMatrix4x4 &viewMatrix,
+                           GLfloat reflection);
     void drawBackground(GLfloat backgroundRotation, const QMatrix4x4 &depthProjectionViewMatrix,
                         const QMatrix4x4 &projectionViewMatrix, const QMatrix4x4 &viewMatrix,
                         bool reflectingDraw = false, bool drawingSelectionBuffer = false);
@@ -185,14 +201,18 @@ private:
     void initDepthShader();
     void updateDepthBuffer();
     void calculateSceneScalingFactors();
+    bool isInstancedDrawing() const;
+    void updateInstanceBuffers();
+    QVector4D instancedBarLayout(BarSeriesRenderCache *cache) const;
     void calculateHeightAdjustment();
     Abstract3DController::SelectionType isSelected(int row, int bar,
                                                    const BarSeriesRenderCache *cache);
     QPoint selectionColorToArrayPosition(const QVector4D &selectionColor);
     QBar3DSeries *selectionColorToSeries(const QVector4D &selectionColor);
 
-    inline void updateRenderRow(const QBarDataRow *dataRow, BarRenderItemRow &renderRow);
-    inline void updateRenderItem(const QBarDataItem &dataItem, BarRenderItem &renderItem);
+    inline void updateRenderRow(const QBarDataProxyPrivate *dataProxy, int dataRowIndex,
+                                BarRenderItemRow &renderRow);
+    inline void updateRenderItem(float value, float angle, BarRenderItem &renderItem);
 
     Q_DISABLE_COPY(Bars3DRenderer)
 };
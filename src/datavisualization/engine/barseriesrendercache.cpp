@@ -28,24 +28,32 @@
 ****************************************************************************/
 
 #include "barseriesrendercache_p.h"
+#include "barinstancebufferhelper_p.h"
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 BarSeriesRenderCache::BarSeriesRenderCache(QAbstract3DSeries *series,
                                            Abstract3DRenderer *renderer)
     : SeriesRenderCache(series, renderer),
-      m_visualIndex(-1)
+      m_visualIndex(-1),
+      m_instanceBuffer(0),
+      m_instancesDirty(true)
 {
 }
 
 BarSeriesRenderCache::~BarSeriesRenderCache()
 {
+    delete m_instanceBuffer;
 }
 
 void BarSeriesRenderCache::cleanup(TextureHelper *texHelper)
 {
     m_renderArray.clear();
     m_sliceArray.clear();
+    m_instanceUpdateSlots.clear();
+    delete m_instanceBuffer;
+    m_instanceBuffer = 0;
+    m_instancesDirty = true;
 
     SeriesRenderCache::cleanup(texHelper);
 }
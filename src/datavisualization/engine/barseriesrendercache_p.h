@@ -47,6 +47,8 @@
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
+class BarInstanceBufferHelper;
+
 class BarSeriesRenderCache : public SeriesRenderCache
 {
 public:
@@ -60,11 +62,19 @@ public:
     inline QVector<BarRenderSliceItem> &sliceArray() { return m_sliceArray; }
     inline void setVisualIndex(int index) { m_visualIndex = index; }
     inline int visualIndex() {return m_visualIndex; }
+    inline void setInstanceBuffer(BarInstanceBufferHelper *buffer) { m_instanceBuffer = buffer; }
+    inline BarInstanceBufferHelper *instanceBuffer() const { return m_instanceBuffer; }
+    inline void setInstancesDirty(bool state) { m_instancesDirty = state; }
+    inline bool instancesDirty() const { return m_instancesDirty; }
+    inline QVector<int> &instanceUpdateSlots() { return m_instanceUpdateSlots; }
 
 protected:
     BarRenderItemArray m_renderArray;
     QVector<BarRenderSliceItem> m_sliceArray;
     int m_visualIndex; // order of the series is relevant
+    BarInstanceBufferHelper *m_instanceBuffer;
+    bool m_instancesDirty;
+    QVector<int> m_instanceUpdateSlots; // Changed bars that are not yet in the instance buffer
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -34,8 +34,11 @@
 #include "texturehelper_p.h"
 #include "abstract3drenderer_p.h"
 #include "scatterpointbufferhelper_p.h"
+#include "scatterobjectbufferhelper_p.h"
+#include "barinstancebufferhelper_p.h"
 
 #include <QtGui/QMatrix4x4>
+#include <QtGui/QOpenGLExtraFunctions>
 #include <QtCore/qmath.h>
 
 // Resources need to be explicitly initialized when building as static library
@@ -65,7 +68,10 @@ Drawer::Drawer(Q3DTheme *theme)
       m_textureHelper(0),
       m_pointbuffer(0),
       m_linebuffer(0),
-      m_scaledFontSize(0.0f)
+      m_scaledFontSize(0.0f),
+      m_labelPicking(false),
+      m_labelPicked(false),
+      m_pickDistance(0.0f)
 {
 }
 
@@ -133,13 +139,15 @@ void Drawer::drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLui
     // 1st attribute buffer : vertices
     glEnableVertexAttribArray(shader->posAtt());
     glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
-    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0,
+                          (void*)object->vertexOffset());
 
     // 2nd attribute buffer : normals
     if (shader->normalAtt() >= 0) {
         glEnableVertexAttribArray(shader->normalAtt());
         glBindBuffer(GL_ARRAY_BUFFER, object->normalBuf());
-        glVertexAttribPointer(shader->normalAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+        glVertexAttribPointer(shader->normalAtt(), 3, GL_FLOAT, GL_FALSE, 0,
+                              (void*)object->vertexOffset());
     }
 
     // 3rd attribute buffer : UVs
@@ -153,7 +161,7 @@ void Drawer::drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLui
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
 
     // Draw the triangles
-    glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT, (void*)0);
+    object->drawElements();
 
     // Free buffers
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -182,15 +190,153 @@ void Drawer::drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLui
     }
 }
 
+void Drawer::drawObjectInstanced(ShaderHelper *shader, AbstractObjectHelper *mesh,
+                                 ScatterObjectBufferHelper *instances, GLuint textureId,
+                                 GLuint depthTextureId)
+{
+    // Selection shaders take the color of each instance from the selection color buffer
+    const GLint colorAtt = shader->selectionColorAtt();
+    if (colorAtt >= 0) {
+        glEnableVertexAttribArray(colorAtt);
+        glBindBuffer(GL_ARRAY_BUFFER, instances->selectionColorBuf());
+        glVertexAttribPointer(colorAtt, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)0);
+        QOpenGLContext::currentContext()->extraFunctions()->glVertexAttribDivisor(colorAtt, 1);
+    }
+
+    drawInstances(shader, mesh, instances->instancePositionBuf(),
+                  instances->instanceRotationBuf(), instances->uvBuf(),
+                  instances->instanceCount(), textureId, depthTextureId);
+
+    if (colorAtt >= 0) {
+        QOpenGLContext::currentContext()->extraFunctions()->glVertexAttribDivisor(colorAtt, 0);
+        glDisableVertexAttribArray(colorAtt);
+    }
+}
+
+void Drawer::drawObjectInstanced(ShaderHelper *shader, AbstractObjectHelper *mesh,
+                                 BarInstanceBufferHelper *instances, GLuint textureId,
+                                 GLuint depthTextureId)
+{
+    // Bar instances have no UVs, the gradient position is derived from the bar height
+    drawInstances(shader, mesh, instances->instancePositionBuf(),
+                  instances->instanceRotationBuf(), 0, instances->instanceCount(), textureId,
+                  depthTextureId);
+}
+
+void Drawer::drawInstances(ShaderHelper *shader, AbstractObjectHelper *mesh,
+                           GLuint positionBuffer, GLuint rotationBuffer, GLuint uvBuffer,
+                           GLsizei instanceCount, GLuint textureId, GLuint depthTextureId)
+{
+    QOpenGLExtraFunctions *extraFuncs = QOpenGLContext::currentContext()->extraFunctions();
+
+    if (textureId) {
+        // Activate texture
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        shader->setUniformValue(shader->texture(), 0);
+    }
+
+    if (depthTextureId) {
+        // Activate depth texture
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, depthTextureId);
+        shader->setUniformValue(shader->shadow(), 1);
+    }
+
+    // 1st attribute buffer : mesh vertices
+    glEnableVertexAttribArray(shader->posAtt());
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuf());
+    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    // 2nd attribute buffer : mesh normals
+    if (shader->normalAtt() >= 0) {
+        glEnableVertexAttribArray(shader->normalAtt());
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->normalBuf());
+        glVertexAttribPointer(shader->normalAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    }
+
+    // 3rd attribute buffer : instance positions and scales
+    glEnableVertexAttribArray(shader->instancePosAtt());
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glVertexAttribPointer(shader->instancePosAtt(), 4, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    extraFuncs->glVertexAttribDivisor(shader->instancePosAtt(), 1);
+
+    // 4th attribute buffer : instance rotations, or identity if none of the items is rotated
+    if (shader->instanceRotationAtt() >= 0) {
+        if (rotationBuffer) {
+            glEnableVertexAttribArray(shader->instanceRotationAtt());
+            glBindBuffer(GL_ARRAY_BUFFER, rotationBuffer);
+            glVertexAttribPointer(shader->instanceRotationAtt(), 4, GL_FLOAT, GL_FALSE, 0,
+                                  (void*)0);
+            extraFuncs->glVertexAttribDivisor(shader->instanceRotationAtt(), 1);
+        } else {
+            glVertexAttrib4f(shader->instanceRotationAtt(), 0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    // 5th attribute buffer : instance UVs
+    if (shader->instanceUVAtt() >= 0 && uvBuffer) {
+        glEnableVertexAttribArray(shader->instanceUVAtt());
+        glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
+        glVertexAttribPointer(shader->instanceUVAtt(), 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+        extraFuncs->glVertexAttribDivisor(shader->instanceUVAtt(), 1);
+    }
+
+    // Index buffer
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->elementBuf());
+
+    // Draw all instances with a single call
+    extraFuncs->glDrawElementsInstanced(GL_TRIANGLES, mesh->indexCount(), GL_UNSIGNED_INT,
+                                        (void*)0, instanceCount);
+
+    // Free buffers
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // Divisors are attribute state, so reset them for the non-instanced shaders
+    if (shader->instanceUVAtt() >= 0 && uvBuffer) {
+        extraFuncs->glVertexAttribDivisor(shader->instanceUVAtt(), 0);
+        glDisableVertexAttribArray(shader->instanceUVAtt());
+    }
+    if (shader->instanceRotationAtt() >= 0 && rotationBuffer) {
+        extraFuncs->glVertexAttribDivisor(shader->instanceRotationAtt(), 0);
+        glDisableVertexAttribArray(shader->instanceRotationAtt());
+    }
+    extraFuncs->glVertexAttribDivisor(shader->instancePosAtt(), 0);
+    glDisableVertexAttribArray(shader->instancePosAtt());
+    if (shader->normalAtt() >= 0)
+        glDisableVertexAttribArray(shader->normalAtt());
+    glDisableVertexAttribArray(shader->posAtt());
+
+    // Release textures
+    if (depthTextureId) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (textureId) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
 void Drawer::drawSelectionObject(ShaderHelper *shader, AbstractObjectHelper *object)
 {
     glEnableVertexAttribArray(shader->posAtt());
     glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
     glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    // Shaders with a color attribute take the color of each vertex from the selection colors
+    const GLint colorAtt = shader->selectionColorAtt();
+    if (colorAtt >= 0) {
+        glEnableVertexAttribArray(colorAtt);
+        glBindBuffer(GL_ARRAY_BUFFER, object->selectionColorBuf());
+        glVertexAttribPointer(colorAtt, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void *)0);
+    }
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
     glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT, (void *)0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (colorAtt >= 0)
+        glDisableVertexAttribArray(colorAtt);
     glDisableVertexAttribArray(shader->posAtt());
 }
 
@@ -199,7 +345,8 @@ void Drawer::drawSurfaceGrid(ShaderHelper *shader, SurfaceObject *object)
     // 1st attribute buffer : vertices
     glEnableVertexAttribArray(shader->posAtt());
     glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
-    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glVertexAttribPointer(shader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0,
+                          (void*)object->vertexOffset());
 
     // Index buffer
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->gridElementBuf());
@@ -214,6 +361,26 @@ void Drawer::drawSurfaceGrid(ShaderHelper *shader, SurfaceObject *object)
     glDisableVertexAttribArray(shader->posAtt());
 }
 
+// Binds the height texture of a height mapped surface for the vertex shader. Texture units
+// below it are used by drawObject().
+void Drawer::bindHeightMap(ShaderHelper *shader, SurfaceObject *object)
+{
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, object->heightMapTexture());
+    shader->setUniformValue(shader->heightMap(), 3);
+    shader->setUniformValue(shader->heightMapSize(), object->heightMapSize());
+    shader->setUniformValue(shader->heightMapScale(), object->heightMapScale());
+    shader->setUniformValue(shader->heightMapOffset(), object->heightMapOffset());
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Drawer::releaseHeightMap()
+{
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
 void Drawer::drawPoint(ShaderHelper *shader)
 {
     // Draw a single point
@@ -260,12 +427,28 @@ void Drawer::drawPoints(ShaderHelper *shader, ScatterPointBufferHelper *object,
         glVertexAttribPointer(shader->uvAtt(), 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
     }
 
+    // 3rd attribute buffer : selection colors, if drawing to the selection buffer
+    const GLint colorAtt = shader->selectionColorAtt();
+    if (colorAtt >= 0) {
+        glEnableVertexAttribArray(colorAtt);
+        glBindBuffer(GL_ARRAY_BUFFER, object->selectionColorBuf());
+        glVertexAttribPointer(colorAtt, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)0);
+    }
+
     // Draw the points
-    glDrawArrays(GL_POINTS, 0, object->indexCount());
+    if (object->subsetIndexCount()) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
+        glDrawElements(GL_POINTS, object->subsetIndexCount(), GL_UNSIGNED_INT, (void *)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        glDrawArrays(GL_POINTS, 0, object->indexCount());
+    }
 
     // Free buffers
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    if (colorAtt >= 0)
+        glDisableVertexAttribArray(colorAtt);
     glDisableVertexAttribArray(shader->posAtt());
 
     if (textureId) {
@@ -408,6 +591,11 @@ void Drawer::drawLabel(const AbstractRenderItem &item, const LabelItem &labelIte
                                 m_scaledFontSize,
                                 0.0f));
 
+    if (isSelecting && m_labelPicking) {
+        pickLabel(modelMatrix);
+        return;
+    }
+
     MVPMatrix = projectionmatrix * viewmatrix * modelMatrix;
 
     shader->setUniformValue(shader->MVP(), MVPMatrix);
@@ -421,6 +609,53 @@ void Drawer::drawLabel(const AbstractRenderItem &item, const LabelItem &labelIte
     }
 }
 
+void Drawer::beginLabelPicking(const QVector3D &origin, const QVector3D &direction,
+                               float distance)
+{
+    m_labelPicking = true;
+    m_labelPicked = false;
+    m_pickOrigin = origin;
+    m_pickDirection = direction;
+    m_pickDistance = distance;
+}
+
+// Returns true with the distance and the selection color of the nearest label hit, if any
+bool Drawer::endLabelPicking(float &distance, QVector4D &color)
+{
+    m_labelPicking = false;
+    if (m_labelPicked) {
+        distance = m_pickDistance;
+        color = m_pickedLabelColor;
+    }
+    return m_labelPicked;
+}
+
+// Tests the label quad, which spans from -1 to 1 along the x and y axes of the model, against
+// the pick ray
+void Drawer::pickLabel(const QMatrix4x4 &modelMatrix)
+{
+    const QVector3D center = modelMatrix.map(QVector3D());
+    const QVector3D right = modelMatrix.map(QVector3D(1.0f, 0.0f, 0.0f)) - center;
+    const QVector3D up = modelMatrix.map(QVector3D(0.0f, 1.0f, 0.0f)) - center;
+    const QVector3D normal = QVector3D::crossProduct(right, up);
+    const float facing = QVector3D::dotProduct(m_pickDirection, normal);
+    if (facing == 0.0f)
+        return;
+
+    const float distance = QVector3D::dotProduct(center - m_pickOrigin, normal) / facing;
+    if (distance < 0.0f || distance >= m_pickDistance)
+        return;
+    const QVector3D offset = m_pickOrigin + m_pickDirection * distance - center;
+    if (qAbs(QVector3D::dotProduct(offset, right)) > right.lengthSquared()
+            || qAbs(QVector3D::dotProduct(offset, up)) > up.lengthSquared()) {
+        return;
+    }
+
+    m_pickDistance = distance;
+    m_pickedLabelColor = m_labelPickColor;
+    m_labelPicked = true;
+}
+
 void Drawer::generateSelectionLabelTexture(Abstract3DRenderer *renderer)
 {
     LabelItem &labelItem = renderer->selectionLabelItem();
@@ -56,6 +56,8 @@ class TextureHelper;
 class Q3DCamera;
 class Abstract3DRenderer;
 class ScatterPointBufferHelper;
+class ScatterObjectBufferHelper;
+class BarInstanceBufferHelper;
 
 class Drawer : public QObject, public QOpenGLFunctions
 {
@@ -87,8 +89,16 @@ public:
 
     void drawObject(ShaderHelper *shader, AbstractObjectHelper *object, GLuint textureId = 0,
                     GLuint depthTextureId = 0, GLuint textureId3D = 0);
+    void drawObjectInstanced(ShaderHelper *shader, AbstractObjectHelper *mesh,
+                             ScatterObjectBufferHelper *instances, GLuint textureId = 0,
+                             GLuint depthTextureId = 0);
+    void drawObjectInstanced(ShaderHelper *shader, AbstractObjectHelper *mesh,
+                             BarInstanceBufferHelper *instances, GLuint textureId = 0,
+                             GLuint depthTextureId = 0);
     void drawSelectionObject(ShaderHelper *shader, AbstractObjectHelper *object);
     void drawSurfaceGrid(ShaderHelper *shader, SurfaceObject *object);
+    void bindHeightMap(ShaderHelper *shader, SurfaceObject *object);
+    void releaseHeightMap();
     void drawPoint(ShaderHelper *shader);
     void drawPoints(ShaderHelper *shader, ScatterPointBufferHelper *object, GLuint textureId);
     void drawLine(ShaderHelper *shader);
@@ -101,6 +111,13 @@ public:
                    Qt::Alignment alignment = Qt::AlignCenter, bool isSlicing = false,
                    bool isSelecting = false);
 
+    // While label picking is active, labels drawn for selection are tested against the pick
+    // ray instead of drawn. The selection color set for the nearest label hit closer than
+    // distance is kept.
+    void beginLabelPicking(const QVector3D &origin, const QVector3D &direction, float distance);
+    bool endLabelPicking(float &distance, QVector4D &color);
+    inline void setLabelPickColor(const QVector4D &color) { m_labelPickColor = color; }
+
     void generateSelectionLabelTexture(Abstract3DRenderer *item);
     void generateLabelItem(LabelItem &item, const QString &text, int widestLabel = 0);
 
@@ -108,11 +125,23 @@ Q_SIGNALS:
     void drawerChanged();
 
 private:
+    void drawInstances(ShaderHelper *shader, AbstractObjectHelper *mesh, GLuint positionBuffer,
+                       GLuint rotationBuffer, GLuint uvBuffer, GLsizei instanceCount,
+                       GLuint textureId, GLuint depthTextureId);
+    void pickLabel(const QMatrix4x4 &modelMatrix);
+
     Q3DTheme *m_theme;
     TextureHelper *m_textureHelper;
     GLuint m_pointbuffer;
     GLuint m_linebuffer;
     GLfloat m_scaledFontSize;
+    bool m_labelPicking;
+    bool m_labelPicked;
+    QVector3D m_pickOrigin;
+    QVector3D m_pickDirection;
+    float m_pickDistance;
+    QVector4D m_labelPickColor;
+    QVector4D m_pickedLabelColor;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
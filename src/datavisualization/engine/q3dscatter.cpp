@@ -236,6 +236,39 @@ QScatter3DSeries *Q3DScatter::selectedSeries() const
     return dptrc()->m_shared->selectedSeries();
 }
 
+/*!
+ * \property Q3DScatter::pointBudget
+ * \since QtDataVisualization 1.4
+ *
+ * \brief The maximum number of items drawn per frame.
+ *
+ * When the visible series have more items than the budget allows, a representative subset
+ * of the items is drawn instead. The subset is selected from a spatial subdivision of
+ * the items, which is refined where it appears largest on the screen, so more detail
+ * is shown as the camera moves closer. Items outside the view don't count against the budget.
+ * The budget is shared between the series in proportion to their item counts.
+ *
+ * With the static optimization hint, the budget applies only to series using the point mesh.
+ *
+ * Zero means that all items are drawn. Negative values are treated as zero.
+ * Defaults to zero.
+ *
+ * \sa QAbstract3DGraph::optimizationHints
+ */
+void Q3DScatter::setPointBudget(int budget)
+{
+    budget = qMax(0, budget);
+    if (budget != pointBudget()) {
+        dptr()->m_shared->setPointBudget(budget);
+        emit pointBudgetChanged(budget);
+    }
+}
+
+int Q3DScatter::pointBudget() const
+{
+    return dptrc()->m_shared->pointBudget();
+}
+
 /*!
  * Adds \a axis to the graph. The axes added via addAxis are not yet taken to use,
  * addAxis is simply used to give the ownership of the \a axis to the graph.
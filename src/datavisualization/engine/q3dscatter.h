@@ -45,6 +45,7 @@ class QT_DATAVISUALIZATION_EXPORT Q3DScatter : public QAbstract3DGraph
     Q_PROPERTY(QValue3DAxis *axisY READ axisY WRITE setAxisY NOTIFY axisYChanged)
     Q_PROPERTY(QValue3DAxis *axisZ READ axisZ WRITE setAxisZ NOTIFY axisZChanged)
     Q_PROPERTY(QScatter3DSeries *selectedSeries READ selectedSeries NOTIFY selectedSeriesChanged)
+    Q_PROPERTY(int pointBudget READ pointBudget WRITE setPointBudget NOTIFY pointBudgetChanged)
 
 public:
     explicit Q3DScatter(const QSurfaceFormat *format = nullptr, QWindow *parent = nullptr);
@@ -66,11 +67,15 @@ public:
 
     QScatter3DSeries *selectedSeries() const;
 
+    void setPointBudget(int budget);
+    int pointBudget() const;
+
 Q_SIGNALS:
     void axisXChanged(QValue3DAxis *axis);
     void axisYChanged(QValue3DAxis *axis);
     void axisZChanged(QValue3DAxis *axis);
     void selectedSeriesChanged(QScatter3DSeries *series);
+    void pointBudgetChanged(int budget);
 
 private:
     Q3DScatterPrivate *dptr();
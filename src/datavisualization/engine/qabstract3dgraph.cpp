@@ -164,6 +164,26 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
            Provides the full feature set at a reasonable performance.
     \value OptimizationStatic
            Optimizes the rendering of static data sets at the expense of some features.
+    \value OptimizationCpuPicking
+           Resolves item selection by ray casting against a spatial index of the items on
+           the CPU instead of rendering them into a selection buffer. Surface graphs then
+           don't create the selection textures that otherwise take four bytes for each
+           sampled data point. Custom items and axis labels are ray cast against their bounds,
+           and the nearest of the hits is selected.
+           Only scatter and surface graphs support this hint.
+    \value OptimizationGpuSurface
+           Generates the vertices and normals of smooth surfaces in the vertex shader from a
+           texture holding the surface heights, so that data changes only update the texture.
+           Applies to surface series whose data proxy is in height array mode, see
+           QSurfaceDataProxy::resetHeightArray(), and requires OpenGL 3.0 or OpenGL ES 3.0.
+           Other surfaces, polar graphs, and axes with custom formatters use the default path.
+           Only surface graphs support this hint.
+    \value OptimizationLevelOfDetail
+           Draws large smooth surfaces as a quadtree of tiles, each drawn with fewer
+           triangles the smaller it appears on screen. Tiles are refined as the camera zooms
+           in, so that their height error stays within a couple of pixels. Surfaces with
+           fewer than 512 x 512 vertices and flat shaded surfaces are drawn at full resolution.
+           Only surface graphs support this hint.
 */
 
 /*!
@@ -708,16 +728,33 @@ qreal QAbstract3DGraph::aspectRatio() const
  * performance. The static mode optimizes graph rendering and is ideal for
  * large non-changing data sets. It is slower with dynamic data changes and item rotations.
  * Selection is not optimized, so using the static mode with massive data sets is not advisable.
- * Static optimization works only on scatter graphs.
+ * Static optimization works on scatter graphs, and on bar graphs when the graphics driver
+ * supports instanced rendering.
  * Defaults to \l{OptimizationDefault}.
  *
- * \note On some environments, large graphs using static optimization may not render, because
- * all of the items are rendered using a single draw call, and different graphics drivers
- * support different maximum vertice counts per call.
+ * When the graphics driver supports instanced rendering (OpenGL 3.3 or OpenGL ES 3.0),
+ * static mesh series are drawn by uploading the item mesh once and only per-item positions,
+ * rotations, and colors for each item. Otherwise the item meshes are combined into a single
+ * vertex buffer.
+ *
+ * Static bar series are drawn with a single instanced call per series, and only the bars on
+ * changed rows are uploaded again. Highlighted bars of the selection are still drawn one by one.
+ *
+ * \note On some environments without instanced rendering support, large graphs using static
+ * optimization may not render, because all of the items are rendered using a single draw call,
+ * and different graphics drivers support different maximum vertice counts per call.
  * This is mostly an issue on 32bit and OpenGL ES2 platforms.
  * To work around this issue, choose an item mesh with a low vertex count or use
  * the point mesh.
  *
+ * The CPU picking hint can be combined with either mode. It makes scatter graphs resolve
+ * the item under the cursor by casting a ray against a spatial index of the items, so
+ * selection doesn't require rendering the whole data set and reading the result back from
+ * the graphics driver. The index is built on the first selection after a data change.
+ * Items are approximated by spheres of the item size, and items of the series take
+ * precedence over custom items and axis labels in front of them. Custom items and labels are
+ * still selected the regular way when no item is hit.
+ *
  * \sa QAbstract3DSeries::mesh
  */
 void QAbstract3DGraph::setOptimizationHints(OptimizationHints hints)
@@ -110,8 +110,11 @@ public:
     };
 
     enum OptimizationHint {
-        OptimizationDefault = 0,
-        OptimizationStatic  = 1
+        OptimizationDefault       = 0,
+        OptimizationStatic        = 1,
+        OptimizationCpuPicking    = 2,
+        OptimizationGpuSurface    = 4,
+        OptimizationLevelOfDetail = 8
     };
     Q_DECLARE_FLAGS(OptimizationHints, OptimizationHint)
 
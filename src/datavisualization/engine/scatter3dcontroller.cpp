@@ -43,6 +43,7 @@ Scatter3DController::Scatter3DController(QRect boundRect, Q3DScene *scene)
       m_renderer(0),
       m_selectedItem(invalidSelectionIndex()),
       m_selectedItemSeries(0),
+      m_pointBudget(0),
       m_recordInsertsAndRemoves(false)
 {
     // Setting a null axis creates a new default axis according to orientation and graph type.
@@ -90,10 +91,20 @@ void Scatter3DController::synchDataToRenderer()
         m_changedItems.clear();
     }
 
+    if (m_appendedSeriesList.size()) {
+        m_renderer->updateAppendedItems(m_appendedSeriesList);
+        m_appendedSeriesList.clear();
+    }
+
     if (m_changeTracker.selectedItemChanged) {
         m_renderer->updateSelectedItem(m_selectedItem, m_selectedItemSeries);
         m_changeTracker.selectedItemChanged = false;
     }
+
+    if (m_changeTracker.pointBudgetChanged) {
+        m_renderer->updatePointBudget(m_pointBudget);
+        m_changeTracker.pointBudgetChanged = false;
+    }
 }
 
 void Scatter3DController::addSeries(QAbstract3DSeries *series)
@@ -113,6 +124,8 @@ void Scatter3DController::removeSeries(QAbstract3DSeries *series)
 
     Abstract3DController::removeSeries(series);
 
+    m_appendedSeriesList.removeAll(static_cast<QScatter3DSeries *>(series));
+
     if (m_selectedItemSeries == series)
         setSelectedItem(invalidSelectionIndex(), 0);
 
@@ -159,10 +172,13 @@ void Scatter3DController::handleItemsAdded(int startIndex, int count)
     QScatter3DSeries *series = static_cast<QScatterDataProxy *>(sender())->series();
     if (series->isVisible()) {
         adjustAxisRanges();
-        m_isDataDirty = true;
-    }
-    if (!m_changedSeriesList.contains(series))
+        // Items are always added to the end, so the renderer only needs to process the new
+        // tail of the array, unless the whole series is reloaded anyway.
+        if (!m_changedSeriesList.contains(series) && !m_appendedSeriesList.contains(series))
+            m_appendedSeriesList.append(series);
+    } else if (!m_changedSeriesList.contains(series)) {
         m_changedSeriesList.append(series);
+    }
     emitNeedRender();
 }
 
@@ -334,6 +350,18 @@ void Scatter3DController::setSelectionMode(QAbstract3DGraph::SelectionFlags mode
     Abstract3DController::setSelectionMode(mode);
 }
 
+void Scatter3DController::setPointBudget(int budget)
+{
+    m_pointBudget = budget;
+    m_changeTracker.pointBudgetChanged = true;
+    emitNeedRender();
+}
+
+int Scatter3DController::pointBudget() const
+{
+    return m_pointBudget;
+}
+
 void Scatter3DController::setSelectedItem(int index, QScatter3DSeries *series)
 {
     const QScatterDataProxy *proxy = 0;
@@ -52,10 +52,12 @@ class QScatter3DSeries;
 struct Scatter3DChangeBitField {
     bool selectedItemChanged : 1;
     bool itemChanged         : 1;
+    bool pointBudgetChanged  : 1;
 
     Scatter3DChangeBitField() :
         selectedItemChanged(true),
-        itemChanged(false)
+        itemChanged(false),
+        pointBudgetChanged(true)
     {
     }
 };
@@ -72,12 +74,14 @@ public:
 private:
     Scatter3DChangeBitField m_changeTracker;
     QVector<ChangeItem> m_changedItems;
+    QVector<QScatter3DSeries *> m_appendedSeriesList; // Series with only new items at the end
 
     // Rendering
     Scatter3DRenderer *m_renderer;
     int m_selectedItem;
     QScatter3DSeries *m_selectedItemSeries; // Points to the series for which the bar is selected
                                             // in single series selection cases.
+    int m_pointBudget;
 
     struct InsertRemoveRecord {
         bool m_isInsert;
@@ -118,6 +122,9 @@ public:
     static inline int invalidSelectionIndex() { return -1; }
     virtual void clearSelection();
 
+    void setPointBudget(int budget);
+    int pointBudget() const;
+
     void synchDataToRenderer();
 
     virtual void addSeries(QAbstract3DSeries *series);
@@ -35,8 +35,17 @@
 #include "scatterseriesrendercache_p.h"
 #include "scatterobjectbufferhelper_p.h"
 #include "scatterpointbufferhelper_p.h"
+#include "qscatterdataproxy_p.h"
 
 #include <QtCore/qmath.h>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include <float.h>
+
+#include <algorithm>
 
 // You can verify that depth buffer drawing works correctly by uncommenting this.
 // You should see the scene from  where the light is
@@ -44,13 +53,20 @@
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
+// Series smaller than this are transformed on the render thread only. Keep it a multiple of
+// eight so that transform tasks never share visibility bytes.
+const int transformTaskMinSize = 65536;
+
 const GLfloat defaultMinSize = 0.01f;
 const GLfloat defaultMaxSize = 0.1f;
 const GLfloat itemScaler = 3.0f;
+// Series drawn item by item that have fewer items are not culled against the view
+const int viewCullingMinItemCount = 1024;
 
 Scatter3DRenderer::Scatter3DRenderer(Scatter3DController *controller)
     : Abstract3DRenderer(controller),
-      m_selectedItem(0),
+      m_labeledItemIndex(Scatter3DController::invalidSelectionIndex()),
+      m_labeledSeriesCache(0),
       m_updateLabels(false),
       m_dotShader(0),
       m_dotGradientShader(0),
@@ -58,7 +74,11 @@ Scatter3DRenderer::Scatter3DRenderer(Scatter3DController *controller)
       m_staticSelectedItemShader(0),
       m_pointShader(0),
       m_depthShader(0),
+      m_instancedDepthShader(0),
       m_selectionShader(0),
+      m_staticSelectionShader(0),
+      m_staticPointSelectionShader(0),
+      m_instancedSelectionShader(0),
       m_backgroundShader(0),
       m_staticGradientPointShader(0),
       m_bgrTexture(0),
@@ -80,7 +100,8 @@ Scatter3DRenderer::Scatter3DRenderer(Scatter3DController *controller)
       m_havePointSeries(false),
       m_haveMeshSeries(false),
       m_haveUniformColorMeshSeries(false),
-      m_haveGradientMeshSeries(false)
+      m_haveGradientMeshSeries(false),
+      m_pointBudget(0)
 {
     initializeOpenGL();
 }
@@ -93,7 +114,11 @@ Scatter3DRenderer::~Scatter3DRenderer()
     delete m_staticSelectedItemShader;
     delete m_dotGradientShader;
     delete m_depthShader;
+    delete m_instancedDepthShader;
     delete m_selectionShader;
+    delete m_staticSelectionShader;
+    delete m_staticPointSelectionShader;
+    delete m_instancedSelectionShader;
     delete m_backgroundShader;
     delete m_staticGradientPointShader;
 }
@@ -192,16 +217,15 @@ void Scatter3DRenderer::updateData()
         if (cache->isVisible()) {
             const QScatter3DSeries *currentSeries = cache->series();
             ScatterRenderItemArray &renderArray = cache->renderArray();
-            QScatterDataProxy *dataProxy = currentSeries->dataProxy();
-            const QScatterDataArray &dataArray = *dataProxy->array();
-            int dataSize = dataArray.size();
+            const QScatterDataProxyPrivate *dataProxy = currentSeries->dataProxy()->dptrc();
+            int dataSize = dataProxy->itemCount();
             totalDataSize += dataSize;
             if (cache->dataDirty()) {
                 if (dataSize != renderArray.size())
                     renderArray.resize(dataSize);
 
-                for (int i = 0; i < dataSize; i++)
-                    updateRenderItem(dataArray.at(i), renderArray[i]);
+                updateRenderItems(dataProxy, renderArray, 0);
+                cache->setOctreeDirty(true);
 
                 if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic))
                     cache->setStaticBufferDirty(true);
@@ -235,7 +259,7 @@ void Scatter3DRenderer::updateData()
                 } else {
                     ScatterObjectBufferHelper *object = cache->bufferObject();
                     if (!object) {
-                        object = new ScatterObjectBufferHelper();
+                        object = new ScatterObjectBufferHelper(m_isInstancingSupported);
                         cache->setBufferObject(object);
                     }
                     if (renderArraySize != cache->oldArraySize()
@@ -255,6 +279,8 @@ void Scatter3DRenderer::updateData()
         }
     }
 
+    updateOctrees();
+
     updateSelectedItem(m_selectedItemIndex,
                        m_selectedSeriesCache ? m_selectedSeriesCache->series() : 0);
 }
@@ -357,7 +383,7 @@ void Scatter3DRenderer::updateItems(const QVector<Scatter3DController::ChangeIte
 {
     ScatterSeriesRenderCache *cache = 0;
     const QScatter3DSeries *prevSeries = 0;
-    const QScatterDataArray *dataArray = 0;
+    const QScatterDataProxyPrivate *dataProxy = 0;
     const bool optimizationStatic = m_cachedOptimizationHint.testFlag(
                 QAbstract3DGraph::OptimizationStatic);
 
@@ -366,7 +392,7 @@ void Scatter3DRenderer::updateItems(const QVector<Scatter3DController::ChangeIte
         if (currentSeries != prevSeries) {
             cache = static_cast<ScatterSeriesRenderCache *>(m_renderCacheList.value(currentSeries));
             prevSeries = currentSeries;
-            dataArray = item.series->dataProxy()->array();
+            dataProxy = item.series->dataProxy()->dptrc();
             // Invisible series render caches are not updated, but instead just marked dirty, so that
             // they can be completely recalculated when they are turned visible.
             if (!cache->isVisible() && !cache->dataDirty())
@@ -377,12 +403,14 @@ void Scatter3DRenderer::updateItems(const QVector<Scatter3DController::ChangeIte
             if (index >= cache->renderArray().size())
                 continue; // Items removed from array for same render
             bool oldVisibility;
-            ScatterRenderItem &item = cache->renderArray()[index];
+            ScatterRenderItemArray &renderArray = cache->renderArray();
             if (optimizationStatic)
-                oldVisibility = item.isVisible();
-            updateRenderItem(dataArray->at(index), item);
+                oldVisibility = renderArray.isVisible(index);
+            updateRenderItem(dataProxy->positionAt(index), dataProxy->rotationAt(index),
+                             renderArray, index);
+            cache->setOctreeDirty(true);
             if (optimizationStatic) {
-                if (!cache->visibilityChanged() && oldVisibility != item.isVisible())
+                if (!cache->visibilityChanged() && oldVisibility != renderArray.isVisible(index))
                     cache->setVisibilityChanged(true);
                 cache->updateIndices().append(index);
             }
@@ -392,6 +420,9 @@ void Scatter3DRenderer::updateItems(const QVector<Scatter3DController::ChangeIte
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
             if (cache->isVisible() && cache->updateIndices().size()) {
+                // Sorted indices let the buffer helpers merge neighboring items into one upload
+                QVector<int> &updateIndices = cache->updateIndices();
+                std::sort(updateIndices.begin(), updateIndices.end());
                 if (cache->mesh() == QAbstract3DSeries::MeshPoint) {
                     cache->bufferPoints()->update(cache);
                     if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
@@ -413,6 +444,8 @@ void Scatter3DRenderer::updateItems(const QVector<Scatter3DController::ChangeIte
             cache->setVisibilityChanged(false);
         }
     }
+
+    updateOctrees();
 }
 
 void Scatter3DRenderer::updateScene(Q3DScene *scene)
@@ -455,6 +488,13 @@ void Scatter3DRenderer::updateOptimizationHint(QAbstract3DGraph::OptimizationHin
     }
 }
 
+void Scatter3DRenderer::updatePointBudget(int budget)
+{
+    m_pointBudget = budget;
+    foreach (SeriesRenderCache *cache, m_renderCacheList)
+        static_cast<ScatterSeriesRenderCache *>(cache)->setItemSubsetDirty(true);
+}
+
 void Scatter3DRenderer::updateMargin(float margin)
 {
     Abstract3DRenderer::updateMargin(margin);
@@ -479,6 +519,21 @@ void Scatter3DRenderer::render(GLuint defaultFboHandle)
     if (m_axisCacheZ.positionsDirty())
         m_axisCacheZ.updateAllPositions();
 
+    // Large static buffer loads are uploaded over several frames, drawing the old buffers
+    // until they swap
+    bool uploading = false;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+        ScatterPointBufferHelper *points = cache->bufferPoints();
+        if (points && points->hasPendingUpload())
+            uploading |= !points->uploadPending();
+        ScatterObjectBufferHelper *object = cache->bufferObject();
+        if (object && object->hasPendingUpload())
+            uploading |= !object->uploadPending();
+    }
+    if (uploading)
+        emit needRender();
+
     // Draw dots scene
     drawScene(defaultFboHandle);
 }
@@ -519,6 +574,8 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
     QMatrix4x4 viewMatrix = activeCamera->d_ptr->viewMatrix();
     QMatrix4x4 projectionViewMatrix = projectionMatrix * viewMatrix;
 
+    updateItemSubsets(projectionViewMatrix);
+
     // Calculate label flipping
     if (viewMatrix.row(0).x() > 0)
         m_zFlipped = false;
@@ -589,6 +646,8 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             depthProjectionMatrix.perspective(15.0f, viewPortRatio, 3.0f, 100.0f);
             depthProjectionViewMatrix = depthProjectionMatrix * depthViewMatrix;
 
+            updateShadowItemSubsets(depthProjectionViewMatrix);
+
             // Draw dots to depth buffer
             foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
                 if (baseCache->isVisible()) {
@@ -608,28 +667,38 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     }
                     QVector3D modelScaler(itemSize, itemSize, itemSize);
 
-                    if (!optimizationDefault
-                            && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
-                                || (!drawingPoints && cache->bufferObject()->indexCount() == 0))) {
+                    // Items culled against the view are culled against the light view instead
+                    const QVector<int> *subset = 0;
+                    if (cache->shadowItemSubsetActive())
+                        subset = &cache->shadowItemSubset();
+                    else if (cache->itemSubsetActive() && !cache->itemSubsetCulled())
+                        subset = &cache->itemSubset();
+
+                    if ((!optimizationDefault
+                         && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
+                             || (!drawingPoints && cache->bufferObject()->indexCount() == 0)))
+                            || (subset && subset->isEmpty())) {
                         continue;
                     }
 
+                    const int *subsetIndices = subset ? subset->constData() : 0;
                     int loopCount = 1;
                     if (optimizationDefault)
-                        loopCount = renderArraySize;
-                    for (int dot = 0; dot < loopCount; dot++) {
-                        const ScatterRenderItem &item = renderArray.at(dot);
-                        if (!item.isVisible() && optimizationDefault)
+                        loopCount = subsetIndices ? subset->size() : renderArraySize;
+                    for (int n = 0; n < loopCount; n++) {
+                        const int dot = subsetIndices ? subsetIndices[n] : n;
+                        if (!renderArray.isVisible(dot) && optimizationDefault)
                             continue;
 
                         QMatrix4x4 modelMatrix;
                         QMatrix4x4 MVPMatrix;
 
                         if (optimizationDefault) {
-                            modelMatrix.translate(item.translation());
+                            modelMatrix.translate(renderArray.translation(dot));
                             if (!drawingPoints) {
-                                if (!seriesRotation.isIdentity() || !item.rotation().isIdentity())
-                                    modelMatrix.rotate(seriesRotation * item.rotation());
+                                const QQuaternion itemRotation = renderArray.rotation(dot);
+                                if (!seriesRotation.isIdentity() || !itemRotation.isIdentity())
+                                    modelMatrix.rotate(seriesRotation * itemRotation);
                                 modelMatrix.scale(modelScaler);
                             }
                         }
@@ -663,6 +732,13 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                                 glBindBuffer(GL_ARRAY_BUFFER, 0);
 
                                 glDisableVertexAttribArray(m_depthShader->posAtt());
+                            } else if (cache->bufferObject()->isInstanced()) {
+                                m_instancedDepthShader->bind();
+                                m_instancedDepthShader->setUniformValue(
+                                            m_instancedDepthShader->MVP(), MVPMatrix);
+                                m_drawer->drawObjectInstanced(m_instancedDepthShader, dotObj,
+                                                              cache->bufferObject());
+                                m_depthShader->bind();
                             } else {
                                 ScatterObjectBufferHelper *object = cache->bufferObject();
                                 // 1st attribute buffer : vertices
@@ -721,8 +797,19 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
         emit needRender();
     }
 
+    // Items, custom items and labels are picked on CPU when so hinted, without the selection
+    // buffer
+    const bool cpuPicking =
+            m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationCpuPicking);
+
     // Skip selection mode drawing if we have no selection mode
-    if (m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
+    if (cpuPicking && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
+            && SelectOnScene == m_selectionState
+            && (m_visibleSeriesCount > 0 || !m_customRenderCache.isEmpty())) {
+        pickItem(projectionViewMatrix, viewMatrix, projectionMatrix, activeCamera);
+        m_clickResolved = true;
+        emit needRender();
+    } else if (!cpuPicking && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
             && SelectOnScene == m_selectionState
             && (m_visibleSeriesCount > 0 || !m_customRenderCache.isEmpty())
             && m_selectionTexture) {
@@ -757,6 +844,13 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
 #endif
                 QVector3D modelScaler(itemSize, itemSize, itemSize);
 
+                if (!optimizationDefault) {
+                    cache->setSelectionIndexOffset(totalIndex);
+                    drawStaticSelection(cache, projectionViewMatrix);
+                    totalIndex += renderArraySize;
+                    continue;
+                }
+
                 // Rebind selection shader if it has changed
                 if (!totalIndex || drawingPoints != previousDrawingPoints) {
                     previousDrawingPoints = drawingPoints;
@@ -768,26 +862,28 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     selectionShader->bind();
                 }
                 cache->setSelectionIndexOffset(totalIndex);
-                for (int dot = 0; dot < renderArraySize; dot++) {
-                    const ScatterRenderItem &item = renderArray.at(dot);
-                    if (!item.isVisible()) {
-                        totalIndex++;
+                const int *subsetIndices =
+                        cache->itemSubsetActive() ? cache->itemSubset().constData() : 0;
+                const int loopCount = subsetIndices ? cache->itemSubset().size() : renderArraySize;
+                for (int n = 0; n < loopCount; n++) {
+                    const int dot = subsetIndices ? subsetIndices[n] : n;
+                    if (!renderArray.isVisible(dot))
                         continue;
-                    }
 
                     QMatrix4x4 modelMatrix;
                     QMatrix4x4 MVPMatrix;
 
-                    modelMatrix.translate(item.translation());
+                    modelMatrix.translate(renderArray.translation(dot));
                     if (!drawingPoints) {
-                        if (!seriesRotation.isIdentity() || !item.rotation().isIdentity())
-                            modelMatrix.rotate(seriesRotation * item.rotation());
+                        const QQuaternion itemRotation = renderArray.rotation(dot);
+                        if (!seriesRotation.isIdentity() || !itemRotation.isIdentity())
+                            modelMatrix.rotate(seriesRotation * itemRotation);
                         modelMatrix.scale(modelScaler);
                     }
 
                     MVPMatrix = projectionViewMatrix * modelMatrix;
 
-                    QVector4D dotColor = indexToSelectionColor(totalIndex++);
+                    QVector4D dotColor = indexToSelectionColor(totalIndex + dot);
                     dotColor /= 255.0f;
 
                     selectionShader->setUniformValue(selectionShader->MVP(), MVPMatrix);
@@ -798,9 +894,13 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     else
                         m_drawer->drawSelectionObject(selectionShader, dotObj);
                 }
+                totalIndex += renderArraySize;
             }
         }
 
+        // Labels are drawn with the plain selection shader, which may not be the last one bound
+        m_selectionShader->bind();
+
         Abstract3DRenderer::drawCustomItems(RenderingSelection, m_selectionShader,
                                             viewMatrix, projectionViewMatrix,
                                             depthProjectionViewMatrix, m_depthTexture,
@@ -830,7 +930,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
     ShaderHelper *dotShader = 0;
     GLuint gradientTexture = 0;
     bool dotSelectionFound = false;
-    ScatterRenderItem *selectedItem(0);
+    int selectedIndex = Scatter3DController::invalidSelectionIndex();
     QVector4D baseColor;
     QVector4D dotColor;
 
@@ -892,9 +992,10 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             int gradientImageHeight = cache->gradientImage().height();
             int maxGradientPositition = gradientImageHeight - 1;
 
-            if (!optimizationDefault
-                    && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
-                        || (!drawingPoints && cache->bufferObject()->indexCount() == 0))) {
+            if ((!optimizationDefault
+                 && ((drawingPoints && cache->bufferPoints()->indexCount() == 0)
+                     || (!drawingPoints && cache->bufferObject()->indexCount() == 0)))
+                    || (cache->itemSubsetActive() && cache->itemSubset().isEmpty())) {
                 continue;
             }
 
@@ -942,24 +1043,27 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                 baseColor = cache->baseColor();
                 dotColor = baseColor;
             }
+            const int *subsetIndices = cache->itemSubsetActive() ? cache->itemSubset().constData() : 0;
             int loopCount = 1;
             if (optimizationDefault)
-                loopCount = renderArraySize;
+                loopCount = subsetIndices ? cache->itemSubset().size() : renderArraySize;
 
-            for (int i = 0; i < loopCount; i++) {
-                ScatterRenderItem &item = renderArray[i];
-                if (!item.isVisible() && optimizationDefault)
+            for (int n = 0; n < loopCount; n++) {
+                const int i = subsetIndices ? subsetIndices[n] : n;
+                if (!renderArray.isVisible(i) && optimizationDefault)
                     continue;
 
+                const QVector3D itemTranslation = renderArray.translation(i);
                 QMatrix4x4 modelMatrix;
                 QMatrix4x4 MVPMatrix;
                 QMatrix4x4 itModelMatrix;
 
                 if (optimizationDefault) {
-                    modelMatrix.translate(item.translation());
+                    modelMatrix.translate(itemTranslation);
                     if (!drawingPoints) {
-                        if (!seriesRotation.isIdentity() || !item.rotation().isIdentity()) {
-                            QQuaternion totalRotation = seriesRotation * item.rotation();
+                        const QQuaternion itemRotation = renderArray.rotation(i);
+                        if (!seriesRotation.isIdentity() || !itemRotation.isIdentity()) {
+                            QQuaternion totalRotation = seriesRotation * itemRotation;
                             modelMatrix.rotate(totalRotation);
                             itModelMatrix.rotate(totalRotation);
                         }
@@ -977,7 +1081,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     if (rangeGradientPoints) {
                         // Drawing points with range gradient
                         // Get color from gradient based on items y position converted to percent
-                        int position = ((item.translation().y() + m_scaleY) * rangeGradientYScaler) * gradientImageHeight;
+                        int position = ((itemTranslation.y() + m_scaleY) * rangeGradientYScaler) * gradientImageHeight;
                         position = qMin(maxGradientPositition, position); // clamp to edge
                         dotColor = Utils::vectorFromColor(
                                     cache->gradientImage().pixel(0, position));
@@ -998,8 +1102,9 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     else
                         gradientTexture = cache->singleHighlightGradientTexture();
                     lightStrength = m_cachedTheme->highlightLightStrength();
-                    // Save the reference to the item to be used in label drawing
-                    selectedItem = &item;
+                    // Save the item position to be used in label drawing
+                    m_selectedItem.setTranslation(itemTranslation);
+                    selectedIndex = i;
                     dotSelectionFound = true;
                     // Save selected item size (adjusted with font size) for selection label
                     // positioning
@@ -1018,7 +1123,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     dotShader->setUniformValue(dotShader->color(), dotColor);
                 } else if (colorStyle == Q3DTheme::ColorStyleRangeGradient) {
                     dotShader->setUniformValue(dotShader->gradientMin(),
-                                               (item.translation().y() + m_scaleY)
+                                               (itemTranslation.y() + m_scaleY)
                                                * rangeGradientYScaler);
                 }
                 if (m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone && !m_isOpenGLES) {
@@ -1033,6 +1138,9 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                         if (optimizationDefault) {
                             m_drawer->drawObject(dotShader, dotObj, gradientTexture,
                                                  m_depthTexture);
+                        } else if (cache->bufferObject()->isInstanced()) {
+                            m_drawer->drawObjectInstanced(dotShader, dotObj, cache->bufferObject(),
+                                                          gradientTexture, m_depthTexture);
                         } else {
                             m_drawer->drawObject(dotShader, cache->bufferObject(), gradientTexture,
                                                  m_depthTexture);
@@ -1049,10 +1157,14 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                         // Set shadowless shader bindings
                         dotShader->setUniformValue(dotShader->lightS(), lightStrength);
                         // Draw the object
-                        if (optimizationDefault)
+                        if (optimizationDefault) {
                             m_drawer->drawObject(dotShader, dotObj, gradientTexture);
-                        else
+                        } else if (cache->bufferObject()->isInstanced()) {
+                            m_drawer->drawObjectInstanced(dotShader, dotObj, cache->bufferObject(),
+                                                          gradientTexture);
+                        } else {
                             m_drawer->drawObject(dotShader, cache->bufferObject(), gradientTexture);
+                        }
                     } else {
                         // Draw the object
                         if (optimizationDefault)
@@ -1067,8 +1179,9 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
             // Draw the selected item on static optimization
             if (!optimizationDefault && selectedSeries
                     && m_selectedItemIndex != Scatter3DController::invalidSelectionIndex()) {
-                ScatterRenderItem &item = renderArray[m_selectedItemIndex];
-                if (item.isVisible()) {
+                if (renderArray.isVisible(m_selectedItemIndex)) {
+                    const QVector3D itemTranslation = renderArray.translation(m_selectedItemIndex);
+                    const QQuaternion itemRotation = renderArray.rotation(m_selectedItemIndex);
                     ShaderHelper *selectionShader;
                     if (drawingPoints) {
                         selectionShader = pointSelectionShader;
@@ -1085,10 +1198,10 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     QMatrix4x4 modelMatrix;
                     QMatrix4x4 itModelMatrix;
 
-                    modelMatrix.translate(item.translation());
+                    modelMatrix.translate(itemTranslation);
                     if (!drawingPoints) {
-                        if (!seriesRotation.isIdentity() || !item.rotation().isIdentity()) {
-                            QQuaternion totalRotation = seriesRotation * item.rotation();
+                        if (!seriesRotation.isIdentity() || !itemRotation.isIdentity()) {
+                            QQuaternion totalRotation = seriesRotation * itemRotation;
                             modelMatrix.rotate(totalRotation);
                             itModelMatrix.rotate(totalRotation);
                         }
@@ -1117,8 +1230,9 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                     else
                         gradientTexture = cache->singleHighlightGradientTexture();
                     GLfloat lightStrength = m_cachedTheme->highlightLightStrength();
-                    // Save the reference to the item to be used in label drawing
-                    selectedItem = &item;
+                    // Save the item position to be used in label drawing
+                    m_selectedItem.setTranslation(itemTranslation);
+                    selectedIndex = m_selectedItemIndex;
                     dotSelectionFound = true;
                     // Save selected item size (adjusted with font size) for selection label
                     // positioning
@@ -1140,7 +1254,7 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                                 selectionShader->setUniformValue(selectionShader->gradientHeight(),
                                                                  0.0f);
                                 selectionShader->setUniformValue(selectionShader->gradientMin(),
-                                                                 (item.translation().y() + m_scaleY)
+                                                                 (itemTranslation.y() + m_scaleY)
                                                                  * rangeGradientYScaler);
                             }
                         }
@@ -1614,13 +1728,14 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
 
     // Handle selection clearing and selection label drawing
     if (!dotSelectionFound) {
-        // We have no ownership, don't delete. Just NULL the pointer.
-        m_selectedItem = NULL;
+        m_labeledItemIndex = Scatter3DController::invalidSelectionIndex();
+        m_labeledSeriesCache = 0;
     } else {
         glDisable(GL_DEPTH_TEST);
         // Draw the selection label
         LabelItem &labelItem = selectionLabelItem();
-        if (m_selectedItem != selectedItem || m_updateLabels
+        if (m_labeledItemIndex != selectedIndex || m_labeledSeriesCache != m_selectedSeriesCache
+                || m_updateLabels
                 || !labelItem.textureId() || m_selectionLabelDirty) {
             QString labelText = selectionLabel();
             if (labelText.isNull() || m_selectionLabelDirty) {
@@ -1629,10 +1744,11 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
                 m_selectionLabelDirty = false;
             }
             m_drawer->generateLabelItem(labelItem, labelText);
-            m_selectedItem = selectedItem;
+            m_labeledItemIndex = selectedIndex;
+            m_labeledSeriesCache = m_selectedSeriesCache;
         }
 
-        m_drawer->drawLabel(*selectedItem, labelItem, viewMatrix, projectionMatrix,
+        m_drawer->drawLabel(m_selectedItem, labelItem, viewMatrix, projectionMatrix,
                             zeroVector, identityQuaternion, selectedItemSize, m_cachedSelectionMode,
                             m_labelShader, m_labelObj, activeCamera, true, false,
                             Drawer::LabelOver);
@@ -1650,6 +1766,60 @@ void Scatter3DRenderer::drawScene(const GLuint defaultFboHandle)
     m_selectionDirty = false;
 }
 
+// Draws a static series to the selection buffer with a single call, the selection color of
+// each item coming from the selection color buffer of the point or object buffers
+void Scatter3DRenderer::drawStaticSelection(ScatterSeriesRenderCache *cache,
+                                            const QMatrix4x4 &projectionViewMatrix)
+{
+    const int indexOffset = cache->selectionIndexOffset();
+    if (cache->mesh() == QAbstract3DSeries::MeshPoint) {
+        ScatterPointBufferHelper *points = cache->bufferPoints();
+        if (points->indexCount() == 0
+                || (cache->itemSubsetActive() && cache->itemSubset().isEmpty())) {
+            return;
+        }
+
+        points->updateSelectionColors(indexOffset);
+        ShaderHelper *shader = m_isOpenGLES ? m_staticPointSelectionShader
+                                            : m_staticSelectionShader;
+        shader->bind();
+        shader->setUniformValue(shader->MVP(), projectionViewMatrix);
+        m_drawer->drawPoints(shader, points, 0);
+
+        // The selected point is removed from the point buffer while it is highlighted
+        if (cache == m_selectedSeriesCache
+                && m_selectedItemIndex != Scatter3DController::invalidSelectionIndex()
+                && cache->renderArray().isVisible(m_selectedItemIndex)) {
+            ShaderHelper *pointShader = m_isOpenGLES ? m_pointShader : m_selectionShader;
+            QMatrix4x4 MVPMatrix = projectionViewMatrix;
+            MVPMatrix.translate(cache->renderArray().translation(m_selectedItemIndex));
+            QVector4D dotColor = indexToSelectionColor(indexOffset + m_selectedItemIndex);
+            dotColor /= 255.0f;
+            pointShader->bind();
+            pointShader->setUniformValue(pointShader->MVP(), MVPMatrix);
+            pointShader->setUniformValue(pointShader->color(), dotColor);
+            m_drawer->drawPoint(pointShader);
+        }
+    } else {
+        ScatterObjectBufferHelper *objects = cache->bufferObject();
+        if (objects->indexCount() == 0)
+            return;
+
+        objects->updateSelectionColors(cache, indexOffset);
+        if (objects->isInstanced()) {
+            m_instancedSelectionShader->bind();
+            m_instancedSelectionShader->setUniformValue(m_instancedSelectionShader->MVP(),
+                                                        projectionViewMatrix);
+            m_drawer->drawObjectInstanced(m_instancedSelectionShader, cache->object(), objects);
+        } else {
+            m_staticSelectionShader->bind();
+            m_staticSelectionShader->setUniformValue(m_staticSelectionShader->MVP(),
+                                                     projectionViewMatrix);
+            m_drawer->drawSelectionObject(m_staticSelectionShader, objects);
+        }
+    }
+}
+
 void Scatter3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCamera,
                                    const QMatrix4x4 &viewMatrix,
                                    const QMatrix4x4 &projectionMatrix) {
@@ -1804,7 +1974,7 @@ void Scatter3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
             if (drawSelection) {
                 QVector4D labelColor = QVector4D(label / 255.0f, 0.0f, 0.0f,
                                                  alphaForRowSelection);
-                shader->setUniformValue(shader->color(), labelColor);
+                setLabelSelectionColor(shader, labelColor);
             }
 
             m_drawer->drawLabel(m_dummyRenderItem, axisLabelItem, viewMatrix, projectionMatrix,
@@ -1993,7 +2163,7 @@ void Scatter3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
             if (drawSelection) {
                 QVector4D labelColor = QVector4D(0.0f, label / 255.0f, 0.0f,
                                                  alphaForColumnSelection);
-                shader->setUniformValue(shader->color(), labelColor);
+                setLabelSelectionColor(shader, labelColor);
             }
 
             m_drawer->drawLabel(m_dummyRenderItem, axisLabelItem, viewMatrix, projectionMatrix,
@@ -2099,7 +2269,7 @@ void Scatter3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
             if (drawSelection) {
                 QVector4D labelColor = QVector4D(0.0f, 0.0f, label / 255.0f,
                                                  alphaForValueSelection);
-                shader->setUniformValue(shader->color(), labelColor);
+                setLabelSelectionColor(shader, labelColor);
             }
 
             if (label == startIndex) {
@@ -2152,12 +2322,15 @@ void Scatter3DRenderer::updateSelectedItem(int index, QScatter3DSeries *series)
     m_selectionLabelDirty = true;
     m_selectedSeriesCache =
             static_cast<ScatterSeriesRenderCache *>(m_renderCacheList.value(series, 0));
+    // The selected item is always drawn, so the drawn items need to be selected again
+    foreach (SeriesRenderCache *cache, m_renderCacheList)
+        static_cast<ScatterSeriesRenderCache *>(cache)->setItemSubsetDirty(true);
     m_selectedItemIndex = Scatter3DController::invalidSelectionIndex();
 
     if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
             && m_oldSelectedSeriesCache
             && m_oldSelectedSeriesCache->mesh() == QAbstract3DSeries::MeshPoint) {
-        m_oldSelectedSeriesCache->bufferPoints()->popPoint();
+        m_oldSelectedSeriesCache->bufferPoints()->popPoint(m_oldSelectedSeriesCache);
         m_oldSelectedSeriesCache = 0;
     }
 
@@ -2168,7 +2341,8 @@ void Scatter3DRenderer::updateSelectedItem(int index, QScatter3DSeries *series)
 
             if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic)
                     && m_selectedSeriesCache->mesh() == QAbstract3DSeries::MeshPoint) {
-                m_selectedSeriesCache->bufferPoints()->pushPoint(m_selectedItemIndex);
+                m_selectedSeriesCache->bufferPoints()->pushPoint(m_selectedSeriesCache,
+                                                                 m_selectedItemIndex);
                 m_oldSelectedSeriesCache = m_selectedSeriesCache;
             }
         }
@@ -2243,10 +2417,9 @@ void Scatter3DRenderer::fixMeshFileName(QString &fileName, QAbstract3DSeries::Me
     }
 }
 
-void Scatter3DRenderer::calculateTranslation(ScatterRenderItem &item)
+QVector3D Scatter3DRenderer::calculateTranslation(const QVector3D &pos) const
 {
     // We need to normalize translations
-    const QVector3D &pos = item.position();
     float xTrans;
     float yTrans = m_axisCacheY.positionAt(pos.y());
     float zTrans;
@@ -2256,7 +2429,7 @@ void Scatter3DRenderer::calculateTranslation(ScatterRenderItem &item)
         xTrans = m_axisCacheX.positionAt(pos.x());
         zTrans = m_axisCacheZ.positionAt(pos.z());
     }
-    item.setTranslation(QVector3D(xTrans, yTrans, zTrans));
+    return QVector3D(xTrans, yTrans, zTrans);
 }
 
 void Scatter3DRenderer::calculateSceneScalingFactors()
@@ -2358,6 +2531,27 @@ void Scatter3DRenderer::initSelectionShader()
     m_selectionShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexPlainColor"),
                                          QStringLiteral(":/shaders/fragmentPlainColor"));
     m_selectionShader->initialize();
+
+    // Static series are drawn to the selection buffer with per-item colors
+    delete m_staticSelectionShader;
+    m_staticSelectionShader = new ShaderHelper(this,
+                                               QStringLiteral(":/shaders/vertexSelectionColor"),
+                                               QStringLiteral(":/shaders/fragmentSelectionColor"));
+    m_staticSelectionShader->initialize();
+    if (m_isOpenGLES) {
+        delete m_staticPointSelectionShader;
+        m_staticPointSelectionShader =
+                new ShaderHelper(this, QStringLiteral(":/shaders/vertexPointSelectionColorES2"),
+                                 QStringLiteral(":/shaders/fragmentSelectionColor"));
+        m_staticPointSelectionShader->initialize();
+    }
+    if (m_isInstancingSupported) {
+        delete m_instancedSelectionShader;
+        m_instancedSelectionShader =
+                new ShaderHelper(this, QStringLiteral(":/shaders/vertexSelectionInstanced"),
+                                 QStringLiteral(":/shaders/fragmentSelectionColor"));
+        m_instancedSelectionShader->initialize();
+    }
 }
 
 void Scatter3DRenderer::initSelectionBuffer()
@@ -2380,6 +2574,15 @@ void Scatter3DRenderer::initDepthShader()
         m_depthShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexDepth"),
                                          QStringLiteral(":/shaders/fragmentDepth"));
         m_depthShader->initialize();
+
+        if (m_isInstancingSupported) {
+            if (m_instancedDepthShader)
+                delete m_instancedDepthShader;
+            m_instancedDepthShader = new ShaderHelper(this,
+                                                      QStringLiteral(":/shaders/vertexDepthInstanced"),
+                                                      QStringLiteral(":/shaders/fragmentDepth"));
+            m_instancedDepthShader->initialize();
+        }
     }
 }
 
@@ -2487,23 +2690,472 @@ void Scatter3DRenderer::selectionColorToSeriesAndIndex(const QVector4D &color,
     series = 0;
 }
 
-void Scatter3DRenderer::updateRenderItem(const QScatterDataItem &dataItem,
-                                         ScatterRenderItem &renderItem)
+// Selects the items drawn for each series. When the visible series have more items than
+// the point budget allows, each series draws a level of detail subset, with the budget split
+// between the series in proportion to their item counts. Otherwise large series drawn item
+// by item skip the items outside the view. Subsets are selected again whenever the view or
+// the items change.
+void Scatter3DRenderer::updateItemSubsets(const QMatrix4x4 &projectionViewMatrix)
+{
+    const bool optimizationStatic =
+            m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationStatic);
+    int totalItemCount = 0;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        if (baseCache->isVisible()) {
+            totalItemCount +=
+                    static_cast<ScatterSeriesRenderCache *>(baseCache)->renderArray().size();
+        }
+    }
+    const bool budgetExceeded = m_pointBudget > 0 && totalItemCount > m_pointBudget;
+
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+        const ScatterRenderItemArray &renderArray = cache->renderArray();
+        const bool drawingPoints = (cache->mesh() == QAbstract3DSeries::MeshPoint);
+        // Static mesh buffers can't draw a subset of the items, and static point buffers
+        // are drawn with a single call, which gains nothing from culling
+        const bool levelOfDetail = budgetExceeded && (!optimizationStatic || drawingPoints);
+        const bool viewCulling = !budgetExceeded && !optimizationStatic
+                && renderArray.size() >= viewCullingMinItemCount;
+        if (!cache->isVisible() || (!levelOfDetail && !viewCulling)) {
+            if (cache->itemSubsetActive()) {
+                cache->setItemSubsetActive(false);
+                cache->itemSubset().clear();
+                if (optimizationStatic && drawingPoints && cache->bufferPoints())
+                    cache->bufferPoints()->setSubsetIndices(cache->itemSubset());
+            }
+            cache->setItemSubsetDirty(true);
+            continue;
+        }
+
+        ScatterPointBufferHelper *points = optimizationStatic ? cache->bufferPoints() : 0;
+        // The current subset matches the points drawn until a pending upload swaps them
+        if (points && points->hasPendingUpload())
+            continue;
+        // Reloading the static buffers discards the uploaded subset
+        if (!cache->itemSubsetDirty() && cache->itemSubsetViewMatrix() == projectionViewMatrix
+                && (!points || points->subsetIndexCount() == cache->itemSubset().size())) {
+            continue;
+        }
+
+        float itemSize = cache->itemSize() / itemScaler;
+        if (itemSize == 0.0f)
+            itemSize = m_dotSizeScale;
+
+        QVector<int> &subsetIndices = cache->itemSubset();
+        bool subsetActive = true;
+        if (levelOfDetail) {
+            const int budget = int(qint64(m_pointBudget) * renderArray.size() / totalItemCount);
+            cache->octree().selectLod(projectionViewMatrix, itemSize, budget, subsetIndices);
+        } else {
+            subsetActive = cache->octree().selectVisible(projectionViewMatrix, itemSize,
+                                                         subsetIndices);
+        }
+        // Static point buffers draw the selected item separately
+        if (subsetActive && !optimizationStatic && cache == m_selectedSeriesCache
+                && m_selectedItemIndex != Scatter3DController::invalidSelectionIndex()
+                && m_selectedItemIndex < renderArray.size()
+                && renderArray.isVisible(m_selectedItemIndex)
+                && !subsetIndices.contains(m_selectedItemIndex)) {
+            subsetIndices.append(m_selectedItemIndex);
+        }
+        if (points)
+            points->setSubsetIndices(subsetIndices);
+
+        cache->setItemSubsetActive(subsetActive);
+        cache->setItemSubsetCulled(!levelOfDetail);
+        cache->setItemSubsetDirty(false);
+        cache->setItemSubsetViewMatrix(projectionViewMatrix);
+        cache->setShadowItemSubsetDirty(true);
+    }
+}
+
+// Selects the items drawn to the shadow depth map for series that cull items outside the view.
+// Items outside the view can cast shadows into it, so they are culled against the view of the
+// light instead. Level of detail subsets are drawn to the depth map as they are.
+void Scatter3DRenderer::updateShadowItemSubsets(const QMatrix4x4 &depthProjectionViewMatrix)
+{
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+        if (!cache->isVisible() || !cache->itemSubsetActive() || !cache->itemSubsetCulled()) {
+            if (cache->shadowItemSubsetActive()) {
+                cache->setShadowItemSubsetActive(false);
+                cache->shadowItemSubset().clear();
+            }
+            cache->setShadowItemSubsetDirty(true);
+            continue;
+        }
+        if (!cache->shadowItemSubsetDirty()
+                && cache->shadowItemSubsetViewMatrix() == depthProjectionViewMatrix) {
+            continue;
+        }
+
+        float itemSize = cache->itemSize() / itemScaler;
+        if (itemSize == 0.0f)
+            itemSize = m_dotSizeScale;
+        cache->setShadowItemSubsetActive(
+                    cache->octree().selectVisible(depthProjectionViewMatrix, itemSize,
+                                                  cache->shadowItemSubset()));
+        cache->setShadowItemSubsetDirty(false);
+        cache->setShadowItemSubsetViewMatrix(depthProjectionViewMatrix);
+    }
+}
+
+// Casts a ray from the camera through the selection query position and resolves the nearest
+// item, custom item or axis label it hits. Items are approximated by spheres of the item size
+// and tested using the spatial indexes of the series. Only the items drawn in the last frame
+// are tested when a series draws a subset of its items. Nothing is selected if the ray misses.
+void Scatter3DRenderer::pickItem(const QMatrix4x4 &projectionViewMatrix,
+                                 const QMatrix4x4 &viewMatrix,
+                                 const QMatrix4x4 &projectionMatrix,
+                                 const Q3DCamera *activeCamera)
+{
+    QVector3D rayOrigin;
+    QVector3D rayDirection;
+    selectionRay(projectionViewMatrix, rayOrigin, rayDirection);
+
+    const float height = float(m_primarySubViewport.height());
+    const QMatrix4x4 inverseProjectionView = projectionViewMatrix.inverted();
+
+    // Points have their size in pixels, so it is converted to scene units at the depth of
+    // the graph center
+    const QVector3D target = projectionViewMatrix.map(QVector3D());
+    const float pixelSize = (inverseProjectionView.map(QVector3D(target.x(),
+                                                                 target.y() + 2.0f / height,
+                                                                 target.z()))
+                             - inverseProjectionView.map(target)).length();
+
+    float nearestDistance = FLT_MAX;
+    int nearestIndex = -1;
+    ScatterSeriesRenderCache *nearestCache = 0;
+    QVector<uchar> drawnItems;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        if (!baseCache->isVisible())
+            continue;
+        ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+        float itemSize = cache->itemSize() / itemScaler;
+        if (itemSize == 0.0f)
+            itemSize = m_dotSizeScale;
+        float radius = itemSize;
+        if (cache->mesh() == QAbstract3DSeries::MeshPoint)
+            radius = 0.5f * itemSize * activeCamera->zoomLevel() * pixelSize;
+
+        const uchar *drawn = 0;
+        if (cache->itemSubsetActive()) {
+            drawnItems.fill(0, cache->renderArray().size());
+            foreach (int index, cache->itemSubset())
+                drawnItems[index] = 1;
+            drawn = drawnItems.constData();
+        }
+
+        float distance;
+        const int index = cache->octree().pick(cache->renderArray(), rayOrigin, rayDirection,
+                                               radius, distance, drawn);
+        if (index >= 0 && distance < nearestDistance) {
+            nearestDistance = distance;
+            nearestIndex = index;
+            nearestCache = cache;
+        }
+    }
+
+    QVector4D color;
+    if (pickCustomItemsAndLabels(rayOrigin, rayDirection, activeCamera, viewMatrix,
+                                 projectionMatrix, m_selectionShader, nearestDistance, color)) {
+        selectionColorToSeriesAndIndex(color, m_clickedIndex, m_clickedSeries);
+    } else if (nearestCache) {
+        m_clickedIndex = nearestIndex;
+        m_clickedSeries = nearestCache->series();
+        m_clickedType = QAbstract3DGraph::ElementSeries;
+        m_selectedLabelIndex = -1;
+        m_selectedCustomItemIndex = -1;
+    } else {
+        selectionColorToSeriesAndIndex(selectionSkipColor, m_clickedIndex, m_clickedSeries);
+    }
+}
+
+// Builds the spatial indexes of the series whose items changed when picking on CPU, so that
+// the first click after a change doesn't have to build them
+void Scatter3DRenderer::updateOctrees()
+{
+    if (!m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationCpuPicking))
+        return;
+
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        if (baseCache->isVisible())
+            static_cast<ScatterSeriesRenderCache *>(baseCache)->octree();
+    }
+}
+
+void Scatter3DRenderer::updateRenderItem(const QVector3D &dotPos, const QQuaternion &rotation,
+                                         ScatterRenderItemArray &renderArray, int index)
 {
-    QVector3D dotPos = dataItem.position();
     if ((dotPos.x() >= m_axisCacheX.min() && dotPos.x() <= m_axisCacheX.max() )
             && (dotPos.y() >= m_axisCacheY.min() && dotPos.y() <= m_axisCacheY.max())
             && (dotPos.z() >= m_axisCacheZ.min() && dotPos.z() <= m_axisCacheZ.max())) {
-        renderItem.setPosition(dotPos);
-        renderItem.setVisible(true);
-        if (!dataItem.rotation().isIdentity())
-            renderItem.setRotation(dataItem.rotation().normalized());
+        renderArray.setVisible(index, true);
+        if (!rotation.isIdentity())
+            renderArray.setRotation(index, rotation.normalized());
         else
-            renderItem.setRotation(identityQuaternion);
-        calculateTranslation(renderItem);
+            renderArray.setRotation(index, identityQuaternion);
+        renderArray.setTranslation(index, calculateTranslation(dotPos));
+    } else {
+        renderArray.setVisible(index, false);
+    }
+}
+
+class Scatter3DRenderer::TransformTask : public QRunnable
+{
+public:
+    TransformTask(const Scatter3DRenderer *renderer, const QScatterDataProxyPrivate *dataProxy,
+                  ScatterRenderItemArray &renderArray, int from, int to, QSemaphore &done)
+        : m_renderer(renderer),
+          m_dataProxy(dataProxy),
+          m_renderArray(renderArray),
+          m_from(from),
+          m_to(to),
+          m_done(done),
+          m_rotationFound(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        m_rotationFound = m_renderer->transformRenderItems(m_dataProxy, m_renderArray,
+                                                           m_from, m_to);
+        m_done.release();
+    }
+
+    inline bool rotationFound() const { return m_rotationFound; }
+
+private:
+    const Scatter3DRenderer *m_renderer;
+    const QScatterDataProxyPrivate *m_dataProxy;
+    ScatterRenderItemArray &m_renderArray;
+    int m_from;
+    int m_to;
+    QSemaphore &m_done;
+    bool m_rotationFound;
+};
+
+// Updates the render items of a series from the index start onwards. Large ranges with built-in
+// axis formatters are split into parts that are transformed in parallel in the global thread
+// pool, with the last part done on the calling thread. Parts that no pool thread has picked up
+// by then, for example while the pool is busy resolving height maps, are transformed on the
+// calling thread too instead of waiting for them.
+void Scatter3DRenderer::updateRenderItems(const QScatterDataProxyPrivate *dataProxy,
+                                          ScatterRenderItemArray &renderArray, int start)
+{
+    const int dataSize = dataProxy->itemCount();
+    const int updateSize = dataSize - start;
+    bool rotationFound = false;
+
+    int taskCount = qMin(QThread::idealThreadCount(), updateSize / transformTaskMinSize);
+    if (taskCount > 1 && m_axisCacheX.hasBuiltInFormatter()
+            && m_axisCacheY.hasBuiltInFormatter() && m_axisCacheZ.hasBuiltInFormatter()) {
+        QThreadPool *pool = QThreadPool::globalInstance();
+        const int rangeSize = updateSize / taskCount;
+        QSemaphore done;
+        QList<TransformTask *> tasks;
+
+        renderArray.detach();
+        int from = start;
+        for (int i = 1; i < taskCount; i++) {
+            const int to = start + i * rangeSize;
+            TransformTask *task = new TransformTask(this, dataProxy, renderArray, from, to, done);
+            tasks.append(task);
+            pool->start(task);
+            from = to;
+        }
+        rotationFound = transformRenderItems(dataProxy, renderArray, from, dataSize);
+        foreach (TransformTask *task, tasks) {
+            if (pool->tryTake(task))
+                task->run();
+        }
+        done.acquire(tasks.size());
+
+        foreach (TransformTask *task, tasks) {
+            rotationFound = rotationFound || task->rotationFound();
+            delete task;
+        }
+    } else {
+        rotationFound = transformRenderItems(dataProxy, renderArray, start, dataSize);
+    }
+
+    if (!rotationFound) {
+        if (!start)
+            renderArray.clearRotations();
+    } else if (!renderArray.hasRotations()) {
+        // Rotation storage is allocated on first use, which can't be done from multiple threads
+        for (int i = start; i < dataSize; i++) {
+            const QQuaternion rotation = dataProxy->rotationAt(i);
+            if (!rotation.isIdentity())
+                renderArray.setRotation(i, rotation.normalized());
+        }
+    }
+}
+
+// Transforms and uploads items added to the end of the series arrays since the last update.
+void Scatter3DRenderer::updateAppendedItems(const QVector<QScatter3DSeries *> &seriesList)
+{
+    const bool optimizationStatic = m_cachedOptimizationHint.testFlag(
+                QAbstract3DGraph::OptimizationStatic);
+    bool appended = false;
+
+    foreach (QScatter3DSeries *series, seriesList) {
+        ScatterSeriesRenderCache *cache =
+                static_cast<ScatterSeriesRenderCache *>(m_renderCacheList.value(series));
+        if (!cache)
+            continue;
+        if (!cache->isVisible()) {
+            cache->setDataDirty(true);
+            continue;
+        }
+
+        const QScatterDataProxyPrivate *dataProxy = series->dataProxy()->dptrc();
+        ScatterRenderItemArray &renderArray = cache->renderArray();
+        const int oldSize = renderArray.size();
+        const int dataSize = dataProxy->itemCount();
+        // Series that were fully updated already have all items
+        if (cache->dataDirty() || dataSize <= oldSize)
+            continue;
+
+        renderArray.resize(dataSize);
+        updateRenderItems(dataProxy, renderArray, oldSize);
+        cache->setOctreeDirty(true);
+        appended = true;
+
+        if (optimizationStatic) {
+            if (cache->mesh() == QAbstract3DSeries::MeshPoint) {
+                ScatterPointBufferHelper *points = cache->bufferPoints();
+                if (!points) {
+                    points = new ScatterPointBufferHelper();
+                    cache->setBufferPoints(points);
+                }
+                points->setScaleY(m_scaleY);
+                points->append(cache, oldSize);
+            } else {
+                cache->setStaticBufferDirty(true);
+            }
+        }
+    }
+
+    if (!appended)
+        return;
+
+    updateOctrees();
+
+    int totalDataSize = 0;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+        if (cache->isVisible())
+            totalDataSize += cache->renderArray().size();
+    }
+    const GLfloat oldDotSizeScale = m_dotSizeScale;
+    m_dotSizeScale = GLfloat(qBound(defaultMinSize,
+                                    2.0f / float(qSqrt(qreal(totalDataSize))),
+                                    defaultMaxSize));
+
+    if (optimizationStatic) {
+        // Mesh series have the dot size baked in their static buffers
+        foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+            ScatterSeriesRenderCache *cache = static_cast<ScatterSeriesRenderCache *>(baseCache);
+            if (cache->isVisible() && cache->mesh() != QAbstract3DSeries::MeshPoint
+                    && (cache->staticBufferDirty() || m_dotSizeScale != oldDotSizeScale)) {
+                ScatterObjectBufferHelper *object = cache->bufferObject();
+                if (!object) {
+                    object = new ScatterObjectBufferHelper(m_isInstancingSupported);
+                    cache->setBufferObject(object);
+                }
+                object->setScaleY(m_scaleY);
+                object->fullLoad(cache, m_dotSizeScale);
+                cache->setOldArraySize(cache->renderArray().size());
+                cache->setOldMeshFileName(cache->object()->objectFile());
+                cache->setStaticBufferDirty(false);
+            }
+        }
+    }
+}
+
+// Transforms the items in range [from, to) and returns true if any of them is rotated.
+// Rotations are only stored if the render array already has rotation storage.
+bool Scatter3DRenderer::transformRenderItems(const QScatterDataProxyPrivate *dataProxy,
+                                             ScatterRenderItemArray &renderArray,
+                                             int from, int to) const
+{
+    if (dataProxy->hasExternalBuffer()) {
+        return transformRenderItems(dataProxy->externalBuffer(), renderArray, from, to);
+    } else {
+        return transformRenderItems(ScatterArraySource(dataProxy->dataArray()), renderArray,
+                                    from, to);
+    }
+}
+
+template <typename Source>
+bool Scatter3DRenderer::transformRenderItems(const Source &source,
+                                             ScatterRenderItemArray &renderArray,
+                                             int from, int to) const
+{
+    float *xData = renderArray.xData();
+    float *yData = renderArray.yData();
+    float *zData = renderArray.zData();
+    uchar *visibility = renderArray.visibilityData();
+    const float minX = m_axisCacheX.min();
+    const float maxX = m_axisCacheX.max();
+    const float minY = m_axisCacheY.min();
+    const float maxY = m_axisCacheY.max();
+    const float minZ = m_axisCacheZ.min();
+    const float maxZ = m_axisCacheZ.max();
+
+    float scaleX, offsetX, scaleY, offsetY, scaleZ, offsetZ;
+    if (!m_polarGraph && m_axisCacheX.linearMapping(scaleX, offsetX)
+            && m_axisCacheY.linearMapping(scaleY, offsetY)
+            && m_axisCacheZ.linearMapping(scaleZ, offsetZ)) {
+        // Linear axes need no formatter calls. Translations of hidden items are never used.
+        for (int i = from; i < to; i++) {
+            const QVector3D dotPos = source.positionAt(i);
+            const float x = dotPos.x();
+            const float y = dotPos.y();
+            const float z = dotPos.z();
+            xData[i] = x * scaleX + offsetX;
+            yData[i] = y * scaleY + offsetY;
+            zData[i] = z * scaleZ + offsetZ;
+            visibility[i] = (x >= minX) & (x <= maxX) & (y >= minY) & (y <= maxY)
+                    & (z >= minZ) & (z <= maxZ);
+        }
     } else {
-        renderItem.setVisible(false);
+        for (int i = from; i < to; i++) {
+            const QVector3D dotPos = source.positionAt(i);
+            const bool visible = (dotPos.x() >= minX && dotPos.x() <= maxX)
+                    && (dotPos.y() >= minY && dotPos.y() <= maxY)
+                    && (dotPos.z() >= minZ && dotPos.z() <= maxZ);
+            visibility[i] = visible;
+            if (visible) {
+                const QVector3D translation = calculateTranslation(dotPos);
+                xData[i] = translation.x();
+                yData[i] = translation.y();
+                zData[i] = translation.z();
+            }
+        }
+    }
+
+    bool rotationFound = false;
+    if (!source.hasRotations())
+        return rotationFound;
+
+    QQuaternion *rotations = renderArray.hasRotations() ? renderArray.rotationData() : 0;
+    for (int i = from; i < to; i++) {
+        const QQuaternion rotation = source.rotationAt(i);
+        if (!rotation.isIdentity()) {
+            rotationFound = true;
+            if (!rotations)
+                break;
+            rotations[i] = rotation.normalized();
+        } else if (rotations) {
+            rotations[i] = identityQuaternion;
+        }
     }
+    return rotationFound;
 }
 
 QVector3D Scatter3DRenderer::convertPositionToTranslation(const QVector3D &position,
@@ -52,7 +52,7 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 class ShaderHelper;
 class Q3DScene;
 class ScatterSeriesRenderCache;
-class QScatterDataItem;
+class QScatterDataProxyPrivate;
 
 class QT_DATAVISUALIZATION_EXPORT Scatter3DRenderer : public Abstract3DRenderer
 {
@@ -60,7 +60,8 @@ class QT_DATAVISUALIZATION_EXPORT Scatter3DRenderer : public Abstract3DRenderer
 
 private:
     // Internal state
-    ScatterRenderItem *m_selectedItem; // points to renderitem array
+    int m_labeledItemIndex; // Item the selection label was last generated for
+    ScatterSeriesRenderCache *m_labeledSeriesCache;
     bool m_updateLabels;
     ShaderHelper *m_dotShader;
     ShaderHelper *m_dotGradientShader;
@@ -68,7 +69,11 @@ private:
     ShaderHelper *m_staticSelectedItemShader;
     ShaderHelper *m_pointShader;
     ShaderHelper *m_depthShader;
+    ShaderHelper *m_instancedDepthShader;
     ShaderHelper *m_selectionShader;
+    ShaderHelper *m_staticSelectionShader; // Colors from the selection color buffers
+    ShaderHelper *m_staticPointSelectionShader;
+    ShaderHelper *m_instancedSelectionShader;
     ShaderHelper *m_backgroundShader;
     ShaderHelper *m_staticGradientPointShader;
     GLuint m_bgrTexture;
@@ -86,12 +91,14 @@ private:
     ScatterSeriesRenderCache *m_oldSelectedSeriesCache;
     GLfloat m_dotSizeScale;
     ScatterRenderItem m_dummyRenderItem;
+    ScatterRenderItem m_selectedItem; // Selection label anchor
     GLfloat m_maxItemSize;
     int m_clickedIndex;
     bool m_havePointSeries;
     bool m_haveMeshSeries;
     bool m_haveUniformColorMeshSeries;
     bool m_haveGradientMeshSeries;
+    int m_pointBudget; // Maximum number of items drawn per frame, zero for no limit
 
 public:
     explicit Scatter3DRenderer(Scatter3DController *controller);
@@ -101,6 +108,7 @@ public:
     void updateSeries(const QList<QAbstract3DSeries *> &seriesList);
     SeriesRenderCache *createNewCache(QAbstract3DSeries *series);
     void updateItems(const QVector<Scatter3DController::ChangeItem> &items);
+    void updateAppendedItems(const QVector<QScatter3DSeries *> &seriesList);
     void updateScene(Q3DScene *scene);
     void updateAxisLabels(QAbstract3DAxis::AxisOrientation orientation,
                           const QStringList &labels);
@@ -108,6 +116,7 @@ public:
                                    bool visible);
     void updateOptimizationHint(QAbstract3DGraph::OptimizationHints hint);
     void updateMargin(float margin);
+    void updatePointBudget(int budget);
 
     QVector3D convertPositionToTranslation(const QVector3D &position, bool isAbsolute);
 
@@ -137,6 +146,8 @@ private:
     virtual void fixMeshFileName(QString &fileName, QAbstract3DSeries::Mesh mesh);
 
     void drawScene(GLuint defaultFboHandle);
+    void drawStaticSelection(ScatterSeriesRenderCache *cache,
+                             const QMatrix4x4 &projectionViewMatrix);
     void drawLabels(bool drawSelection, const Q3DCamera *activeCamera,
                     const QMatrix4x4 &viewMatrix, const QMatrix4x4 &projectionMatrix);
 
@@ -148,12 +159,27 @@ private:
     void initDepthShader();
     void updateDepthBuffer();
     void initPointShader();
-    void calculateTranslation(ScatterRenderItem &item);
+    QVector3D calculateTranslation(const QVector3D &pos) const;
     void calculateSceneScalingFactors();
 
     void selectionColorToSeriesAndIndex(const QVector4D &color, int &index,
                                         QAbstract3DSeries *&series);
-    inline void updateRenderItem(const QScatterDataItem &dataItem, ScatterRenderItem &renderItem);
+    void updateItemSubsets(const QMatrix4x4 &projectionViewMatrix);
+    void updateShadowItemSubsets(const QMatrix4x4 &depthProjectionViewMatrix);
+    void pickItem(const QMatrix4x4 &projectionViewMatrix, const QMatrix4x4 &viewMatrix,
+                  const QMatrix4x4 &projectionMatrix, const Q3DCamera *activeCamera);
+    void updateOctrees();
+    inline void updateRenderItem(const QVector3D &dotPos, const QQuaternion &rotation,
+                                 ScatterRenderItemArray &renderArray, int index);
+    void updateRenderItems(const QScatterDataProxyPrivate *dataProxy,
+                           ScatterRenderItemArray &renderArray, int start);
+    bool transformRenderItems(const QScatterDataProxyPrivate *dataProxy,
+                              ScatterRenderItemArray &renderArray, int from, int to) const;
+    template <typename Source>
+    bool transformRenderItems(const Source &source, ScatterRenderItemArray &renderArray,
+                              int from, int to) const;
+
+    class TransformTask;
 
     Q_DISABLE_COPY(Scatter3DRenderer)
 };
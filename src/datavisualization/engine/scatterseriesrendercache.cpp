@@ -43,7 +43,13 @@ ScatterSeriesRenderCache::ScatterSeriesRenderCache(QAbstract3DSeries *series,
       m_oldMeshFileName(QString()),
       m_scatterBufferObj(0),
       m_scatterBufferPoints(0),
-      m_visibilityChanged(false)
+      m_visibilityChanged(false),
+      m_octreeDirty(true),
+      m_itemSubsetActive(false),
+      m_itemSubsetDirty(true),
+      m_itemSubsetCulled(false),
+      m_shadowItemSubsetActive(false),
+      m_shadowItemSubsetDirty(true)
 {
 }
 
@@ -56,8 +62,26 @@ ScatterSeriesRenderCache::~ScatterSeriesRenderCache()
 void ScatterSeriesRenderCache::cleanup(TextureHelper *texHelper)
 {
     m_renderArray.clear();
+    m_octree.clear();
+    m_octreeDirty = true;
+    m_itemSubset.clear();
+    m_itemSubsetActive = false;
+    m_itemSubsetDirty = true;
+    m_itemSubsetCulled = false;
+    m_shadowItemSubset.clear();
+    m_shadowItemSubsetActive = false;
+    m_shadowItemSubsetDirty = true;
 
     SeriesRenderCache::cleanup(texHelper);
 }
 
+const ScatterOctree &ScatterSeriesRenderCache::octree()
+{
+    if (m_octreeDirty) {
+        m_octree.build(m_renderArray);
+        m_octreeDirty = false;
+    }
+    return m_octree;
+}
+
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -44,6 +44,7 @@
 #include "seriesrendercache_p.h"
 #include "qscatter3dseries_p.h"
 #include "scatterrenderitem_p.h"
+#include "scatteroctree_p.h"
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -78,6 +79,40 @@ public:
     inline QVector<int> &bufferIndices() { return m_bufferIndices; }
     inline void setVisibilityChanged(bool changed) { m_visibilityChanged = changed; }
     inline bool visibilityChanged() const { return m_visibilityChanged; }
+    inline void setOctreeDirty(bool state)
+    {
+        m_octreeDirty = state;
+        if (state) {
+            m_itemSubsetDirty = true;
+            m_shadowItemSubsetDirty = true;
+        }
+    }
+    const ScatterOctree &octree();
+    inline QVector<int> &itemSubset() { return m_itemSubset; }
+    inline void setItemSubsetActive(bool active) { m_itemSubsetActive = active; }
+    inline bool itemSubsetActive() const { return m_itemSubsetActive; }
+    inline void setItemSubsetDirty(bool state) { m_itemSubsetDirty = state; }
+    inline bool itemSubsetDirty() const { return m_itemSubsetDirty; }
+    inline void setItemSubsetViewMatrix(const QMatrix4x4 &matrix)
+    {
+        m_itemSubsetViewMatrix = matrix;
+    }
+    inline const QMatrix4x4 &itemSubsetViewMatrix() const { return m_itemSubsetViewMatrix; }
+    inline void setItemSubsetCulled(bool culled) { m_itemSubsetCulled = culled; }
+    inline bool itemSubsetCulled() const { return m_itemSubsetCulled; }
+    inline QVector<int> &shadowItemSubset() { return m_shadowItemSubset; }
+    inline void setShadowItemSubsetActive(bool active) { m_shadowItemSubsetActive = active; }
+    inline bool shadowItemSubsetActive() const { return m_shadowItemSubsetActive; }
+    inline void setShadowItemSubsetDirty(bool state) { m_shadowItemSubsetDirty = state; }
+    inline bool shadowItemSubsetDirty() const { return m_shadowItemSubsetDirty; }
+    inline void setShadowItemSubsetViewMatrix(const QMatrix4x4 &matrix)
+    {
+        m_shadowItemSubsetViewMatrix = matrix;
+    }
+    inline const QMatrix4x4 &shadowItemSubsetViewMatrix() const
+    {
+        return m_shadowItemSubsetViewMatrix;
+    }
 
 protected:
     ScatterRenderItemArray m_renderArray;
@@ -91,6 +126,17 @@ protected:
     QVector<int> m_updateIndices; // Used as temporary cache during item updates
     QVector<int> m_bufferIndices; // Cache for mapping renderarray to mesh buffer
     bool m_visibilityChanged; // Used to detect if full buffer change needed
+    ScatterOctree m_octree; // Spatial index of the render items, built on demand
+    bool m_octreeDirty;
+    QVector<int> m_itemSubset; // Items drawn when level of detail or view culling is active
+    bool m_itemSubsetActive;
+    bool m_itemSubsetDirty;
+    QMatrix4x4 m_itemSubsetViewMatrix; // Projection view matrix the items were selected for
+    bool m_itemSubsetCulled; // Subset is the items in the view rather than a level of detail
+    QVector<int> m_shadowItemSubset; // Culled items drawn to the shadow depth map
+    bool m_shadowItemSubsetActive;
+    bool m_shadowItemSubsetDirty;
+    QMatrix4x4 m_shadowItemSubsetViewMatrix;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -0,0 +1,23 @@
+uniform highp mat4 MVP;
+uniform highp vec4 barLayout;
+uniform highp vec4 barScale;
+
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec4 instancePosition;
+attribute highp vec4 instanceRotation;
+
+highp vec3 rotate(highp vec4 q, highp vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    highp float height = instancePosition.y;
+    if (height * barScale.w < 0.0)
+        height = 0.0;
+    height *= barScale.y;
+    highp vec3 scale = vec3(barScale.x, height, barScale.z);
+    highp vec3 vertexPosition_wrld = rotate(instanceRotation, vertexPosition_mdl * scale)
+            + vec3(barLayout.x * instancePosition.x + barLayout.y, height,
+                   barLayout.z * instancePosition.z + barLayout.w);
+    gl_Position = MVP * vec4(vertexPosition_wrld, 1.0);
+}
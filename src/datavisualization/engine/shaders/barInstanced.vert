@@ -0,0 +1,54 @@
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec3 vertexNormal_mdl;
+attribute highp vec4 instancePosition;
+attribute highp vec4 instanceRotation;
+
+uniform highp mat4 MVP;
+uniform highp mat4 V;
+uniform highp vec3 lightPosition_wrld;
+uniform highp vec4 barLayout;
+uniform highp vec4 barScale;
+uniform highp vec4 barSelection;
+
+varying highp vec3 lightPosition_wrld_frag;
+varying highp vec2 UV;
+varying highp vec3 position_wrld;
+varying highp vec3 normal_cmr;
+varying highp vec3 eyeDirection_cmr;
+varying highp vec3 lightDirection_cmr;
+varying highp vec2 coords_mdl;
+
+highp vec3 rotate(highp vec4 q, highp vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    highp float height = instancePosition.y;
+    // Highlighted bars and bars on the other side of the floor than barScale.w are collapsed
+    if (height * barScale.w < 0.0
+            || (instancePosition.z == barSelection.x
+                && (barSelection.z > 0.0 || instancePosition.x == barSelection.y))
+            || (instancePosition.x == barSelection.y && barSelection.w > 0.0)) {
+        height = 0.0;
+    }
+    height *= barScale.y;
+    // Negative heights reverse the winding of the triangles, so bars above and below the floor
+    // are drawn separately with different face culling
+    highp vec3 scale = vec3(barScale.x, height, barScale.z);
+    highp vec3 vertexPosition_wrld = rotate(instanceRotation, vertexPosition_mdl * scale)
+            + vec3(barLayout.x * instancePosition.x + barLayout.y, height,
+                   barLayout.z * instancePosition.z + barLayout.w);
+    gl_Position = MVP * vec4(vertexPosition_wrld, 1.0);
+    coords_mdl = vertexPosition_mdl.xy;
+    position_wrld = vertexPosition_wrld;
+    vec3 vertexPosition_cmr = vec4(V * vec4(vertexPosition_wrld, 1.0)).xyz;
+    eyeDirection_cmr = vec3(0.0, 0.0, 0.0) - vertexPosition_cmr;
+    vec3 lightPosition_cmr = vec4(V * vec4(lightPosition_wrld, 1.0)).xyz;
+    lightDirection_cmr = lightPosition_cmr + eyeDirection_cmr;
+    // Inverse transpose of the scaling, up to a positive factor
+    highp vec3 normal = vertexNormal_mdl * vec3(scale.y * scale.z, scale.x * scale.z,
+                                                scale.x * scale.y) * sign(height);
+    normal_cmr = vec4(V * vec4(rotate(instanceRotation, normal), 0.0)).xyz;
+    UV = vec2(0.0, (vertexPosition_mdl.y + 1.0) * instancePosition.w);
+    lightPosition_wrld_frag = lightPosition_wrld;
+}
@@ -0,0 +1,38 @@
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec3 vertexNormal_mdl;
+attribute highp vec4 instancePosition;
+attribute highp vec4 instanceRotation;
+attribute highp vec2 instanceUV;
+
+uniform highp mat4 MVP;
+uniform highp mat4 V;
+uniform highp vec3 lightPosition_wrld;
+uniform highp float gradHeight;
+
+varying highp vec3 lightPosition_wrld_frag;
+varying highp vec2 UV;
+varying highp vec3 position_wrld;
+varying highp vec3 normal_cmr;
+varying highp vec3 eyeDirection_cmr;
+varying highp vec3 lightDirection_cmr;
+varying highp vec2 coords_mdl;
+
+highp vec3 rotate(highp vec4 q, highp vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    highp vec3 vertexPosition_wrld = rotate(instanceRotation,
+                                            vertexPosition_mdl * instancePosition.w)
+            + instancePosition.xyz;
+    gl_Position = MVP * vec4(vertexPosition_wrld, 1.0);
+    coords_mdl = vertexPosition_wrld.xy;
+    position_wrld = vertexPosition_wrld;
+    vec3 vertexPosition_cmr = vec4(V * vec4(vertexPosition_wrld, 1.0)).xyz;
+    eyeDirection_cmr = vec3(0.0, 0.0, 0.0) - vertexPosition_cmr;
+    vec3 lightPosition_cmr = vec4(V * vec4(lightPosition_wrld, 1.0)).xyz;
+    lightDirection_cmr = lightPosition_cmr + eyeDirection_cmr;
+    normal_cmr = vec4(V * vec4(rotate(instanceRotation, vertexNormal_mdl), 0.0)).xyz;
+    UV = vec2(0.0, instanceUV.y + (vertexPosition_mdl.y + 1.0) * gradHeight);
+    lightPosition_wrld_frag = lightPosition_wrld;
+}
@@ -0,0 +1,16 @@
+uniform highp mat4 MVP;
+
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec4 instancePosition;
+attribute highp vec4 instanceRotation;
+
+highp vec3 rotate(highp vec4 q, highp vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    highp vec3 vertexPosition_wrld = rotate(instanceRotation,
+                                            vertexPosition_mdl * instancePosition.w)
+            + instancePosition.xyz;
+    gl_Position = MVP * vec4(vertexPosition_wrld, 1.0);
+}
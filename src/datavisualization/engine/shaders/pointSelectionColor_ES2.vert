@@ -0,0 +1,12 @@
+uniform highp mat4 MVP;
+
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec4 selectionColor;
+
+varying highp vec4 color_frag;
+
+void main() {
+    gl_PointSize = 5.0;
+    gl_Position = MVP * vec4(vertexPosition_mdl, 1.0);
+    color_frag = selectionColor;
+}
@@ -0,0 +1,5 @@
+varying highp vec4 color_frag;
+
+void main() {
+    gl_FragColor = color_frag;
+}
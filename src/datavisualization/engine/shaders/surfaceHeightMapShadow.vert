@@ -0,0 +1,58 @@
+#version 120
+
+uniform highp mat4 MVP;
+uniform highp mat4 V;
+uniform highp mat4 M;
+uniform highp mat4 itM;
+uniform highp mat4 depthMVP;
+uniform highp vec3 lightPosition_wrld;
+uniform highp sampler2D heightMap;
+uniform highp vec2 heightMapSize;
+uniform highp vec3 heightMapScale;
+uniform highp vec3 heightMapOffset;
+
+attribute highp vec3 vertexPosition_mdl;
+attribute highp vec2 vertexUV;
+
+varying highp vec2 UV;
+varying highp vec3 position_wrld;
+varying highp vec3 normal_cmr;
+varying highp vec3 eyeDirection_cmr;
+varying highp vec3 lightDirection_cmr;
+varying highp vec4 shadowCoord;
+varying highp vec2 coords_mdl;
+
+const highp mat4 bias = mat4(0.5, 0.0, 0.0, 0.0,
+                             0.0, 0.5, 0.0, 0.0,
+                             0.0, 0.0, 0.5, 0.0,
+                             0.5, 0.5, 0.5, 1.0);
+
+// Vertex positions hold the column and row of the vertex in the height map
+highp float heightAt(highp vec2 grid) {
+    return texture2D(heightMap, (grid + 0.5) / heightMapSize).r;
+}
+
+void main() {
+    highp vec2 grid = vertexPosition_mdl.xy;
+    highp vec3 position = vec3(grid.x, heightAt(grid), grid.y) * heightMapScale
+            + heightMapOffset;
+
+    // Central differences, one-sided at the edges of the height map
+    highp vec2 low = max(grid - 1.0, 0.0);
+    highp vec2 high = min(grid + 1.0, heightMapSize - 1.0);
+    highp float slopeX = (heightAt(vec2(high.x, grid.y)) - heightAt(vec2(low.x, grid.y)))
+            * heightMapScale.y / ((high.x - low.x) * heightMapScale.x);
+    highp float slopeZ = (heightAt(vec2(grid.x, high.y)) - heightAt(vec2(grid.x, low.y)))
+            * heightMapScale.y / ((high.y - low.y) * heightMapScale.z);
+    highp vec3 normal = vec3(-slopeX, 1.0, -slopeZ);
+
+    gl_Position = MVP * vec4(position, 1.0);
+    coords_mdl = position.xy;
+    shadowCoord = bias * depthMVP * vec4(position, 1.0);
+    position_wrld = vec4(M * vec4(position, 1.0)).xyz;
+    vec3 vertexPosition_cmr = vec4(V * M * vec4(position, 1.0)).xyz;
+    eyeDirection_cmr = vec3(0.0, 0.0, 0.0) - vertexPosition_cmr;
+    lightDirection_cmr = vec4(V * vec4(lightPosition_wrld, 0.0)).xyz;
+    normal_cmr = vec4(V * itM * vec4(normal, 0.0)).xyz;
+    UV = vertexUV;
+}
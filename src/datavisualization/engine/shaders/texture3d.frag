@@ -6,18 +6,30 @@ varying highp vec3 rayDir;
 uniform highp sampler3D textureSampler;
 uniform highp vec4 colorIndex[256];
 uniform highp int color8Bit;
+uniform highp vec2 valueWindow;
 uniform highp vec3 textureDimensions;
 uniform highp int sampleCount; // This is the maximum sample count
 uniform highp float alphaMultiplier;
 uniform highp int preserveOpacity;
 uniform highp vec3 minBounds;
 uniform highp vec3 maxBounds;
+uniform highp sampler3D brickMap;
+uniform highp vec3 brickSize;
+uniform highp vec3 brickCount;
+uniform highp int skipEmptyBricks;
+uniform highp vec3 occupiedMin;
+uniform highp vec3 occupiedMax;
 
 // Ray traveling straight through a single 'alpha thickness' applies 100% of the encountered alpha.
 // Rays traveling shorter distances apply a fraction. This is used to normalize the alpha over
 // entire volume, regardless of texture dimensions
 const highp float alphaThicknesses = 32.0;
 
+// Maps the sampled value through the value window into the color table
+highp vec4 indexedColor(highp float value) {
+    return colorIndex[int(clamp((value - valueWindow.x) * valueWindow.y, 0.0, 1.0) * 255.0)];
+}
+
 void main() {
     vec3 rayStart = pos;
 
@@ -51,6 +63,22 @@ void main() {
 
     highp vec3 ray = rayStop - rayStart;
 
+    // Clip the ray to the box of the bricks that have visible texels
+    highp vec3 invRay = 1.0 / ray;
+    highp vec3 occupiedT0 = (occupiedMin - rayStart) * invRay;
+    highp vec3 occupiedT1 = (occupiedMax - rayStart) * invRay;
+    highp vec3 nearT = min(occupiedT0, occupiedT1);
+    highp vec3 farT = max(occupiedT0, occupiedT1);
+    highp float enterT = max(0.0, max(nearT.x, max(nearT.y, nearT.z)));
+    highp float exitT = min(1.0, min(farT.x, min(farT.y, farT.z)));
+    if (enterT >= exitT)
+        discard;
+    rayStop = rayStart + exitT * ray;
+    rayStart += enterT * ray;
+    ray = rayStop - rayStart;
+    highp vec3 brickExits = vec3(greaterThanEqual(ray, vec3(0.0)));
+    invRay = 1.0 / ray;
+
     highp vec3 absRay = abs(ray);
     highp vec3 invAbsRay = 1.0 / absRay;
     highp float fullDist = length(ray);
@@ -69,36 +97,49 @@ void main() {
     // nextEdges vector indicates the next edges of the texel boundaries along each axis that
     // the ray is about to cross. The first edges are offset by a fraction of a texel to
     // avoid artifacts from rounding errors later.
-    highp vec3 nextEdges = vec3(floor(curPos.x / textureDimensions.x) * textureDimensions.x,
-                                floor(curPos.y / textureDimensions.y) * textureDimensions.y,
-                                floor(curPos.z / textureDimensions.z) * textureDimensions.z);
-
     highp vec3 textureSteps = textureDimensions;
     highp vec3 textureOffset = textureDimensions * 0.001;
+    highp vec3 edgeOffsets;
     if (ray.x > 0) {
-        nextEdges.x += textureDimensions.x + textureOffset.x;
+        edgeOffsets.x = textureDimensions.x + textureOffset.x;
     } else {
-        nextEdges.x -= textureOffset.x;
+        edgeOffsets.x = -textureOffset.x;
         textureSteps.x = -textureDimensions.x;
     }
     if (ray.y > 0) {
-        nextEdges.y += textureDimensions.y + textureOffset.y;
+        edgeOffsets.y = textureDimensions.y + textureOffset.y;
     } else {
-        nextEdges.y -= textureOffset.y;
+        edgeOffsets.y = -textureOffset.y;
         textureSteps.y = -textureDimensions.y;
     }
     if (ray.z > 0) {
-        nextEdges.z += textureDimensions.z + textureOffset.z;
+        edgeOffsets.z = textureDimensions.z + textureOffset.z;
     } else {
-        nextEdges.z -= textureOffset.z;
+        edgeOffsets.z = -textureOffset.z;
         textureSteps.z = -textureDimensions.z;
     }
+    highp vec3 nextEdges = floor(curPos / textureDimensions) * textureDimensions + edgeOffsets;
 
     // Raytrace into volume, need to sample pixels along the eye ray until we hit opacity 1
     for (int i = 0; i < sampleCount; i++) {
+        if (skipEmptyBricks != 0) {
+            highp vec3 brick = floor(curPos / brickSize);
+            if (texture3D(brickMap, (brick + 0.5) / brickCount).r == 0.0) {
+                // No visible texels in the brick, so jump to where the ray leaves it
+                highp vec3 brickT = ((brick + brickExits) * brickSize - curPos) * invRay;
+                highp float skipLen = min(brickT.x, min(brickT.y, brickT.z)) + 0.0001;
+                curPos += skipLen * ray;
+                curLen += skipLen;
+                if (curLen >= 1.0)
+                    break;
+                nextEdges = floor(curPos / textureDimensions) * textureDimensions + edgeOffsets;
+                continue;
+            }
+        }
+
         curColor = texture3D(textureSampler, curPos);
         if (color8Bit != 0)
-            curColor = colorIndex[int(curColor.r * 255.0)];
+            curColor = indexedColor(curColor.r);
 
         // Find which dimension has least to go to figure out the next step distance
         highp vec3 delta = abs(nextEdges - curPos);
@@ -6,12 +6,19 @@ varying highp vec3 rayDir;
 uniform highp sampler3D textureSampler;
 uniform highp vec4 colorIndex[256];
 uniform highp int color8Bit;
+uniform highp vec2 valueWindow;
 uniform highp vec3 textureDimensions;
 uniform highp int sampleCount; // This is the maximum sample count
 uniform highp float alphaMultiplier;
 uniform highp int preserveOpacity;
 uniform highp vec3 minBounds;
 uniform highp vec3 maxBounds;
+uniform highp sampler3D brickMap;
+uniform highp vec3 brickSize;
+uniform highp vec3 brickCount;
+uniform highp int skipEmptyBricks;
+uniform highp vec3 occupiedMin;
+uniform highp vec3 occupiedMax;
 
 // Ray traveling straight through a single 'alpha thickness' applies 100% of the encountered alpha.
 // Rays traveling shorter distances apply a fraction. This is used to normalize the alpha over
@@ -19,6 +26,11 @@ uniform highp vec3 maxBounds;
 const highp float alphaThicknesses = 32.0;
 const highp float SQRT3 = 1.73205081;
 
+// Maps the sampled value through the value window into the color table
+highp vec4 indexedColor(highp float value) {
+    return colorIndex[int(clamp((value - valueWindow.x) * valueWindow.y, 0.0, 1.0) * 255.0)];
+}
+
 void main() {
     vec3 rayStart = pos;
     highp vec3 startBounds = minBounds;
@@ -51,9 +63,25 @@ void main() {
 
     highp vec3 ray = rayStop - rayStart;
 
+    // Clip the ray to the box of the bricks that have visible texels
+    highp vec3 invRay = 1.0 / ray;
+    highp vec3 occupiedT0 = (occupiedMin - rayStart) * invRay;
+    highp vec3 occupiedT1 = (occupiedMax - rayStart) * invRay;
+    highp vec3 nearT = min(occupiedT0, occupiedT1);
+    highp vec3 farT = max(occupiedT0, occupiedT1);
+    highp float enterT = max(0.0, max(nearT.x, max(nearT.y, nearT.z)));
+    highp float exitT = min(1.0, min(farT.x, min(farT.y, farT.z)));
+    if (enterT >= exitT)
+        discard;
+    rayStop = rayStart + exitT * ray;
+    rayStart += enterT * ray;
+    ray = rayStop - rayStart;
+    highp vec3 brickExits = vec3(greaterThanEqual(ray, vec3(0.0)));
+
     highp float fullDist = length(ray);
     highp float stepSize = SQRT3 / sampleCount;
     highp vec3 step = (SQRT3 * normalize(ray)) / sampleCount;
+    highp vec3 invStep = 1.0 / step;
 
     rayStart += (step * 0.001);
 
@@ -69,9 +97,24 @@ void main() {
 
     // Raytrace into volume, need to sample pixels along the eye ray until we hit opacity 1
     for (int i = 0; i < sampleCount; i++) {
+        if (skipEmptyBricks != 0) {
+            highp vec3 brick = floor(curPos / brickSize);
+            if (texture3D(brickMap, (brick + 0.5) / brickCount).r == 0.0) {
+                // No visible texels in the brick, so jump over the samples inside it
+                highp vec3 brickSteps = ((brick + brickExits) * brickSize - curPos) * invStep;
+                highp float skipSteps = floor(min(brickSteps.x, min(brickSteps.y, brickSteps.z)))
+                        + 1.0;
+                curPos += skipSteps * step;
+                curLen += skipSteps * stepSize;
+                if (curLen >= fullDist)
+                    break;
+                continue;
+            }
+        }
+
         curColor = texture3D(textureSampler, curPos);
         if (color8Bit != 0)
-            curColor = colorIndex[int(curColor.r * 255.0)];
+            curColor = indexedColor(curColor.r);
 
         if (curColor.a >= 0.0) {
             if (curColor.a == 1.0 && (preserveOpacity == 1 || alphaMultiplier >= 1.0))
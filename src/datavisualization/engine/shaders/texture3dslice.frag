@@ -7,6 +7,7 @@ uniform highp sampler3D textureSampler;
 uniform highp vec3 volumeSliceIndices;
 uniform highp vec4 colorIndex[256];
 uniform highp int color8Bit;
+uniform highp vec2 valueWindow;
 uniform highp float alphaMultiplier;
 uniform highp int preserveOpacity;
 uniform highp vec3 minBounds;
@@ -16,6 +17,11 @@ const highp vec3 xPlaneNormal = vec3(1.0, 0, 0);
 const highp vec3 yPlaneNormal = vec3(0, 1.0, 0);
 const highp vec3 zPlaneNormal = vec3(0, 0, 1.0);
 
+// Maps the sampled value through the value window into the color table
+highp vec4 indexedColor(highp float value) {
+    return colorIndex[int(clamp((value - valueWindow.x) * valueWindow.y, 0.0, 1.0) * 255.0)];
+}
+
 void main() {
     // Find out where ray intersects the slice planes
     vec3 normRayDir = normalize(rayDir);
@@ -88,7 +94,7 @@ void main() {
             texelVec = 0.5 * (texelVec + 1.0);
             curColor = texture3D(textureSampler, texelVec);
             if (color8Bit != 0)
-                curColor = colorIndex[int(curColor.r * 255.0)];
+                curColor = indexedColor(curColor.r);
 
             if (curColor.a > 0.0) {
                 curAlpha = curColor.a;
@@ -108,7 +114,7 @@ void main() {
                 texelVec = 0.5 * (texelVec + 1.0);
                 curColor = texture3D(textureSampler, texelVec);
                 if (color8Bit != 0)
-                    curColor = colorIndex[int(curColor.r * 255.0)];
+                    curColor = indexedColor(curColor.r);
                 if (curColor.a > 0.0) {
                     if (curColor.a == 1.0 && preserveOpacity != 0)
                         curAlpha = 1.0;
@@ -128,7 +134,7 @@ void main() {
                     curColor = texture3D(textureSampler, texelVec);
                     if (curColor.a > 0.0) {
                         if (color8Bit != 0)
-                            curColor = colorIndex[int(curColor.r * 255.0)];
+                            curColor = indexedColor(curColor.r);
                         if (curColor.a == 1.0 && preserveOpacity != 0)
                             curAlpha = 1.0;
                         else
@@ -77,6 +77,18 @@ void Surface3DController::synchDataToRenderer()
     if (!isInitialized())
         return;
 
+    // Shifts tell how the data the renderer has relates to the new data, so they are passed
+    // before the data is updated. Series that are reloaded anyway don't need them.
+    if (m_shiftedRows.size()) {
+        QVector<ChangeShift> shiftedRows;
+        foreach (const ChangeShift &shift, m_shiftedRows) {
+            if (!m_changedSeriesList.contains(shift.series))
+                shiftedRows.append(shift);
+        }
+        m_renderer->updateShiftedRows(shiftedRows);
+        m_shiftedRows.clear();
+    }
+
     Abstract3DController::synchDataToRenderer();
 
     // Notify changes to renderer
@@ -179,6 +191,11 @@ void Surface3DController::removeSeries(QAbstract3DSeries *series)
 
     Abstract3DController::removeSeries(series);
 
+    for (int i = m_shiftedRows.size() - 1; i >= 0; i--) {
+        if (m_shiftedRows.at(i).series == series)
+            m_shiftedRows.removeAt(i);
+    }
+
     if (m_selectedSeries == series)
         setSelectedPoint(invalidSelectionPosition(), 0, false);
 
@@ -281,7 +298,7 @@ void Surface3DController::setSelectedPoint(const QPoint &position, QSurface3DSer
             float axisMinZ = m_axisZ->min();
             float axisMaxZ = m_axisZ->max();
 
-            QSurfaceDataItem item = proxy->array()->at(pos.x())->at(pos.y());
+            QSurfaceDataItem item = proxy->dptrc()->dataView().item(pos.x(), pos.y());
             if (item.x() < axisMinX || item.x() > axisMaxX
                     || item.z() < axisMinZ || item.z() > axisMaxZ) {
                 scene()->setSlicingActive(false);
@@ -480,6 +497,65 @@ void Surface3DController::handleRowsRemoved(int startIndex, int count)
     emitNeedRender();
 }
 
+void Surface3DController::handleRowsShifted(int count)
+{
+    QSurface3DSeries *series = static_cast<QSurfaceDataProxy *>(sender())->series();
+    if (series == m_selectedSeries && m_selectedPoint != invalidSelectionPosition()) {
+        // The selection moves down with its row, and is cleared if the row was shifted out
+        int selectedRow = m_selectedPoint.x() - count;
+        if (selectedRow < 0) {
+            setSelectedPoint(invalidSelectionPosition(), 0, false);
+        } else {
+            setSelectedPoint(QPoint(selectedRow, m_selectedPoint.y()), m_selectedSeries,
+                             false);
+        }
+    }
+
+    // Pending row and item changes refer to the rows before the shift
+    for (int i = m_changedRows.size() - 1; i >= 0; i--) {
+        ChangeRow &change = m_changedRows[i];
+        if (change.series == series) {
+            change.row -= count;
+            if (change.row < 0)
+                m_changedRows.removeAt(i);
+        }
+    }
+    for (int i = m_changedItems.size() - 1; i >= 0; i--) {
+        ChangeItem &change = m_changedItems[i];
+        if (change.series == series) {
+            change.point.rx() -= count;
+            if (change.point.x() < 0)
+                m_changedItems.removeAt(i);
+        }
+    }
+
+    if (series->isVisible()) {
+        adjustAxisRanges();
+        m_isDataDirty = true;
+        // The renderer can reuse the rows that are still there, unless the whole series is
+        // reloaded anyway
+        if (!m_changedSeriesList.contains(series)) {
+            bool newShift = true;
+            for (int i = 0; i < m_shiftedRows.size(); i++) {
+                if (m_shiftedRows.at(i).series == series) {
+                    m_shiftedRows[i].count += count;
+                    newShift = false;
+                    break;
+                }
+            }
+            if (newShift) {
+                ChangeShift shift = {series, count};
+                m_shiftedRows.append(shift);
+            }
+        }
+    } else if (!m_changedSeriesList.contains(series)) {
+        m_changedSeriesList.append(series);
+    }
+
+    series->d_ptr->markItemLabelDirty();
+    emitNeedRender();
+}
+
 void Surface3DController::updateSurfaceTexture(QSurface3DSeries *series)
 {
     m_changeTracker.surfaceTextureChanged = true;
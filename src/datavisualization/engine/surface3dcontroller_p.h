@@ -78,6 +78,10 @@ public:
         QSurface3DSeries *series;
         int row;
     };
+    struct ChangeShift {
+        QSurface3DSeries *series;
+        int count; // Rows removed from the start of the array and added to its end
+    };
 
 private:
     Surface3DChangeBitField m_changeTracker;
@@ -88,6 +92,7 @@ private:
     bool m_flatShadingSupported;
     QVector<ChangeItem> m_changedItems;
     QVector<ChangeRow> m_changedRows;
+    QVector<ChangeShift> m_shiftedRows;
     bool m_flipHorizontalGrid;
     QVector<QSurface3DSeries *> m_changedTextures;
 
@@ -130,6 +135,7 @@ public Q_SLOTS:
     void handleRowsRemoved(int startIndex, int count);
     void handleRowsInserted(int startIndex, int count);
     void handleItemChanged(int rowIndex, int columnIndex);
+    void handleRowsShifted(int count);
 
     void handleFlatShadingSupportedChange(bool supported);
 
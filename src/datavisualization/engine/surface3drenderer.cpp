@@ -35,6 +35,8 @@
 
 #include <QtCore/qmath.h>
 
+#include <float.h>
+
 static const int ID_TO_RGBA_MASK = 0xff;
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
@@ -60,6 +62,11 @@ Surface3DRenderer::Surface3DRenderer(Surface3DController *controller)
       m_surfaceSliceFlatShader(0),
       m_surfaceSliceSmoothShader(0),
       m_selectionShader(0),
+      m_surfaceHeightMapShader(0),
+      m_surfaceTexturedHeightMapShader(0),
+      m_heightMapDepthShader(0),
+      m_heightMapSelectionShader(0),
+      m_heightMapGridShader(0),
       m_heightNormalizer(0.0f),
       m_scaleX(0.0f),
       m_scaleY(0.0f),
@@ -70,6 +77,7 @@ Surface3DRenderer::Surface3DRenderer(Surface3DController *controller)
       m_selectionResultTexture(0),
       m_shadowQualityToShader(33.3f),
       m_flatSupported(true),
+      m_heightMapSupported(Utils::isVertexTextureSupported()),
       m_selectionActive(false),
       m_shadowQualityMultiplier(3),
       m_selectedPoint(Surface3DController::invalidSelectionPosition()),
@@ -106,6 +114,11 @@ Surface3DRenderer::~Surface3DRenderer()
     delete m_surfaceGridShader;
     delete m_surfaceSliceFlatShader;
     delete m_surfaceSliceSmoothShader;
+    delete m_surfaceHeightMapShader;
+    delete m_surfaceTexturedHeightMapShader;
+    delete m_heightMapDepthShader;
+    delete m_heightMapSelectionShader;
+    delete m_heightMapGridShader;
 }
 
 void Surface3DRenderer::contextCleanup()
@@ -204,17 +217,22 @@ void Surface3DRenderer::updateData()
         SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
         if (cache->isVisible() && cache->dataDirty()) {
             const QSurface3DSeries *currentSeries = cache->series();
-            QSurfaceDataProxy *dataProxy = currentSeries->dataProxy();
-            const QSurfaceDataArray &array = *dataProxy->array();
+            const QSurfaceDataProxyPrivate *dataProxy = currentSeries->dataProxy()->dptrc();
+            const SurfaceHeightGrid &heightGrid = dataProxy->m_heightGrid;
+            const SurfaceDataView array = dataProxy->dataView();
             QSurfaceDataArray &dataArray = cache->dataArray();
             QRect sampleSpace;
 
             // Need minimum of 2x2 array to draw a surface
-            if (array.size() >= 2 && array.at(0)->size() >= 2)
+            if (array.rowCount() >= 2 && array.columnCount() >= 2)
                 sampleSpace = calculateSampleRect(array);
 
+            const int rowShift = cache->rowShift();
+            cache->setRowShift(0);
+
             bool dimensionsChanged = false;
-            if (cache->sampleSpace() != sampleSpace) {
+            if (cache->sampleSpace() != sampleSpace
+                    || cache->heightGrid().isNull() != heightGrid.isNull()) {
                 if (sampleSpace.width() >= 2)
                     m_selectionTexturesDirty = true;
 
@@ -225,26 +243,42 @@ void Surface3DRenderer::updateData()
                     delete dataArray.at(i);
                 dataArray.clear();
             }
+            // Height grids are shared with the proxy instead of copied
+            cache->setHeightGrid(heightGrid);
 
             if (sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
-                if (dimensionsChanged) {
-                    dataArray.reserve(sampleSpace.height());
-                    for (int i = 0; i < sampleSpace.height(); i++)
-                        dataArray << new QSurfaceDataRow(sampleSpace.width());
-                }
-                for (int i = 0; i < sampleSpace.height(); i++) {
-                    for (int j = 0; j < sampleSpace.width(); j++) {
-                        (*(dataArray.at(i)))[j] = array.at(i + sampleSpace.y())->at(
-                                    j + sampleSpace.x());
+                // When the rows were shifted, the sample space holds the same rows as before
+                // except for the ones shifted in
+                const bool shifted = !dimensionsChanged && heightGrid.isNull()
+                        && rowShift > 0 && rowShift < sampleSpace.height();
+                if (heightGrid.isNull()) {
+                    const QSurfaceDataArray &srcArray = *dataProxy->m_dataArray;
+                    int firstRow = 0;
+                    if (dimensionsChanged) {
+                        dataArray.reserve(sampleSpace.height());
+                        for (int i = 0; i < sampleSpace.height(); i++)
+                            dataArray << new QSurfaceDataRow(sampleSpace.width());
+                    } else if (shifted) {
+                        for (int i = 0; i < rowShift; i++)
+                            dataArray.append(dataArray.takeFirst());
+                        firstRow = sampleSpace.height() - rowShift;
+                    }
+                    for (int i = firstRow; i < sampleSpace.height(); i++) {
+                        for (int j = 0; j < sampleSpace.width(); j++) {
+                            (*(dataArray.at(i)))[j] = srcArray.at(i + sampleSpace.y())->at(
+                                        j + sampleSpace.x());
+                        }
                     }
                 }
 
                 checkFlatSupport(cache);
-                updateObjects(cache, dimensionsChanged);
+                if (!shifted || !scrollObjects(cache, rowShift))
+                    updateObjects(cache, dimensionsChanged);
                 cache->setFlatStatusDirty(false);
             } else {
                 cache->surfaceObject()->clear();
             }
+            cache->setPickMipmapDirty(true);
             cache->setDataDirty(false);
         }
     }
@@ -316,8 +350,7 @@ void Surface3DRenderer::updateSurfaceTextures(QVector<QSurface3DSeries *> series
             cache->setSurfaceTexture(0);
 
             const QSurface3DSeries *currentSeries = cache->series();
-            QSurfaceDataProxy *dataProxy = currentSeries->dataProxy();
-            const QSurfaceDataArray &array = *dataProxy->array();
+            const SurfaceDataView array = currentSeries->dataProxy()->dptrc()->dataView();
 
             if (!series->texture().isNull()) {
                 GLuint texId = m_textureHelper->create2DTexture(series->texture(),
@@ -328,9 +361,9 @@ void Surface3DRenderer::updateSurfaceTextures(QVector<QSurface3DSeries *> series
                 cache->setSurfaceTexture(texId);
 
                 if (cache->isFlatShadingEnabled())
-                    cache->surfaceObject()->coarseUVs(array, cache->dataArray());
+                    cache->surfaceObject()->coarseUVs(array, cache->dataView());
                 else
-                    cache->surfaceObject()->smoothUVs(array, cache->dataArray());
+                    cache->surfaceObject()->smoothUVs(array, cache->dataView());
             }
         }
     }
@@ -361,8 +394,11 @@ void Surface3DRenderer::updateRows(const QVector<Surface3DController::ChangeRow>
         if (dataProxy)
             srcArray = dataProxy->array();
 
-        if (cache && srcArray->size() >= 2 && srcArray->at(0)->size() >= 2 &&
-                sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
+        // Height grids are converted to items before they are changed, so a cache that still
+        // has one is waiting for the reset
+        if (cache && cache->heightGrid().isNull()
+                && srcArray->size() >= 2 && srcArray->at(0)->size() >= 2
+                && sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
             bool updateBuffers = false;
             int sampleSpaceTop = sampleSpace.y() + sampleSpace.height();
             int row = item.row;
@@ -381,8 +417,10 @@ void Surface3DRenderer::updateRows(const QVector<Surface3DController::ChangeRow>
                                                             m_polarGraph);
                 }
             }
-            if (updateBuffers)
+            if (updateBuffers) {
                 cache->surfaceObject()->uploadBuffers();
+                cache->setPickMipmapDirty(true);
+            }
         }
     }
 
@@ -402,8 +440,11 @@ void Surface3DRenderer::updateItems(const QVector<Surface3DController::ChangeIte
         if (dataProxy)
             srcArray = dataProxy->array();
 
-        if (cache && srcArray->size() >= 2 && srcArray->at(0)->size() >= 2 &&
-                sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
+        // Height grids are converted to items before they are changed, so a cache that still
+        // has one is waiting for the reset
+        if (cache && cache->heightGrid().isNull()
+                && srcArray->size() >= 2 && srcArray->at(0)->size() >= 2
+                && sampleSpace.width() >= 2 && sampleSpace.height() >= 2) {
             int sampleSpaceTop = sampleSpace.y() + sampleSpace.height();
             int sampleSpaceRight = sampleSpace.x() + sampleSpace.width();
             bool updateBuffers = false;
@@ -422,8 +463,10 @@ void Surface3DRenderer::updateItems(const QVector<Surface3DController::ChangeIte
                 else
                     cache->surfaceObject()->updateSmoothItem(dstArray, y, x, m_polarGraph);
             }
-            if (updateBuffers)
+            if (updateBuffers) {
                 cache->surfaceObject()->uploadBuffers();
+                cache->setPickMipmapDirty(true);
+            }
         }
 
     }
@@ -431,6 +474,19 @@ void Surface3DRenderer::updateItems(const QVector<Surface3DController::ChangeIte
     updateSelectedPoint(m_selectedPoint, m_selectedSeries);
 }
 
+void Surface3DRenderer::updateShiftedRows(const QVector<Surface3DController::ChangeShift> &shifts)
+{
+    foreach (const Surface3DController::ChangeShift &shift, shifts) {
+        SurfaceSeriesRenderCache *cache =
+                static_cast<SurfaceSeriesRenderCache *>(m_renderCacheList.value(shift.series));
+        // Caches that are out of date get all rows anyway
+        if (cache && cache->isVisible() && !cache->dataDirty()) {
+            cache->setRowShift(cache->rowShift() + shift.count);
+            cache->setDataDirty(true);
+        }
+    }
+}
+
 void Surface3DRenderer::updateSliceDataModel(const QPoint &point)
 {
     foreach (SeriesRenderCache *baseCache, m_renderCacheList)
@@ -440,9 +496,9 @@ void Surface3DRenderer::updateSliceDataModel(const QPoint &point)
         // Find axis coordinates for the selected point
         SeriesRenderCache *selectedCache =
                 m_renderCacheList.value(const_cast<QSurface3DSeries *>(m_selectedSeries));
-        QSurfaceDataArray &dataArray =
-                static_cast<SurfaceSeriesRenderCache *>(selectedCache)->dataArray();
-        QSurfaceDataItem item = dataArray.at(point.x())->at(point.y());
+        const SurfaceDataView dataArray =
+                static_cast<SurfaceSeriesRenderCache *>(selectedCache)->dataView();
+        QSurfaceDataItem item = dataArray.item(point.x(), point.y());
         QPointF coords(item.x(), item.z());
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
@@ -470,11 +526,11 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
 {
     QPoint point(-1, -1);
 
-    QSurfaceDataArray &dataArray = cache->dataArray();
-    int top = dataArray.size() - 1;
-    int right = dataArray.at(top)->size() - 1;
-    QSurfaceDataItem itemBottomLeft = dataArray.at(0)->at(0);
-    QSurfaceDataItem itemTopRight = dataArray.at(top)->at(right);
+    const SurfaceDataView dataArray = cache->dataView();
+    int top = dataArray.rowCount() - 1;
+    int right = dataArray.columnCount() - 1;
+    QSurfaceDataItem itemBottomLeft = dataArray.item(0, 0);
+    QSurfaceDataItem itemTopRight = dataArray.item(top, right);
 
     if (itemBottomLeft.x() <= coords.x() && itemTopRight.x() >= coords.x()) {
         float modelX = coords.x() - itemBottomLeft.x();
@@ -482,7 +538,7 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
         float stepX = spanX / float(right);
         int sampleX = int((modelX + (stepX / 2.0f)) / stepX);
 
-        QSurfaceDataItem item = dataArray.at(0)->at(sampleX);
+        QSurfaceDataItem item = dataArray.item(0, sampleX);
         if (!::qFuzzyCompare(float(coords.x()), item.x())) {
             int direction = 1;
             if (item.x() > coords.x())
@@ -501,7 +557,7 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
         float stepY = spanY / float(top);
         int sampleY = int((modelY + (stepY / 2.0f)) / stepY);
 
-        QSurfaceDataItem item = dataArray.at(sampleY)->at(0);
+        QSurfaceDataItem item = dataArray.item(sampleY, 0);
         if (!::qFuzzyCompare(float(coords.y()), item.z())) {
             int direction = 1;
             if (item.z() > coords.y())
@@ -518,14 +574,14 @@ QPoint Surface3DRenderer::mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache
 }
 
 void Surface3DRenderer::findMatchingRow(float z, int &sample, int direction,
-                                        QSurfaceDataArray &dataArray)
+                                        const SurfaceDataView &dataArray)
 {
-    int maxZ = dataArray.size() - 1;
-    QSurfaceDataItem item = dataArray.at(sample)->at(0);
+    int maxZ = dataArray.rowCount() - 1;
+    QSurfaceDataItem item = dataArray.item(sample, 0);
     float distance = qAbs(z - item.z());
     int newSample = sample + direction;
     while (newSample >= 0 && newSample <= maxZ) {
-        item = dataArray.at(newSample)->at(0);
+        item = dataArray.item(newSample, 0);
         float newDist = qAbs(z - item.z());
         if (newDist < distance) {
             sample = newSample;
@@ -538,14 +594,14 @@ void Surface3DRenderer::findMatchingRow(float z, int &sample, int direction,
 }
 
 void Surface3DRenderer::findMatchingColumn(float x, int &sample, int direction,
-                                           QSurfaceDataArray &dataArray)
+                                           const SurfaceDataView &dataArray)
 {
-    int maxX = dataArray.at(0)->size() - 1;
-    QSurfaceDataItem item = dataArray.at(0)->at(sample);
+    int maxX = dataArray.columnCount() - 1;
+    QSurfaceDataItem item = dataArray.item(0, sample);
     float distance = qAbs(x - item.x());
     int newSample = sample + direction;
     while (newSample >= 0 && newSample <= maxX) {
-        item = dataArray.at(0)->at(newSample);
+        item = dataArray.item(0, newSample);
         float newDist = qAbs(x - item.x());
         if (newDist < distance) {
             sample = newSample;
@@ -575,19 +631,20 @@ void Surface3DRenderer::updateSliceObject(SurfaceSeriesRenderCache *cache, const
     sliceDataArray.reserve(2);
 
     QSurfaceDataRow *sliceRow;
-    QSurfaceDataArray &dataArray = cache->dataArray();
+    const SurfaceDataView dataArray = cache->dataView();
     float adjust = (0.025f * m_heightNormalizer) / 2.0f;
     float doubleAdjust = 2.0f * adjust;
     bool flipZX = false;
     float zBack;
     float zFront;
     if (m_cachedSelectionMode.testFlag(QAbstract3DGraph::SelectionRow)) {
-        QSurfaceDataRow *src = dataArray.at(row);
-        sliceRow = new QSurfaceDataRow(src->size());
+        sliceRow = new QSurfaceDataRow(dataArray.columnCount());
         zBack = m_axisCacheZ.min();
         zFront = m_axisCacheZ.max();
-        for (int i = 0; i < sliceRow->size(); i++)
-            (*sliceRow)[i].setPosition(QVector3D(src->at(i).x(), src->at(i).y() + adjust, zFront));
+        for (int i = 0; i < sliceRow->size(); i++) {
+            const QSurfaceDataItem item = dataArray.item(row, i);
+            (*sliceRow)[i].setPosition(QVector3D(item.x(), item.y() + adjust, zFront));
+        }
     } else {
         flipZX = true;
         const QRect &sampleSpace = cache->sampleSpace();
@@ -595,9 +652,8 @@ void Surface3DRenderer::updateSliceObject(SurfaceSeriesRenderCache *cache, const
         zBack = m_axisCacheX.min();
         zFront = m_axisCacheX.max();
         for (int i = 0; i < sampleSpace.height(); i++) {
-            (*sliceRow)[i].setPosition(QVector3D(dataArray.at(i)->at(column).z(),
-                                                 dataArray.at(i)->at(column).y() + adjust,
-                                                 zFront));
+            const QSurfaceDataItem item = dataArray.item(i, column);
+            (*sliceRow)[i].setPosition(QVector3D(item.z(), item.y() + adjust, zFront));
         }
     }
     sliceDataArray << sliceRow;
@@ -622,15 +678,15 @@ void Surface3DRenderer::updateSliceObject(SurfaceSeriesRenderCache *cache, const
     }
 }
 
-inline static float getDataValue(const QSurfaceDataArray &array, bool searchRow, int index)
+inline static float getDataValue(const SurfaceDataView &array, bool searchRow, int index)
 {
     if (searchRow)
-        return array.at(0)->at(index).x();
+        return array.item(0, index).x();
     else
-        return array.at(index)->at(0).z();
+        return array.item(index, 0).z();
 }
 
-inline static int binarySearchArray(const QSurfaceDataArray &array, int maxIdx, float limitValue,
+inline static int binarySearchArray(const SurfaceDataView &array, int maxIdx, float limitValue,
                                     bool searchRow, bool lowBound, bool ascending)
 {
     int min = 0;
@@ -680,17 +736,17 @@ inline static int binarySearchArray(const QSurfaceDataArray &array, int maxIdx,
     return retVal;
 }
 
-QRect Surface3DRenderer::calculateSampleRect(const QSurfaceDataArray &array)
+QRect Surface3DRenderer::calculateSampleRect(const SurfaceDataView &array)
 {
     QRect sampleSpace;
 
-    const int maxRow = array.size() - 1;
-    const int maxColumn = array.at(0)->size() - 1;
+    const int maxRow = array.rowCount() - 1;
+    const int maxColumn = array.columnCount() - 1;
 
     // We assume data is ordered sequentially in rows for X-value and in columns for Z-value.
     // Determine if data is ascending or descending in each case.
-    const bool ascendingX = array.at(0)->at(0).x() < array.at(0)->at(maxColumn).x();
-    const bool ascendingZ = array.at(0)->at(0).z() < array.at(maxRow)->at(0).z();
+    const bool ascendingX = array.item(0, 0).x() < array.item(0, maxColumn).x();
+    const bool ascendingZ = array.item(0, 0).z() < array.item(maxRow, 0).z();
 
     int idx = binarySearchArray(array, maxColumn, m_axisCacheX.min(), true, true, ascendingX);
     if (idx != -1) {
@@ -763,6 +819,17 @@ void Surface3DRenderer::render(GLuint defaultFboHandle)
     if (m_axisCacheZ.positionsDirty())
         m_axisCacheZ.updateAllPositions();
 
+    // Large surface loads are uploaded over several frames, drawing the old surface until
+    // they swap
+    bool uploading = false;
+    for (SeriesRenderCache *baseCache: m_renderCacheList) {
+        SurfaceObject *object = static_cast<SurfaceSeriesRenderCache *>(baseCache)->surfaceObject();
+        if (object->hasPendingUpload())
+            uploading |= !object->uploadPending();
+    }
+    if (uploading)
+        emit needRender();
+
     drawScene(defaultFboHandle);
     if (m_cachedIsSlicingActivated)
         drawSlicedScene();
@@ -1125,13 +1192,18 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
     QMatrix4x4 projectionMatrix;
     GLfloat viewPortRatio = (GLfloat)m_primarySubViewport.width()
             / (GLfloat)m_primarySubViewport.height();
+    // Pixels per view space unit, at unit distance for perspective projection
+    float pixelsPerUnit;
     if (m_useOrthoProjection) {
         GLfloat orthoRatio = 2.0f;
         projectionMatrix.ortho(-viewPortRatio * orthoRatio, viewPortRatio * orthoRatio,
                                -orthoRatio, orthoRatio,
                                0.0f, 100.0f);
+        pixelsPerUnit = float(m_primarySubViewport.height()) / (2.0f * orthoRatio);
     } else {
         projectionMatrix.perspective(45.0f, viewPortRatio, 0.1f, 100.0f);
+        pixelsPerUnit = float(m_primarySubViewport.height())
+                / (2.0f * float(qTan(qDegreesToRadians(22.5))));
     }
 
     const Q3DCamera *activeCamera = m_cachedScene->activeCamera();
@@ -1141,6 +1213,21 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
 
     QMatrix4x4 projectionViewMatrix = projectionMatrix * viewMatrix;
 
+    // Select the detail levels of large surfaces for the view, for all passes. Orthographic
+    // projection doesn't shrink distant tiles, but the zoom of the view matrix scales them all.
+    if (m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationLevelOfDetail)) {
+        const QVector3D eyePosition = viewMatrix.inverted().map(zeroVector);
+        if (m_useOrthoProjection)
+            pixelsPerUnit *= viewMatrix.column(0).toVector3D().length();
+        foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+            SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
+            if (cache->isVisible() && cache->surfaceObject()->hasDetailLevels()) {
+                cache->surfaceObject()->selectDetailLevels(eyePosition, pixelsPerUnit,
+                                                           !m_useOrthoProjection);
+            }
+        }
+    }
+
     // Calculate flipping indicators
     if (viewMatrix.row(0).x() > 0)
         m_zFlipped = false;
@@ -1222,21 +1309,36 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
             SurfaceObject *object = cache->surfaceObject();
             if (object->indexCount() && cache->surfaceVisible() && cache->isVisible()
                     && cache->sampleSpace().width() >= 2 && cache->sampleSpace().height() >= 2) {
-                // No translation nor scaling for surfaces, therefore no modelMatrix
-                // Use directly projectionViewMatrix
-                m_depthShader->setUniformValue(m_depthShader->MVP(), depthProjectionViewMatrix);
+                ShaderHelper *depthShader = m_depthShader;
+                if (object->isHeightMapped()) {
+                    depthShader = m_heightMapDepthShader;
+                    depthShader->bind();
+                    m_drawer->bindHeightMap(depthShader, object);
+                }
+
+                // No scaling for surfaces, only the translation of scrolled surfaces
+                QMatrix4x4 modelMatrix;
+                modelMatrix.translate(object->scrollTranslation());
+                depthShader->setUniformValue(depthShader->MVP(),
+                                             depthProjectionViewMatrix * modelMatrix);
 
                 // 1st attribute buffer : vertices
-                glEnableVertexAttribArray(m_depthShader->posAtt());
+                glEnableVertexAttribArray(depthShader->posAtt());
                 glBindBuffer(GL_ARRAY_BUFFER, object->vertexBuf());
-                glVertexAttribPointer(m_depthShader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0,
-                                      (void *)0);
+                glVertexAttribPointer(depthShader->posAtt(), 3, GL_FLOAT, GL_FALSE, 0,
+                                      (void *)object->vertexOffset());
 
                 // Index buffer
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object->elementBuf());
 
                 // Draw the triangles
-                glDrawElements(GL_TRIANGLES, object->indexCount(), GL_UNSIGNED_INT, (void *)0);
+                object->drawElements();
+
+                if (object->isHeightMapped()) {
+                    glDisableVertexAttribArray(depthShader->posAtt());
+                    m_drawer->releaseHeightMap();
+                    m_depthShader->bind();
+                }
             }
         }
 
@@ -1275,12 +1377,25 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
         emit needRender();
     }
 
-    // Draw selection buffer
-    if (!m_cachedIsSlicingActivated && (!m_renderCacheList.isEmpty()
-                                        || !m_customRenderCache.isEmpty())
+    // Surfaces, custom items and labels are picked on CPU when so hinted, without the selection
+    // buffer
+    const bool cpuPicking =
+            m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationCpuPicking);
+
+    if (cpuPicking && !m_cachedIsSlicingActivated && (!m_renderCacheList.isEmpty()
+                                                      || !m_customRenderCache.isEmpty())
+            && m_selectionState == SelectOnScene
+            && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone) {
+        pickSurface(projectionViewMatrix, viewMatrix, projectionMatrix, activeCamera);
+        m_clickResolved = true;
+
+        emit needRender();
+    } else if (!cpuPicking && !m_cachedIsSlicingActivated && (!m_renderCacheList.isEmpty()
+                                                             || !m_customRenderCache.isEmpty())
             && m_selectionState == SelectOnScene
             && m_cachedSelectionMode > QAbstract3DGraph::SelectionNone
             && m_selectionResultTexture) {
+        // Draw selection buffer
         m_selectionShader->bind();
         glBindFramebuffer(GL_FRAMEBUFFER, m_selectionFrameBuffer);
         glViewport(0,
@@ -1297,13 +1412,28 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
             SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
-            if (cache->surfaceObject()->indexCount() && cache->renderable()) {
-                m_selectionShader->setUniformValue(m_selectionShader->MVP(), projectionViewMatrix);
+            SurfaceObject *object = cache->surfaceObject();
+            if (object->indexCount() && cache->renderable()) {
+                ShaderHelper *selectionShader = m_selectionShader;
+                if (object->isHeightMapped()) {
+                    selectionShader = m_heightMapSelectionShader;
+                    selectionShader->bind();
+                    m_drawer->bindHeightMap(selectionShader, object);
+                }
+
+                QMatrix4x4 modelMatrix;
+                modelMatrix.translate(object->scrollTranslation());
+                selectionShader->setUniformValue(selectionShader->MVP(),
+                                                 projectionViewMatrix * modelMatrix);
+
+                object->activateSurfaceTexture(false);
 
-                cache->surfaceObject()->activateSurfaceTexture(false);
+                m_drawer->drawObject(selectionShader, object, cache->selectionTexture());
 
-                m_drawer->drawObject(m_selectionShader, cache->surfaceObject(),
-                                     cache->selectionTexture());
+                if (object->isHeightMapped()) {
+                    m_drawer->releaseHeightMap();
+                    m_selectionShader->bind();
+                }
             }
         }
         m_surfaceGridShader->bind();
@@ -1349,7 +1479,7 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                 int x = m_selectedPoint.x() - sampleSpace.y();
                 int y = m_selectedPoint.y() - sampleSpace.x();
                 if (x >= 0 && y >= 0 && x < sampleSpace.height() && y < sampleSpace.width()
-                        && cache->dataArray().size()) {
+                        && cache->dataView().rowCount()) {
                     visiblePoint = QPoint(x, y);
                 }
             }
@@ -1382,10 +1512,11 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
             QMatrix4x4 MVPMatrix;
             QMatrix4x4 itModelMatrix;
 
+            modelMatrix.translate(cache->surfaceObject()->scrollTranslation());
 #ifdef SHOW_DEPTH_TEXTURE_SCENE
-            MVPMatrix = depthProjectionViewMatrix;
+            MVPMatrix = depthProjectionViewMatrix * modelMatrix;
 #else
-            MVPMatrix = projectionViewMatrix;
+            MVPMatrix = projectionViewMatrix * modelMatrix;
 #endif
             cache->setMVPMatrix(MVPMatrix);
 
@@ -1403,12 +1534,18 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                     ShaderHelper *shader = m_surfaceFlatShader;
                     if (cache->surfaceTexture())
                         shader = m_surfaceTexturedFlatShader;
-                    if (!cache->isFlatShadingEnabled()) {
+                    if (cache->surfaceObject()->isHeightMapped()) {
+                        shader = m_surfaceHeightMapShader;
+                        if (cache->surfaceTexture())
+                            shader = m_surfaceTexturedHeightMapShader;
+                    } else if (!cache->isFlatShadingEnabled()) {
                         shader = m_surfaceSmoothShader;
                         if (cache->surfaceTexture())
                             shader = m_surfaceTexturedSmoothShader;
                     }
                     shader->bind();
+                    if (cache->surfaceObject()->isHeightMapped())
+                        m_drawer->bindHeightMap(shader, cache->surfaceObject());
 
                     // Set shader bindings
                     shader->setUniformValue(shader->lightP(), lightPos);
@@ -1465,6 +1602,8 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
                         // Draw the objects
                         m_drawer->drawObject(shader, cache->surfaceObject(), texture);
                     }
+                    if (cache->surfaceObject()->isHeightMapped())
+                        m_drawer->releaseHeightMap();
                 }
             }
         }
@@ -1473,21 +1612,32 @@ void Surface3DRenderer::drawScene(GLuint defaultFboHandle)
         // Draw surface grid
         if (drawGrid) {
             glDisable(GL_POLYGON_OFFSET_FILL);
+            const QVector4D gridLineColor = Utils::vectorFromColor(m_cachedTheme->gridLineColor());
             m_surfaceGridShader->bind();
-            m_surfaceGridShader->setUniformValue(m_surfaceGridShader->color(),
-                                                 Utils::vectorFromColor(
-                                                     m_cachedTheme->gridLineColor()));
+            m_surfaceGridShader->setUniformValue(m_surfaceGridShader->color(), gridLineColor);
             foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
                 SurfaceSeriesRenderCache *cache =
                         static_cast<SurfaceSeriesRenderCache *>(baseCache);
-                m_surfaceGridShader->setUniformValue(m_surfaceGridShader->MVP(),
-                                                     cache->MVPMatrix());
-
+                SurfaceObject *object = cache->surfaceObject();
                 const QRect &sampleSpace = cache->sampleSpace();
-                if (cache->surfaceObject()->indexCount() && cache->surfaceGridVisible()
+                if (object->indexCount() && cache->surfaceGridVisible()
                         && cache->isVisible() && sampleSpace.width() >= 2
                         && sampleSpace.height() >= 2) {
-                    m_drawer->drawSurfaceGrid(m_surfaceGridShader, cache->surfaceObject());
+                    ShaderHelper *gridShader = m_surfaceGridShader;
+                    if (object->isHeightMapped()) {
+                        gridShader = m_heightMapGridShader;
+                        gridShader->bind();
+                        gridShader->setUniformValue(gridShader->color(), gridLineColor);
+                        m_drawer->bindHeightMap(gridShader, object);
+                    }
+
+                    gridShader->setUniformValue(gridShader->MVP(), cache->MVPMatrix());
+                    m_drawer->drawSurfaceGrid(gridShader, object);
+
+                    if (object->isHeightMapped()) {
+                        m_drawer->releaseHeightMap();
+                        m_surfaceGridShader->bind();
+                    }
                 }
             }
         }
@@ -2093,7 +2243,7 @@ void Surface3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
             if (drawSelection) {
                 QVector4D labelColor = QVector4D(label / 255.0f, 0.0f, 0.0f,
                                                  alphaForRowSelection);
-                shader->setUniformValue(shader->color(), labelColor);
+                setLabelSelectionColor(shader, labelColor);
             }
 
             m_drawer->drawLabel(m_dummyRenderItem, axisLabelItem, viewMatrix, projectionMatrix,
@@ -2286,7 +2436,7 @@ void Surface3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
             if (drawSelection) {
                 QVector4D labelColor = QVector4D(0.0f, label / 255.0f, 0.0f,
                                                  alphaForColumnSelection);
-                shader->setUniformValue(shader->color(), labelColor);
+                setLabelSelectionColor(shader, labelColor);
             }
 
             m_drawer->drawLabel(m_dummyRenderItem, axisLabelItem, viewMatrix, projectionMatrix,
@@ -2391,7 +2541,7 @@ void Surface3DRenderer::drawLabels(bool drawSelection, const Q3DCamera *activeCa
             if (drawSelection) {
                 QVector4D labelColor = QVector4D(0.0f, 0.0f, label / 255.0f,
                                                  alphaForValueSelection);
-                shader->setUniformValue(shader->color(), labelColor);
+                setLabelSelectionColor(shader, labelColor);
             }
 
             if (label == startIndex) {
@@ -2451,6 +2601,29 @@ void Surface3DRenderer::updateSelectionMode(QAbstract3DGraph::SelectionFlags mod
         updateSelectionTextures();
 }
 
+void Surface3DRenderer::updateOptimizationHint(QAbstract3DGraph::OptimizationHints hint)
+{
+    const bool levelOfDetailChanged =
+            (m_cachedOptimizationHint ^ hint).testFlag(QAbstract3DGraph::OptimizationLevelOfDetail);
+
+    // Marks all caches dirty, so the surfaces are set up again
+    Abstract3DRenderer::updateOptimizationHint(hint);
+
+    // The surfaces create or drop their detail tiles when set up, and must not be scrolled
+    // instead, which would keep the old tiles and their selection
+    if (levelOfDetailChanged) {
+        const bool levelOfDetail = hint.testFlag(QAbstract3DGraph::OptimizationLevelOfDetail);
+        foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+            SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
+            cache->surfaceObject()->setLevelOfDetail(levelOfDetail);
+            cache->setRowShift(0);
+        }
+    }
+
+    // Selection textures are only needed when not picking on CPU
+    m_selectionTexturesDirty = true;
+}
+
 void Surface3DRenderer::updateSelectionTextures()
 {
     uint lastSelectionId = 1;
@@ -2475,7 +2648,8 @@ void Surface3DRenderer::createSelectionTexture(SurfaceSeriesRenderCache *cache,
     int idImageWidth = (sampleSpace.width() - 1) * 2;
     int idImageHeight = (sampleSpace.height() - 1) * 2;
 
-    if (idImageHeight <= 0 || idImageWidth <= 0) {
+    if (idImageHeight <= 0 || idImageWidth <= 0
+            || m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationCpuPicking)) {
         cache->setSelectionIdRange(~0U, ~0U);
         cache->setSelectionTexture(0);
         return;
@@ -2620,25 +2794,54 @@ void Surface3DRenderer::checkFlatSupport(SurfaceSeriesRenderCache *cache)
 
 void Surface3DRenderer::updateObjects(SurfaceSeriesRenderCache *cache, bool dimensionChanged)
 {
-    QSurfaceDataArray &dataArray = cache->dataArray();
+    const SurfaceDataView dataArray = cache->dataView();
     const QRect &sampleSpace = cache->sampleSpace();
 
     const QSurface3DSeries *currentSeries = cache->series();
-    QSurfaceDataProxy *dataProxy = currentSeries->dataProxy();
-    const QSurfaceDataArray &array = *dataProxy->array();
+    const SurfaceDataView array = currentSeries->dataProxy()->dptrc()->dataView();
 
     if (cache->isFlatShadingEnabled()) {
         cache->surfaceObject()->setUpData(dataArray, sampleSpace, dimensionChanged, m_polarGraph);
         if (cache->surfaceTexture())
             cache->surfaceObject()->coarseUVs(array, dataArray);
     } else {
-        cache->surfaceObject()->setUpSmoothData(dataArray, sampleSpace, dimensionChanged,
-                                                m_polarGraph);
+        const bool levelOfDetail =
+                m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationLevelOfDetail);
+        cache->surfaceObject()->setLevelOfDetail(levelOfDetail);
+        if (!useHeightMap(cache) || !cache->surfaceObject()->setUpHeightMapData(
+                    cache->heightGrid(), sampleSpace, dimensionChanged)) {
+            cache->surfaceObject()->setUpSmoothData(dataArray, sampleSpace, dimensionChanged,
+                                                    m_polarGraph);
+        }
         if (cache->surfaceTexture())
             cache->surfaceObject()->smoothUVs(array, dataArray);
     }
 }
 
+// Scrolls the surface of a cache whose data array was shifted by rowShift rows, instead of
+// setting it up again. Returns false if the surface can't be scrolled.
+bool Surface3DRenderer::scrollObjects(SurfaceSeriesRenderCache *cache, int rowShift)
+{
+    if (cache->isFlatShadingEnabled() || m_polarGraph || cache->surfaceObject()->isHeightMapped()
+            || !cache->surfaceObject()->scrollSmoothRows(cache->dataView(), rowShift)) {
+        return false;
+    }
+
+    if (cache->surfaceTexture()) {
+        const SurfaceDataView array = cache->series()->dataProxy()->dptrc()->dataView();
+        cache->surfaceObject()->smoothUVs(array, cache->dataView());
+    }
+    return true;
+}
+
+// Smooth surfaces of height grids can be generated in the vertex shader, which samples the
+// heights from a texture. Polar graphs don't map the grid linearly, so they can't.
+bool Surface3DRenderer::useHeightMap(const SurfaceSeriesRenderCache *cache) const
+{
+    return m_heightMapSupported && !m_polarGraph && !cache->heightGrid().isNull()
+            && m_cachedOptimizationHint.testFlag(QAbstract3DGraph::OptimizationGpuSurface);
+}
+
 void Surface3DRenderer::updateSelectedPoint(const QPoint &position, QSurface3DSeries *series)
 {
     m_selectedPoint = position;
@@ -2677,8 +2880,7 @@ void Surface3DRenderer::surfacePointSelected(const QPoint &point)
         SurfaceSeriesRenderCache *selectedCache =
                 static_cast<SurfaceSeriesRenderCache *>(
                     m_renderCacheList.value(const_cast<QSurface3DSeries *>(m_selectedSeries)));
-        QSurfaceDataArray &dataArray = selectedCache->dataArray();
-        QSurfaceDataItem item = dataArray.at(point.x())->at(point.y());
+        QSurfaceDataItem item = selectedCache->dataView().item(point.x(), point.y());
         QPointF coords(item.x(), item.z());
 
         foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
@@ -2814,6 +3016,62 @@ QPoint Surface3DRenderer::selectionIdToSurfacePoint(uint id)
     return QPoint(row, column);
 }
 
+// Casts a ray from the camera through the selection query position and resolves what it hits
+// first. Surfaces are tested using the min/max mipmaps of the series, which resolve the data
+// point nearest to the hit, and custom items and labels are tested against their bounds.
+// Nothing is selected if the ray misses.
+void Surface3DRenderer::pickSurface(const QMatrix4x4 &projectionViewMatrix,
+                                    const QMatrix4x4 &viewMatrix,
+                                    const QMatrix4x4 &projectionMatrix,
+                                    const Q3DCamera *activeCamera)
+{
+    QVector3D rayOrigin;
+    QVector3D rayDirection;
+    selectionRay(projectionViewMatrix, rayOrigin, rayDirection);
+
+    float nearestDistance = FLT_MAX;
+    QPoint nearestPoint;
+    SurfaceSeriesRenderCache *nearestCache = 0;
+    foreach (SeriesRenderCache *baseCache, m_renderCacheList) {
+        SurfaceSeriesRenderCache *cache = static_cast<SurfaceSeriesRenderCache *>(baseCache);
+        SurfaceObject *object = cache->surfaceObject();
+        if (!object->indexCount() || !cache->renderable())
+            continue;
+
+        // Surfaces are drawn without a model transformation, except for the translation of
+        // scrolled surfaces, which vertexAt() includes
+        QPoint point;
+        float distance;
+        if (cache->pickMipmap().pick(object, rayOrigin, rayDirection, point, distance)
+                && distance < nearestDistance) {
+            nearestDistance = distance;
+            nearestPoint = point;
+            nearestCache = cache;
+        }
+    }
+
+    QVector4D color;
+    if (pickCustomItemsAndLabels(rayOrigin, rayDirection, activeCamera, viewMatrix,
+                                 projectionMatrix, m_surfaceGridShader, nearestDistance, color)) {
+        const uint selectionId = uint(color.x())
+                + uint(color.y()) * greenMultiplier
+                + uint(color.z()) * blueMultiplier
+                + uint(color.w()) * alphaMultiplier;
+        m_clickedPosition = selectionIdToSurfacePoint(selectionId);
+    } else if (nearestCache) {
+        const QRect &sampleSpace = nearestCache->sampleSpace();
+        m_clickedPosition = QPoint(nearestPoint.x() + sampleSpace.y(),
+                                   nearestPoint.y() + sampleSpace.x());
+        m_clickedSeries = nearestCache->series();
+        m_clickedType = QAbstract3DGraph::ElementSeries;
+        m_selectedLabelIndex = -1;
+        m_selectedCustomItemIndex = -1;
+    } else {
+        // Zero is the selection id of the background
+        m_clickedPosition = selectionIdToSurfacePoint(0);
+    }
+}
+
 void Surface3DRenderer::updateShadowQuality(QAbstract3DGraph::ShadowQuality quality)
 {
     m_cachedShadowQuality = quality;
@@ -2954,6 +3212,31 @@ void Surface3DRenderer::initShaders(const QString &vertexShader, const QString &
         m_surfaceSliceFlatShader->initialize();
         m_surfaceTexturedFlatShader->initialize();
     }
+
+    delete m_surfaceHeightMapShader;
+    delete m_surfaceTexturedHeightMapShader;
+    m_surfaceHeightMapShader = 0;
+    m_surfaceTexturedHeightMapShader = 0;
+    if (m_heightMapSupported) {
+        if (m_isOpenGLES) {
+            m_surfaceHeightMapShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                        QStringLiteral(":/shaders/fragmentSurfaceES2"));
+            m_surfaceTexturedHeightMapShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                                QStringLiteral(":/shaders/fragmentTextureES2"));
+        } else if (m_cachedShadowQuality > QAbstract3DGraph::ShadowQualityNone) {
+            m_surfaceHeightMapShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMapShadow"),
+                                                        QStringLiteral(":/shaders/fragmentSurfaceShadowNoTex"));
+            m_surfaceTexturedHeightMapShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMapShadow"),
+                                                                QStringLiteral(":/shaders/fragmentTexturedSurfaceShadow"));
+        } else {
+            m_surfaceHeightMapShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                        QStringLiteral(":/shaders/fragmentSurface"));
+            m_surfaceTexturedHeightMapShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                                QStringLiteral(":/shaders/fragmentTexture"));
+        }
+        m_surfaceHeightMapShader->initialize();
+        m_surfaceTexturedHeightMapShader->initialize();
+    }
 }
 
 void Surface3DRenderer::initBackgroundShaders(const QString &vertexShader,
@@ -2972,6 +3255,13 @@ void Surface3DRenderer::initSelectionShaders()
     m_selectionShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexLabel"),
                                          QStringLiteral(":/shaders/fragmentLabel"));
     m_selectionShader->initialize();
+
+    if (m_heightMapSupported) {
+        delete m_heightMapSelectionShader;
+        m_heightMapSelectionShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                      QStringLiteral(":/shaders/fragmentLabel"));
+        m_heightMapSelectionShader->initialize();
+    }
 }
 
 void Surface3DRenderer::initSurfaceShaders()
@@ -2983,6 +3273,13 @@ void Surface3DRenderer::initSurfaceShaders()
                                            QStringLiteral(":/shaders/fragmentPlainColor"));
     m_surfaceGridShader->initialize();
 
+    if (m_heightMapSupported) {
+        delete m_heightMapGridShader;
+        m_heightMapGridShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                 QStringLiteral(":/shaders/fragmentPlainColor"));
+        m_heightMapGridShader->initialize();
+    }
+
     // Triggers surface shader selection by shadow setting
     handleShadowQualityChange();
 }
@@ -2994,6 +3291,13 @@ void Surface3DRenderer::initDepthShader()
         m_depthShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexDepth"),
                                          QStringLiteral(":/shaders/fragmentDepth"));
         m_depthShader->initialize();
+
+        if (m_heightMapSupported) {
+            delete m_heightMapDepthShader;
+            m_heightMapDepthShader = new ShaderHelper(this, QStringLiteral(":/shaders/vertexSurfaceHeightMap"),
+                                                      QStringLiteral(":/shaders/fragmentDepth"));
+            m_heightMapDepthShader->initialize();
+        }
     }
 }
 
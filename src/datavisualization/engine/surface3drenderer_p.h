@@ -68,6 +68,11 @@ private:
     ShaderHelper *m_surfaceSliceFlatShader;
     ShaderHelper *m_surfaceSliceSmoothShader;
     ShaderHelper *m_selectionShader;
+    ShaderHelper *m_surfaceHeightMapShader;
+    ShaderHelper *m_surfaceTexturedHeightMapShader;
+    ShaderHelper *m_heightMapDepthShader;
+    ShaderHelper *m_heightMapSelectionShader;
+    ShaderHelper *m_heightMapGridShader;
     float m_heightNormalizer;
     float m_scaleX;
     float m_scaleY;
@@ -78,6 +83,7 @@ private:
     GLuint m_selectionResultTexture;
     GLfloat m_shadowQualityToShader;
     bool m_flatSupported;
+    bool m_heightMapSupported;
     bool m_selectionActive;
     AbstractRenderItem m_dummyRenderItem;
     GLint m_shadowQualityMultiplier;
@@ -98,8 +104,10 @@ public:
     SeriesRenderCache *createNewCache(QAbstract3DSeries *series);
     void cleanCache(SeriesRenderCache *cache);
     void updateSelectionMode(QAbstract3DGraph::SelectionFlags mode);
+    void updateOptimizationHint(QAbstract3DGraph::OptimizationHints hint);
     void updateRows(const QVector<Surface3DController::ChangeRow> &rows);
     void updateItems(const QVector<Surface3DController::ChangeItem> &points);
+    void updateShiftedRows(const QVector<Surface3DController::ChangeShift> &shifts);
     void updateScene(Q3DScene *scene);
     void updateSlicingActive(bool isSlicing);
     void updateSelectedPoint(const QPoint &position, QSurface3DSeries *series);
@@ -127,15 +135,18 @@ Q_SIGNALS:
 private:
     void checkFlatSupport(SurfaceSeriesRenderCache *cache);
     void updateObjects(SurfaceSeriesRenderCache *cache, bool dimensionChanged);
+    bool useHeightMap(const SurfaceSeriesRenderCache *cache) const;
+    bool scrollObjects(SurfaceSeriesRenderCache *cache, int rowShift);
     void updateSliceDataModel(const QPoint &point);
     QPoint mapCoordsToSampleSpace(SurfaceSeriesRenderCache *cache, const QPointF &coords);
-    void findMatchingRow(float z, int &sample, int direction, QSurfaceDataArray &dataArray);
-    void findMatchingColumn(float x, int &sample, int direction, QSurfaceDataArray &dataArray);
+    void findMatchingRow(float z, int &sample, int direction, const SurfaceDataView &dataArray);
+    void findMatchingColumn(float x, int &sample, int direction,
+                            const SurfaceDataView &dataArray);
     void updateSliceObject(SurfaceSeriesRenderCache *cache, const QPoint &point);
     void updateShadowQuality(QAbstract3DGraph::ShadowQuality quality);
     void updateTextures();
     void initShaders(const QString &vertexShader, const QString &fragmentShader);
-    QRect calculateSampleRect(const QSurfaceDataArray &array);
+    QRect calculateSampleRect(const SurfaceDataView &array);
     void loadBackgroundMesh();
 
     void drawSlicedScene();
@@ -156,6 +167,8 @@ private:
     void surfacePointSelected(const QPoint &point);
     void updateSelectionPoint(SurfaceSeriesRenderCache *cache, const QPoint &point, bool label);
     QPoint selectionIdToSurfacePoint(uint id);
+    void pickSurface(const QMatrix4x4 &projectionViewMatrix, const QMatrix4x4 &viewMatrix,
+                     const QMatrix4x4 &projectionMatrix, const Q3DCamera *activeCamera);
     void updateDepthBuffer();
     void emitSelectedPointChanged(QPoint position);
 
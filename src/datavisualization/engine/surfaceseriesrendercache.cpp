@@ -42,9 +42,11 @@ SurfaceSeriesRenderCache::SurfaceSeriesRenderCache(QAbstract3DSeries *series,
       m_surfaceObj(new SurfaceObject(renderer)),
       m_sliceSurfaceObj(new SurfaceObject(renderer)),
       m_sampleSpace(QRect(0, 0, 0, 0)),
+      m_rowShift(0),
       m_selectionTexture(0),
       m_selectionIdStart(0),
       m_selectionIdEnd(0),
+      m_pickMipmapDirty(true),
       m_flatChangeAllowed(true),
       m_flatStatusDirty(true),
       m_sliceSelectionPointer(0),
@@ -84,6 +86,9 @@ void SurfaceSeriesRenderCache::cleanup(TextureHelper *texHelper)
     for (int i = 0; i < m_dataArray.size(); i++)
         delete m_dataArray.at(i);
     m_dataArray.clear();
+    m_heightGrid = SurfaceHeightGrid();
+    m_pickMipmap.clear();
+    m_pickMipmapDirty = true;
 
     for (int i = 0; i < m_sliceDataArray.size(); i++)
         delete m_sliceDataArray.at(i);
@@ -95,4 +100,16 @@ void SurfaceSeriesRenderCache::cleanup(TextureHelper *texHelper)
     SeriesRenderCache::cleanup(texHelper);
 }
 
+const SurfaceMinMaxMipmap &SurfaceSeriesRenderCache::pickMipmap()
+{
+    if (m_pickMipmapDirty) {
+        if (m_surfaceObj->indexCount())
+            m_pickMipmap.build(m_surfaceObj, m_sampleSpace.width(), m_sampleSpace.height());
+        else
+            m_pickMipmap.clear();
+        m_pickMipmapDirty = false;
+    }
+    return m_pickMipmap;
+}
+
 QT_END_NAMESPACE_DATAVISUALIZATION
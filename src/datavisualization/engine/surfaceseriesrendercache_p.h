@@ -44,6 +44,7 @@
 #include "seriesrendercache_p.h"
 #include "qsurface3dseries_p.h"
 #include "surfaceobject_p.h"
+#include "surfaceminmaxmipmap_p.h"
 #include "selectionpointer_p.h"
 
 #include <QtGui/QMatrix4x4>
@@ -72,6 +73,18 @@ public:
     inline void setSampleSpace(const QRect &sampleSpace) { m_sampleSpace = sampleSpace; }
     inline QSurface3DSeries *series() const { return static_cast<QSurface3DSeries *>(m_series); }
     inline QSurfaceDataArray &dataArray() { return m_dataArray; }
+    inline const SurfaceHeightGrid &heightGrid() const { return m_heightGrid; }
+    inline void setHeightGrid(const SurfaceHeightGrid &grid) { m_heightGrid = grid; }
+    // Sampled data, from the shared height grid if the series has one
+    inline SurfaceDataView dataView() const
+    {
+        if (m_heightGrid.isNull())
+            return SurfaceDataView(m_dataArray);
+        return SurfaceDataView(m_heightGrid, m_sampleSpace);
+    }
+    // Rows shifted through the data since the last update
+    inline int rowShift() const { return m_rowShift; }
+    inline void setRowShift(int count) { m_rowShift = count; }
     inline QSurfaceDataArray &sliceDataArray() { return m_sliceDataArray; }
     inline bool renderable() const { return m_visible && (m_surfaceVisible ||
                                                           m_surfaceGridVisible); }
@@ -82,6 +95,8 @@ public:
     inline uint selectionIdStart() const { return m_selectionIdStart; }
     inline bool isWithinIdRange(uint selection) const { return selection >= m_selectionIdStart &&
                                                         selection <= m_selectionIdEnd; }
+    inline void setPickMipmapDirty(bool state) { m_pickMipmapDirty = state; }
+    const SurfaceMinMaxMipmap &pickMipmap();
     inline bool isFlatStatusDirty() const { return m_flatStatusDirty; }
     inline void setFlatStatusDirty(bool status) { m_flatStatusDirty = status; }
     inline void setMVPMatrix(const QMatrix4x4 &matrix) { m_MVPMatrix = matrix; }
@@ -107,10 +122,14 @@ protected:
     SurfaceObject *m_sliceSurfaceObj;
     QRect m_sampleSpace;
     QSurfaceDataArray m_dataArray;
+    SurfaceHeightGrid m_heightGrid;
+    int m_rowShift;
     QSurfaceDataArray m_sliceDataArray;
     GLuint m_selectionTexture;
     uint m_selectionIdStart;
     uint m_selectionIdEnd;
+    SurfaceMinMaxMipmap m_pickMipmap; // Cell bounds for picking on CPU, built on demand
+    bool m_pickMipmapDirty;
     bool m_flatChangeAllowed;
     bool m_flatStatusDirty;
     QMatrix4x4 m_MVPMatrix;
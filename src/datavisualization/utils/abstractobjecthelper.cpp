@@ -31,13 +31,24 @@
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
+// Loads at least this large are uploaded over several frames while the old buffers are drawn
+const qint64 stagedUploadMinSize = 4 * 1024 * 1024;
+const int stagedUploadFrameSize = 8 * 1024 * 1024;
+
 AbstractObjectHelper::AbstractObjectHelper()
     : m_vertexbuffer(0),
       m_normalbuffer(0),
       m_uvbuffer(0),
       m_elementbuffer(0),
+      m_selectionColorBuffer(0),
       m_indexCount(0),
-      m_meshDataLoaded(false)
+      m_meshDataLoaded(false),
+      m_vertexOffset(0),
+      m_pendingIndexCount(0),
+      m_pendingInstanceCount(0),
+      m_queuedIndexCount(0),
+      m_queuedInstanceCount(0),
+      m_pendingUploadStarted(false)
 {
     initializeOpenGLFunctions();
 }
@@ -49,6 +60,8 @@ AbstractObjectHelper::~AbstractObjectHelper()
         glDeleteBuffers(1, &m_uvbuffer);
         glDeleteBuffers(1, &m_normalbuffer);
         glDeleteBuffers(1, &m_elementbuffer);
+        glDeleteBuffers(1, &m_selectionColorBuffer);
+        discardPendingUpload();
     }
 }
 
@@ -85,4 +98,173 @@ GLuint AbstractObjectHelper::indexCount()
     return m_indexCount;
 }
 
+void AbstractObjectHelper::drawElements()
+{
+    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void *)0);
+}
+
+// Uploads items stored consecutively in data to the buffer bound to GL_ARRAY_BUFFER, item i
+// going to the slot bufferSlots[i]. Items with consecutive slots are uploaded with a single
+// call, so the slots should be in ascending order.
+void AbstractObjectHelper::uploadItems(const QVector<int> &bufferSlots, const void *data,
+                                       int itemSize)
+{
+    const char *itemData = static_cast<const char *>(data);
+    const int itemCount = bufferSlots.size();
+    int runStart = 0;
+    for (int i = 1; i <= itemCount; i++) {
+        if (i == itemCount || bufferSlots.at(i) != bufferSlots.at(i - 1) + 1) {
+            glBufferSubData(GL_ARRAY_BUFFER, GLintptr(bufferSlots.at(runStart)) * itemSize,
+                            GLsizeiptr(i - runStart) * itemSize,
+                            itemData + GLintptr(runStart) * itemSize);
+            runStart = i;
+        }
+    }
+}
+
+// Replaces the contents of the selection color buffer with four bytes per color
+void AbstractObjectHelper::loadSelectionColors(const QVector<GLubyte> &colors)
+{
+    if (!m_selectionColorBuffer)
+        glGenBuffers(1, &m_selectionColorBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_selectionColorBuffer);
+    glBufferData(GL_ARRAY_BUFFER, colors.size(), colors.constData(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Large loads are staged instead of uploaded at once if there are buffers to draw meanwhile.
+bool AbstractObjectHelper::stagesUpload(qint64 size) const
+{
+    return m_meshDataLoaded && size >= stagedUploadMinSize;
+}
+
+// Stages data for a new buffer that replaces *frontBuffer once all staged buffers have been
+// uploaded. Staging an empty buffer deletes the front buffer at the swap. Staging a buffer again
+// replaces its data if the upload has not started yet. Otherwise the upload runs to the swap,
+// and the new data is queued to be staged after it, so that loads changing every frame still
+// get drawn. Only the latest queued load is kept, so every load has to stage the same buffers.
+void AbstractObjectHelper::stageData(GLenum target, GLuint *frontBuffer,
+                                     const QSharedPointer<PendingData> &data, int size,
+                                     GLenum usage)
+{
+    QVector<PendingBuffer> &buffers = m_pendingUploadStarted ? m_queuedBuffers
+                                                             : m_pendingBuffers;
+    for (int i = 0; i < buffers.size(); i++) {
+        PendingBuffer &pending = buffers[i];
+        if (pending.frontBuffer == frontBuffer) {
+            pending.target = target;
+            pending.usage = usage;
+            pending.data = data;
+            pending.size = size;
+            return;
+        }
+    }
+
+    PendingBuffer pending;
+    pending.target = target;
+    pending.frontBuffer = frontBuffer;
+    pending.buffer = 0;
+    pending.usage = usage;
+    pending.data = data;
+    pending.size = size;
+    pending.uploaded = 0;
+    buffers.append(pending);
+}
+
+// Sets the index and instance counts that take effect when the buffers staged last are swapped in
+void AbstractObjectHelper::setStagedCounts(GLuint indexCount, GLuint instanceCount)
+{
+    if (m_queuedBuffers.isEmpty()) {
+        m_pendingIndexCount = indexCount;
+        m_pendingInstanceCount = instanceCount;
+    } else {
+        m_queuedIndexCount = indexCount;
+        m_queuedInstanceCount = instanceCount;
+    }
+}
+
+void AbstractObjectHelper::discardPendingUpload()
+{
+    foreach (const PendingBuffer &pending, m_pendingBuffers)
+        glDeleteBuffers(1, &pending.buffer);
+    m_pendingBuffers.clear();
+    m_queuedBuffers.clear();
+    m_pendingUploadStarted = false;
+}
+
+// Makes the queued load the pending one, its upload starting on the next call to uploadPending()
+void AbstractObjectHelper::stageQueuedLoad()
+{
+    m_pendingBuffers = m_queuedBuffers;
+    m_pendingIndexCount = m_queuedIndexCount;
+    m_pendingInstanceCount = m_queuedInstanceCount;
+    m_queuedBuffers.clear();
+    m_pendingUploadStarted = false;
+}
+
+// Uploads the next part of the staged buffers, and swaps them in when they are complete.
+// Returns true if the buffers were swapped.
+bool AbstractObjectHelper::uploadPending()
+{
+    if (!hasPendingUpload())
+        return false;
+
+    m_pendingUploadStarted = true;
+    int budget = stagedUploadFrameSize;
+    bool complete = true;
+    for (int i = 0; i < m_pendingBuffers.size(); i++) {
+        PendingBuffer &pending = m_pendingBuffers[i];
+        const int size = pending.size;
+        if (pending.uploaded == size)
+            continue;
+        if (budget <= 0) {
+            complete = false;
+            break;
+        }
+
+        if (!pending.buffer) {
+            glGenBuffers(1, &pending.buffer);
+            glBindBuffer(pending.target, pending.buffer);
+            glBufferData(pending.target, size, 0, pending.usage);
+        } else {
+            glBindBuffer(pending.target, pending.buffer);
+        }
+        const int count = qMin(budget, size - pending.uploaded);
+        glBufferSubData(pending.target, pending.uploaded, count,
+                        pending.data->data + pending.uploaded);
+        glBindBuffer(pending.target, 0);
+        pending.uploaded += count;
+        budget -= count;
+        if (pending.uploaded < size)
+            complete = false;
+        else
+            pending.data.clear();
+    }
+
+    if (complete) {
+        swapPendingBuffers();
+        stageQueuedLoad();
+        return true;
+    }
+    return false;
+}
+
+// Uploads the rest of the staged buffers at once, including a queued load. Partial updates need
+// this first, as they apply to the buffers matching the current render items.
+void AbstractObjectHelper::finishPendingUpload()
+{
+    while (hasPendingUpload())
+        uploadPending();
+}
+
+void AbstractObjectHelper::swapPendingBuffers()
+{
+    foreach (const PendingBuffer &pending, m_pendingBuffers) {
+        glDeleteBuffers(1, pending.frontBuffer);
+        *pending.frontBuffer = pending.buffer;
+    }
+    m_pendingBuffers.clear();
+    m_indexCount = m_pendingIndexCount;
+}
+
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -41,10 +41,12 @@
 #define ABSTRACTOBJECTHELPER_H
 
 #include "datavisualizationglobal_p.h"
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
-class AbstractObjectHelper: protected QOpenGLFunctions
+class QT_DATAVISUALIZATION_EXPORT AbstractObjectHelper: protected QOpenGLFunctions
 {
 protected:
     AbstractObjectHelper();
@@ -56,15 +58,98 @@ public:
     virtual GLuint uvBuf();
     GLuint elementBuf();
     GLuint indexCount();
+    // Per-vertex or per-instance colors for drawing all items to the selection buffer at once
+    inline GLuint selectionColorBuf() const { return m_selectionColorBuffer; }
+    // Byte offset of the first vertex in the vertex and normal buffers
+    inline GLintptr vertexOffset() const { return m_vertexOffset; }
+    // Draws the triangles of the element buffer, which has to be bound
+    virtual void drawElements();
+
+    inline bool hasPendingUpload() const { return !m_pendingBuffers.isEmpty(); }
+    bool uploadPending();
+    void finishPendingUpload();
+
+protected:
+    // Keeps the staged data of the caller alive until it has been uploaded
+    class PendingData
+    {
+    public:
+        virtual ~PendingData() {}
+        const char *data;
+    };
+
+    template <typename T>
+    class PendingVector : public PendingData
+    {
+    public:
+        PendingVector(const QVector<T> &vector)
+            : m_vector(vector)
+        {
+            data = reinterpret_cast<const char *>(m_vector.constData());
+        }
+
+    private:
+        QVector<T> m_vector;
+    };
+
+    struct PendingBuffer {
+        GLenum target;
+        GLuint *frontBuffer;
+        GLuint buffer;
+        GLenum usage;
+        QSharedPointer<PendingData> data;
+        int size;
+        int uploaded;
+    };
+
+    void uploadItems(const QVector<int> &bufferSlots, const void *data, int itemSize);
+    bool stagesUpload(qint64 size) const;
+    // Shares the data instead of copying it, so the caller should not modify it while it is staged
+    template <typename T>
+    inline void stageBuffer(GLenum target, GLuint *frontBuffer, const QVector<T> &data, int size,
+                            GLenum usage)
+    {
+        stageData(target, frontBuffer, QSharedPointer<PendingData>(new PendingVector<T>(data)),
+                  size, usage);
+    }
+    void stageData(GLenum target, GLuint *frontBuffer, const QSharedPointer<PendingData> &data,
+                   int size, GLenum usage);
+    void setStagedCounts(GLuint indexCount, GLuint instanceCount = 0);
+    void discardPendingUpload();
+    virtual void swapPendingBuffers();
+    void loadSelectionColors(const QVector<GLubyte> &colors);
+    // Same color as Abstract3DRenderer::indexToSelectionColor(), as normalized bytes
+    static inline void writeSelectionColor(int index, GLubyte *color)
+    {
+        color[0] = index & 0xff;
+        color[1] = (index & 0xff00) >> 8;
+        color[2] = (index & 0xff0000) >> 16;
+        color[3] = 0;
+    }
 
 public:
     GLuint m_vertexbuffer;
     GLuint m_normalbuffer;
     GLuint m_uvbuffer;
     GLuint m_elementbuffer;
+    GLuint m_selectionColorBuffer;
 
     GLuint m_indexCount;
     GLboolean m_meshDataLoaded;
+    GLintptr m_vertexOffset;
+
+protected:
+    QVector<PendingBuffer> m_pendingBuffers;
+    GLuint m_pendingIndexCount; // Index count that takes effect when the pending buffers swap
+    GLuint m_pendingInstanceCount;
+    // Latest load staged while the pending buffers were being uploaded, which is staged next
+    QVector<PendingBuffer> m_queuedBuffers;
+    GLuint m_queuedIndexCount;
+    GLuint m_queuedInstanceCount;
+    bool m_pendingUploadStarted;
+
+private:
+    void stageQueuedLoad();
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -0,0 +1,193 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "barinstancebufferhelper_p.h"
+#include <QtGui/QVector4D>
+
+QT_BEGIN_NAMESPACE_DATAVISUALIZATION
+
+BarInstanceBufferHelper::BarInstanceBufferHelper()
+    : m_instanceCount(0),
+      m_instancePositionBuffer(0),
+      m_instanceRotationBuffer(0),
+      m_gradientScale(0.0f)
+{
+}
+
+BarInstanceBufferHelper::~BarInstanceBufferHelper()
+{
+    if (QOpenGLContext::currentContext()) {
+        glDeleteBuffers(1, &m_instancePositionBuffer);
+        glDeleteBuffers(1, &m_instanceRotationBuffer);
+    }
+}
+
+// Gradient scale is the gradient texture distance per unit of bar height, or zero if the whole
+// gradient is spread over each bar.
+void BarInstanceBufferHelper::fullLoad(BarSeriesRenderCache *cache, float gradientScale)
+{
+    const BarRenderItemArray &renderArray = cache->renderArray();
+    const int rowCount = renderArray.size();
+    const int columnCount = rowCount ? renderArray.at(0).size() : 0;
+    const int itemCount = rowCount * columnCount;
+
+    m_gradientScale = gradientScale;
+    m_meshRotation = cache->meshRotation();
+    cache->instanceUpdateSlots().clear();
+
+    if (itemCount == 0) {
+        discardPendingUpload();
+        m_meshDataLoaded = false;
+        m_instanceCount = 0;
+        return;  // No use to go forward
+    }
+
+    // Position buffer holds the column, height and row of the bar, and the gradient position
+    // of the bar top in w. Layout of the grid is applied in the shader.
+    QVector<QVector4D> buffered_positions;
+    QVector<QVector4D> buffered_rotations;
+    buffered_positions.resize(itemCount);
+    buffered_rotations.resize(itemCount);
+
+    bool rotated = false;
+    int slot = 0;
+    for (int row = 0; row < rowCount; row++) {
+        const BarRenderItemRow &renderRow = renderArray.at(row);
+        for (int column = 0; column < columnCount; column++) {
+            const BarRenderItem &item = renderRow.at(column);
+            buffered_positions[slot] = instancePosition(item, row, column);
+            const QQuaternion totalRotation = m_meshRotation * item.rotation();
+            if (!totalRotation.isIdentity())
+                rotated = true;
+            buffered_rotations[slot] = totalRotation.toVector4D();
+            slot++;
+        }
+    }
+
+    const qint64 vectorSize = itemCount * sizeof(QVector4D);
+    if (stagesUpload((rotated ? 2 : 1) * vectorSize)) {
+        // Keep drawing the old bars until the new ones have been uploaded.
+        stageBuffer(GL_ARRAY_BUFFER, &m_instancePositionBuffer, buffered_positions,
+                    vectorSize, GL_STATIC_DRAW);
+        stageBuffer(GL_ARRAY_BUFFER, &m_instanceRotationBuffer, buffered_rotations,
+                    rotated ? vectorSize : 0, GL_STATIC_DRAW);
+        setStagedCounts(0, itemCount);
+        return;
+    }
+
+    discardPendingUpload();
+
+    if (!m_instancePositionBuffer)
+        glGenBuffers(1, &m_instancePositionBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instancePositionBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vectorSize, &buffered_positions.at(0), GL_STATIC_DRAW);
+
+    // Unrotated series use a constant attribute value instead of a buffer
+    if (rotated) {
+        if (!m_instanceRotationBuffer)
+            glGenBuffers(1, &m_instanceRotationBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceRotationBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vectorSize, &buffered_rotations.at(0), GL_STATIC_DRAW);
+    } else if (m_instanceRotationBuffer) {
+        glDeleteBuffers(1, &m_instanceRotationBuffer);
+        m_instanceRotationBuffer = 0;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_instanceCount = itemCount;
+    m_meshDataLoaded = true;
+}
+
+// Uploads the bars in the update slots of the cache, or reloads all bars if the per-series
+// values in the buffer have changed
+void BarInstanceBufferHelper::update(BarSeriesRenderCache *cache, float gradientScale)
+{
+    const BarRenderItemArray &renderArray = cache->renderArray();
+    const QVector<int> &updateSlots = cache->instanceUpdateSlots();
+    const int updateSize = updateSlots.size();
+    const int rowCount = renderArray.size();
+    const int columnCount = rowCount ? renderArray.at(0).size() : 0;
+    if (gradientScale != m_gradientScale || cache->meshRotation() != m_meshRotation
+            || (updateSize && GLuint(rowCount * columnCount) != m_instanceCount)) {
+        fullLoad(cache, gradientScale);
+        return;
+    }
+    if (!updateSize)
+        return;
+
+    QVector<QVector4D> positions;
+    QVector<QVector4D> rotations;
+    positions.reserve(updateSize);
+    rotations.reserve(updateSize);
+    for (int i = 0; i < updateSize; i++) {
+        const int slot = updateSlots.at(i);
+        const int row = slot / columnCount;
+        const int column = slot % columnCount;
+        const BarRenderItem &item = renderArray.at(row).at(column);
+        const QQuaternion totalRotation = m_meshRotation * item.rotation();
+        // Rotating a previously unrotated series requires creating the rotation buffer
+        if (!m_instanceRotationBuffer && !totalRotation.isIdentity()) {
+            fullLoad(cache, gradientScale);
+            return;
+        }
+        positions.append(instancePosition(item, row, column));
+        rotations.append(totalRotation.toVector4D());
+    }
+
+    // Partial uploads go to the front buffers, so the pending ones must not replace them later
+    finishPendingUpload();
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instancePositionBuffer);
+    uploadItems(updateSlots, positions.constData(), sizeof(QVector4D));
+    if (m_instanceRotationBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceRotationBuffer);
+        uploadItems(updateSlots, rotations.constData(), sizeof(QVector4D));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    cache->instanceUpdateSlots().clear();
+}
+
+QVector4D BarInstanceBufferHelper::instancePosition(const BarRenderItem &item, int row,
+                                                    int column) const
+{
+    const float gradientPosition = m_gradientScale ? qAbs(item.height()) * m_gradientScale
+                                                   : 0.5f;
+    return QVector4D(float(column), item.height(), float(row), gradientPosition);
+}
+
+void BarInstanceBufferHelper::swapPendingBuffers()
+{
+    AbstractObjectHelper::swapPendingBuffers();
+    m_instanceCount = m_pendingInstanceCount;
+}
+
+QT_END_NAMESPACE_DATAVISUALIZATION
@@ -0,0 +1,79 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef BARINSTANCEBUFFERHELPER_P_H
+#define BARINSTANCEBUFFERHELPER_P_H
+
+#include "datavisualizationglobal_p.h"
+#include "abstractobjecthelper_p.h"
+#include "barseriesrendercache_p.h"
+
+QT_BEGIN_NAMESPACE_DATAVISUALIZATION
+
+// Per-bar instance data of a bar series for drawing all bars of the series with a single
+// instanced call. Bar at (row, column) is in slot row * columnCount + column.
+class BarInstanceBufferHelper : public AbstractObjectHelper
+{
+public:
+    BarInstanceBufferHelper();
+    virtual ~BarInstanceBufferHelper();
+
+    void fullLoad(BarSeriesRenderCache *cache, float gradientScale);
+    void update(BarSeriesRenderCache *cache, float gradientScale);
+
+    inline GLuint instanceCount() const { return m_instanceCount; }
+    inline GLuint instancePositionBuf() const { return m_instancePositionBuffer; }
+    inline GLuint instanceRotationBuf() const { return m_instanceRotationBuffer; }
+
+protected:
+    void swapPendingBuffers();
+
+private:
+    QVector4D instancePosition(const BarRenderItem &item, int row, int column) const;
+
+    GLuint m_instanceCount;
+    GLuint m_instancePositionBuffer;
+    GLuint m_instanceRotationBuffer; // Zero if no bar is rotated
+    float m_gradientScale;
+    QQuaternion m_meshRotation;
+};
+
+QT_END_NAMESPACE_DATAVISUALIZATION
+
+#endif
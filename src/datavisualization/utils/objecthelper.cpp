@@ -149,6 +149,17 @@ void ObjectHelper::load()
 
     m_indexCount = m_indices.size();
 
+    m_minBounds = m_indexedVertices.at(0);
+    m_maxBounds = m_minBounds;
+    foreach (const QVector3D &vertex, m_indexedVertices) {
+        m_minBounds = QVector3D(qMin(m_minBounds.x(), vertex.x()),
+                                qMin(m_minBounds.y(), vertex.y()),
+                                qMin(m_minBounds.z(), vertex.z()));
+        m_maxBounds = QVector3D(qMax(m_maxBounds.x(), vertex.x()),
+                                qMax(m_maxBounds.y(), vertex.y()),
+                                qMax(m_maxBounds.z(), vertex.z()));
+    }
+
     glGenBuffers(1, &m_vertexbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
     glBufferData(GL_ARRAY_BUFFER, m_indexedVertices.size() * sizeof(QVector3D),
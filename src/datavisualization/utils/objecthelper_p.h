@@ -63,6 +63,9 @@ public:
     inline const QVector<QVector3D> &indexedvertices() const { return m_indexedVertices; }
     inline const QVector<QVector2D> &indexedUVs() const { return m_indexedUVs; }
     inline const QVector<QVector3D> &indexedNormals() const { return m_indexedNormals; }
+    // Bounds of the mesh vertices
+    inline const QVector3D &minBounds() const { return m_minBounds; }
+    inline const QVector3D &maxBounds() const { return m_maxBounds; }
 
 private:
     static ObjectHelper *getObjectHelper(const Abstract3DRenderer *cacheId,
@@ -74,6 +77,8 @@ private:
     QVector<QVector3D> m_indexedVertices;
     QVector<QVector2D> m_indexedUVs;
     QVector<QVector3D> m_indexedNormals;
+    QVector3D m_minBounds;
+    QVector3D m_maxBounds;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -30,6 +30,7 @@
 #include "scatterobjectbufferhelper_p.h"
 #include "objecthelper_p.h"
 #include <QtGui/QVector2D>
+#include <QtGui/QVector4D>
 #include <QtGui/QMatrix4x4>
 #include <QtCore/qmath.h>
 
@@ -37,42 +38,48 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 const GLfloat itemScaler = 3.0f;
 
-ScatterObjectBufferHelper::ScatterObjectBufferHelper()
-    : m_scaleY(0.0f)
+ScatterObjectBufferHelper::ScatterObjectBufferHelper(bool instanced)
+    : m_scaleY(0.0f),
+      m_instanced(instanced),
+      m_instanceCount(0),
+      m_instancePositionBuffer(0),
+      m_instanceRotationBuffer(0),
+      m_selectionColorsDirty(true),
+      m_selectionIndexOffset(0)
 {
 }
 
 ScatterObjectBufferHelper::~ScatterObjectBufferHelper()
 {
+    if (QOpenGLContext::currentContext()) {
+        glDeleteBuffers(1, &m_instancePositionBuffer);
+        glDeleteBuffers(1, &m_instanceRotationBuffer);
+    }
 }
 
 void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal dotScale)
 {
-    m_meshDataLoaded = false;
-    m_indexCount = 0;
+    m_selectionColorsDirty = true;
+
+    if (m_instanced) {
+        loadInstances(cache, dotScale);
+        return;
+    }
 
     ObjectHelper *dotObj = cache->object();
     const ScatterRenderItemArray &renderArray = cache->renderArray();
     const uint renderArraySize = renderArray.size();
 
-    if (renderArraySize == 0)
+    if (renderArraySize == 0) {
+        discardPendingUpload();
+        m_meshDataLoaded = false;
+        m_indexCount = 0;
         return;  // No use to go forward
+    }
 
     uint itemCount = 0;
     QQuaternion seriesRotation(cache->meshRotation());
 
-    if (m_meshDataLoaded) {
-        // Delete old data
-        glDeleteBuffers(1, &m_vertexbuffer);
-        glDeleteBuffers(1, &m_uvbuffer);
-        glDeleteBuffers(1, &m_normalbuffer);
-        glDeleteBuffers(1, &m_elementbuffer);
-        m_vertexbuffer = 0;
-        m_uvbuffer = 0;
-        m_normalbuffer = 0;
-        m_elementbuffer = 0;
-    }
-
     // Index vertices
     const QVector<GLuint> indices = dotObj->indices();
     const QVector<QVector3D> indexed_vertices = dotObj->indexedvertices();
@@ -120,21 +127,22 @@ void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal
     cache->bufferIndices().resize(renderArraySize);
 
     for (uint i = 0; i < renderArraySize; i++) {
-        const ScatterRenderItem &item = renderArray.at(i);
-        if (!item.isVisible())
+        if (!renderArray.isVisible(i))
             continue;
         else
             cache->bufferIndices()[i] = itemCount;
 
+        const QVector3D translation = renderArray.translation(i);
+        const QQuaternion rotation = renderArray.rotation(i);
         int offset = itemCount * verticeCount;
-        if (item.rotation().isIdentity()) {
+        if (rotation.isIdentity()) {
             for (int j = 0; j < verticeCount; j++) {
-                buffered_vertices[j + offset] = scaled_vertices[j] + item.translation();
+                buffered_vertices[j + offset] = scaled_vertices[j] + translation;
                 buffered_normals[j + offset] = indexed_normals[j];
             }
         } else {
             QMatrix4x4 matrix;
-            QQuaternion totalRotation = seriesRotation * item.rotation();
+            QQuaternion totalRotation = seriesRotation * rotation;
             matrix.rotate(totalRotation);
             matrix.scale(modelScaler);
             QMatrix4x4 itModelMatrix = matrix.inverted();
@@ -142,7 +150,7 @@ void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal
 
             for (int j = 0; j < verticeCount; j++) {
                 buffered_vertices[j + offset] = indexed_vertices[j] * modelMatrix
-                        + item.translation();
+                        + translation;
                 buffered_normals[j + offset] = indexed_normals[j] * itModelMatrix;
             }
         }
@@ -161,6 +169,39 @@ void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal
         itemCount++;
     }
 
+    const qint64 vertexSize = verticeCount * sizeof(QVector3D);
+    const qint64 normalSize = normalsCount * sizeof(QVector3D);
+    const qint64 uvSize = uvsCount * sizeof(QVector2D);
+    const qint64 indexSize = indicesCount * sizeof(GLint);
+    if (itemCount > 0
+            && stagesUpload((vertexSize + normalSize + uvSize + indexSize) * itemCount)) {
+        // Keep drawing the old items until the new ones have been uploaded.
+        stageBuffer(GL_ARRAY_BUFFER, &m_vertexbuffer, buffered_vertices,
+                    vertexSize * itemCount, GL_STATIC_DRAW);
+        stageBuffer(GL_ARRAY_BUFFER, &m_normalbuffer, buffered_normals,
+                    normalSize * itemCount, GL_STATIC_DRAW);
+        stageBuffer(GL_ARRAY_BUFFER, &m_uvbuffer, buffered_uvs,
+                    uvSize * itemCount, GL_STATIC_DRAW);
+        stageBuffer(GL_ELEMENT_ARRAY_BUFFER, &m_elementbuffer, buffered_indices,
+                    indexSize * itemCount, GL_STATIC_DRAW);
+        setStagedCounts(indicesCount * itemCount);
+        return;
+    }
+
+    discardPendingUpload();
+    if (m_meshDataLoaded) {
+        // Delete old data
+        glDeleteBuffers(1, &m_vertexbuffer);
+        glDeleteBuffers(1, &m_uvbuffer);
+        glDeleteBuffers(1, &m_normalbuffer);
+        glDeleteBuffers(1, &m_elementbuffer);
+        m_vertexbuffer = 0;
+        m_uvbuffer = 0;
+        m_normalbuffer = 0;
+        m_elementbuffer = 0;
+        m_meshDataLoaded = false;
+    }
+
     m_indexCount = indicesCount * itemCount;
 
     if (itemCount > 0) {
@@ -193,10 +234,218 @@ void ScatterObjectBufferHelper::fullLoad(ScatterSeriesRenderCache *cache, qreal
     }
 }
 
+void ScatterObjectBufferHelper::loadInstances(ScatterSeriesRenderCache *cache, qreal dotScale)
+{
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const int renderArraySize = renderArray.size();
+
+    if (renderArraySize == 0) {
+        discardPendingUpload();
+        m_meshDataLoaded = false;
+        m_indexCount = 0;
+        m_instanceCount = 0;
+        return;  // No use to go forward
+    }
+
+    QQuaternion seriesRotation(cache->meshRotation());
+    float itemSize = cache->itemSize() / itemScaler;
+    if (itemSize == 0.0f)
+        itemSize = dotScale;
+
+    // Only per-item data is buffered, the mesh itself is shared by all instances.
+    // Position buffer holds the translation in xyz and the item scale in w.
+    QVector<QVector4D> buffered_positions;
+    QVector<QVector4D> buffered_rotations;
+    buffered_positions.resize(renderArraySize);
+    buffered_rotations.resize(renderArraySize);
+
+    cache->bufferIndices().resize(renderArraySize);
+
+    bool rotated = false;
+    uint itemCount = 0;
+    for (int i = 0; i < renderArraySize; i++) {
+        if (!renderArray.isVisible(i))
+            continue;
+        else
+            cache->bufferIndices()[i] = itemCount;
+
+        buffered_positions[itemCount] = QVector4D(renderArray.translation(i), itemSize);
+        const QQuaternion totalRotation = seriesRotation * renderArray.rotation(i);
+        if (!totalRotation.isIdentity())
+            rotated = true;
+        buffered_rotations[itemCount] = totalRotation.toVector4D();
+
+        itemCount++;
+    }
+
+    if (itemCount == 0) {
+        discardPendingUpload();
+        m_meshDataLoaded = false;
+        m_indexCount = 0;
+        m_instanceCount = 0;
+        return;
+    }
+
+    QVector<QVector2D> buffered_uvs;
+    buffered_uvs.resize(itemCount);
+    if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
+        createRangeGradientUVs(cache, buffered_uvs);
+
+    const qint64 vectorSize = itemCount * sizeof(QVector4D);
+    if (stagesUpload((rotated ? 2 : 1) * vectorSize + itemCount * sizeof(QVector2D))) {
+        // Keep drawing the old instances until the new ones have been uploaded.
+        stageBuffer(GL_ARRAY_BUFFER, &m_instancePositionBuffer, buffered_positions,
+                    vectorSize, GL_STATIC_DRAW);
+        stageBuffer(GL_ARRAY_BUFFER, &m_instanceRotationBuffer, buffered_rotations,
+                    rotated ? vectorSize : 0, GL_STATIC_DRAW);
+        stageBuffer(GL_ARRAY_BUFFER, &m_uvbuffer, buffered_uvs,
+                    itemCount * sizeof(QVector2D), GL_STATIC_DRAW);
+        setStagedCounts(cache->object()->indexCount(), itemCount);
+        return;
+    }
+
+    discardPendingUpload();
+
+    if (!m_instancePositionBuffer)
+        glGenBuffers(1, &m_instancePositionBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instancePositionBuffer);
+    glBufferData(GL_ARRAY_BUFFER, itemCount * sizeof(QVector4D), &buffered_positions.at(0),
+                 GL_STATIC_DRAW);
+
+    // Unrotated series use a constant attribute value instead of a buffer
+    if (rotated) {
+        if (!m_instanceRotationBuffer)
+            glGenBuffers(1, &m_instanceRotationBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceRotationBuffer);
+        glBufferData(GL_ARRAY_BUFFER, itemCount * sizeof(QVector4D), &buffered_rotations.at(0),
+                     GL_STATIC_DRAW);
+    } else if (m_instanceRotationBuffer) {
+        glDeleteBuffers(1, &m_instanceRotationBuffer);
+        m_instanceRotationBuffer = 0;
+    }
+
+    if (!m_uvbuffer)
+        glGenBuffers(1, &m_uvbuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
+    glBufferData(GL_ARRAY_BUFFER, itemCount * sizeof(QVector2D), &buffered_uvs.at(0),
+                 GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Each instance draws the indices of the shared mesh
+    m_instanceCount = itemCount;
+    m_indexCount = cache->object()->indexCount();
+    m_meshDataLoaded = true;
+}
+
+void ScatterObjectBufferHelper::updateInstances(ScatterSeriesRenderCache *cache, qreal dotScale)
+{
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const int updateSize = cache->updateIndices().size();
+
+    if (!updateSize || !m_instanceCount) {
+        loadInstances(cache, dotScale);
+        return;
+    }
+
+    QQuaternion seriesRotation(cache->meshRotation());
+    float itemSize = cache->itemSize() / itemScaler;
+    if (itemSize == 0.0f)
+        itemSize = dotScale;
+
+    // Rotating a previously unrotated series requires creating the rotation buffer
+    if (!m_instanceRotationBuffer) {
+        for (int i = 0; i < updateSize; i++) {
+            const int index = cache->updateIndices().at(i);
+            if (renderArray.isVisible(index)
+                    && !(seriesRotation * renderArray.rotation(index)).isIdentity()) {
+                loadInstances(cache, dotScale);
+                return;
+            }
+        }
+    }
+
+    QVector<int> bufferSlots;
+    QVector<QVector4D> positions;
+    QVector<QVector4D> rotations;
+    bufferSlots.reserve(updateSize);
+    positions.reserve(updateSize);
+    if (m_instanceRotationBuffer)
+        rotations.reserve(updateSize);
+    for (int i = 0; i < updateSize; i++) {
+        const int index = cache->updateIndices().at(i);
+        if (!renderArray.isVisible(index))
+            continue;
+
+        bufferSlots.append(cache->bufferIndices().at(index));
+        positions.append(QVector4D(renderArray.translation(index), itemSize));
+        if (m_instanceRotationBuffer)
+            rotations.append((seriesRotation * renderArray.rotation(index)).toVector4D());
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instancePositionBuffer);
+    uploadItems(bufferSlots, positions.constData(), sizeof(QVector4D));
+    if (m_instanceRotationBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceRotationBuffer);
+        uploadItems(bufferSlots, rotations.constData(), sizeof(QVector4D));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ScatterObjectBufferHelper::swapPendingBuffers()
+{
+    AbstractObjectHelper::swapPendingBuffers();
+    if (m_instanced)
+        m_instanceCount = m_pendingInstanceCount;
+}
+
+// Gives the vertices or the instance of each item the selection color of the item index,
+// offset by the items of the preceding series
+void ScatterObjectBufferHelper::updateSelectionColors(ScatterSeriesRenderCache *cache,
+                                                      int indexOffset)
+{
+    finishPendingUpload();
+
+    if (!m_meshDataLoaded || !m_indexCount
+            || (!m_selectionColorsDirty && indexOffset == m_selectionIndexOffset)) {
+        return;
+    }
+
+    // Hidden items have no buffer slot, so the colors follow the buffer indices of the items
+    const int colorsPerItem = m_instanced ? 1 : cache->object()->indexedvertices().count();
+    const int slotCount = m_instanced ? int(m_instanceCount)
+                                      : int(m_indexCount / cache->object()->indexCount());
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const QVector<int> &bufferIndices = cache->bufferIndices();
+    const int itemCount = qMin(renderArray.size(), bufferIndices.size());
+    QVector<GLubyte> colors(slotCount * colorsPerItem * 4);
+    for (int i = 0; i < itemCount; i++) {
+        const int slot = bufferIndices.at(i);
+        if (!renderArray.isVisible(i) || slot >= slotCount)
+            continue;
+
+        GLubyte *color = colors.data() + slot * colorsPerItem * 4;
+        for (int j = 0; j < colorsPerItem; j++)
+            writeSelectionColor(indexOffset + i, color + j * 4);
+    }
+    loadSelectionColors(colors);
+
+    m_selectionColorsDirty = false;
+    m_selectionIndexOffset = indexOffset;
+}
+
+int ScatterObjectBufferHelper::uvCountPerItem(ScatterSeriesRenderCache *cache) const
+{
+    // Instanced meshes have a single UV per item instead of one per mesh vertex
+    return m_instanced ? 1 : cache->object()->indexedUVs().count();
+}
+
 void ScatterObjectBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
 {
+    finishPendingUpload();
+
     ObjectHelper *dotObj = cache->object();
-    const int uvsCount = dotObj->indexedUVs().count();
+    const int uvsCount = uvCountPerItem(cache);
     const ScatterRenderItemArray &renderArray = cache->renderArray();
     const bool updateAll = (cache->updateIndices().size() == 0);
     const int updateSize = updateAll ? renderArray.size() : cache->updateIndices().size();
@@ -210,6 +459,9 @@ void ScatterObjectBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
     uint itemCount = 0;
     if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient) {
         itemCount = createRangeGradientUVs(cache, buffered_uvs);
+    } else if (m_instanced) {
+        // Object gradient of instanced meshes is resolved in the vertex shader
+        itemCount = m_instanceCount;
     } else if (cache->colorStyle() == Q3DTheme::ColorStyleObjectGradient) {
         const QVector<QVector3D> indexed_vertices = dotObj->indexedvertices();
         itemCount = createObjectGradientUVs(cache, buffered_uvs, indexed_vertices);
@@ -218,15 +470,14 @@ void ScatterObjectBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
     glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
     int itemSize = uvsCount * sizeof(QVector2D);
     if (cache->updateIndices().size()) {
-        int pos = 0;
+        QVector<int> bufferSlots;
+        bufferSlots.reserve(updateSize);
         for (int i = 0; i < updateSize; i++) {
             int index = cache->updateIndices().at(i);
-            if (renderArray.at(index).isVisible()) {
-                int dataPos = cache->bufferIndices().at(index);
-                glBufferSubData(GL_ARRAY_BUFFER, itemSize * dataPos, itemSize,
-                                &buffered_uvs.at(uvsCount * pos++));
-            }
+            if (renderArray.isVisible(index))
+                bufferSlots.append(cache->bufferIndices().at(index));
         }
+        uploadItems(bufferSlots, buffered_uvs.constData(), itemSize);
     } else {
         glBufferData(GL_ARRAY_BUFFER, itemSize * itemCount, &buffered_uvs.at(0), GL_STATIC_DRAW);
     }
@@ -236,8 +487,7 @@ void ScatterObjectBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
 uint ScatterObjectBufferHelper::createRangeGradientUVs(ScatterSeriesRenderCache *cache,
                                                        QVector<QVector2D> &buffered_uvs)
 {
-    ObjectHelper *dotObj = cache->object();
-    const int uvsCount = dotObj->indexedUVs().count();
+    const int uvsCount = uvCountPerItem(cache);
     const ScatterRenderItemArray &renderArray = cache->renderArray();
     const bool updateAll = (cache->updateIndices().size() == 0);
     const int updateSize = updateAll ? renderArray.size() : cache->updateIndices().size();
@@ -249,11 +499,10 @@ uint ScatterObjectBufferHelper::createRangeGradientUVs(ScatterSeriesRenderCache
     uint pos = 0;
     for (int i = 0; i < updateSize; i++) {
         int index = updateAll ? i : cache->updateIndices().at(i);
-        const ScatterRenderItem &item = renderArray.at(index);
-        if (!item.isVisible())
+        if (!renderArray.isVisible(index))
             continue;
 
-        float y = ((item.translation().y() + m_scaleY) * 0.5f) / m_scaleY;
+        float y = ((renderArray.translation(index).y() + m_scaleY) * 0.5f) / m_scaleY;
 
         // Avoid values near gradient texel boundary, as this causes artifacts
         // with some graphics cards.
@@ -288,8 +537,7 @@ uint ScatterObjectBufferHelper::createObjectGradientUVs(ScatterSeriesRenderCache
     uv.setX(0.0f);
     uint pos = 0;
     for (uint i = 0; i < renderArraySize; i++) {
-        const ScatterRenderItem &item = renderArray.at(i);
-        if (!item.isVisible())
+        if (!renderArray.isVisible(i))
             continue;
 
         int offset = pos * uvsCount;
@@ -306,6 +554,14 @@ uint ScatterObjectBufferHelper::createObjectGradientUVs(ScatterSeriesRenderCache
 
 void ScatterObjectBufferHelper::update(ScatterSeriesRenderCache *cache, qreal dotScale)
 {
+    finishPendingUpload();
+    m_selectionColorsDirty = true;
+
+    if (m_instanced) {
+        updateInstances(cache, dotScale);
+        return;
+    }
+
     ObjectHelper *dotObj = cache->object();
     const ScatterRenderItemArray &renderArray = cache->renderArray();
     const bool updateAll = (cache->updateIndices().size() == 0);
@@ -342,23 +598,24 @@ void ScatterObjectBufferHelper::update(ScatterSeriesRenderCache *cache, qreal do
     int itemCount = 0;
     for (int i = 0; i < updateSize; i++) {
         int index = updateAll ? i : cache->updateIndices().at(i);
-        const ScatterRenderItem &item = renderArray.at(index);
-        if (!item.isVisible())
+        if (!renderArray.isVisible(index))
             continue;
 
+        const QVector3D translation = renderArray.translation(index);
+        const QQuaternion rotation = renderArray.rotation(index);
         const int offset = itemCount * verticeCount;
-        if (item.rotation().isIdentity()) {
+        if (rotation.isIdentity()) {
             for (int j = 0; j < verticeCount; j++)
-                buffered_vertices[j + offset] = scaled_vertices[j] + item.translation();
+                buffered_vertices[j + offset] = scaled_vertices[j] + translation;
         } else {
             QMatrix4x4 matrix;
-            matrix.rotate(seriesRotation * item.rotation());
+            matrix.rotate(seriesRotation * rotation);
             modelMatrix = matrix.transposed();
             modelMatrix.scale(modelScaler);
 
             for (int j = 0; j < verticeCount; j++)
                 buffered_vertices[j + offset] = indexed_vertices[j] * modelMatrix
-                        + item.translation();
+                        + translation;
         }
         itemCount++;
     }
@@ -371,15 +628,14 @@ void ScatterObjectBufferHelper::update(ScatterSeriesRenderCache *cache, qreal do
                          &buffered_vertices.at(0), GL_STATIC_DRAW);
         }
     } else {
-        itemCount = 0;
+        QVector<int> bufferSlots;
+        bufferSlots.reserve(itemCount);
         for (int i = 0; i < updateSize; i++) {
-            int index = updateAll ? i : cache->updateIndices().at(i);
-            if (renderArray.at(index).isVisible()) {
-                glBufferSubData(GL_ARRAY_BUFFER, cache->bufferIndices().at(index) * sizeOfItem,
-                                sizeOfItem, &buffered_vertices.at(itemCount * verticeCount));
-                itemCount++;
-            }
+            int index = cache->updateIndices().at(i);
+            if (renderArray.isVisible(index))
+                bufferSlots.append(cache->bufferIndices().at(index));
         }
+        uploadItems(bufferSlots, buffered_vertices.constData(), sizeOfItem);
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -49,15 +49,27 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 class ScatterObjectBufferHelper : public AbstractObjectHelper
 {
 public:
-    ScatterObjectBufferHelper();
+    ScatterObjectBufferHelper(bool instanced = false);
     virtual ~ScatterObjectBufferHelper();
 
     void fullLoad(ScatterSeriesRenderCache *cache, qreal dotScale);
     void update(ScatterSeriesRenderCache *cache, qreal dotScale);
     void updateUVs(ScatterSeriesRenderCache *cache);
+    void updateSelectionColors(ScatterSeriesRenderCache *cache, int indexOffset);
     void setScaleY(float scale) { m_scaleY = scale; }
 
+    inline bool isInstanced() const { return m_instanced; }
+    inline GLuint instanceCount() const { return m_instanceCount; }
+    inline GLuint instancePositionBuf() const { return m_instancePositionBuffer; }
+    inline GLuint instanceRotationBuf() const { return m_instanceRotationBuffer; }
+
+protected:
+    void swapPendingBuffers();
+
 private:
+    void loadInstances(ScatterSeriesRenderCache *cache, qreal dotScale);
+    void updateInstances(ScatterSeriesRenderCache *cache, qreal dotScale);
+    int uvCountPerItem(ScatterSeriesRenderCache *cache) const;
     uint createRangeGradientUVs(ScatterSeriesRenderCache *cache,
                                 QVector<QVector2D> &buffered_uvs);
     uint createObjectGradientUVs(ScatterSeriesRenderCache *cache,
@@ -65,6 +77,12 @@ private:
                                  const QVector<QVector3D> &indexed_vertices);
 
     float m_scaleY;
+    bool m_instanced;
+    GLuint m_instanceCount;
+    GLuint m_instancePositionBuffer;
+    GLuint m_instanceRotationBuffer; // Zero if no item is rotated
+    bool m_selectionColorsDirty;
+    int m_selectionIndexOffset;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
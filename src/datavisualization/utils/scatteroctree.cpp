@@ -0,0 +1,388 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "scatteroctree_p.h"
+#include "utils_p.h"
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QMap>
+#include <QtGui/QVector4D>
+#include <QtCore/qmath.h>
+#include <float.h>
+#include <string.h>
+
+QT_BEGIN_NAMESPACE_DATAVISUALIZATION
+
+const int octreeLeafSize = 32;
+const int octreeMaxDepth = 16;
+// Number of items representing a node that isn't refined in level of detail selection
+const int lodNodeSampleCount = 8;
+
+static inline int sampleCount(const ScatterOctree::Node &node)
+{
+    return qMin(node.itemCount, lodNodeSampleCount);
+}
+
+// Returns the size of the node bounds divided by the distance to the camera, which is
+// proportional to the size of the node on the screen
+static float projectedSize(const QMatrix4x4 &projectionViewMatrix,
+                           const ScatterOctree::Node &node)
+{
+    const QVector4D center = projectionViewMatrix
+            * QVector4D((node.minimum + node.maximum) * 0.5f, 1.0f);
+    const float size = (node.maximum - node.minimum).length();
+    // Nodes around the camera plane are refined first
+    if (center.w() < size)
+        return FLT_MAX;
+    return size / center.w();
+}
+
+ScatterOctree::ScatterOctree()
+{
+}
+
+void ScatterOctree::build(const ScatterRenderItemArray &renderArray)
+{
+    clear();
+
+    const int size = renderArray.size();
+    m_itemIndices.reserve(renderArray.visibleCount());
+    for (int i = 0; i < size; i++) {
+        if (renderArray.isVisible(i))
+            m_itemIndices.append(i);
+    }
+
+    if (!m_itemIndices.isEmpty()) {
+        // Octant of each item followed by the items sorted by octant
+        QVector<int> scratch(2 * m_itemIndices.size());
+        m_nodes.append(Node());
+        buildNode(renderArray, 0, 0, m_itemIndices.size(), 0, scratch);
+    }
+}
+
+void ScatterOctree::clear()
+{
+    m_nodes.clear();
+    m_itemIndices.clear();
+}
+
+void ScatterOctree::buildNode(const ScatterRenderItemArray &renderArray, int nodeIndex,
+                              int firstItem, int itemCount, int depth, QVector<int> &scratch)
+{
+    const float *x = renderArray.xData();
+    const float *y = renderArray.yData();
+    const float *z = renderArray.zData();
+    int *items = m_itemIndices.data() + firstItem;
+
+    QVector3D minimum(FLT_MAX, FLT_MAX, FLT_MAX);
+    QVector3D maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (int i = 0; i < itemCount; i++) {
+        const int index = items[i];
+        minimum.setX(qMin(minimum.x(), x[index]));
+        minimum.setY(qMin(minimum.y(), y[index]));
+        minimum.setZ(qMin(minimum.z(), z[index]));
+        maximum.setX(qMax(maximum.x(), x[index]));
+        maximum.setY(qMax(maximum.y(), y[index]));
+        maximum.setZ(qMax(maximum.z(), z[index]));
+    }
+
+    Node &node = m_nodes[nodeIndex];
+    node.minimum = minimum;
+    node.maximum = maximum;
+    node.firstChild = -1;
+    node.childCount = 0;
+    node.firstItem = firstItem;
+    node.itemCount = itemCount;
+
+    if (itemCount <= octreeLeafSize || depth >= octreeMaxDepth)
+        return;
+
+    // Sort the items into octants around the center of the bounds
+    const QVector3D center = (minimum + maximum) * 0.5f;
+    int octantCounts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    int *octants = scratch.data() + firstItem;
+    int *sorted = octants + m_itemIndices.size();
+    for (int i = 0; i < itemCount; i++) {
+        const int index = items[i];
+        const int octant = (x[index] >= center.x() ? 1 : 0)
+                | (y[index] >= center.y() ? 2 : 0)
+                | (z[index] >= center.z() ? 4 : 0);
+        octants[i] = octant;
+        octantCounts[octant]++;
+    }
+
+    int octantStarts[8];
+    int childCount = 0;
+    int start = 0;
+    for (int i = 0; i < 8; i++) {
+        octantStarts[i] = start;
+        start += octantCounts[i];
+        if (octantCounts[i])
+            childCount++;
+    }
+    // All items are in one octant when the bounds are too small to split
+    if (childCount < 2)
+        return;
+
+    for (int i = 0; i < itemCount; i++)
+        sorted[octantStarts[octants[i]]++] = items[i];
+    memcpy(items, sorted, itemCount * sizeof(int));
+
+    const int firstChild = m_nodes.size();
+    node.firstChild = firstChild;
+    node.childCount = childCount;
+    m_nodes.resize(firstChild + childCount);
+
+    int child = firstChild;
+    int childFirstItem = firstItem;
+    for (int i = 0; i < 8; i++) {
+        if (octantCounts[i]) {
+            buildNode(renderArray, child++, childFirstItem, octantCounts[i], depth + 1, scratch);
+            childFirstItem += octantCounts[i];
+        }
+    }
+}
+
+int ScatterOctree::pick(const ScatterRenderItemArray &renderArray, const QVector3D &origin,
+                        const QVector3D &direction, float radius, float &distance,
+                        const uchar *drawn) const
+{
+    int pickedIndex = -1;
+    if (m_nodes.isEmpty())
+        return pickedIndex;
+
+    const float *x = renderArray.xData();
+    const float *y = renderArray.yData();
+    const float *z = renderArray.zData();
+    const float radiusSquared = radius * radius;
+    const QVector3D margin(radius, radius, radius);
+    distance = FLT_MAX;
+
+    QVarLengthArray<int, 128> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.last());
+        stack.removeLast();
+
+        const float boxDistance = Utils::rayBoxDistance(origin, direction, node.minimum - margin,
+                                                        node.maximum + margin);
+        if (boxDistance < 0.0f || boxDistance > distance)
+            continue;
+
+        if (node.firstChild >= 0) {
+            for (int i = 0; i < node.childCount; i++)
+                stack.append(node.firstChild + i);
+            continue;
+        }
+
+        const int lastItem = node.firstItem + node.itemCount;
+        for (int i = node.firstItem; i < lastItem; i++) {
+            const int index = m_itemIndices.at(i);
+            if (drawn && !drawn[index])
+                continue;
+            const QVector3D toItem(x[index] - origin.x(), y[index] - origin.y(),
+                                   z[index] - origin.z());
+            const float closest = QVector3D::dotProduct(toItem, direction);
+            const float missSquared = toItem.lengthSquared() - closest * closest;
+            if (missSquared > radiusSquared)
+                continue;
+            const float halfChord = qSqrt(radiusSquared - missSquared);
+            if (closest + halfChord < 0.0f)
+                continue; // Behind the ray origin
+            const float hitDistance = qMax(0.0f, closest - halfChord);
+            if (hitDistance < distance) {
+                distance = hitDistance;
+                pickedIndex = index;
+            }
+        }
+    }
+
+    return pickedIndex;
+}
+
+void ScatterOctree::selectLod(const QMatrix4x4 &projectionViewMatrix, float margin, int budget,
+                              QVector<int> &indices) const
+{
+    indices.clear();
+    if (m_nodes.isEmpty() || budget <= 0)
+        return;
+
+    const QVector3D marginVector(margin, margin, margin);
+    QMultiMap<float, int> unrefinedNodes; // By projected size
+    QVector<int> refinedLeaves;
+    int cost = 0;
+
+    const Node &root = m_nodes.at(0);
+    if (boxViewRelation(projectionViewMatrix, root.minimum - marginVector,
+                        root.maximum + marginVector) != OutsideView) {
+        unrefinedNodes.insert(projectedSize(projectionViewMatrix, root), 0);
+        cost = sampleCount(root);
+    }
+
+    while (!unrefinedNodes.isEmpty()) {
+        QMultiMap<float, int>::iterator largest = unrefinedNodes.end();
+        --largest;
+        const int nodeIndex = largest.value();
+        const Node &node = m_nodes.at(nodeIndex);
+
+        int refinedCost = 0;
+        int visibleChildren[8];
+        int visibleChildCount = 0;
+        if (node.firstChild < 0) {
+            refinedCost = node.itemCount;
+        } else {
+            for (int i = 0; i < node.childCount; i++) {
+                const int childIndex = node.firstChild + i;
+                const Node &child = m_nodes.at(childIndex);
+                if (boxViewRelation(projectionViewMatrix, child.minimum - marginVector,
+                                    child.maximum + marginVector) != OutsideView) {
+                    visibleChildren[visibleChildCount++] = childIndex;
+                    refinedCost += sampleCount(child);
+                }
+            }
+        }
+
+        const int newCost = cost - sampleCount(node) + refinedCost;
+        if (newCost > budget)
+            break;
+        cost = newCost;
+        unrefinedNodes.erase(largest);
+
+        if (node.firstChild < 0) {
+            refinedLeaves.append(nodeIndex);
+        } else {
+            for (int i = 0; i < visibleChildCount; i++) {
+                const int childIndex = visibleChildren[i];
+                unrefinedNodes.insert(projectedSize(projectionViewMatrix,
+                                                    m_nodes.at(childIndex)), childIndex);
+            }
+        }
+    }
+
+    indices.reserve(cost);
+    foreach (int nodeIndex, refinedLeaves) {
+        const Node &node = m_nodes.at(nodeIndex);
+        const int lastItem = node.firstItem + node.itemCount;
+        for (int i = node.firstItem; i < lastItem; i++)
+            indices.append(m_itemIndices.at(i));
+    }
+    foreach (int nodeIndex, unrefinedNodes) {
+        // Items of a subtree are ordered by octant, so evenly spaced items spread over it
+        const Node &node = m_nodes.at(nodeIndex);
+        const int samples = sampleCount(node);
+        for (int i = 0; i < samples; i++) {
+            const int item = node.firstItem + int(qint64(i) * node.itemCount / samples);
+            indices.append(m_itemIndices.at(item));
+        }
+    }
+}
+
+bool ScatterOctree::selectVisible(const QMatrix4x4 &projectionViewMatrix, float margin,
+                                  QVector<int> &indices) const
+{
+    indices.clear();
+    if (m_nodes.isEmpty())
+        return false;
+
+    const QVector3D marginVector(margin, margin, margin);
+    QVarLengthArray<int, 128> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const int nodeIndex = stack.last();
+        const Node &node = m_nodes.at(nodeIndex);
+        stack.removeLast();
+
+        const ViewRelation relation = boxViewRelation(projectionViewMatrix,
+                                                      node.minimum - marginVector,
+                                                      node.maximum + marginVector);
+        if (relation == OutsideView)
+            continue;
+        if (relation == InsideView && nodeIndex == 0)
+            return false;
+
+        if (relation == InsideView || node.firstChild < 0) {
+            // Items of partially visible leaves are left for the graphics driver to clip
+            const int lastItem = node.firstItem + node.itemCount;
+            for (int i = node.firstItem; i < lastItem; i++)
+                indices.append(m_itemIndices.at(i));
+        } else {
+            for (int i = 0; i < node.childCount; i++)
+                stack.append(node.firstChild + i);
+        }
+    }
+    return true;
+}
+
+// Classifies the box against the clip planes of the view. Boxes that are not fully outside
+// any single plane are considered to intersect the view, even if they don't.
+ScatterOctree::ViewRelation ScatterOctree::boxViewRelation(
+        const QMatrix4x4 &projectionViewMatrix, const QVector3D &minimum,
+        const QVector3D &maximum)
+{
+    int outsideCounts[6] = {0, 0, 0, 0, 0, 0};
+    bool inside = true;
+    for (int i = 0; i < 8; i++) {
+        const QVector4D corner = projectionViewMatrix
+                * QVector4D((i & 1) ? maximum.x() : minimum.x(),
+                            (i & 2) ? maximum.y() : minimum.y(),
+                            (i & 4) ? maximum.z() : minimum.z(), 1.0f);
+        bool cornerInside = true;
+        if (corner.x() < -corner.w()) {
+            outsideCounts[0]++;
+            cornerInside = false;
+        }
+        if (corner.x() > corner.w()) {
+            outsideCounts[1]++;
+            cornerInside = false;
+        }
+        if (corner.y() < -corner.w()) {
+            outsideCounts[2]++;
+            cornerInside = false;
+        }
+        if (corner.y() > corner.w()) {
+            outsideCounts[3]++;
+            cornerInside = false;
+        }
+        if (corner.z() < -corner.w()) {
+            outsideCounts[4]++;
+            cornerInside = false;
+        }
+        if (corner.z() > corner.w()) {
+            outsideCounts[5]++;
+            cornerInside = false;
+        }
+        inside = inside && cornerInside;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (outsideCounts[i] == 8)
+            return OutsideView;
+    }
+    return inside ? InsideView : IntersectsView;
+}
+
+QT_END_NAMESPACE_DATAVISUALIZATION
@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+
+#ifndef SCATTEROCTREE_P_H
+#define SCATTEROCTREE_P_H
+
+#include "datavisualizationglobal_p.h"
+#include "scatterrenderitem_p.h"
+#include <QtGui/QMatrix4x4>
+
+QT_BEGIN_NAMESPACE_DATAVISUALIZATION
+
+// Octree over the translations of the visible items of a scatter render item array.
+// Nodes store the tight bounds of their items, and the items of each subtree are stored
+// contiguously in the item index array, so that a whole subtree can be handled as one range.
+class QT_DATAVISUALIZATION_EXPORT ScatterOctree
+{
+public:
+    struct Node {
+        QVector3D minimum;
+        QVector3D maximum;
+        int firstChild; // Index of the first child node, or -1 for leaves
+        int childCount;
+        int firstItem;  // Range of the subtree items in itemIndices()
+        int itemCount;
+    };
+
+    ScatterOctree();
+
+    void build(const ScatterRenderItemArray &renderArray);
+    void clear();
+
+    inline bool isEmpty() const { return m_nodes.isEmpty(); }
+    inline const QVector<Node> &nodes() const { return m_nodes; }
+    inline const QVector<int> &itemIndices() const { return m_itemIndices; }
+
+    // Returns the index of the nearest item whose sphere of the given radius is hit by the ray,
+    // or -1 if no item is hit. Direction must be normalized. If drawn is given, items whose
+    // entry in it is zero are skipped.
+    int pick(const ScatterRenderItemArray &renderArray, const QVector3D &origin,
+             const QVector3D &direction, float radius, float &distance,
+             const uchar *drawn = 0) const;
+
+    // Selects a representative subset of at most budget items for the view. Nodes are refined
+    // in order of their projected size while the budget allows. Unrefined nodes are represented
+    // by evenly spaced items of their range. Nodes outside the view expanded by margin
+    // are skipped.
+    void selectLod(const QMatrix4x4 &projectionViewMatrix, float margin, int budget,
+                   QVector<int> &indices) const;
+
+    // Collects the items of the nodes that are at least partially inside the view expanded
+    // by margin. Returns false without collecting anything if the whole tree is inside the view.
+    bool selectVisible(const QMatrix4x4 &projectionViewMatrix, float margin,
+                       QVector<int> &indices) const;
+
+    enum ViewRelation {
+        OutsideView,
+        InsideView,
+        IntersectsView
+    };
+    static ViewRelation boxViewRelation(const QMatrix4x4 &projectionViewMatrix,
+                                        const QVector3D &minimum, const QVector3D &maximum);
+
+private:
+    void buildNode(const ScatterRenderItemArray &renderArray, int nodeIndex,
+                   int firstItem, int itemCount, int depth, QVector<int> &scratch);
+
+    QVector<Node> m_nodes; // Root node is the first one
+    QVector<int> m_itemIndices;
+};
+
+QT_END_NAMESPACE_DATAVISUALIZATION
+
+#endif
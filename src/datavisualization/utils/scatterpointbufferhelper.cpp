@@ -33,10 +33,22 @@
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 const QVector3D hiddenPos(-1000.0f, -1000.0f, -1000.0f);
+const int pointUploadChunkSize = 4096;
+// Updates touching more than 1 / pointFullUploadDivisor of the points re-upload all of them
+const int pointFullUploadDivisor = 4;
+
+static inline QVector3D bufferedPoint(const ScatterRenderItemArray &renderArray, int index)
+{
+    return renderArray.isVisible(index) ? renderArray.translation(index) : hiddenPos;
+}
 
 ScatterPointBufferHelper::ScatterPointBufferHelper()
     : m_pointbuffer(0),
-      m_oldRemoveIndex(-1)
+      m_oldRemoveIndex(-1),
+      m_capacity(0),
+      m_subsetIndexCount(0),
+      m_selectionColorCount(0),
+      m_selectionIndexOffset(0)
 {
 }
 
@@ -53,14 +65,17 @@ GLuint ScatterPointBufferHelper::pointBuf()
     return m_pointbuffer;
 }
 
-void ScatterPointBufferHelper::pushPoint(uint pointIndex)
+void ScatterPointBufferHelper::pushPoint(ScatterSeriesRenderCache *cache, uint pointIndex)
 {
+    finishPendingUpload();
+
     glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
 
     // Pop the previous point if it is still pushed
-    if (m_oldRemoveIndex >= 0) {
+    if (m_oldRemoveIndex >= 0 && m_oldRemoveIndex < cache->renderArray().size()) {
+        const QVector3D oldPoint = bufferedPoint(cache->renderArray(), m_oldRemoveIndex);
         glBufferSubData(GL_ARRAY_BUFFER, m_oldRemoveIndex * sizeof(QVector3D),
-                        sizeof(QVector3D), &m_bufferedPoints.at(m_oldRemoveIndex));
+                        sizeof(QVector3D), &oldPoint);
     }
 
     glBufferSubData(GL_ARRAY_BUFFER, pointIndex * sizeof(QVector3D),
@@ -72,12 +87,14 @@ void ScatterPointBufferHelper::pushPoint(uint pointIndex)
     m_oldRemoveIndex = pointIndex;
 }
 
-void ScatterPointBufferHelper::popPoint()
+void ScatterPointBufferHelper::popPoint(ScatterSeriesRenderCache *cache)
 {
-    if (m_oldRemoveIndex >= 0) {
+    if (m_oldRemoveIndex >= 0 && m_oldRemoveIndex < cache->renderArray().size()) {
+        finishPendingUpload();
+        const QVector3D oldPoint = bufferedPoint(cache->renderArray(), m_oldRemoveIndex);
         glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
         glBufferSubData(GL_ARRAY_BUFFER, m_oldRemoveIndex * sizeof(QVector3D),
-                        sizeof(QVector3D), &m_bufferedPoints.at(m_oldRemoveIndex));
+                        sizeof(QVector3D), &oldPoint);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
@@ -86,44 +103,54 @@ void ScatterPointBufferHelper::popPoint()
 
 void ScatterPointBufferHelper::load(ScatterSeriesRenderCache *cache)
 {
-    ScatterRenderItemArray &renderArray = cache->renderArray();
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
     const int renderArraySize = renderArray.size();
-    m_indexCount = 0;
+    // New buffer has no pushed point
+    m_oldRemoveIndex = -1;
+
+    if (renderArray.visibleCount()
+            && stagesUpload(qint64(renderArraySize) * qint64(sizeof(QVector3D)))) {
+        // Keep drawing the old points until the new ones have been uploaded.
+        QVector<QVector3D> points(renderArraySize);
+        createPoints(renderArray, 0, renderArraySize, points.data());
+        stageBuffer(GL_ARRAY_BUFFER, &m_pointbuffer, points,
+                    renderArraySize * sizeof(QVector3D), GL_DYNAMIC_DRAW);
 
+        QVector<QVector2D> buffered_uvs;
+        if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
+            createRangeGradientUVs(cache, buffered_uvs);
+        stageBuffer(GL_ARRAY_BUFFER, &m_uvbuffer, buffered_uvs,
+                    buffered_uvs.size() * sizeof(QVector2D), GL_STATIC_DRAW);
+        setStagedCounts(renderArraySize);
+        return;
+    }
+
+    discardPendingUpload();
+    m_indexCount = 0;
     if (m_meshDataLoaded) {
         // Delete old data
         glDeleteBuffers(1, &m_pointbuffer);
         glDeleteBuffers(1, &m_uvbuffer);
-        m_bufferedPoints.clear();
+        glDeleteBuffers(1, &m_elementbuffer);
         m_pointbuffer = 0;
         m_uvbuffer = 0;
+        m_elementbuffer = 0;
     }
-
-    bool itemsVisible = false;
-    m_bufferedPoints.resize(renderArraySize);
-    for (int i = 0; i < renderArraySize; i++) {
-        const ScatterRenderItem &item = renderArray.at(i);
-        if (!item.isVisible()) {
-            m_bufferedPoints[i] = hiddenPos;
-        } else {
-            itemsVisible = true;
-            m_bufferedPoints[i] = item.translation();
-        }
-    }
+    m_subsetIndexCount = 0;
 
     QVector<QVector2D> buffered_uvs;
-    if (itemsVisible)
+    if (renderArray.visibleCount())
         m_indexCount = renderArraySize;
 
     if (m_indexCount > 0) {
         if (cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient)
             createRangeGradientUVs(cache, buffered_uvs);
 
+        m_capacity = renderArraySize;
         glGenBuffers(1, &m_pointbuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
-        glBufferData(GL_ARRAY_BUFFER, m_bufferedPoints.size() * sizeof(QVector3D),
-                     &m_bufferedPoints.at(0),
-                     GL_DYNAMIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, renderArraySize * sizeof(QVector3D), 0, GL_DYNAMIC_DRAW);
+        uploadPoints(renderArray, 0, renderArraySize);
 
         if (buffered_uvs.size()) {
             glGenBuffers(1, &m_uvbuffer);
@@ -138,34 +165,113 @@ void ScatterPointBufferHelper::load(ScatterSeriesRenderCache *cache)
     }
 }
 
+// Uploads the render items from the index start onwards, which have been appended to the end
+// of the render array since the last load. The buffers grow geometrically, so that streaming
+// items in small batches doesn't reallocate them every time.
+void ScatterPointBufferHelper::append(ScatterSeriesRenderCache *cache, int start)
+{
+    finishPendingUpload();
+
+    if (!m_meshDataLoaded || m_indexCount <= 0) {
+        load(cache);
+        return;
+    }
+
+    const ScatterRenderItemArray &renderArray = cache->renderArray();
+    const int renderArraySize = renderArray.size();
+    bool reallocated = false;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
+    if (renderArraySize > m_capacity) {
+        // Reallocation discards the old contents, so all points need to be uploaded again
+        m_capacity = qMax(renderArraySize, 2 * m_capacity);
+        glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(QVector3D), 0, GL_DYNAMIC_DRAW);
+        start = 0;
+        reallocated = true;
+    }
+    uploadPoints(renderArray, start, renderArraySize - start);
+
+    if (m_uvbuffer && cache->colorStyle() == Q3DTheme::ColorStyleRangeGradient) {
+        QVector<QVector2D> buffered_uvs(renderArraySize - start);
+        for (int i = start; i < renderArraySize; i++)
+            buffered_uvs[i - start] = rangeGradientUV(renderArray, i);
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
+        if (reallocated)
+            glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(QVector2D), 0, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(QVector2D),
+                        buffered_uvs.size() * sizeof(QVector2D), buffered_uvs.constData());
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_indexCount = renderArraySize;
+}
+
 void ScatterPointBufferHelper::update(ScatterSeriesRenderCache *cache)
 {
+    finishPendingUpload();
+
     // It may be that the buffer hasn't yet been initialized, in case the entire series was
     // hidden items. No need to update in that case.
     if (m_indexCount > 0) {
         const ScatterRenderItemArray &renderArray = cache->renderArray();
-        const int updateSize = cache->updateIndices().size();
+        const QVector<int> &updateIndices = cache->updateIndices();
+        const int updateSize = updateIndices.size();
 
         glBindBuffer(GL_ARRAY_BUFFER, m_pointbuffer);
-        for (int i = 0; i < updateSize; i++) {
-            int index = cache->updateIndices().at(i);
-            const ScatterRenderItem &item = renderArray.at(index);
-            if (!item.isVisible())
-                m_bufferedPoints[index] = hiddenPos;
-            else
-                m_bufferedPoints[index] = item.translation();
-
-            if (index != m_oldRemoveIndex) {
-                glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(QVector3D),
-                                sizeof(QVector3D), &m_bufferedPoints.at(index));
+        if (updateSize > renderArray.size() / pointFullUploadDivisor) {
+            // Uploading everything is cheaper than a large number of scattered small uploads
+            uploadPoints(renderArray, 0, renderArray.size());
+        } else {
+            QVector<QVector3D> points(updateSize);
+            for (int i = 0; i < updateSize; i++) {
+                const int index = updateIndices.at(i);
+                points[i] = (index == m_oldRemoveIndex) ? hiddenPos
+                                                        : bufferedPoint(renderArray, index);
             }
+            uploadItems(updateIndices, points.constData(), sizeof(QVector3D));
         }
         glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 }
 
+void ScatterPointBufferHelper::uploadPoints(const ScatterRenderItemArray &renderArray,
+                                            int start, int count)
+{
+    // The render array keeps translation components in separate arrays, so the points are
+    // interleaved into the bound buffer in fixed size chunks instead of via a full copy.
+    const int chunkSize = qMin(count, pointUploadChunkSize);
+    QVector<QVector3D> chunk(chunkSize);
+
+    for (int offset = 0; offset < count; offset += chunkSize) {
+        const int chunkStart = start + offset;
+        const int chunkCount = qMin(chunkSize, count - offset);
+        createPoints(renderArray, chunkStart, chunkCount, chunk.data());
+        glBufferSubData(GL_ARRAY_BUFFER, chunkStart * sizeof(QVector3D),
+                        chunkCount * sizeof(QVector3D), chunk.constData());
+    }
+}
+
+void ScatterPointBufferHelper::createPoints(const ScatterRenderItemArray &renderArray,
+                                            int start, int count, QVector3D *points) const
+{
+    const float *x = renderArray.xData();
+    const float *y = renderArray.yData();
+    const float *z = renderArray.zData();
+    for (int i = 0; i < count; i++) {
+        const int index = start + i;
+        if (renderArray.isVisible(index) && index != m_oldRemoveIndex)
+            points[i] = QVector3D(x[index], y[index], z[index]);
+        else
+            points[i] = hiddenPos;
+    }
+}
+
 void ScatterPointBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
 {
+    finishPendingUpload();
+
     // It may be that the buffer hasn't yet been initialized, in case the entire series was
     // hidden items. No need to update in that case.
     if (m_indexCount > 0) {
@@ -176,18 +282,14 @@ void ScatterPointBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
             if (!m_uvbuffer)
                 glGenBuffers(1, &m_uvbuffer);
 
-            int updateSize = cache->updateIndices().size();
             glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-            if (updateSize) {
-                for (int i = 0; i < updateSize; i++) {
-                    int index = cache->updateIndices().at(i);
-                    glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(QVector2D),
-                                    sizeof(QVector2D), &buffered_uvs.at(i));
-
-                }
+            if (cache->updateIndices().size()) {
+                uploadItems(cache->updateIndices(), buffered_uvs.constData(), sizeof(QVector2D));
             } else {
-                glBufferData(GL_ARRAY_BUFFER, buffered_uvs.size() * sizeof(QVector2D),
-                             &buffered_uvs.at(0), GL_STATIC_DRAW);
+                // Keep room for appended points
+                glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(QVector2D), 0, GL_STATIC_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, buffered_uvs.size() * sizeof(QVector2D),
+                                &buffered_uvs.at(0));
             }
 
             glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -195,6 +297,54 @@ void ScatterPointBufferHelper::updateUVs(ScatterSeriesRenderCache *cache)
     }
 }
 
+// Restricts drawing to the points at the given indices, or draws all points if indices is empty
+void ScatterPointBufferHelper::setSubsetIndices(const QVector<int> &indices)
+{
+    m_subsetIndexCount = indices.size();
+    if (m_indexCount > 0 && m_subsetIndexCount > 0) {
+        if (!m_elementbuffer)
+            glGenBuffers(1, &m_elementbuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_subsetIndexCount * sizeof(GLuint),
+                     indices.constData(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        m_subsetIndexCount = 0;
+    }
+}
+
+// Gives each point the selection color of its index, offset by the items of the preceding
+// series. The colors only depend on the point count and the offset, so they are reused until
+// either changes.
+void ScatterPointBufferHelper::updateSelectionColors(int indexOffset)
+{
+    finishPendingUpload();
+
+    const int pointCount = m_indexCount;
+    if (pointCount <= 0 || (pointCount == m_selectionColorCount
+                            && indexOffset == m_selectionIndexOffset)) {
+        return;
+    }
+
+    QVector<GLubyte> colors(pointCount * 4);
+    GLubyte *color = colors.data();
+    for (int i = 0; i < pointCount; i++, color += 4)
+        writeSelectionColor(indexOffset + i, color);
+    loadSelectionColors(colors);
+
+    m_selectionColorCount = pointCount;
+    m_selectionIndexOffset = indexOffset;
+}
+
+void ScatterPointBufferHelper::swapPendingBuffers()
+{
+    AbstractObjectHelper::swapPendingBuffers();
+
+    // The subset indices refer to the old points
+    m_capacity = m_indexCount;
+    m_subsetIndexCount = 0;
+}
+
 void ScatterPointBufferHelper::createRangeGradientUVs(ScatterSeriesRenderCache *cache,
                                                       QVector<QVector2D> &buffered_uvs)
 {
@@ -203,15 +353,9 @@ void ScatterPointBufferHelper::createRangeGradientUVs(ScatterSeriesRenderCache *
     const int updateSize = updateAll ? renderArray.size() : cache->updateIndices().size();
     buffered_uvs.resize(updateSize);
 
-    QVector2D uv;
-    uv.setX(0.0f);
     for (int i = 0; i < updateSize; i++) {
         int index = updateAll ? i : cache->updateIndices().at(i);
-        const ScatterRenderItem &item = renderArray.at(index);
-
-        float y = ((item.translation().y() + m_scaleY) * 0.5f) / m_scaleY;
-        uv.setY(y);
-        buffered_uvs[i] = uv;
+        buffered_uvs[i] = rangeGradientUV(renderArray, index);
     }
 }
 
@@ -43,6 +43,7 @@
 #include "datavisualizationglobal_p.h"
 #include "abstractobjecthelper_p.h"
 #include "scatterseriesrendercache_p.h"
+#include <QtGui/QVector2D>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -54,24 +55,41 @@ public:
 
     GLuint pointBuf();
 
-    void pushPoint(uint pointIndex);
-    void popPoint();
+    void pushPoint(ScatterSeriesRenderCache *cache, uint pointIndex);
+    void popPoint(ScatterSeriesRenderCache *cache);
     void load(ScatterSeriesRenderCache *cache);
+    void append(ScatterSeriesRenderCache *cache, int start);
     void update(ScatterSeriesRenderCache *cache);
     void setScaleY(float scale) { m_scaleY = scale; }
     void updateUVs(ScatterSeriesRenderCache *cache);
+    void setSubsetIndices(const QVector<int> &indices);
+    void updateSelectionColors(int indexOffset);
+    inline int subsetIndexCount() const { return m_subsetIndexCount; }
 
 public:
     GLuint m_pointbuffer;
 
+protected:
+    void swapPendingBuffers();
+
 private:
     void createRangeGradientUVs(ScatterSeriesRenderCache *cache,
                                 QVector<QVector2D> &buffered_uvs);
+    void uploadPoints(const ScatterRenderItemArray &renderArray, int start, int count);
+    void createPoints(const ScatterRenderItemArray &renderArray, int start, int count,
+                      QVector3D *points) const;
+    inline QVector2D rangeGradientUV(const ScatterRenderItemArray &renderArray, int index) const
+    {
+        return QVector2D(0.0f, ((renderArray.yData()[index] + m_scaleY) * 0.5f) / m_scaleY);
+    }
 
 private:
-    QVector<QVector3D> m_bufferedPoints;
     int m_oldRemoveIndex;
     float m_scaleY;
+    int m_capacity; // Number of points the buffers have room for
+    int m_subsetIndexCount; // Number of points drawn via the element buffer, zero draws all
+    int m_selectionColorCount;
+    int m_selectionIndexOffset;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
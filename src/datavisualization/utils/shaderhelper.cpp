@@ -55,6 +55,10 @@ ShaderHelper::ShaderHelper(QObject *parent,
       m_positionAttr(0),
       m_uvAttr(0),
       m_normalAttr(0),
+      m_instancePositionAttr(0),
+      m_instanceRotationAttr(0),
+      m_instanceUVAttr(0),
+      m_selectionColorAttr(0),
       m_colorUniform(0),
       m_viewMatrixUniform(0),
       m_modelMatrixUniform(0),
@@ -74,6 +78,13 @@ ShaderHelper::ShaderHelper(QObject *parent,
       m_colorIndexUniform(0),
       m_cameraPositionRelativeToModelUniform(0),
       m_color8BitUniform(0),
+      m_valueWindowUniform(0),
+      m_brickMapUniform(0),
+      m_brickSizeUniform(0),
+      m_brickCountUniform(0),
+      m_skipEmptyBricksUniform(0),
+      m_occupiedMinUniform(0),
+      m_occupiedMaxUniform(0),
       m_textureDimensionsUniform(0),
       m_sampleCountUniform(0),
       m_alphaMultiplierUniform(0),
@@ -81,6 +92,13 @@ ShaderHelper::ShaderHelper(QObject *parent,
       m_minBoundsUniform(0),
       m_maxBoundsUniform(0),
       m_sliceFrameWidthUniform(0),
+      m_heightMapUniform(0),
+      m_heightMapSizeUniform(0),
+      m_heightMapScaleUniform(0),
+      m_heightMapOffsetUniform(0),
+      m_barLayoutUniform(0),
+      m_barScaleUniform(0),
+      m_barSelectionUniform(0),
       m_initialized(false)
 {
 }
@@ -118,6 +136,10 @@ void ShaderHelper::initialize()
     m_positionAttr = m_program->attributeLocation("vertexPosition_mdl");
     m_normalAttr = m_program->attributeLocation("vertexNormal_mdl");
     m_uvAttr = m_program->attributeLocation("vertexUV");
+    m_instancePositionAttr = m_program->attributeLocation("instancePosition");
+    m_instanceRotationAttr = m_program->attributeLocation("instanceRotation");
+    m_instanceUVAttr = m_program->attributeLocation("instanceUV");
+    m_selectionColorAttr = m_program->attributeLocation("selectionColor");
 
     m_mvpMatrixUniform = m_program->uniformLocation("MVP");
     m_viewMatrixUniform = m_program->uniformLocation("V");
@@ -138,6 +160,13 @@ void ShaderHelper::initialize()
     m_colorIndexUniform = m_program->uniformLocation("colorIndex");
     m_cameraPositionRelativeToModelUniform = m_program->uniformLocation("cameraPositionRelativeToModel");
     m_color8BitUniform = m_program->uniformLocation("color8Bit");
+    m_valueWindowUniform = m_program->uniformLocation("valueWindow");
+    m_brickMapUniform = m_program->uniformLocation("brickMap");
+    m_brickSizeUniform = m_program->uniformLocation("brickSize");
+    m_brickCountUniform = m_program->uniformLocation("brickCount");
+    m_skipEmptyBricksUniform = m_program->uniformLocation("skipEmptyBricks");
+    m_occupiedMinUniform = m_program->uniformLocation("occupiedMin");
+    m_occupiedMaxUniform = m_program->uniformLocation("occupiedMax");
     m_textureDimensionsUniform = m_program->uniformLocation("textureDimensions");
     m_sampleCountUniform = m_program->uniformLocation("sampleCount");
     m_alphaMultiplierUniform = m_program->uniformLocation("alphaMultiplier");
@@ -145,6 +174,13 @@ void ShaderHelper::initialize()
     m_minBoundsUniform = m_program->uniformLocation("minBounds");
     m_maxBoundsUniform = m_program->uniformLocation("maxBounds");
     m_sliceFrameWidthUniform = m_program->uniformLocation("sliceFrameWidth");
+    m_heightMapUniform = m_program->uniformLocation("heightMap");
+    m_heightMapSizeUniform = m_program->uniformLocation("heightMapSize");
+    m_heightMapScaleUniform = m_program->uniformLocation("heightMapScale");
+    m_heightMapOffsetUniform = m_program->uniformLocation("heightMapOffset");
+    m_barLayoutUniform = m_program->uniformLocation("barLayout");
+    m_barScaleUniform = m_program->uniformLocation("barScale");
+    m_barSelectionUniform = m_program->uniformLocation("barSelection");
     m_initialized = true;
 }
 
@@ -345,6 +381,55 @@ GLint ShaderHelper::color8Bit()
     return m_color8BitUniform;
 }
 
+GLint ShaderHelper::valueWindow()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_valueWindowUniform;
+}
+
+GLint ShaderHelper::brickMap()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_brickMapUniform;
+}
+
+GLint ShaderHelper::brickSize()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_brickSizeUniform;
+}
+
+GLint ShaderHelper::brickCount()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_brickCountUniform;
+}
+
+GLint ShaderHelper::skipEmptyBricks()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_skipEmptyBricksUniform;
+}
+
+GLint ShaderHelper::occupiedMin()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_occupiedMinUniform;
+}
+
+GLint ShaderHelper::occupiedMax()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_occupiedMaxUniform;
+}
+
 GLint ShaderHelper::textureDimensions()
 {
     if (!m_initialized)
@@ -395,6 +480,55 @@ GLint ShaderHelper::sliceFrameWidth()
     return m_sliceFrameWidthUniform;
 }
 
+GLint ShaderHelper::heightMap()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_heightMapUniform;
+}
+
+GLint ShaderHelper::heightMapSize()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_heightMapSizeUniform;
+}
+
+GLint ShaderHelper::heightMapScale()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_heightMapScaleUniform;
+}
+
+GLint ShaderHelper::heightMapOffset()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_heightMapOffsetUniform;
+}
+
+GLint ShaderHelper::barLayout()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_barLayoutUniform;
+}
+
+GLint ShaderHelper::barScale()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_barScaleUniform;
+}
+
+GLint ShaderHelper::barSelection()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_barSelectionUniform;
+}
+
 GLint ShaderHelper::posAtt()
 {
     if (!m_initialized)
@@ -416,4 +550,32 @@ GLint ShaderHelper::normalAtt()
     return m_normalAttr;
 }
 
+GLint ShaderHelper::instancePosAtt()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_instancePositionAttr;
+}
+
+GLint ShaderHelper::instanceRotationAtt()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_instanceRotationAttr;
+}
+
+GLint ShaderHelper::instanceUVAtt()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_instanceUVAttr;
+}
+
+GLint ShaderHelper::selectionColorAtt()
+{
+    if (!m_initialized)
+        qFatal("Shader not initialized");
+    return m_selectionColorAttr;
+}
+
 QT_END_NAMESPACE_DATAVISUALIZATION
@@ -90,6 +90,13 @@ class ShaderHelper
     GLint colorIndex();
     GLint cameraPositionRelativeToModel();
     GLint color8Bit();
+    GLint valueWindow();
+    GLint brickMap();
+    GLint brickSize();
+    GLint brickCount();
+    GLint skipEmptyBricks();
+    GLint occupiedMin();
+    GLint occupiedMax();
     GLint textureDimensions();
     GLint sampleCount();
     GLint alphaMultiplier();
@@ -97,10 +104,21 @@ class ShaderHelper
     GLint maxBounds();
     GLint minBounds();
     GLint sliceFrameWidth();
+    GLint heightMap();
+    GLint heightMapSize();
+    GLint heightMapScale();
+    GLint heightMapOffset();
+    GLint barLayout();
+    GLint barScale();
+    GLint barSelection();
 
     GLint posAtt();
     GLint uvAtt();
     GLint normalAtt();
+    GLint instancePosAtt();
+    GLint instanceRotationAtt();
+    GLint instanceUVAtt();
+    GLint selectionColorAtt();
 
     private:
     QObject *m_caller;
@@ -115,6 +133,10 @@ class ShaderHelper
     GLint m_positionAttr;
     GLint m_uvAttr;
     GLint m_normalAttr;
+    GLint m_instancePositionAttr;
+    GLint m_instanceRotationAttr;
+    GLint m_instanceUVAttr;
+    GLint m_selectionColorAttr;
 
     GLint m_colorUniform;
     GLint m_viewMatrixUniform;
@@ -135,6 +157,13 @@ class ShaderHelper
     GLint m_colorIndexUniform;
     GLint m_cameraPositionRelativeToModelUniform;
     GLint m_color8BitUniform;
+    GLint m_valueWindowUniform;
+    GLint m_brickMapUniform;
+    GLint m_brickSizeUniform;
+    GLint m_brickCountUniform;
+    GLint m_skipEmptyBricksUniform;
+    GLint m_occupiedMinUniform;
+    GLint m_occupiedMaxUniform;
     GLint m_textureDimensionsUniform;
     GLint m_sampleCountUniform;
     GLint m_alphaMultiplierUniform;
@@ -142,6 +171,13 @@ class ShaderHelper
     GLint m_minBoundsUniform;
     GLint m_maxBoundsUniform;
     GLint m_sliceFrameWidthUniform;
+    GLint m_heightMapUniform;
+    GLint m_heightMapSizeUniform;
+    GLint m_heightMapScaleUniform;
+    GLint m_heightMapOffsetUniform;
+    GLint m_barLayoutUniform;
+    GLint m_barScaleUniform;
+    GLint m_barSelectionUniform;
 
     GLboolean m_initialized;
 };
@@ -0,0 +1,271 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "surfaceminmaxmipmap_p.h"
+#include "surfaceobject_p.h"
+#include "utils_p.h"
+#include <QtCore/QVarLengthArray>
+#include <float.h>
+
+QT_BEGIN_NAMESPACE_DATAVISUALIZATION
+
+// Cells per side of the blocks of the base level
+const int mipmapBlockCells = 4;
+
+// Intersects the ray with the triangle a, b, c. Returns false if the ray misses it, otherwise
+// the distance along the ray and the weights u and v of b and c at the hit.
+static bool rayTriangle(const QVector3D &origin, const QVector3D &direction, const QVector3D &a,
+                        const QVector3D &b, const QVector3D &c, float &distance, float &u,
+                        float &v)
+{
+    const QVector3D edge1 = b - a;
+    const QVector3D edge2 = c - a;
+    const QVector3D p = QVector3D::crossProduct(direction, edge2);
+    const float determinant = QVector3D::dotProduct(edge1, p);
+    if (determinant == 0.0f)
+        return false;
+    const float inverse = 1.0f / determinant;
+    const QVector3D s = origin - a;
+    u = QVector3D::dotProduct(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+    const QVector3D q = QVector3D::crossProduct(s, edge1);
+    v = QVector3D::dotProduct(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+    distance = QVector3D::dotProduct(edge2, q) * inverse;
+    return distance >= 0.0f;
+}
+
+SurfaceMinMaxMipmap::SurfaceMinMaxMipmap()
+    : m_columns(0),
+      m_rows(0)
+{
+}
+
+void SurfaceMinMaxMipmap::build(SurfaceObject *object, int columns, int rows)
+{
+    clear();
+    if (columns < 2 || rows < 2)
+        return;
+
+    m_columns = columns;
+    m_rows = rows;
+
+    Level base;
+    base.columns = (columns - 2) / mipmapBlockCells + 1;
+    base.rows = (rows - 2) / mipmapBlockCells + 1;
+    base.minimum.fill(QVector3D(FLT_MAX, FLT_MAX, FLT_MAX), base.columns * base.rows);
+    base.maximum.fill(QVector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX), base.columns * base.rows);
+
+    // Each vertex extends the blocks of the cells around it
+    QVector3D *minimum = base.minimum.data();
+    QVector3D *maximum = base.maximum.data();
+    for (int i = 0; i < rows; i++) {
+        const int lowerBlock = qMax(i - 1, 0) / mipmapBlockCells;
+        const int upperBlock = qMin(i, rows - 2) / mipmapBlockCells;
+        for (int j = 0; j < columns; j++) {
+            const QVector3D vertex = object->vertexAt(j, i);
+            const int leftBlock = qMax(j - 1, 0) / mipmapBlockCells;
+            const int rightBlock = qMin(j, columns - 2) / mipmapBlockCells;
+            for (int blockRow = lowerBlock; blockRow <= upperBlock; blockRow++) {
+                for (int blockColumn = leftBlock; blockColumn <= rightBlock; blockColumn++) {
+                    const int index = blockRow * base.columns + blockColumn;
+                    minimum[index] = QVector3D(qMin(minimum[index].x(), vertex.x()),
+                                               qMin(minimum[index].y(), vertex.y()),
+                                               qMin(minimum[index].z(), vertex.z()));
+                    maximum[index] = QVector3D(qMax(maximum[index].x(), vertex.x()),
+                                               qMax(maximum[index].y(), vertex.y()),
+                                               qMax(maximum[index].z(), vertex.z()));
+                }
+            }
+        }
+    }
+    m_levels.append(base);
+
+    while (m_levels.last().columns > 1 || m_levels.last().rows > 1) {
+        const Level &lower = m_levels.last();
+        Level level;
+        level.columns = (lower.columns + 1) / 2;
+        level.rows = (lower.rows + 1) / 2;
+        level.minimum.resize(level.columns * level.rows);
+        level.maximum.resize(level.columns * level.rows);
+        for (int i = 0; i < level.rows; i++) {
+            for (int j = 0; j < level.columns; j++) {
+                const int index = i * level.columns + j;
+                const int first = 2 * i * lower.columns + 2 * j;
+                QVector3D blockMinimum = lower.minimum.at(first);
+                QVector3D blockMaximum = lower.maximum.at(first);
+                for (int row = 2 * i; row < qMin(2 * i + 2, lower.rows); row++) {
+                    for (int column = 2 * j; column < qMin(2 * j + 2, lower.columns); column++) {
+                        const QVector3D &childMinimum = lower.minimum.at(row * lower.columns
+                                                                         + column);
+                        const QVector3D &childMaximum = lower.maximum.at(row * lower.columns
+                                                                         + column);
+                        blockMinimum = QVector3D(qMin(blockMinimum.x(), childMinimum.x()),
+                                                 qMin(blockMinimum.y(), childMinimum.y()),
+                                                 qMin(blockMinimum.z(), childMinimum.z()));
+                        blockMaximum = QVector3D(qMax(blockMaximum.x(), childMaximum.x()),
+                                                 qMax(blockMaximum.y(), childMaximum.y()),
+                                                 qMax(blockMaximum.z(), childMaximum.z()));
+                    }
+                }
+                level.minimum[index] = blockMinimum;
+                level.maximum[index] = blockMaximum;
+            }
+        }
+        m_levels.append(level);
+    }
+}
+
+void SurfaceMinMaxMipmap::clear()
+{
+    m_levels.clear();
+    m_columns = 0;
+    m_rows = 0;
+}
+
+bool SurfaceMinMaxMipmap::pick(SurfaceObject *object, const QVector3D &origin,
+                               const QVector3D &direction, QPoint &position,
+                               float &distance) const
+{
+    position = QPoint(-1, -1);
+    if (m_levels.isEmpty())
+        return false;
+
+    distance = FLT_MAX;
+
+    // Blocks to visit as level, column, and row triplets
+    QVarLengthArray<int, 192> stack;
+    stack.append(m_levels.size() - 1);
+    stack.append(0);
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const int row = stack.last();
+        stack.removeLast();
+        const int column = stack.last();
+        stack.removeLast();
+        const int level = stack.last();
+        stack.removeLast();
+
+        const Level &blocks = m_levels.at(level);
+        const int index = row * blocks.columns + column;
+        const float boxDistance = Utils::rayBoxDistance(origin, direction,
+                                                        blocks.minimum.at(index),
+                                                        blocks.maximum.at(index));
+        if (boxDistance < 0.0f || boxDistance > distance)
+            continue;
+
+        if (level == 0) {
+            pickBlock(object, column, row, origin, direction, position, distance);
+            continue;
+        }
+
+        // Push the children hit by the ray farthest first, so that the nearest one is
+        // visited first and the hits in it can cull the rest
+        const Level &children = m_levels.at(level - 1);
+        int childIndices[4];
+        float childDistances[4];
+        int childCount = 0;
+        for (int i = 2 * row; i < qMin(2 * row + 2, children.rows); i++) {
+            for (int j = 2 * column; j < qMin(2 * column + 2, children.columns); j++) {
+                const int childIndex = i * children.columns + j;
+                const float childDistance =
+                        Utils::rayBoxDistance(origin, direction,
+                                              children.minimum.at(childIndex),
+                                              children.maximum.at(childIndex));
+                if (childDistance < 0.0f || childDistance > distance)
+                    continue;
+                int k = childCount++;
+                while (k > 0 && childDistances[k - 1] < childDistance) {
+                    childIndices[k] = childIndices[k - 1];
+                    childDistances[k] = childDistances[k - 1];
+                    k--;
+                }
+                childIndices[k] = childIndex;
+                childDistances[k] = childDistance;
+            }
+        }
+        for (int i = 0; i < childCount; i++) {
+            stack.append(level - 1);
+            stack.append(childIndices[i] % children.columns);
+            stack.append(childIndices[i] / children.columns);
+        }
+    }
+
+    return position.x() >= 0;
+}
+
+// Tests the triangles of the cells of a base level block, split along the same diagonal as in
+// the index buffers of the surface object. The vertex nearest to a hit is resolved from its
+// position within the cell, like the quadrants of the cells in a selection texture.
+void SurfaceMinMaxMipmap::pickBlock(SurfaceObject *object, int column, int row,
+                                    const QVector3D &origin, const QVector3D &direction,
+                                    QPoint &position, float &distance) const
+{
+    const SurfaceObject::DataDimensions dimensions = object->dataDimensions();
+    const bool cornerDiagonal = dimensions != SurfaceObject::BothAscending
+            && dimensions != SurfaceObject::BothDescending;
+    const int lastColumn = qMin((column + 1) * mipmapBlockCells, m_columns - 1);
+    const int lastRow = qMin((row + 1) * mipmapBlockCells, m_rows - 1);
+
+    for (int i = row * mipmapBlockCells; i < lastRow; i++) {
+        for (int j = column * mipmapBlockCells; j < lastColumn; j++) {
+            // Corners and their positions within the cell
+            const QVector3D corners[4] = { object->vertexAt(j, i), object->vertexAt(j + 1, i),
+                                           object->vertexAt(j, i + 1),
+                                           object->vertexAt(j + 1, i + 1) };
+            static const float cornerX[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+            static const float cornerY[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+            static const int cornerTriangles[6] = { 0, 3, 2, 0, 1, 3 };
+            static const int rightTriangles[6] = { 0, 1, 2, 3, 2, 1 };
+            const int *triangles = cornerDiagonal ? cornerTriangles : rightTriangles;
+
+            for (int k = 0; k < 6; k += 3) {
+                const int a = triangles[k];
+                const int b = triangles[k + 1];
+                const int c = triangles[k + 2];
+                float hitDistance;
+                float u;
+                float v;
+                if (!rayTriangle(origin, direction, corners[a], corners[b], corners[c],
+                                 hitDistance, u, v) || hitDistance >= distance) {
+                    continue;
+                }
+                const float w = 1.0f - u - v;
+                const float x = cornerX[a] * w + cornerX[b] * u + cornerX[c] * v;
+                const float y = cornerY[a] * w + cornerY[b] * u + cornerY[c] * v;
+                distance = hitDistance;
+                position = QPoint(i + (y >= 0.5f ? 1 : 0), j + (x >= 0.5f ? 1 : 0));
+            }
+        }
+    }
+}
+
+QT_END_NAMESPACE_DATAVISUALIZATION
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QtDataVisualization API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#ifndef SURFACEMINMAXMIPMAP_P_H
+#define SURFACEMINMAXMIPMAP_P_H
+
+#include "datavisualizationglobal_p.h"
+#include <QtCore/QPoint>
+#include <QtCore/QVector>
+#include <QtGui/QVector3D>
+
+QT_BEGIN_NAMESPACE_DATAVISUALIZATION
+
+class SurfaceObject;
+
+// Min/max mipmap over the cells of a surface object. The base level stores the bounds of
+// blocks of cells, and each level above it the bounds of two by two blocks of the level below,
+// up to a single block covering the whole surface. Bounds are three dimensional, so that
+// irregular and polar grids are handled the same way as regular height fields.
+class QT_DATAVISUALIZATION_EXPORT SurfaceMinMaxMipmap
+{
+public:
+    SurfaceMinMaxMipmap();
+
+    void build(SurfaceObject *object, int columns, int rows);
+    void clear();
+
+    inline bool isEmpty() const { return m_levels.isEmpty(); }
+
+    // Casts the ray against the triangles of the surface. Returns false if the ray misses it,
+    // otherwise the distance to the nearest hit and the position (row, column) of the vertex
+    // nearest to it. Direction must be normalized.
+    bool pick(SurfaceObject *object, const QVector3D &origin, const QVector3D &direction,
+              QPoint &position, float &distance) const;
+
+private:
+    struct Level {
+        int columns; // Blocks per row
+        int rows;
+        QVector<QVector3D> minimum;
+        QVector<QVector3D> maximum;
+    };
+
+    void pickBlock(SurfaceObject *object, int column, int row, const QVector3D &origin,
+                   const QVector3D &direction, QPoint &position, float &distance) const;
+
+    QVector<Level> m_levels; // Base level first
+    int m_columns; // Vertices per row
+    int m_rows;
+};
+
+QT_END_NAMESPACE_DATAVISUALIZATION
+
+#endif
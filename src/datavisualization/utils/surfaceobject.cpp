@@ -30,15 +30,87 @@
 #include "surfaceobject_p.h"
 #include "surface3drenderer_p.h"
 
+#include <QtCore/QPair>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtGui/QVector2D>
 
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
+// Not defined by OpenGL ES 2 headers. Height maps are only used with OpenGL (ES) 3.0 or later.
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+
+// Surfaces with fewer vertices than this per band are rebuilt on the render thread only
+const int bandTaskMinSize = 65536;
+// Level of detail is only used for surfaces with at least this many vertices
+const int detailMinSize = 512 * 512;
+// Cells per side of a detail tile, at the vertex step of its level
+const int detailTileCells = 32;
+// Largest height error in pixels a tile may have on screen before it is refined
+const float detailPixelError = 2.0f;
+
+class SurfaceObject::BandTask : public QRunnable
+{
+public:
+    BandTask(SurfaceObject *object, BandStage stage, const BandData &data, int fromRow,
+             int toRow, QSemaphore &done)
+        : m_object(object),
+          m_stage(stage),
+          m_data(data),
+          m_fromRow(fromRow),
+          m_toRow(toRow),
+          m_done(done),
+          m_minY(10000000.0f),
+          m_maxY(-10000000.0f)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        m_object->processBand(m_stage, m_data, m_fromRow, m_toRow, m_minY, m_maxY);
+        m_done.release();
+    }
+
+    inline float minY() const { return m_minY; }
+    inline float maxY() const { return m_maxY; }
+
+private:
+    SurfaceObject *m_object;
+    BandStage m_stage;
+    const BandData &m_data;
+    int m_fromRow;
+    int m_toRow;
+    QSemaphore &m_done;
+    float m_minY;
+    float m_maxY;
+};
+
 SurfaceObject::SurfaceObject(Surface3DRenderer *renderer)
-    : m_axisCacheX(renderer->m_axisCacheX),
-      m_axisCacheY(renderer->m_axisCacheY),
-      m_axisCacheZ(renderer->m_axisCacheZ),
-      m_renderer(renderer)
+    : SurfaceObject(renderer->m_axisCacheX, renderer->m_axisCacheY, renderer->m_axisCacheZ)
+{
+    m_renderer = renderer;
+}
+
+// Creates a surface mapped by the given axis caches without a renderer, which polar surfaces need
+SurfaceObject::SurfaceObject(AxisRenderCache &axisCacheX, AxisRenderCache &axisCacheY,
+                             AxisRenderCache &axisCacheZ)
+    : m_axisCacheX(axisCacheX),
+      m_axisCacheY(axisCacheY),
+      m_axisCacheZ(axisCacheZ),
+      m_renderer(0)
 {
     glGenBuffers(1, &m_vertexbuffer);
     glGenBuffers(1, &m_normalbuffer);
@@ -53,17 +125,29 @@ SurfaceObject::~SurfaceObject()
     if (QOpenGLContext::currentContext()) {
         glDeleteBuffers(1, &m_gridElementbuffer);
         glDeleteBuffers(1, &m_uvTextureBuffer);
+        glDeleteBuffers(1, &m_stitchElementbuffer);
+        if (m_heightMapTexture)
+            glDeleteTextures(1, &m_heightMapTexture);
     }
 }
 
-void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QRect &space,
+void SurfaceObject::setUpSmoothData(const SurfaceDataView &dataArray, const QRect &space,
                                     bool changeGeometry, bool polar, bool flipXZ)
 {
+    if (m_heightMapped) {
+        // Buffers hold height map grid positions, so the geometry has to be recreated
+        releaseHeightMap();
+        changeGeometry = true;
+    }
+    if (m_scrolled) {
+        // Buffers hold the rows twice
+        resetScroll();
+        changeGeometry = true;
+    }
+
     m_columns = space.width();
     m_rows = space.height();
     int totalSize = m_rows * m_columns;
-    GLfloat uvX = 1.0f / GLfloat(m_columns - 1);
-    GLfloat uvY = 1.0f / GLfloat(m_rows - 1);
 
     m_surfaceType = SurfaceSmooth;
 
@@ -80,147 +164,330 @@ void SurfaceObject::setUpSmoothData(const QSurfaceDataArray &dataArray, const QR
     QVector<QVector2D> uvs;
     if (changeGeometry)
         uvs.resize(totalSize);
-    int totalIndex = 0;
 
-    // Init min and max to ridiculous values
-    m_minY = 10000000.0;
-    m_maxY = -10000000.0f;
+    BandData bandData;
+    initBandData(bandData, dataArray, changeGeometry ? uvs.data() : 0, 0, polar, flipXZ);
+    processBands(BandVertices, bandData, m_rows);
+    m_linearMapping = bandData.linear && !flipXZ;
+    m_mappingScale = QVector3D(bandData.scaleX, bandData.scaleY, bandData.scaleZ);
+    m_mappingOffset = QVector3D(bandData.offsetX, bandData.offsetY, bandData.offsetZ);
+
+    // Create normals
+    int rowLimit = m_rows - 1;
+    int colLimit = m_columns - 1;
+    if (changeGeometry)
+        m_normals.resize(totalSize);
+
+    processBands(BandNormals, bandData, m_rows);
+
+    // Create indices table
+    indicesDirty = updateSmoothIndices(changeGeometry || indicesDirty);
+
+    // Create line element indices
+    if (changeGeometry)
+        createSmoothGridlineIndices(0, 0, colLimit, rowLimit);
+
+    createBuffers(m_vertices, uvs, m_normals, 0, !(changeGeometry || indicesDirty));
+}
+
+// Sets up a smooth surface whose vertices and normals are generated in the vertex shader from
+// a float texture holding the heights of the sample space, so data changes only update the
+// texture. Returns false without changing anything if the axes don't map the grid linearly
+// or the sample space doesn't fit in a texture.
+bool SurfaceObject::setUpHeightMapData(const SurfaceHeightGrid &grid, const QRect &space,
+                                       bool changeGeometry)
+{
+    float scaleX;
+    float offsetX;
+    float scaleY;
+    float offsetY;
+    float scaleZ;
+    float offsetZ;
+    if (!m_axisCacheX.linearMapping(scaleX, offsetX)
+            || !m_axisCacheY.linearMapping(scaleY, offsetY)
+            || !m_axisCacheZ.linearMapping(scaleZ, offsetZ)) {
+        return false;
+    }
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (space.width() > maxTextureSize || space.height() > maxTextureSize)
+        return false;
+
+    if (!m_heightMapped) {
+        // Buffers hold full vertices, so the geometry has to be recreated
+        resetScroll();
+        changeGeometry = true;
+        m_vertices.clear();
+        m_normals.clear();
+    }
+    discardPendingUpload();
+
+    m_surfaceType = SurfaceSmooth;
+    m_heightMapped = true;
+    m_heightMap = grid;
+    m_heightMapSpace = space;
+    m_columns = space.width();
+    m_rows = space.height();
+    int rowLimit = m_rows - 1;
+    int colLimit = m_columns - 1;
+
+    checkDirections(SurfaceDataView(grid, space));
+    bool indicesDirty = false;
+    if (m_dataDimension != m_oldDataDimension)
+        indicesDirty = true;
+    m_oldDataDimension = m_dataDimension;
 
+    // The grid origin and step map linearly to the axes as well
+    m_heightMapScale = QVector3D(grid.stepX * scaleX, scaleY, grid.stepZ * scaleZ);
+    m_heightMapOffset = QVector3D((grid.originX + float(space.x()) * grid.stepX) * scaleX
+                                  + offsetX,
+                                  offsetY,
+                                  (grid.originZ + float(space.y()) * grid.stepZ) * scaleZ
+                                  + offsetZ);
+
+    const float *heights = grid.heights.constData() + space.y() * grid.columnCount + space.x();
+    float minHeight = heights[0];
+    float maxHeight = heights[0];
     for (int i = 0; i < m_rows; i++) {
-        const QSurfaceDataRow &p = *dataArray.at(i);
+        const float *row = heights + i * grid.columnCount;
         for (int j = 0; j < m_columns; j++) {
-            getNormalizedVertex(p.at(j), m_vertices[totalIndex], polar, flipXZ);
-            if (changeGeometry)
+            minHeight = qMin(row[j], minHeight);
+            maxHeight = qMax(row[j], maxHeight);
+        }
+    }
+    m_minY = qMin(minHeight * scaleY + offsetY, maxHeight * scaleY + offsetY);
+    m_maxY = qMax(minHeight * scaleY + offsetY, maxHeight * scaleY + offsetY);
+
+    if (changeGeometry) {
+        int totalSize = m_rows * m_columns;
+        GLfloat uvX = 1.0f / GLfloat(colLimit);
+        GLfloat uvY = 1.0f / GLfloat(rowLimit);
+        QVector<QVector3D> gridPositions(totalSize);
+        QVector<QVector2D> uvs(totalSize);
+        int totalIndex = 0;
+        for (int i = 0; i < m_rows; i++) {
+            for (int j = 0; j < m_columns; j++) {
+                gridPositions[totalIndex] = QVector3D(GLfloat(j), GLfloat(i), 0.0f);
                 uvs[totalIndex] = QVector2D(GLfloat(j) * uvX, GLfloat(i) * uvY);
-            totalIndex++;
+                totalIndex++;
+            }
         }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
+        glBufferData(GL_ARRAY_BUFFER, totalSize * sizeof(QVector3D),
+                     gridPositions.constData(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
+        glBufferData(GL_ARRAY_BUFFER, totalSize * sizeof(QVector2D),
+                     uvs.constData(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        createSmoothGridlineIndices(0, 0, colLimit, rowLimit);
+    }
+
+    updateSmoothIndices(changeGeometry || indicesDirty);
+
+    uploadHeightMap(heights, grid.columnCount);
+
+    m_meshDataLoaded = true;
+    return true;
+}
+
+// Scrolls a smooth surface by count rows, dropping its first rows and adding the last count
+// rows of dataArray. The rows are stored twice in the vertex and normal buffers, so the rows in
+// data order always follow each other from the scroll row on and the index buffers stay valid.
+// Only the new rows and the rows next to them are processed and uploaded. An axis range change
+// that keeps the axis scales moves the surface with scrollTranslation(). Returns false without
+// changing anything if the surface has to be set up again instead.
+bool SurfaceObject::scrollSmoothRows(const SurfaceDataView &dataArray, int count)
+{
+    if (m_surfaceType != SurfaceSmooth || m_heightMapped || !m_linearMapping
+            || hasDetailLevels() || useDetailLevels() || count < 1 || count >= m_rows - 1
+            || dataArray.rowCount() != m_rows || dataArray.columnCount() != m_columns) {
+        return false;
     }
 
-    if (flipXZ) {
-        for (int i = 0; i < m_vertices.size(); i++) {
-            m_vertices[i].setX(-m_vertices.at(i).x());
-            m_vertices[i].setZ(-m_vertices.at(i).z());
+    float scaleX;
+    float offsetX;
+    float scaleY;
+    float offsetY;
+    float scaleZ;
+    float offsetZ;
+    if (!m_axisCacheX.linearMapping(scaleX, offsetX)
+            || !m_axisCacheY.linearMapping(scaleY, offsetY)
+            || !m_axisCacheZ.linearMapping(scaleZ, offsetZ)
+            || !qFuzzyCompare(scaleX, m_mappingScale.x())
+            || !qFuzzyCompare(scaleY, m_mappingScale.y())
+            || !qFuzzyCompare(scaleZ, m_mappingScale.z())
+            || !qFuzzyIsNull(offsetY - m_mappingOffset.y())) {
+        return false;
+    }
+
+    checkDirections(dataArray);
+    if (m_dataDimension != m_oldDataDimension)
+        return false;
+
+    const int totalSize = m_rows * m_columns;
+    const bool enterScroll = !m_scrolled;
+    if (enterScroll) {
+        // The buffers are uploaded whole below
+        discardPendingUpload();
+        m_vertices.resize(totalSize * 2);
+        m_normals.resize(totalSize * 2);
+        for (int i = 0; i < totalSize; i++) {
+            m_vertices[totalSize + i] = m_vertices.at(i);
+            m_normals[totalSize + i] = m_normals.at(i);
         }
+        m_scrolled = true;
+    }
+    m_scrollRow = (m_scrollRow + count) % m_rows;
+    m_vertexOffset = GLintptr(m_scrollRow) * m_columns * sizeof(QVector3D);
+    m_scrollTranslation = QVector3D(offsetX - m_mappingOffset.x(), 0.0f,
+                                    offsetZ - m_mappingOffset.z());
+
+    // The new rows use the mapping of the rows that are already there. The Y range only grows
+    // until the surface is set up again.
+    BandData bandData;
+    initBandData(bandData, dataArray, 0, 0, false, false);
+    bandData.vertices = m_vertices.data() + m_scrollRow * m_columns;
+    bandData.linear = true;
+    bandData.scaleX = m_mappingScale.x();
+    bandData.offsetX = m_mappingOffset.x();
+    bandData.scaleY = m_mappingScale.y();
+    bandData.offsetY = m_mappingOffset.y();
+    bandData.scaleZ = m_mappingScale.z();
+    bandData.offsetZ = m_mappingOffset.z();
+    const int firstNewRow = m_rows - count;
+    createVertexBand(bandData, firstNewRow, m_rows, m_minY, m_maxY);
+
+    // The first row may have become the upper line, and the last old row has new neighbors
+    createNormalBand(bandData, 0, 1);
+    createNormalBand(bandData, firstNewRow - 1, m_rows);
+
+    updateScrollRows(0, 1, !enterScroll);
+    updateScrollRows(firstNewRow - 1, m_rows, !enterScroll);
+
+    if (enterScroll) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
+        glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(QVector3D),
+                     m_vertices.constData(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
+        glBufferData(GL_ARRAY_BUFFER, m_normals.size() * sizeof(QVector3D),
+                     m_normals.constData(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-    // Create normals
-    int rowLimit = m_rows - 1;
-    int colLimit = m_columns - 1;
-    if (changeGeometry)
-        m_normals.resize(totalSize);
+    return true;
+}
 
-    totalIndex = 0;
+// Copies the rows from fromRow up to toRow, counted from the scroll row, to their other copy
+// in the vertex and normal arrays, and uploads both copies if requested.
+void SurfaceObject::updateScrollRows(int fromRow, int toRow, bool upload)
+{
+    const int totalSize = m_rows * m_columns;
+    const GLsizeiptr rowSize = m_columns * sizeof(QVector3D);
+    for (int row = fromRow; row < toRow; row++) {
+        const int start = (m_scrollRow + row) * m_columns;
+        const int copyStart = (start < totalSize) ? start + totalSize : start - totalSize;
+        for (int j = 0; j < m_columns; j++) {
+            m_vertices[copyStart + j] = m_vertices.at(start + j);
+            m_normals[copyStart + j] = m_normals.at(start + j);
+        }
 
-    if ((m_dataDimension == BothAscending) || (m_dataDimension == XDescending)) {
-        for (int row = 0; row < rowLimit; row++)
-            createSmoothNormalBodyLine(totalIndex, row * m_columns);
-        createSmoothNormalUpperLine(totalIndex);
-    } else { // BothDescending || ZDescending
-        createSmoothNormalUpperLine(totalIndex);
-        for (int row = 1; row < m_rows; row++)
-            createSmoothNormalBodyLine(totalIndex, row * m_columns);
+        if (upload) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
+            glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(QVector3D), rowSize,
+                            m_vertices.constData() + start);
+            glBufferSubData(GL_ARRAY_BUFFER, copyStart * sizeof(QVector3D), rowSize,
+                            m_vertices.constData() + copyStart);
+            glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
+            glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(QVector3D), rowSize,
+                            m_normals.constData() + start);
+            glBufferSubData(GL_ARRAY_BUFFER, copyStart * sizeof(QVector3D), rowSize,
+                            m_normals.constData() + copyStart);
+        }
     }
+    if (upload)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    // Create indices table
-    if (changeGeometry || indicesDirty)
-        createSmoothIndices(0, 0, colLimit, rowLimit);
-
-    // Create line element indices
-    if (changeGeometry)
-        createSmoothGridlineIndices(0, 0, colLimit, rowLimit);
+// Moves the rows of a scrolled surface back to data order with the translation applied, for
+// updates that expect a single copy of the rows. The buffers are not uploaded.
+void SurfaceObject::resetScroll()
+{
+    if (!m_scrolled)
+        return;
 
-    createBuffers(m_vertices, uvs, m_normals, 0);
+    const int totalSize = m_rows * m_columns;
+    const int start = m_scrollRow * m_columns;
+    m_vertices = m_vertices.mid(start, totalSize);
+    m_normals = m_normals.mid(start, totalSize);
+    for (int i = 0; i < totalSize; i++)
+        m_vertices[i] += m_scrollTranslation;
+    m_mappingOffset += m_scrollTranslation;
+
+    m_scrolled = false;
+    m_scrollRow = 0;
+    m_vertexOffset = 0;
+    m_scrollTranslation = QVector3D();
 }
 
-void SurfaceObject::createSmoothNormalBodyLine(int &totalIndex, int column)
+void SurfaceObject::createSmoothNormalBodyLine(QVector3D *normals, int &totalIndex, int column)
 {
+    // Rows of scrolled surfaces start from the scroll row
+    const int scrollOffset = m_scrollRow * m_columns;
+    const QVector3D *v = m_vertices.constData() + scrollOffset;
+    QVector3D *n = normals + scrollOffset;
     int colLimit = m_columns - 1;
 
     if (m_dataDimension == BothAscending) {
         int end = colLimit + column;
-        for (int j = column; j < end; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j + 1),
-                                             m_vertices.at(j + m_columns));
-        }
-        m_normals[totalIndex++] = normal(m_vertices.at(end),
-                                         m_vertices.at(end + m_columns),
-                                         m_vertices.at(end - 1));
+        for (int j = column; j < end; j++)
+            n[totalIndex++] = normal(v[j], v[j + 1], v[j + m_columns]);
+        n[totalIndex++] = normal(v[end], v[end + m_columns], v[end - 1]);
     } else if (m_dataDimension == XDescending) {
-        m_normals[totalIndex++] = normal(m_vertices.at(column),
-                                         m_vertices.at(column + m_columns),
-                                         m_vertices.at(column + 1));
+        n[totalIndex++] = normal(v[column], v[column + m_columns], v[column + 1]);
         int end = column + m_columns;
-        for (int j = column + 1; j < end; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j - 1),
-                                             m_vertices.at(j + m_columns));
-        }
+        for (int j = column + 1; j < end; j++)
+            n[totalIndex++] = normal(v[j], v[j - 1], v[j + m_columns]);
     } else if (m_dataDimension == ZDescending) {
         int end = colLimit + column;
-        for (int j = column; j < end; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j + 1),
-                                             m_vertices.at(j - m_columns));
-        }
-        m_normals[totalIndex++] = normal(m_vertices.at(end),
-                                         m_vertices.at(end - m_columns),
-                                         m_vertices.at(end - 1));
+        for (int j = column; j < end; j++)
+            n[totalIndex++] = normal(v[j], v[j + 1], v[j - m_columns]);
+        n[totalIndex++] = normal(v[end], v[end - m_columns], v[end - 1]);
     } else { // BothDescending
-        m_normals[totalIndex++] = normal(m_vertices.at(column),
-                                         m_vertices.at(column - m_columns),
-                                         m_vertices.at(column + 1));
+        n[totalIndex++] = normal(v[column], v[column - m_columns], v[column + 1]);
         int end = column + m_columns;
-        for (int j = column + 1; j < end; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j - 1),
-                                             m_vertices.at(j - m_columns));
-        }
+        for (int j = column + 1; j < end; j++)
+            n[totalIndex++] = normal(v[j], v[j - 1], v[j - m_columns]);
     }
 }
 
-void SurfaceObject::createSmoothNormalUpperLine(int &totalIndex)
+void SurfaceObject::createSmoothNormalUpperLine(QVector3D *normals, int &totalIndex)
 {
+    const int scrollOffset = m_scrollRow * m_columns;
+    const QVector3D *v = m_vertices.constData() + scrollOffset;
+    QVector3D *n = normals + scrollOffset;
     if (m_dataDimension == BothAscending) {
         int lineEnd = m_rows * m_columns - 1;
-        for (int j = (m_rows - 1) * m_columns; j < lineEnd; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j - m_columns),
-                                             m_vertices.at(j + 1));
-        }
-        m_normals[totalIndex++] = normal(m_vertices.at(lineEnd),
-                                         m_vertices.at(lineEnd - 1),
-                                         m_vertices.at(lineEnd - m_columns));
+        for (int j = (m_rows - 1) * m_columns; j < lineEnd; j++)
+            n[totalIndex++] = normal(v[j], v[j - m_columns], v[j + 1]);
+        n[totalIndex++] = normal(v[lineEnd], v[lineEnd - 1], v[lineEnd - m_columns]);
     } else if (m_dataDimension == XDescending) {
         int lineStart = (m_rows - 1) * m_columns;
         int lineEnd = m_rows * m_columns;
-        m_normals[totalIndex++] = normal(m_vertices.at(lineStart),
-                                         m_vertices.at(lineStart + 1),
-                                         m_vertices.at(lineStart - m_columns));
-        for (int j = lineStart + 1; j < lineEnd; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j - m_columns),
-                                             m_vertices.at(j - 1));
-        }
+        n[totalIndex++] = normal(v[lineStart], v[lineStart + 1], v[lineStart - m_columns]);
+        for (int j = lineStart + 1; j < lineEnd; j++)
+            n[totalIndex++] = normal(v[j], v[j - m_columns], v[j - 1]);
     } else if (m_dataDimension == ZDescending) {
         int colLimit = m_columns - 1;
-        for (int j = 0; j < colLimit; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j + m_columns),
-                                             m_vertices.at(j + 1));
-        }
-        m_normals[totalIndex++] = normal(m_vertices.at(colLimit),
-                                         m_vertices.at(colLimit - 1),
-                                         m_vertices.at(colLimit + m_columns));
+        for (int j = 0; j < colLimit; j++)
+            n[totalIndex++] = normal(v[j], v[j + m_columns], v[j + 1]);
+        n[totalIndex++] = normal(v[colLimit], v[colLimit - 1], v[colLimit + m_columns]);
     } else { // BothDescending
-        m_normals[totalIndex++] = normal(m_vertices.at(0),
-                                         m_vertices.at(1),
-                                         m_vertices.at(m_columns));
-        for (int j = 1; j < m_columns; j++) {
-            m_normals[totalIndex++] = normal(m_vertices.at(j),
-                                             m_vertices.at(j + m_columns),
-                                             m_vertices.at(j - 1));
-        }
+        n[totalIndex++] = normal(v[0], v[1], v[m_columns]);
+        for (int j = 1; j < m_columns; j++)
+            n[totalIndex++] = normal(v[j], v[j + m_columns], v[j - 1]);
     }
 }
 
@@ -300,18 +567,18 @@ QVector3D SurfaceObject::createSmoothNormalUpperLineItem(int x, int y)
     }
 }
 
-void SurfaceObject::smoothUVs(const QSurfaceDataArray &dataArray,
-                              const QSurfaceDataArray &modelArray)
+void SurfaceObject::smoothUVs(const SurfaceDataView &dataArray,
+                              const SurfaceDataView &modelArray)
 {
-    if (dataArray.size() == 0 || modelArray.size() == 0)
+    if (dataArray.rowCount() == 0 || modelArray.rowCount() == 0)
         return;
 
-    int columns = dataArray.at(0)->size();
-    int rows = dataArray.size();
-    float xRangeNormalizer = dataArray.at(0)->at(columns - 1).x() - dataArray.at(0)->at(0).x();
-    float zRangeNormalizer = dataArray.at(rows - 1)->at(0).z() - dataArray.at(0)->at(0).z();
-    float xMin = dataArray.at(0)->at(0).x();
-    float zMin = dataArray.at(0)->at(0).z();
+    int columns = dataArray.columnCount();
+    int rows = dataArray.rowCount();
+    float xRangeNormalizer = dataArray.item(0, columns - 1).x() - dataArray.item(0, 0).x();
+    float zRangeNormalizer = dataArray.item(rows - 1, 0).z() - dataArray.item(0, 0).z();
+    float xMin = dataArray.item(0, 0).x();
+    float zMin = dataArray.item(0, 0).z();
     const bool zDescending = m_dataDimension.testFlag(SurfaceObject::ZDescending);
     const bool xDescending = m_dataDimension.testFlag(SurfaceObject::XDescending);
 
@@ -319,12 +586,11 @@ void SurfaceObject::smoothUVs(const QSurfaceDataArray &dataArray,
     uvs.resize(m_rows * m_columns);
     int index = 0;
     for (int i = 0; i < m_rows; i++) {
-        float y = (modelArray.at(i)->at(0).z() - zMin) / zRangeNormalizer;
+        float y = (modelArray.item(i, 0).z() - zMin) / zRangeNormalizer;
         if (zDescending)
             y = 1.0f - y;
-        const QSurfaceDataRow &p = *modelArray.at(i);
         for (int j = 0; j < m_columns; j++) {
-            float x = (p.at(j).x() - xMin) / xRangeNormalizer;
+            float x = (modelArray.item(i, j).x() - xMin) / xRangeNormalizer;
             if (xDescending)
                 x = 1.0f - x;
             uvs[index] = QVector2D(x, y);
@@ -344,6 +610,10 @@ void SurfaceObject::smoothUVs(const QSurfaceDataArray &dataArray,
 
 void SurfaceObject::updateSmoothRow(const QSurfaceDataArray &dataArray, int rowIndex, bool polar)
 {
+    // The buffers are uploaded whole after the update, so a staged upload is not needed
+    discardPendingUpload();
+    resetScroll();
+
     // Update vertices
     int p = rowIndex * m_columns;
     const QSurfaceDataRow &dataRow = *dataArray.at(rowIndex);
@@ -363,21 +633,27 @@ void SurfaceObject::updateSmoothRow(const QSurfaceDataArray &dataArray, int rowI
         endRow--;
     int totalIndex = startRow * m_columns;
 
+    QVector3D *normals = m_normals.data();
     if ((startRow == 0) && !upwards) {
-        createSmoothNormalUpperLine(totalIndex);
+        createSmoothNormalUpperLine(normals, totalIndex);
         startRow++;
     }
 
     for (int row = startRow; row <= endRow; row++)
-       createSmoothNormalBodyLine(totalIndex, row * m_columns);
+       createSmoothNormalBodyLine(normals, totalIndex, row * m_columns);
 
     if ((rowIndex == m_rows - 1) && upwards)
-        createSmoothNormalUpperLine(totalIndex);
+        createSmoothNormalUpperLine(normals, totalIndex);
+    m_detailMetricsDirty = true;
 }
 
 void SurfaceObject::updateSmoothItem(const QSurfaceDataArray &dataArray, int row, int column,
                                      bool polar)
 {
+    // The buffers are uploaded whole after the update, so a staged upload is not needed
+    discardPendingUpload();
+    resetScroll();
+
     // Update a vertice
     getNormalizedVertex(dataArray.at(row)->at(column),
                         m_vertices[row * m_columns + column], polar, false);
@@ -411,6 +687,7 @@ void SurfaceObject::updateSmoothItem(const QSurfaceDataArray &dataArray, int row
                 m_normals[p] = createSmoothNormalBodyLineItem(j, i);
          }
     }
+    m_detailMetricsDirty = true;
 }
 
 
@@ -431,37 +708,90 @@ void SurfaceObject::createSmoothIndices(int x, int y, int endX, int endY)
     int rowEnd = endY * m_columns;
     for (int row = y * m_columns; row < rowEnd; row += m_columns) {
         for (int j = x; j < endX; j++) {
-            if ((m_dataDimension == BothAscending) || (m_dataDimension == BothDescending)) {
-                // Left triangle
-                indices[p++] = row + j + 1;
-                indices[p++] = row + m_columns + j;
-                indices[p++] = row + j;
-
-                // Right triangle
-                indices[p++] = row + m_columns + j + 1;
-                indices[p++] = row + m_columns + j;
-                indices[p++] = row + j + 1;
-            } else if (m_dataDimension == XDescending) {
-                // Right triangle
-                indices[p++] = row + m_columns + j;
-                indices[p++] = row + m_columns + j + 1;
-                indices[p++] = row + j;
-
-                // Left triangle
-                indices[p++] = row + j;
-                indices[p++] = row + m_columns + j + 1;
-                indices[p++] = row + j + 1;
-            } else {
-                // Left triangle
-                indices[p++] = row + m_columns + j;
-                indices[p++] = row + m_columns + j + 1;
-                indices[p++] = row + j;
+            createSmoothCellIndices(indices, p, row + j, row + j + 1, row + m_columns + j,
+                                    row + m_columns + j + 1);
+        }
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCount * sizeof(GLint),
+                 indices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    delete[] indices;
+}
+
+// Creates the triangle indices of a smooth surface if indicesDirty is set or level of detail
+// was toggled, as detail tiles for large surfaces when level of detail is enabled. Returns
+// true if the indices were created.
+bool SurfaceObject::updateSmoothIndices(bool indicesDirty)
+{
+    const bool levelOfDetail = useDetailLevels();
+    if (!indicesDirty && levelOfDetail == hasDetailLevels()) {
+        m_detailMetricsDirty = levelOfDetail;
+        return false;
+    }
+
+    if (levelOfDetail) {
+        createDetailIndices();
+    } else {
+        clearDetailLevels();
+        createSmoothIndices(0, 0, m_columns - 1, m_rows - 1);
+    }
+    return true;
+}
+
+// Returns true if the smooth surface is drawn with detail tiles when set up again
+bool SurfaceObject::useDetailLevels() const
+{
+    return m_levelOfDetail && m_rows * m_columns >= detailMinSize;
+}
 
-                // Right triangle
-                indices[p++] = row + j;
-                indices[p++] = row + m_columns + j + 1;
-                indices[p++] = row + j + 1;
+// Builds a quadtree of detail tiles over the smooth surface. The leaves cover the surface at
+// full resolution, and each parent covers the area of its children using every other vertex
+// of them. All levels index the same vertices, so only the index buffer grows. Indices of the
+// tiles of each level follow each other in depth first order, which lets neighboring tiles
+// selected at the same level be drawn with a single call.
+void SurfaceObject::createDetailIndices()
+{
+    clearDetailLevels();
+
+    int rootStep = 1;
+    while (rootStep * detailTileCells < qMax(m_columns, m_rows) - 1)
+        rootStep *= 2;
+    QVector<QVector<int> > levels;
+    createDetailNode(0, 0, rootStep, 0, levels);
+
+    int indexCount = 0;
+    for (int level = 0; level < levels.size(); level++) {
+        foreach (int index, levels.at(level)) {
+            DetailNode &node = m_detailNodes[index];
+            const int lastColumn = qMin(node.column + detailTileCells * node.step, m_columns - 1);
+            const int lastRow = qMin(node.row + detailTileCells * node.step, m_rows - 1);
+            node.indexOffset = indexCount;
+            node.indexCount = 6 * ((lastColumn - node.column + node.step - 1) / node.step)
+                    * ((lastRow - node.row + node.step - 1) / node.step);
+            indexCount += node.indexCount;
+        }
+    }
 
+    m_indexCount = indexCount;
+    GLint *indices = new GLint[m_indexCount];
+    int p = 0;
+    for (int level = 0; level < levels.size(); level++) {
+        foreach (int index, levels.at(level)) {
+            const DetailNode &node = m_detailNodes.at(index);
+            const int lastColumn = qMin(node.column + detailTileCells * node.step, m_columns - 1);
+            const int lastRow = qMin(node.row + detailTileCells * node.step, m_rows - 1);
+            for (int i = node.row; i < lastRow; i += node.step) {
+                const int row = i * m_columns;
+                const int upperRow = qMin(i + node.step, lastRow) * m_columns;
+                for (int j = node.column; j < lastColumn; j += node.step) {
+                    const int nextColumn = qMin(j + node.step, lastColumn);
+                    createSmoothCellIndices(indices, p, row + j, row + nextColumn,
+                                            upperRow + j, upperRow + nextColumn);
+                }
             }
         }
     }
@@ -469,10 +799,351 @@ void SurfaceObject::createSmoothIndices(int x, int y, int endX, int endY)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCount * sizeof(GLint),
                  indices, GL_STATIC_DRAW);
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     delete[] indices;
+
+    updateDetailMetrics();
+
+    // Draw the coarsest level until the first selection
+    const DetailNode &root = m_detailNodes.at(0);
+    m_selectedDetailNodes.append(0);
+    m_detailRanges.append(root.indexOffset);
+    m_detailRanges.append(root.indexCount);
+}
+
+int SurfaceObject::createDetailNode(int column, int row, int step, int level,
+                                    QVector<QVector<int> > &levels)
+{
+    if (column >= m_columns - 1 || row >= m_rows - 1)
+        return -1;
+
+    const int index = m_detailNodes.size();
+    DetailNode node;
+    node.column = column;
+    node.row = row;
+    node.step = step;
+    node.error = 0.0f;
+    node.indexOffset = 0;
+    node.indexCount = 0;
+    for (int i = 0; i < 4; i++)
+        node.children[i] = -1;
+    m_detailNodes.append(node);
+
+    if (levels.size() <= level)
+        levels.resize(level + 1);
+    levels[level].append(index);
+
+    if (step > 1) {
+        const int childStep = step / 2;
+        const int half = detailTileCells * childStep;
+        // The node vector may be reallocated while the children are created
+        int children[4];
+        children[0] = createDetailNode(column, row, childStep, level + 1, levels);
+        children[1] = createDetailNode(column + half, row, childStep, level + 1, levels);
+        children[2] = createDetailNode(column, row + half, childStep, level + 1, levels);
+        children[3] = createDetailNode(column + half, row + half, childStep, level + 1, levels);
+        for (int i = 0; i < 4; i++)
+            m_detailNodes[index].children[i] = children[i];
+    }
+
+    return index;
+}
+
+// Updates the bounds and height errors of the detail tiles from the current vertices
+void SurfaceObject::updateDetailMetrics()
+{
+    if (!m_detailNodes.isEmpty())
+        updateDetailNodeMetrics(0);
+    m_detailMetricsDirty = false;
+}
+
+void SurfaceObject::clearDetailLevels()
+{
+    m_detailNodes.clear();
+    m_selectedDetailNodes.clear();
+    m_detailRanges.clear();
+    m_stitchIndices.clear();
+    m_detailMetricsDirty = false;
+}
+
+void SurfaceObject::updateDetailNodeMetrics(int index)
+{
+    DetailNode &node = m_detailNodes[index];
+    const int lastColumn = qMin(node.column + detailTileCells * node.step, m_columns - 1);
+    const int lastRow = qMin(node.row + detailTileCells * node.step, m_rows - 1);
+
+    if (node.step == 1) {
+        node.minBounds = vertexAt(node.column, node.row);
+        node.maxBounds = node.minBounds;
+        for (int i = node.row; i <= lastRow; i++) {
+            for (int j = node.column; j <= lastColumn; j++) {
+                const QVector3D vertex = vertexAt(j, i);
+                node.minBounds = QVector3D(qMin(node.minBounds.x(), vertex.x()),
+                                           qMin(node.minBounds.y(), vertex.y()),
+                                           qMin(node.minBounds.z(), vertex.z()));
+                node.maxBounds = QVector3D(qMax(node.maxBounds.x(), vertex.x()),
+                                           qMax(node.maxBounds.y(), vertex.y()),
+                                           qMax(node.maxBounds.z(), vertex.z()));
+            }
+        }
+        node.error = 0.0f;
+        return;
+    }
+
+    float childError = 0.0f;
+    bool firstChild = true;
+    for (int i = 0; i < 4; i++) {
+        const int childIndex = node.children[i];
+        if (childIndex < 0)
+            continue;
+        updateDetailNodeMetrics(childIndex);
+        const DetailNode &child = m_detailNodes.at(childIndex);
+        if (firstChild) {
+            node.minBounds = child.minBounds;
+            node.maxBounds = child.maxBounds;
+            firstChild = false;
+        } else {
+            node.minBounds = QVector3D(qMin(node.minBounds.x(), child.minBounds.x()),
+                                       qMin(node.minBounds.y(), child.minBounds.y()),
+                                       qMin(node.minBounds.z(), child.minBounds.z()));
+            node.maxBounds = QVector3D(qMax(node.maxBounds.x(), child.maxBounds.x()),
+                                       qMax(node.maxBounds.y(), child.maxBounds.y()),
+                                       qMax(node.maxBounds.z(), child.maxBounds.z()));
+        }
+        childError = qMax(childError, child.error);
+    }
+
+    // Largest height difference between the vertices used by the children and the cells of
+    // this node interpolated over them
+    const int childStep = node.step / 2;
+    float deviation = 0.0f;
+    for (int i = node.row; ; i += childStep) {
+        i = qMin(i, lastRow);
+        const int row = qMin(node.row + ((i - node.row) / node.step) * node.step, lastRow);
+        const int upperRow = qMin(row + node.step, lastRow);
+        const float rowFactor = upperRow > row ? float(i - row) / float(upperRow - row) : 0.0f;
+        for (int j = node.column; ; j += childStep) {
+            j = qMin(j, lastColumn);
+            const int column = qMin(node.column + ((j - node.column) / node.step) * node.step,
+                                    lastColumn);
+            const int nextColumn = qMin(column + node.step, lastColumn);
+            const float columnFactor = nextColumn > column
+                    ? float(j - column) / float(nextColumn - column) : 0.0f;
+            const float lower = vertexAt(column, row).y() * (1.0f - columnFactor)
+                    + vertexAt(nextColumn, row).y() * columnFactor;
+            const float upper = vertexAt(column, upperRow).y() * (1.0f - columnFactor)
+                    + vertexAt(nextColumn, upperRow).y() * columnFactor;
+            const float height = lower * (1.0f - rowFactor) + upper * rowFactor;
+            deviation = qMax(deviation, qAbs(vertexAt(j, i).y() - height));
+            if (j == lastColumn)
+                break;
+        }
+        if (i == lastRow)
+            break;
+    }
+
+    m_detailNodes[index].error = childError + deviation;
+}
+
+// Selects the detail tiles to draw for the view. Tiles are refined until their height error
+// projected to the screen is at most detailPixelError pixels. For perspective projections
+// the error is scaled by the distance from the eye to the closest point of the tile bounds.
+void SurfaceObject::selectDetailLevels(const QVector3D &eyePosition, float pixelsPerUnit,
+                                       bool perspective)
+{
+    if (m_detailNodes.isEmpty())
+        return;
+    if (m_detailMetricsDirty)
+        updateDetailMetrics();
+
+    QVector<QPair<int, int> > ranges;
+    QVector<int> selectedNodes;
+    QVector<int> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const int index = stack.takeLast();
+        const DetailNode &node = m_detailNodes.at(index);
+        bool refine = false;
+        if (node.step > 1) {
+            float screenError = node.error * pixelsPerUnit;
+            if (perspective) {
+                const QVector3D distance(
+                            qMax(qMax(node.minBounds.x() - eyePosition.x(),
+                                      eyePosition.x() - node.maxBounds.x()), 0.0f),
+                            qMax(qMax(node.minBounds.y() - eyePosition.y(),
+                                      eyePosition.y() - node.maxBounds.y()), 0.0f),
+                            qMax(qMax(node.minBounds.z() - eyePosition.z(),
+                                      eyePosition.z() - node.maxBounds.z()), 0.0f));
+                screenError /= qMax(distance.length(), 0.001f);
+            }
+            refine = screenError > detailPixelError;
+        }
+        if (refine) {
+            for (int i = 3; i >= 0; i--) {
+                if (node.children[i] >= 0)
+                    stack.append(node.children[i]);
+            }
+        } else {
+            ranges.append(qMakePair(node.indexOffset, node.indexCount));
+            selectedNodes.append(index);
+        }
+    }
+
+    // Merge the ranges that follow each other in the index buffer
+    std::sort(ranges.begin(), ranges.end());
+    const QVector<int> oldRanges = m_detailRanges;
+    m_detailRanges.clear();
+    for (int i = 0; i < ranges.size(); i++) {
+        const int count = m_detailRanges.size();
+        if (count && m_detailRanges.at(count - 2) + m_detailRanges.at(count - 1)
+                == ranges.at(i).first) {
+            m_detailRanges[count - 1] += ranges.at(i).second;
+        } else {
+            m_detailRanges.append(ranges.at(i).first);
+            m_detailRanges.append(ranges.at(i).second);
+        }
+    }
+
+    m_selectedDetailNodes = selectedNodes;
+    if (m_detailRanges != oldRanges)
+        createStitchIndices(selectedNodes);
+}
+
+QVector<SurfaceObject::DetailTile> SurfaceObject::selectedDetailTiles() const
+{
+    QVector<DetailTile> tiles;
+    tiles.reserve(m_selectedDetailNodes.size());
+    foreach (int index, m_selectedDetailNodes) {
+        const DetailNode &node = m_detailNodes.at(index);
+        DetailTile tile;
+        tile.column = node.column;
+        tile.row = node.row;
+        tile.step = node.step;
+        tiles.append(tile);
+    }
+    return tiles;
+}
+
+// Closes the cracks at the T-junctions where a selected tile meets finer selected tiles. Each
+// cell edge of the coarser tile gets a triangle fan from its first vertex over the vertices the
+// finer tiles use along it, which covers the gap between the edge and the finer tiles.
+void SurfaceObject::createStitchIndices(const QVector<int> &selectedNodes)
+{
+    QBitArray selected(m_detailNodes.size());
+    foreach (int index, selectedNodes)
+        selected.setBit(index);
+
+    QVector<GLint> &indices = m_stitchIndices;
+    indices.clear();
+    QVector<int> positions;
+    foreach (int index, selectedNodes) {
+        const DetailNode &node = m_detailNodes.at(index);
+        if (node.step == 1)
+            continue;
+        const int lastColumn = qMin(node.column + detailTileCells * node.step, m_columns - 1);
+        const int lastRow = qMin(node.row + detailTileCells * node.step, m_rows - 1);
+        // Left, right, bottom and top edges
+        for (int side = 0; side < 4; side++) {
+            const bool vertical = side < 2;
+            const bool after = side % 2;
+            const int line = vertical ? (after ? lastColumn : node.column)
+                                      : (after ? lastRow : node.row);
+            const int start = vertical ? node.row : node.column;
+            const int end = vertical ? lastRow : lastColumn;
+            positions.clear();
+            collectEdgePositions(0, selected, vertical, after, line, start, end, node.step,
+                                 positions);
+            if (positions.isEmpty())
+                continue;
+            std::sort(positions.begin(), positions.end());
+            positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+            int k = 0;
+            for (int corner = start; corner < end; corner += node.step) {
+                const int next = qMin(corner + node.step, end);
+                while (k < positions.size() && positions.at(k) <= corner)
+                    k++;
+                for (; k + 1 < positions.size() && positions.at(k + 1) <= next; k++) {
+                    const int a = positions.at(k);
+                    const int b = positions.at(k + 1);
+                    if (vertical) {
+                        indices << corner * m_columns + line << a * m_columns + line
+                                << b * m_columns + line;
+                    } else {
+                        indices << line * m_columns + corner << line * m_columns + a
+                                << line * m_columns + b;
+                    }
+                }
+            }
+        }
+    }
+
+    if (indices.isEmpty())
+        return;
+    if (!m_stitchElementbuffer)
+        glGenBuffers(1, &m_stitchElementbuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_stitchElementbuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLint),
+                 indices.constData(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// Collects the vertex positions along the edge from start to end on the line that the selected
+// tiles finer than step use. Vertical edges run along a column, and the tiles are searched on
+// the side of the larger columns or rows if after is set.
+void SurfaceObject::collectEdgePositions(int index, const QBitArray &selected, bool vertical,
+                                         bool after, int line, int start, int end, int step,
+                                         QVector<int> &positions) const
+{
+    const DetailNode &node = m_detailNodes.at(index);
+    const int lastColumn = qMin(node.column + detailTileCells * node.step, m_columns - 1);
+    const int lastRow = qMin(node.row + detailTileCells * node.step, m_rows - 1);
+    const int acrossStart = vertical ? node.column : node.row;
+    const int acrossEnd = vertical ? lastColumn : lastRow;
+    const int alongStart = qMax(vertical ? node.row : node.column, start);
+    const int alongEnd = qMin(vertical ? lastRow : lastColumn, end);
+    if (alongStart >= alongEnd)
+        return;
+    if (after ? (line < acrossStart || line >= acrossEnd)
+              : (line <= acrossStart || line > acrossEnd)) {
+        return;
+    }
+
+    if (selected.testBit(index)) {
+        if (node.step < step) {
+            for (int i = alongStart; i < alongEnd; i += node.step)
+                positions.append(i);
+            positions.append(alongEnd);
+        }
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (node.children[i] >= 0) {
+            collectEdgePositions(node.children[i], selected, vertical, after, line, start, end,
+                                 step, positions);
+        }
+    }
+}
+
+void SurfaceObject::drawElements()
+{
+    if (m_detailNodes.isEmpty()) {
+        AbstractObjectHelper::drawElements();
+        return;
+    }
+
+    for (int i = 0; i < m_detailRanges.size(); i += 2) {
+        glDrawElements(GL_TRIANGLES, m_detailRanges.at(i + 1), GL_UNSIGNED_INT,
+                       (void *)(GLintptr(m_detailRanges.at(i)) * GLintptr(sizeof(GLint))));
+    }
+
+    if (!m_stitchIndices.isEmpty()) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_stitchElementbuffer);
+        glDrawElements(GL_TRIANGLES, m_stitchIndices.size(), GL_UNSIGNED_INT, (void *)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementbuffer);
+    }
 }
 
 void SurfaceObject::createSmoothGridlineIndices(int x, int y, int endX, int endY)
@@ -513,14 +1184,26 @@ void SurfaceObject::createSmoothGridlineIndices(int x, int y, int endX, int endY
     delete[] gridIndices;
 }
 
-void SurfaceObject::setUpData(const QSurfaceDataArray &dataArray, const QRect &space,
+void SurfaceObject::setUpData(const SurfaceDataView &dataArray, const QRect &space,
                               bool changeGeometry, bool polar, bool flipXZ)
 {
+    if (m_heightMapped) {
+        releaseHeightMap();
+        changeGeometry = true;
+    }
+    if (m_scrolled) {
+        resetScroll();
+        changeGeometry = true;
+    }
+    if (hasDetailLevels()) {
+        // The element buffer holds the detail tiles
+        clearDetailLevels();
+        changeGeometry = true;
+    }
+
     m_columns = space.width();
     m_rows = space.height();
     int totalSize = m_rows * m_columns * 2;
-    GLfloat uvX = 1.0f / GLfloat(m_columns - 1);
-    GLfloat uvY = 1.0f / GLfloat(m_rows - 1);
 
     checkDirections(dataArray);
     bool indicesDirty = false;
@@ -538,40 +1221,12 @@ void SurfaceObject::setUpData(const QSurfaceDataArray &dataArray, const QRect &s
     if (changeGeometry)
         uvs.resize(totalSize);
 
-    int totalIndex = 0;
     int rowLimit = m_rows - 1;
     int colLimit = m_columns - 1;
-    int doubleColumns = m_columns * 2 - 2;
-    int rowColLimit = rowLimit * doubleColumns;
-
-    // Init min and max to ridiculous values
-    m_minY = 10000000.0;
-    m_maxY = -10000000.0f;
-
-    for (int i = 0; i < m_rows; i++) {
-        const QSurfaceDataRow &row = *dataArray.at(i);
-        for (int j = 0; j < m_columns; j++) {
-            getNormalizedVertex(row.at(j), m_vertices[totalIndex], polar, flipXZ);
-            if (changeGeometry)
-                uvs[totalIndex] = QVector2D(GLfloat(j) * uvX, GLfloat(i) * uvY);
 
-            totalIndex++;
-
-            if (j > 0 && j < colLimit) {
-                m_vertices[totalIndex] = m_vertices[totalIndex - 1];
-                if (changeGeometry)
-                    uvs[totalIndex] = uvs[totalIndex - 1];
-                totalIndex++;
-            }
-        }
-    }
-
-    if (flipXZ) {
-        for (int i = 0; i < m_vertices.size(); i++) {
-            m_vertices[i].setX(-m_vertices.at(i).x());
-            m_vertices[i].setZ(-m_vertices.at(i).z());
-        }
-    }
+    BandData bandData;
+    initBandData(bandData, dataArray, changeGeometry ? uvs.data() : 0, 0, polar, flipXZ);
+    processBands(BandVertices, bandData, m_rows);
 
     // Create normals & indices table
     GLint *indices = 0;
@@ -582,41 +1237,30 @@ void SurfaceObject::setUpData(const QSurfaceDataArray &dataArray, const QRect &s
         m_normals.resize(normalCount);
     }
 
-    int p = 0;
-    totalIndex = 0;
-    for (int row = 0, upperRow = doubleColumns;
-         row < rowColLimit;
-         row += doubleColumns, upperRow += doubleColumns) {
-        for (int j = 0; j < doubleColumns; j += 2) {
-            createNormals(totalIndex, row, upperRow, j);
-
-            if (changeGeometry || indicesDirty) {
-                createCoarseIndices(indices, p, row, upperRow, j);
-            }
-        }
-    }
+    bandData.indices = indices;
+    processBands(BandNormals, bandData, rowLimit);
 
     // Create grid line element indices
     if (changeGeometry)
         createCoarseGridlineIndices(0, 0, colLimit, rowLimit);
 
-    createBuffers(m_vertices, uvs, m_normals, indices);
+    createBuffers(m_vertices, uvs, m_normals, indices, !(changeGeometry || indicesDirty));
 
     delete[] indices;
 }
 
-void SurfaceObject::coarseUVs(const QSurfaceDataArray &dataArray,
-                              const QSurfaceDataArray &modelArray)
+void SurfaceObject::coarseUVs(const SurfaceDataView &dataArray,
+                              const SurfaceDataView &modelArray)
 {
-    if (dataArray.size() == 0 || modelArray.size() == 0)
+    if (dataArray.rowCount() == 0 || modelArray.rowCount() == 0)
         return;
 
-    int columns = dataArray.at(0)->size();
-    int rows = dataArray.size();
-    float xRangeNormalizer = dataArray.at(0)->at(columns - 1).x() - dataArray.at(0)->at(0).x();
-    float zRangeNormalizer = dataArray.at(rows - 1)->at(0).z() - dataArray.at(0)->at(0).z();
-    float xMin = dataArray.at(0)->at(0).x();
-    float zMin = dataArray.at(0)->at(0).z();
+    int columns = dataArray.columnCount();
+    int rows = dataArray.rowCount();
+    float xRangeNormalizer = dataArray.item(0, columns - 1).x() - dataArray.item(0, 0).x();
+    float zRangeNormalizer = dataArray.item(rows - 1, 0).z() - dataArray.item(0, 0).z();
+    float xMin = dataArray.item(0, 0).x();
+    float zMin = dataArray.item(0, 0).z();
     const bool zDescending = m_dataDimension.testFlag(SurfaceObject::ZDescending);
     const bool xDescending = m_dataDimension.testFlag(SurfaceObject::XDescending);
 
@@ -625,12 +1269,11 @@ void SurfaceObject::coarseUVs(const QSurfaceDataArray &dataArray,
     int index = 0;
     int colLimit = m_columns - 1;
     for (int i = 0; i < m_rows; i++) {
-        float y = (modelArray.at(i)->at(0).z() - zMin) / zRangeNormalizer;
+        float y = (modelArray.item(i, 0).z() - zMin) / zRangeNormalizer;
         if (zDescending)
             y = 1.0f - y;
-        const QSurfaceDataRow &p = *modelArray.at(i);
         for (int j = 0; j < m_columns; j++) {
-            float x = (p.at(j).x() - xMin) / xRangeNormalizer;
+            float x = (modelArray.item(i, j).x() - xMin) / xRangeNormalizer;
             if (xDescending)
                 x = 1.0f - x;
             uvs[index] = QVector2D(x, y);
@@ -654,6 +1297,8 @@ void SurfaceObject::coarseUVs(const QSurfaceDataArray &dataArray,
 
 void SurfaceObject::updateCoarseRow(const QSurfaceDataArray &dataArray, int rowIndex, bool polar)
 {
+    // The buffers are uploaded whole after the update, so a staged upload is not needed
+    discardPendingUpload();
     int colLimit = m_columns - 1;
     int doubleColumns = m_columns * 2 - 2;
 
@@ -675,17 +1320,20 @@ void SurfaceObject::updateCoarseRow(const QSurfaceDataArray &dataArray, int rowI
     int rowLimit = (rowIndex + 1) * doubleColumns;
     if (rowIndex == m_rows - 1)
         rowLimit = rowIndex * doubleColumns; //Topmost row, no normals
+    QVector3D *normals = m_normals.data();
     for (int row = p, upperRow = p + doubleColumns;
          row < rowLimit;
          row += doubleColumns, upperRow += doubleColumns) {
         for (int j = 0; j < doubleColumns; j += 2)
-            createNormals(p, row, upperRow, j);
+            createNormals(normals, p, row, upperRow, j);
     }
 }
 
 void SurfaceObject::updateCoarseItem(const QSurfaceDataArray &dataArray, int row, int column,
                                      bool polar)
 {
+    // The buffers are uploaded whole after the update, so a staged upload is not needed
+    discardPendingUpload();
     int colLimit = m_columns - 1;
     int doubleColumns = m_columns * 2 - 2;
 
@@ -708,10 +1356,11 @@ void SurfaceObject::updateCoarseItem(const QSurfaceDataArray &dataArray, int row
     if (column == m_columns - 1)
         column--;
 
+    QVector3D *normals = m_normals.data();
     for (int i = startRow; i <= row; i++) {
         for (int j = startCol; j <= column; j++) {
             p = i * doubleColumns + j * 2;
-            createNormals(p, i * doubleColumns, (i + 1) * doubleColumns, j * 2);
+            createNormals(normals, p, i * doubleColumns, (i + 1) * doubleColumns, j * 2);
         }
     }
 }
@@ -806,9 +1455,24 @@ void SurfaceObject::uploadBuffers()
     createBuffers(m_vertices, uvs, m_normals, 0);
 }
 
+// Data updates that keep the geometry may be staged, as the old vertices and normals still
+// match the index buffers while they are drawn.
 void SurfaceObject::createBuffers(const QVector<QVector3D> &vertices, const QVector<QVector2D> &uvs,
-                                  const QVector<QVector3D> &normals, const GLint *indices)
+                                  const QVector<QVector3D> &normals, const GLint *indices,
+                                  bool allowStaging)
 {
+    const qint64 vertexSize = vertices.size() * sizeof(QVector3D);
+    const qint64 normalSize = normals.size() * sizeof(QVector3D);
+    if (allowStaging && stagesUpload(vertexSize + normalSize)) {
+        stageBuffer(GL_ARRAY_BUFFER, &m_vertexbuffer, vertices, vertexSize,
+                    GL_DYNAMIC_DRAW);
+        stageBuffer(GL_ARRAY_BUFFER, &m_normalbuffer, normals, normalSize,
+                    GL_DYNAMIC_DRAW);
+        setStagedCounts(m_indexCount);
+        return;
+    }
+    discardPendingUpload();
+
     // Move to buffers
     glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(QVector3D),
@@ -836,16 +1500,219 @@ void SurfaceObject::createBuffers(const QVector<QVector3D> &vertices, const QVec
     m_meshDataLoaded = true;
 }
 
-void SurfaceObject::checkDirections(const QSurfaceDataArray &array)
+void SurfaceObject::initBandData(BandData &data, const SurfaceDataView &dataArray,
+                                 QVector2D *uvs, GLint *indices, bool polar, bool flipXZ)
+{
+    data.dataArray = &dataArray;
+    data.uvs = uvs;
+    data.indices = indices;
+    data.uvX = 1.0f / GLfloat(m_columns - 1);
+    data.uvY = 1.0f / GLfloat(m_rows - 1);
+    data.polar = polar;
+    data.flipXZ = flipXZ;
+
+    // Flipped surfaces take their X positions from the Z axis and vice versa
+    const AxisRenderCache &axisCacheX = flipXZ ? m_axisCacheZ : m_axisCacheX;
+    const AxisRenderCache &axisCacheZ = flipXZ ? m_axisCacheX : m_axisCacheZ;
+    data.linear = !polar
+            && axisCacheX.linearMapping(data.scaleX, data.offsetX)
+            && m_axisCacheY.linearMapping(data.scaleY, data.offsetY)
+            && axisCacheZ.linearMapping(data.scaleZ, data.offsetZ);
+}
+
+// Runs a stage of a full rebuild over rowCount rows. Large surfaces are split into bands of
+// rows that are processed in parallel in the global thread pool, with the last band done on
+// the calling thread. Bands that no pool thread has picked up by then are processed on the
+// calling thread too instead of waiting for them. Vertex bands track their own Y range, which
+// is merged afterwards.
+void SurfaceObject::processBands(BandStage stage, const BandData &inputData, int rowCount)
+{
+    // Bands write through these pointers. Taking them here copies any storage shared with a
+    // staged upload before the workers start.
+    BandData data = inputData;
+    data.vertices = m_vertices.data();
+    data.normals = m_normals.data();
+
+    float minY = 10000000.0f;
+    float maxY = -10000000.0f;
+
+    int taskCount = qMin(QThread::idealThreadCount(), rowCount * m_columns / bandTaskMinSize);
+    taskCount = qMin(taskCount, rowCount);
+    if (stage == BandVertices && !data.linear
+            && !(m_axisCacheX.hasBuiltInFormatter() && m_axisCacheY.hasBuiltInFormatter()
+                 && m_axisCacheZ.hasBuiltInFormatter())) {
+        taskCount = 1;
+    }
+
+    if (taskCount > 1) {
+        QThreadPool *pool = QThreadPool::globalInstance();
+        const int bandSize = rowCount / taskCount;
+        QSemaphore done;
+        QList<BandTask *> tasks;
+
+        int from = 0;
+        for (int i = 1; i < taskCount; i++) {
+            const int to = i * bandSize;
+            BandTask *task = new BandTask(this, stage, data, from, to, done);
+            tasks.append(task);
+            pool->start(task);
+            from = to;
+        }
+        processBand(stage, data, from, rowCount, minY, maxY);
+        foreach (BandTask *task, tasks) {
+            if (pool->tryTake(task))
+                task->run();
+        }
+        done.acquire(tasks.size());
+
+        foreach (BandTask *task, tasks) {
+            minY = qMin(task->minY(), minY);
+            maxY = qMax(task->maxY(), maxY);
+            delete task;
+        }
+    } else {
+        processBand(stage, data, 0, rowCount, minY, maxY);
+    }
+
+    if (stage == BandVertices) {
+        m_minY = minY;
+        m_maxY = maxY;
+    }
+}
+
+void SurfaceObject::processBand(BandStage stage, const BandData &data, int fromRow, int toRow,
+                                float &minY, float &maxY)
+{
+    if (stage == BandVertices)
+        createVertexBand(data, fromRow, toRow, minY, maxY);
+    else
+        createNormalBand(data, fromRow, toRow);
+}
+
+// Normalizes the data rows from fromRow up to toRow. Flat surfaces store the inner vertices
+// of each row twice, so that every triangle can have its own normal.
+void SurfaceObject::createVertexBand(const BandData &data, int fromRow, int toRow,
+                                     float &minY, float &maxY)
+{
+    const bool flat = (m_surfaceType == SurfaceFlat);
+    const int colLimit = m_columns - 1;
+    const int rowStride = flat ? m_columns * 2 - 2 : m_columns;
+    QVector3D *vertex = data.vertices + fromRow * rowStride;
+    QVector2D *uv = data.uvs ? data.uvs + fromRow * rowStride : 0;
+
+    for (int i = fromRow; i < toRow; i++) {
+        for (int j = 0; j < m_columns; j++) {
+            const QSurfaceDataItem item = data.dataArray->item(i, j);
+            QVector3D position;
+            if (data.linear) {
+                position = QVector3D(item.x() * data.scaleX + data.offsetX,
+                                     item.y() * data.scaleY + data.offsetY,
+                                     item.z() * data.scaleZ + data.offsetZ);
+            } else {
+                position = normalizedVertex(item, data.polar, data.flipXZ);
+            }
+            minY = qMin(position.y(), minY);
+            maxY = qMax(position.y(), maxY);
+            if (data.flipXZ) {
+                position.setX(-position.x());
+                position.setZ(-position.z());
+            }
+
+            *vertex++ = position;
+            if (uv)
+                *uv++ = QVector2D(GLfloat(j) * data.uvX, GLfloat(i) * data.uvY);
+            if (flat && j > 0 && j < colLimit) {
+                *vertex++ = position;
+                if (uv) {
+                    *uv = *(uv - 1);
+                    uv++;
+                }
+            }
+        }
+    }
+}
+
+// Creates the normals of the rows from fromRow up to toRow. For flat surfaces the rows are
+// rows of cells, and their indices are created as well when requested.
+void SurfaceObject::createNormalBand(const BandData &data, int fromRow, int toRow)
+{
+    if (m_surfaceType == SurfaceFlat) {
+        const int colLimit = m_columns - 1;
+        const int doubleColumns = m_columns * 2 - 2;
+        int p = fromRow * colLimit * 2;
+        int indexPos = fromRow * colLimit * 6;
+        for (int i = fromRow; i < toRow; i++) {
+            const int row = i * doubleColumns;
+            const int upperRow = row + doubleColumns;
+            for (int j = 0; j < doubleColumns; j += 2) {
+                createNormals(data.normals, p, row, upperRow, j);
+                if (data.indices)
+                    createCoarseIndices(data.indices, indexPos, row, upperRow, j);
+            }
+        }
+    } else {
+        // The upper line is the last row for ascending Z and the first one for descending Z
+        const bool upwards = (m_dataDimension == BothAscending)
+                || (m_dataDimension == XDescending);
+        const int upperLine = upwards ? m_rows - 1 : 0;
+        for (int row = fromRow; row < toRow; row++) {
+            int totalIndex = row * m_columns;
+            if (row == upperLine)
+                createSmoothNormalUpperLine(data.normals, totalIndex);
+            else
+                createSmoothNormalBodyLine(data.normals, totalIndex, row * m_columns);
+        }
+    }
+}
+
+// Uploads the heights of the sample space, which start at heights and have rowLength values
+// per row. The texture is only reallocated when the sample space size changes.
+void SurfaceObject::uploadHeightMap(const float *heights, int rowLength)
+{
+    if (!m_heightMapTexture) {
+        glGenTextures(1, &m_heightMapTexture);
+        glBindTexture(GL_TEXTURE_2D, m_heightMapTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, m_heightMapTexture);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    const QSize size(m_columns, m_rows);
+    if (m_heightMapTextureSize != size) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_columns, m_rows, 0, GL_RED, GL_FLOAT, heights);
+        m_heightMapTextureSize = size;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_columns, m_rows, GL_RED, GL_FLOAT, heights);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void SurfaceObject::releaseHeightMap()
+{
+    if (m_heightMapTexture && QOpenGLContext::currentContext())
+        glDeleteTextures(1, &m_heightMapTexture);
+    m_heightMapTexture = 0;
+    m_heightMapTextureSize = QSize();
+    m_heightMap = SurfaceHeightGrid();
+    m_heightMapped = false;
+}
+
+void SurfaceObject::checkDirections(const SurfaceDataView &array)
 {
     m_dataDimension = BothAscending;
 
-    if (array.at(0)->at(0).x() > array.at(0)->at(array.at(0)->size() - 1).x())
+    if (array.item(0, 0).x() > array.item(0, array.columnCount() - 1).x())
         m_dataDimension |= XDescending;
     if (m_axisCacheX.reversed())
         m_dataDimension ^= XDescending;
 
-    if (array.at(0)->at(0).z() > array.at(array.size() - 1)->at(0).z())
+    if (array.item(0, 0).z() > array.item(array.rowCount() - 1, 0).z())
         m_dataDimension |= ZDescending;
     if (m_axisCacheZ.reversed())
         m_dataDimension ^= ZDescending;
@@ -853,6 +1720,14 @@ void SurfaceObject::checkDirections(const QSurfaceDataArray &array)
 
 void SurfaceObject::getNormalizedVertex(const QSurfaceDataItem &data, QVector3D &vertex,
                                         bool polar, bool flipXZ)
+{
+    vertex = normalizedVertex(data, polar, flipXZ);
+    m_minY = qMin(vertex.y(), m_minY);
+    m_maxY = qMax(vertex.y(), m_maxY);
+}
+
+QVector3D SurfaceObject::normalizedVertex(const QSurfaceDataItem &data, bool polar,
+                                          bool flipXZ) const
 {
     float normalizedX;
     float normalizedZ;
@@ -868,12 +1743,7 @@ void SurfaceObject::getNormalizedVertex(const QSurfaceDataItem &data, QVector3D
             normalizedZ = m_axisCacheZ.positionAt(data.z());
         }
     }
-    float normalizedY = m_axisCacheY.positionAt(data.y());
-    m_minY = qMin(normalizedY, m_minY);
-    m_maxY = qMax(normalizedY, m_maxY);
-    vertex.setX(normalizedX);
-    vertex.setY(normalizedY);
-    vertex.setZ(normalizedZ);
+    return QVector3D(normalizedX, m_axisCacheY.positionAt(data.y()), normalizedZ);
 }
 
 GLuint SurfaceObject::gridElementBuf()
@@ -902,18 +1772,31 @@ GLuint SurfaceObject::gridIndexCount()
 QVector3D SurfaceObject::vertexAt(int column, int row)
 {
     int pos = 0;
+    if (m_heightMapped) {
+        const int index = (m_heightMapSpace.y() + row) * m_heightMap.columnCount
+                + m_heightMapSpace.x() + column;
+        return QVector3D(float(column), m_heightMap.heights.at(index), float(row))
+                * m_heightMapScale + m_heightMapOffset;
+    }
     if (m_surfaceType == Undefined || !m_vertices.size())
         return zeroVector;
 
     if (m_surfaceType == SurfaceFlat)
         pos = row * (m_columns * 2 - 2) + column * 2 - (column > 0);
     else
-        pos = row * m_columns + column;
-    return m_vertices.at(pos);
+        pos = (m_scrollRow + row) * m_columns + column;
+    return m_vertices.at(pos) + m_scrollTranslation;
 }
 
 void SurfaceObject::clear()
 {
+    discardPendingUpload();
+    releaseHeightMap();
+    m_scrolled = false;
+    m_scrollRow = 0;
+    m_vertexOffset = 0;
+    m_scrollTranslation = QVector3D();
+    clearDetailLevels();
     m_gridIndexCount = 0;
     m_indexCount = 0;
     m_surfaceType = Undefined;
@@ -921,6 +1804,33 @@ void SurfaceObject::clear()
     m_normals.clear();
 }
 
+// Adds the two triangles of the smooth surface cell with the given corner vertices
+void SurfaceObject::createSmoothCellIndices(GLint *indices, int &p, int corner, int right,
+                                            int upper, int upperRight)
+{
+    if ((m_dataDimension == BothAscending) || (m_dataDimension == BothDescending)) {
+        // Left triangle
+        indices[p++] = right;
+        indices[p++] = upper;
+        indices[p++] = corner;
+
+        // Right triangle
+        indices[p++] = upperRight;
+        indices[p++] = upper;
+        indices[p++] = right;
+    } else {
+        // Left triangle
+        indices[p++] = upper;
+        indices[p++] = upperRight;
+        indices[p++] = corner;
+
+        // Right triangle
+        indices[p++] = corner;
+        indices[p++] = upperRight;
+        indices[p++] = right;
+    }
+}
+
 void SurfaceObject::createCoarseIndices(GLint *indices, int &p, int row, int upperRow, int j)
 {
      if ((m_dataDimension == BothAscending) || (m_dataDimension == BothDescending)) {
@@ -954,42 +1864,23 @@ void SurfaceObject::createCoarseIndices(GLint *indices, int &p, int row, int upp
     }
 }
 
-void SurfaceObject::createNormals(int &p, int row, int upperRow, int j)
+void SurfaceObject::createNormals(QVector3D *normals, int &p, int row, int upperRow, int j)
 {
+    const QVector3D *v = m_vertices.constData();
+    QVector3D *n = normals;
     if ((m_dataDimension == BothAscending) || (m_dataDimension == BothDescending)) {
-        m_normals[p++] = normal(m_vertices.at(row + j),
-                                m_vertices.at(row + j + 1),
-                                m_vertices.at(upperRow + j));
+        n[p++] = normal(v[row + j], v[row + j + 1], v[upperRow + j]);
 
-        m_normals[p++] = normal(m_vertices.at(row + j + 1),
-                                m_vertices.at(upperRow + j + 1),
-                                m_vertices.at(upperRow + j));
+        n[p++] = normal(v[row + j + 1], v[upperRow + j + 1], v[upperRow + j]);
     } else if (m_dataDimension == XDescending) {
-        m_normals[p++] = normal(m_vertices.at(row + j),
-                                m_vertices.at(upperRow + j),
-                                m_vertices.at(upperRow + j + 1));
+        n[p++] = normal(v[row + j], v[upperRow + j], v[upperRow + j + 1]);
 
-        m_normals[p++] = normal(m_vertices.at(row + j + 1),
-                                m_vertices.at(row + j),
-                                m_vertices.at(upperRow + j + 1));
+        n[p++] = normal(v[row + j + 1], v[row + j], v[upperRow + j + 1]);
     } else {
-        m_normals[p++] = normal(m_vertices.at(row + j),
-                                m_vertices.at(upperRow + j),
-                                m_vertices.at(upperRow + j + 1));
+        n[p++] = normal(v[row + j], v[upperRow + j], v[upperRow + j + 1]);
 
-        m_normals[p++] = normal(m_vertices.at(row + j + 1),
-                                m_vertices.at(row + j),
-                                m_vertices.at(upperRow + j + 1));
+        n[p++] = normal(v[row + j + 1], v[row + j], v[upperRow + j + 1]);
     }
 }
 
-QVector3D SurfaceObject::normal(const QVector3D &a, const QVector3D &b, const QVector3D &c)
-{
-    QVector3D v1 = b - a;
-    QVector3D v2 = c - a;
-    QVector3D normal = QVector3D::crossProduct(v1, v2);
-
-    return normal;
-}
-
 QT_END_NAMESPACE_DATAVISUALIZATION
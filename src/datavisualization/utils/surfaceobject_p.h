@@ -42,16 +42,18 @@
 
 #include "datavisualizationglobal_p.h"
 #include "abstractobjecthelper_p.h"
-#include "qsurfacedataproxy.h"
+#include "qsurfacedataproxy_p.h"
 
+#include <QtCore/QBitArray>
 #include <QtCore/QRect>
+#include <QtGui/QVector2D>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
 class Surface3DRenderer;
 class AxisRenderCache;
 
-class SurfaceObject : public AbstractObjectHelper
+class QT_DATAVISUALIZATION_EXPORT SurfaceObject : public AbstractObjectHelper
 {
 public:
     enum SurfaceType {
@@ -68,16 +70,28 @@ public:
     };
     Q_DECLARE_FLAGS(DataDimensions, DataDimension)
 
+    // Detail tile selected for drawing, with step columns and rows between its vertices
+    struct DetailTile {
+        int column;
+        int row;
+        int step;
+    };
+
 public:
     SurfaceObject(Surface3DRenderer *renderer);
+    SurfaceObject(AxisRenderCache &axisCacheX, AxisRenderCache &axisCacheY,
+                  AxisRenderCache &axisCacheZ);
     virtual ~SurfaceObject();
 
-    void setUpData(const QSurfaceDataArray &dataArray, const QRect &space,
+    void setUpData(const SurfaceDataView &dataArray, const QRect &space,
                    bool changeGeometry, bool polar, bool flipXZ = false);
-    void setUpSmoothData(const QSurfaceDataArray &dataArray, const QRect &space,
+    void setUpSmoothData(const SurfaceDataView &dataArray, const QRect &space,
                          bool changeGeometry, bool polar, bool flipXZ = false);
-    void smoothUVs(const QSurfaceDataArray &dataArray, const QSurfaceDataArray &modelArray);
-    void coarseUVs(const QSurfaceDataArray &dataArray, const QSurfaceDataArray &modelArray);
+    bool setUpHeightMapData(const SurfaceHeightGrid &grid, const QRect &space,
+                            bool changeGeometry);
+    bool scrollSmoothRows(const SurfaceDataView &dataArray, int count);
+    void smoothUVs(const SurfaceDataView &dataArray, const SurfaceDataView &modelArray);
+    void coarseUVs(const SurfaceDataView &dataArray, const SurfaceDataView &modelArray);
     void updateCoarseRow(const QSurfaceDataArray &dataArray, int rowIndex, bool polar);
     void updateSmoothRow(const QSurfaceDataArray &dataArray, int startRow, bool polar);
     void updateSmoothItem(const QSurfaceDataArray &dataArray, int row, int column, bool polar);
@@ -95,20 +109,111 @@ public:
     float minYValue() const { return m_minY; }
     float maxYValue() const { return m_maxY; }
     inline void activateSurfaceTexture(bool value) { m_returnTextureBuffer = value; }
+    inline DataDimensions dataDimensions() const { return m_dataDimension; }
+    inline bool isHeightMapped() const { return m_heightMapped; }
+    inline GLuint heightMapTexture() const { return m_heightMapTexture; }
+    inline QVector2D heightMapSize() const { return QVector2D(m_columns, m_rows); }
+    inline const QVector3D &heightMapScale() const { return m_heightMapScale; }
+    inline const QVector3D &heightMapOffset() const { return m_heightMapOffset; }
+    // Translation of a scrolled surface, whose vertices keep the axis positions they were
+    // created with
+    inline const QVector3D &scrollTranslation() const { return m_scrollTranslation; }
+    // Level of detail applies to large smooth surfaces set up after enabling it
+    inline void setLevelOfDetail(bool enable) { m_levelOfDetail = enable; }
+    inline bool hasDetailLevels() const { return !m_detailNodes.isEmpty(); }
+    void selectDetailLevels(const QVector3D &eyePosition, float pixelsPerUnit, bool perspective);
+    QVector<DetailTile> selectedDetailTiles() const;
+    inline const QVector<GLint> &stitchIndices() const { return m_stitchIndices; }
+    inline int columns() const { return m_columns; }
+    inline int rows() const { return m_rows; }
+    void drawElements();
 
 private:
+    class BandTask;
+
+    enum BandStage {
+        BandVertices,
+        BandNormals
+    };
+
+    // Inputs shared by the row bands of a full surface rebuild
+    struct BandData {
+        const SurfaceDataView *dataArray;
+        QVector3D *vertices; // Set by processBands()
+        QVector3D *normals; // Set by processBands()
+        QVector2D *uvs; // Null when the UVs don't change
+        GLint *indices; // Null when the indices don't change, only used by flat surfaces
+        GLfloat uvX;
+        GLfloat uvY;
+        bool polar;
+        bool flipXZ;
+        bool linear; // Axes map values linearly, see AxisRenderCache::linearMapping()
+        float scaleX;
+        float offsetX;
+        float scaleY;
+        float offsetY;
+        float scaleZ;
+        float offsetZ;
+    };
+
+    // Tile of the level of detail quadtree, covering detailTileCells cells per side with step
+    // columns and rows between the vertices of each cell
+    struct DetailNode {
+        int column;
+        int row;
+        int step;
+        int children[4]; // Negative for children outside the surface
+        QVector3D minBounds;
+        QVector3D maxBounds;
+        float error; // Largest height difference to the full resolution surface
+        int indexOffset;
+        int indexCount;
+    };
+
+    void initBandData(BandData &data, const SurfaceDataView &dataArray, QVector2D *uvs,
+                      GLint *indices, bool polar, bool flipXZ);
+    void processBands(BandStage stage, const BandData &inputData, int rowCount);
+    void processBand(BandStage stage, const BandData &data, int fromRow, int toRow,
+                     float &minY, float &maxY);
+    void createVertexBand(const BandData &data, int fromRow, int toRow,
+                          float &minY, float &maxY);
+    void createNormalBand(const BandData &data, int fromRow, int toRow);
     void createCoarseIndices(GLint *indices, int &p, int row, int upperRow, int j);
-    void createNormals(int &p, int row, int upperRow, int j);
-    void createSmoothNormalBodyLine(int &totalIndex, int column);
-    void createSmoothNormalUpperLine(int &totalIndex);
+    void createSmoothCellIndices(GLint *indices, int &p, int corner, int right, int upper,
+                                 int upperRight);
+    bool updateSmoothIndices(bool indicesDirty);
+    bool useDetailLevels() const;
+    void createDetailIndices();
+    int createDetailNode(int column, int row, int step, int level,
+                         QVector<QVector<int> > &levels);
+    void updateDetailMetrics();
+    void updateDetailNodeMetrics(int index);
+    void clearDetailLevels();
+    void createStitchIndices(const QVector<int> &selectedNodes);
+    void collectEdgePositions(int index, const QBitArray &selected, bool vertical, bool after,
+                              int line, int start, int end, int step,
+                              QVector<int> &positions) const;
+    void createNormals(QVector3D *normals, int &p, int row, int upperRow, int j);
+    void createSmoothNormalBodyLine(QVector3D *normals, int &totalIndex, int column);
+    void createSmoothNormalUpperLine(QVector3D *normals, int &totalIndex);
     QVector3D createSmoothNormalBodyLineItem(int x, int y);
     QVector3D createSmoothNormalUpperLineItem(int x, int y);
-    QVector3D normal(const QVector3D &a, const QVector3D &b, const QVector3D &c);
+    static inline QVector3D normal(const QVector3D &a, const QVector3D &b, const QVector3D &c)
+    {
+        return QVector3D::crossProduct(b - a, c - a);
+    }
     void createBuffers(const QVector<QVector3D> &vertices, const QVector<QVector2D> &uvs,
-                       const QVector<QVector3D> &normals, const GLint *indices);
-    void checkDirections(const QSurfaceDataArray &array);
+                       const QVector<QVector3D> &normals, const GLint *indices,
+                       bool allowStaging = false);
+    void checkDirections(const SurfaceDataView &array);
+    void uploadHeightMap(const float *heights, int rowLength);
+    void resetScroll();
+    void updateScrollRows(int fromRow, int toRow, bool upload);
+    void releaseHeightMap();
     inline void getNormalizedVertex(const QSurfaceDataItem &data, QVector3D &vertex, bool polar,
                                     bool flipXZ);
+    inline QVector3D normalizedVertex(const QSurfaceDataItem &data, bool polar,
+                                      bool flipXZ) const;
 
 private:
     SurfaceType m_surfaceType = Undefined;
@@ -129,6 +234,34 @@ private:
     bool m_returnTextureBuffer = false;
     SurfaceObject::DataDimensions m_dataDimension;
     SurfaceObject::DataDimensions m_oldDataDimension = DataDimensions(-1);
+    // Height map surfaces keep grid positions in the vertex buffer and the heights of the
+    // sample space in a float texture
+    bool m_heightMapped = false;
+    GLuint m_heightMapTexture = 0;
+    QSize m_heightMapTextureSize;
+    SurfaceHeightGrid m_heightMap; // Shared with the render cache
+    QRect m_heightMapSpace;
+    QVector3D m_heightMapScale;
+    QVector3D m_heightMapOffset;
+    // Linear axis mapping the smooth vertices were created with, if any
+    bool m_linearMapping = false;
+    QVector3D m_mappingScale;
+    QVector3D m_mappingOffset;
+    // Scrolled surfaces store their rows twice in the vertex and normal buffers, so that the
+    // rows in data order always follow each other starting from the scroll row
+    bool m_scrolled = false;
+    int m_scrollRow = 0;
+    QVector3D m_scrollTranslation;
+    // Quadtree of detail tiles, root first, the selected tiles and their index ranges as
+    // offset and count pairs. Empty when the whole surface is drawn at full resolution.
+    bool m_levelOfDetail = false;
+    bool m_detailMetricsDirty = false;
+    QVector<DetailNode> m_detailNodes;
+    QVector<int> m_selectedDetailNodes;
+    QVector<int> m_detailRanges;
+    // Triangles that close the cracks between selected tiles of different levels
+    GLuint m_stitchElementbuffer = 0;
+    QVector<GLint> m_stitchIndices;
 };
 
 QT_END_NAMESPACE_DATAVISUALIZATION
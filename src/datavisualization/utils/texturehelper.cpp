@@ -36,6 +36,14 @@
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
+// Not defined by OpenGL 2.1 headers. Scalar volume formats need OpenGL 3.0 or ARB_texture_rg.
+#ifndef GL_R16
+#define GL_R16 0x822A
+#endif
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+
 // Defined in shaderhelper.cpp
 extern void discardDebugMsgs(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 
@@ -108,16 +116,18 @@ GLuint TextureHelper::create2DTexture(const QImage &image, bool useTrilinearFilt
     return textureId;
 }
 
-GLuint TextureHelper::create3DTexture(const QVector<uchar> *data, int width, int height, int depth,
-                                      QImage::Format dataFormat)
+GLuint TextureHelper::create3DTexture(const uchar *data, int width, int height, int depth,
+                                      QImage::Format dataFormat,
+                                      QCustom3DVolume::SampleFormat sampleFormat)
 {
-    if (Utils::isOpenGLES() || !width || !height || !depth)
+    if (Utils::isOpenGLES() || !data || !width || !height || !depth)
         return 0;
 
     GLuint textureId = 0;
 #if defined(QT_OPENGL_ES_2)
     Q_UNUSED(dataFormat)
     Q_UNUSED(data)
+    Q_UNUSED(sampleFormat)
 #else
     glEnable(GL_TEXTURE_3D);
 
@@ -136,14 +146,24 @@ GLuint TextureHelper::create3DTexture(const QVector<uchar> *data, int width, int
 
     GLint internalFormat = 4;
     GLint format = GL_BGRA;
-    if (dataFormat == QImage::Format_Indexed8) {
+    GLenum type = GL_UNSIGNED_BYTE;
+    if (sampleFormat == QCustom3DVolume::SampleFormatUInt16) {
+        // Rows are padded to 32 bits, which matches the default unpack alignment
+        internalFormat = GL_R16;
+        format = GL_RED;
+        type = GL_UNSIGNED_SHORT;
+    } else if (sampleFormat == QCustom3DVolume::SampleFormatFloat32) {
+        internalFormat = GL_R32F;
+        format = GL_RED;
+        type = GL_FLOAT;
+    } else if (dataFormat == QImage::Format_Indexed8) {
         internalFormat = 1;
         format = GL_RED;
         // Align width to 32bits
         width = width + width % 4;
     }
     m_openGlFunctions_2_1->glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0,
-                                        format, GL_UNSIGNED_BYTE, data->constData());
+                                        format, type, data);
     status = glGetError();
     if (status)
         qWarning() << __FUNCTION__ << "3D texture creation failed:" << status;
@@ -154,6 +174,37 @@ GLuint TextureHelper::create3DTexture(const QVector<uchar> *data, int width, int
     return textureId;
 }
 
+GLuint TextureHelper::create3DMaskTexture(const QVector<uchar> &data, int width, int height,
+                                          int depth)
+{
+    if (Utils::isOpenGLES() || !width || !height || !depth)
+        return 0;
+
+    GLuint textureId = 0;
+#if defined(QT_OPENGL_ES_2)
+    Q_UNUSED(data)
+#else
+    glEnable(GL_TEXTURE_3D);
+
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_3D, textureId);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    m_openGlFunctions_2_1->glTexImage3D(GL_TEXTURE_3D, 0, 1, width, height, depth, 0,
+                                        GL_RED, GL_UNSIGNED_BYTE, data.constData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glDisable(GL_TEXTURE_3D);
+#endif
+    return textureId;
+}
+
 GLuint TextureHelper::createCubeMapTexture(const QImage &image, bool useTrilinearFiltering)
 {
     if (image.isNull())
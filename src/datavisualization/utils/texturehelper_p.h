@@ -41,6 +41,7 @@
 #define TEXTUREHELPER_P_H
 
 #include "datavisualizationglobal_p.h"
+#include "qcustom3dvolume.h"
 #include <QtGui/QRgb>
 #include <QtGui/QLinearGradient>
 #if !defined(QT_OPENGL_ES_2)
@@ -59,8 +60,12 @@ class TextureHelper : protected QOpenGLFunctions
     // Ownership of created texture is transferred to caller
     GLuint create2DTexture(const QImage &image, bool useTrilinearFiltering = false,
                            bool convert = true, bool smoothScale = true, bool clampY = false);
-    GLuint create3DTexture(const QVector<uchar> *data, int width, int height, int depth,
-                           QImage::Format dataFormat);
+    GLuint create3DTexture(const uchar *data, int width, int height, int depth,
+                           QImage::Format dataFormat,
+                           QCustom3DVolume::SampleFormat sampleFormat
+                           = QCustom3DVolume::SampleFormatImage);
+    // Single channel 8-bit texture with tightly packed data
+    GLuint create3DMaskTexture(const QVector<uchar> &data, int width, int height, int depth);
     GLuint createCubeMapTexture(const QImage &image, bool useTrilinearFiltering = false);
     // Returns selection texture and inserts generated framebuffers to framebuffer parameters
     GLuint createSelectionTexture(const QSize &size, GLuint &frameBuffer, GLuint &depthBuffer);
@@ -33,6 +33,7 @@
 #include <QtGui/QOpenGLContext>
 #include <QtGui/QOffscreenSurface>
 #include <QtCore/QCoreApplication>
+#include <float.h>
 
 QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 
@@ -43,6 +44,8 @@ QT_BEGIN_NAMESPACE_DATAVISUALIZATION
 static bool staticsResolved = false;
 static GLint maxTextureSize = 0;
 static bool isES = false;
+static bool isInstancing = false;
+static bool isVertexTexture = false;
 
 GLuint Utils::getNearestPowerOfTwo(GLuint value)
 {
@@ -328,6 +331,31 @@ QQuaternion Utils::calculateRotation(const QVector3D &xyzRotations)
     return totalRotation;
 }
 
+// Returns the distance along the ray to the box, or -1 if the ray misses it
+float Utils::rayBoxDistance(const QVector3D &origin, const QVector3D &direction,
+                            const QVector3D &minimum, const QVector3D &maximum)
+{
+    float nearDistance = 0.0f;
+    float farDistance = FLT_MAX;
+    for (int i = 0; i < 3; i++) {
+        if (qFuzzyIsNull(direction[i])) {
+            if (origin[i] < minimum[i] || origin[i] > maximum[i])
+                return -1.0f;
+        } else {
+            const float inverse = 1.0f / direction[i];
+            float t1 = (minimum[i] - origin[i]) * inverse;
+            float t2 = (maximum[i] - origin[i]) * inverse;
+            if (t1 > t2)
+                qSwap(t1, t2);
+            nearDistance = qMax(nearDistance, t1);
+            farDistance = qMin(farDistance, t2);
+            if (nearDistance > farDistance)
+                return -1.0f;
+        }
+    }
+    return nearDistance;
+}
+
 bool Utils::isOpenGLES()
 {
     if (!staticsResolved)
@@ -335,6 +363,20 @@ bool Utils::isOpenGLES()
     return isES;
 }
 
+bool Utils::isInstancingSupported()
+{
+    if (!staticsResolved)
+        resolveStatics();
+    return isInstancing;
+}
+
+bool Utils::isVertexTextureSupported()
+{
+    if (!staticsResolved)
+        resolveStatics();
+    return isVertexTexture;
+}
+
 void Utils::resolveStatics()
 {
     QOpenGLContext *ctx = QOpenGLContext::currentContext();
@@ -360,6 +402,19 @@ void Utils::resolveStatics()
 
     ctx->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
 
+    // Instanced arrays are core in OpenGL 3.3 and OpenGL ES 3.0
+    const QPair<int, int> glVersion = ctx->format().version();
+    if (isES)
+        isInstancing = (glVersion >= qMakePair(3, 0));
+    else
+        isInstancing = (glVersion >= qMakePair(3, 3));
+
+    // Single channel float textures are core in OpenGL 3.0 and OpenGL ES 3.0, but sampling
+    // them in vertex shaders also needs vertex texture units
+    GLint vertexTextureUnits = 0;
+    ctx->functions()->glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextureUnits);
+    isVertexTexture = (glVersion >= qMakePair(3, 0)) && vertexTextureUnits > 0;
+
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 4, 0))
     // We support only ES2 emulation with software renderer for now
     QString versionStr;
@@ -371,6 +426,8 @@ void Utils::resolveStatics()
             || QCoreApplication::testAttribute(Qt::AA_UseSoftwareOpenGL)) {
         qWarning("Only OpenGL ES2 emulation is available for software rendering.");
         isES = true;
+        isInstancing = false;
+        isVertexTexture = false;
     }
 #endif
 
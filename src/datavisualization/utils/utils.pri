@@ -9,7 +9,10 @@ HEADERS += $$PWD/meshloader_p.h \
            $$PWD/surfaceobject_p.h \
            $$PWD/qutils.h \
            $$PWD/scatterobjectbufferhelper_p.h \
-           $$PWD/scatterpointbufferhelper_p.h
+           $$PWD/scatterpointbufferhelper_p.h \
+           $$PWD/scatteroctree_p.h \
+           $$PWD/surfaceminmaxmipmap_p.h \
+           $$PWD/barinstancebufferhelper_p.h
 
 SOURCES += $$PWD/meshloader.cpp \
            $$PWD/vertexindexer.cpp \
@@ -21,6 +24,9 @@ SOURCES += $$PWD/meshloader.cpp \
            $$PWD/abstractobjecthelper.cpp \
            $$PWD/surfaceobject.cpp \
            $$PWD/scatterobjectbufferhelper.cpp \
-           $$PWD/scatterpointbufferhelper.cpp
+           $$PWD/scatterpointbufferhelper.cpp \
+           $$PWD/scatteroctree.cpp \
+           $$PWD/surfaceminmaxmipmap.cpp \
+           $$PWD/barinstancebufferhelper.cpp
 
 INCLUDEPATH += $$PWD
@@ -80,7 +80,11 @@ public:
 
     static float wrapValue(float value, float min, float max);
     static QQuaternion calculateRotation(const QVector3D &xyzRotations);
+    static float rayBoxDistance(const QVector3D &origin, const QVector3D &direction,
+                                const QVector3D &minimum, const QVector3D &maximum);
     static bool isOpenGLES();
+    static bool isInstancingSupported();
+    static bool isVertexTextureSupported();
     static void resolveStatics();
 
 private:
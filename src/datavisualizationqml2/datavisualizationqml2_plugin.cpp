@@ -144,6 +144,11 @@ void QtDataVisualizationQml2Plugin::registerTypes(const char *uri)
     // New revisions
     qmlRegisterType<Q3DLight, 1>(uri, 1, 3, "Light3D");
 
+    // QtDataVisualization 1.4
+
+    // New revisions
+    qmlRegisterType<DeclarativeScatter, 1>(uri, 1, 4, "Scatter3D");
+
     // The minor version used to be the current Qt 5 minor. For compatibility it is the last
     // Qt 5 release.
     qmlRegisterModule(uri, 1, 15);
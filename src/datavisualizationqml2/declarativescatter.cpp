@@ -88,6 +88,20 @@ QScatter3DSeries *DeclarativeScatter::selectedSeries() const
     return m_scatterController->selectedSeries();
 }
 
+void DeclarativeScatter::setPointBudget(int budget)
+{
+    budget = qMax(0, budget);
+    if (budget != pointBudget()) {
+        m_scatterController->setPointBudget(budget);
+        emit pointBudgetChanged(budget);
+    }
+}
+
+int DeclarativeScatter::pointBudget() const
+{
+    return m_scatterController->pointBudget();
+}
+
 QQmlListProperty<QScatter3DSeries> DeclarativeScatter::seriesList()
 {
     return QQmlListProperty<QScatter3DSeries>(this, this,
@@ -55,6 +55,7 @@ class DeclarativeScatter : public AbstractDeclarative
     Q_PROPERTY(QValue3DAxis *axisZ READ axisZ WRITE setAxisZ NOTIFY axisZChanged)
     Q_PROPERTY(QScatter3DSeries *selectedSeries READ selectedSeries NOTIFY selectedSeriesChanged)
     Q_PROPERTY(QQmlListProperty<QScatter3DSeries> seriesList READ seriesList)
+    Q_PROPERTY(int pointBudget READ pointBudget WRITE setPointBudget NOTIFY pointBudgetChanged REVISION 1)
     Q_CLASSINFO("DefaultProperty", "seriesList")
 
 public:
@@ -78,6 +79,9 @@ public:
 
     QScatter3DSeries *selectedSeries() const;
 
+    void setPointBudget(int budget);
+    int pointBudget() const;
+
 public Q_SLOTS:
     void handleAxisXChanged(QAbstract3DAxis *axis);
     void handleAxisYChanged(QAbstract3DAxis *axis);
@@ -88,6 +92,7 @@ Q_SIGNALS:
     void axisYChanged(QValue3DAxis *axis);
     void axisZChanged(QValue3DAxis *axis);
     void selectedSeriesChanged(QScatter3DSeries *series);
+    Q_REVISION(1) void pointBudgetChanged(int budget);
 
 protected:
     Scatter3DController *m_scatterController;
@@ -3,15 +3,19 @@ SUBDIRS = q3dbars \
           q3dbars-proxy \
           q3dbars-modelproxy \
           q3dbars-series \
+          q3dbars-renderer \
           q3dscatter \
           q3dscatter-proxy \
           q3dscatter-modelproxy \
           q3dscatter-series \
+          q3dscatter-octree \
+          q3dobject-staging \
           q3dsurface \
           q3dsurface-proxy \
           q3dsurface-modelproxy \
           q3dsurface-heightproxy \
           q3dsurface-series \
+          q3dsurface-object \
           q3daxis-category \
           q3daxis-logvalue \
           q3daxis-value \
@@ -47,6 +47,8 @@ private slots:
 
     void initialProperties();
     void initializeProperties();
+    void initializeValueArray();
+    void valueArrayRowsStayValid();
 
 private:
     QBarDataProxy *m_proxy;
@@ -104,5 +106,81 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->rowLabels().count(), 1);
 }
 
+void tst_proxy::initializeValueArray()
+{
+    QVERIFY(m_proxy);
+
+    QVector<float> values;
+    values << 1.0f << 3.0f << 7.5f << 2.0f << 4.0f << 6.0f;
+
+    m_proxy->resetValueArray(values, 3);
+
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QVERIFY(m_proxy->valueArray());
+    QCOMPARE(*m_proxy->valueArray(), values);
+
+    // Items without rotation are stored in the value array
+    m_proxy->setItem(1, 2, QBarDataItem(5.0f));
+    QVERIFY(m_proxy->valueArray());
+    QCOMPARE(m_proxy->valueArray()->at(5), 5.0f);
+    QBarDataRow *row = new QBarDataRow;
+    *row << 8.0f << 9.0f << 10.0f;
+    m_proxy->addRow(row);
+    QCOMPARE(m_proxy->rowCount(), 3);
+    QCOMPARE(m_proxy->itemAt(2, 1)->value(), 9.0f);
+
+    // Rotated items convert the value array
+    m_proxy->setItem(0, 0, QBarDataItem(2.5f, 45.0f));
+    QVERIFY(!m_proxy->valueArray());
+    QCOMPARE(m_proxy->rowCount(), 3);
+    QCOMPARE(m_proxy->itemAt(0, 0)->rotation(), 45.0f);
+    QCOMPARE(m_proxy->itemAt(1, 2)->value(), 5.0f);
+}
+
+void tst_proxy::valueArrayRowsStayValid()
+{
+    QVERIFY(m_proxy);
+
+    QVector<float> values;
+    values << 1.0f << 2.0f << 3.0f << 4.0f;
+
+    m_proxy->resetValueArray(values, 2);
+
+    // Accessing the rows creates the items, which are kept in step with the values
+    const QBarDataRow *firstRow = m_proxy->rowAt(0);
+    const QBarDataArray *array = m_proxy->array();
+    QCOMPARE(array->size(), 2);
+
+    QBarDataRow *row = new QBarDataRow;
+    *row << 5.0f << 6.0f;
+    m_proxy->addRow(row);
+    QVERIFY(m_proxy->valueArray());
+    QCOMPARE(m_proxy->rowAt(2), row);
+    QCOMPARE(m_proxy->rowAt(0), firstRow);
+
+    row = new QBarDataRow;
+    *row << 7.0f << 8.0f;
+    m_proxy->insertRow(0, row);
+    QVERIFY(m_proxy->valueArray());
+    QCOMPARE(m_proxy->rowAt(0), row);
+    QCOMPARE(m_proxy->rowAt(1), firstRow);
+    QCOMPARE(firstRow->at(1).value(), 2.0f);
+
+    m_proxy->setItem(1, 1, QBarDataItem(9.0f));
+    QCOMPARE(firstRow->at(1).value(), 9.0f);
+    QCOMPARE(m_proxy->valueArray()->at(3), 9.0f);
+
+    m_proxy->removeRows(0, 1);
+    QCOMPARE(m_proxy->rowAt(0), firstRow);
+    QCOMPARE(m_proxy->array(), array);
+    QCOMPARE(array->size(), m_proxy->rowCount());
+
+    QVector<float> expected;
+    expected << 1.0f << 9.0f << 3.0f << 4.0f << 5.0f << 6.0f;
+    QCOMPARE(*m_proxy->valueArray(), expected);
+    for (int i = 0; i < expected.size(); i++)
+        QCOMPARE(array->at(i / 2)->at(i % 2).value(), expected.at(i));
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "bars3drenderer_p.h"
+
+using namespace QtDataVisualization;
+
+class tst_renderer: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void rowHighlight_data();
+    void rowHighlight();
+};
+
+void tst_renderer::initTestCase()
+{
+}
+
+void tst_renderer::cleanupTestCase()
+{
+}
+
+void tst_renderer::init()
+{
+}
+
+void tst_renderer::cleanup()
+{
+}
+
+void tst_renderer::rowHighlight_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("row");
+    QTest::addColumn<int>("highlight");
+
+    const int none = Bars3DController::SelectionNone;
+    const int item = Bars3DController::SelectionItem;
+    const int row = Bars3DController::SelectionRow;
+    const int itemMode = QAbstract3DGraph::SelectionItem;
+    const int rowMode = QAbstract3DGraph::SelectionItem | QAbstract3DGraph::SelectionRow;
+    const int columnMode = QAbstract3DGraph::SelectionColumn;
+    const int rowAndColumnMode = QAbstract3DGraph::SelectionItemRowAndColumn;
+
+    // Selected position is row 2, column 3
+    QTest::newRow("item, selected row") << itemMode << 2 << item;
+    QTest::newRow("item, other row") << itemMode << 1 << none;
+    QTest::newRow("row, selected row") << rowMode << 2 << row;
+    QTest::newRow("row, other row") << rowMode << 1 << none;
+    QTest::newRow("column, selected row") << columnMode << 2 << item;
+    QTest::newRow("column, other row") << columnMode << 1 << item;
+    QTest::newRow("row and column, selected row") << rowAndColumnMode << 2 << row;
+    QTest::newRow("row and column, other row") << rowAndColumnMode << 1 << item;
+}
+
+void tst_renderer::rowHighlight()
+{
+    QFETCH(int, mode);
+    QFETCH(int, row);
+    QFETCH(int, highlight);
+
+    // Instanced bar series visit only the highlighted bars of each row
+    QAbstract3DGraph::SelectionFlags selectionMode(mode);
+    QCOMPARE(int(Bars3DRenderer::rowHighlight(row, QPoint(2, 3), selectionMode)), highlight);
+    QCOMPARE(int(Bars3DRenderer::rowHighlight(row, Bars3DController::invalidSelectionPosition(),
+                                              selectionMode)),
+             int(Bars3DController::SelectionNone));
+}
+
+QTEST_MAIN(tst_renderer)
+#include "tst_renderer.moc"
@@ -5,4 +5,7 @@ CONFIG += console testcase
 
 TEMPLATE = app
 
+INCLUDEPATH += ../../../../src/datavisualization/global \
+               ../../../../src/datavisualization/data
+
 SOURCES += tst_custom.cpp
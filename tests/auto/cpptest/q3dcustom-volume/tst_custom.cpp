@@ -30,9 +30,19 @@
 #include <QtTest/QtTest>
 
 #include <QtDataVisualization/QCustom3DVolume>
+#include <QtCore/QTemporaryFile>
+
+#include "qcustom3dvolume_p.h"
 
 using namespace QtDataVisualization;
 
+// Gives access to the private data of a volume
+class VolumeAccessor : public QCustom3DVolume
+{
+public:
+    using QCustom3DVolume::dptr;
+};
+
 class tst_custom: public QObject
 {
     Q_OBJECT
@@ -48,8 +58,12 @@ private slots:
     void initialProperties();
     void initializeProperties();
     void invalidProperties();
+    void interactiveDownsampling();
+    void textureDataFile();
 
 private:
+    static QRgb texelColor(int x, int y, int z);
+
     QCustom3DVolume *m_custom;
 };
 
@@ -132,6 +146,12 @@ void tst_custom::initialProperties()
     QCOMPARE(m_custom->sliceIndexY(), -1);
     QCOMPARE(m_custom->sliceIndexZ(), -1);
     QCOMPARE(m_custom->useHighDefShader(), true);
+    QCOMPARE(m_custom->interactiveDownsampling(), 1);
+    QCOMPARE(m_custom->sampleFormat(), QCustom3DVolume::SampleFormatImage);
+    QCOMPARE(m_custom->windowLevel(), 0.5f);
+    QCOMPARE(m_custom->windowWidth(), 1.0f);
+    QCOMPARE(m_custom->textureDataFile(), QString());
+    QCOMPARE(m_custom->textureMemoryBudget(), 0);
 
     // Common (from QCustom3DVolume)
     QCOMPARE(m_custom->meshFile(), QString(":/defaultMeshes/barFull"));
@@ -161,6 +181,10 @@ void tst_custom::initializeProperties()
     m_custom->setSliceIndexY(0);
     m_custom->setSliceIndexZ(0);
     m_custom->setUseHighDefShader(false);
+    m_custom->setInteractiveDownsampling(4);
+    m_custom->setSampleFormat(QCustom3DVolume::SampleFormatUInt16);
+    m_custom->setWindow(1000.0f, 400.0f);
+    m_custom->setTextureMemoryBudget(64);
 
     QCOMPARE(m_custom->alphaMultiplier(), 0.1f);
     QCOMPARE(m_custom->drawSliceFrames(), true);
@@ -174,6 +198,37 @@ void tst_custom::initializeProperties()
     QCOMPARE(m_custom->sliceIndexY(), 0);
     QCOMPARE(m_custom->sliceIndexZ(), 0);
     QCOMPARE(m_custom->useHighDefShader(), false);
+    QCOMPARE(m_custom->interactiveDownsampling(), 4);
+    QCOMPARE(m_custom->sampleFormat(), QCustom3DVolume::SampleFormatUInt16);
+    QCOMPARE(m_custom->windowLevel(), 1000.0f);
+    QCOMPARE(m_custom->windowWidth(), 400.0f);
+    QCOMPARE(m_custom->textureMemoryBudget(), 64);
+
+    // 16-bit lines are aligned to 32 bits
+    m_custom->setTextureDimensions(3, 2, 2);
+    QCOMPARE(m_custom->textureDataWidth(), 8);
+    m_custom->setSampleFormat(QCustom3DVolume::SampleFormatFloat32);
+    QCOMPARE(m_custom->textureDataWidth(), 12);
+
+    // Window is mapped to the color table
+    QVector<float> *samples = new QVector<float>;
+    *samples << 700.0f << 800.0f << 1000.0f << 1200.0f << 1300.0f << 0.0f;
+    samples->resize(12);
+    QVector<QRgb> table;
+    for (int i = 0; i < 256; i++)
+        table << qRgb(i, i, i);
+    m_custom->setColorTable(table);
+    QVector<uchar> *data = new QVector<uchar>(samples->size() * int(sizeof(float)));
+    memcpy(data->data(), samples->constData(), data->size());
+    delete samples;
+    m_custom->setTextureData(data);
+    QImage slice = m_custom->renderSlice(Qt::ZAxis, 0);
+    QCOMPARE(slice.format(), QImage::Format_Indexed8);
+    QCOMPARE(slice.pixelIndex(0, 0), 0);
+    QCOMPARE(slice.pixelIndex(1, 0), 0);
+    QCOMPARE(slice.pixelIndex(2, 0), 127);
+    QCOMPARE(slice.pixelIndex(0, 1), 255);
+    QCOMPARE(slice.pixelIndex(1, 1), 255);
 
     // Common (from QCustom3DVolume)
     m_custom->setPosition(QVector3D(1.0, 1.0, 1.0));
@@ -209,6 +264,145 @@ void tst_custom::invalidProperties()
 
     m_custom->setTextureFormat(QImage::Format_ARGB8555_Premultiplied);
     QCOMPARE(m_custom->textureFormat(), QImage::Format_ARGB32);
+
+    m_custom->setWindowWidth(0.0f);
+    QCOMPARE(m_custom->windowWidth(), 1.0f);
+
+    m_custom->setInteractiveDownsampling(3);
+    QCOMPARE(m_custom->interactiveDownsampling(), 1);
+
+    m_custom->setTextureMemoryBudget(-1);
+    QCOMPARE(m_custom->textureMemoryBudget(), 0);
+
+    QCOMPARE(m_custom->setTextureDataFile(QStringLiteral("nonexistent.raw")), false);
+    QCOMPARE(m_custom->textureDataFile(), QString());
+}
+
+void tst_custom::interactiveDownsampling()
+{
+    QSignalSpy spy(m_custom, &QCustom3DVolume::interactiveDownsamplingChanged);
+
+    m_custom->setInteractiveDownsampling(2);
+    QCOMPARE(m_custom->interactiveDownsampling(), 2);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), 2);
+
+    // No signal if the value doesn't change
+    m_custom->setInteractiveDownsampling(2);
+    QCOMPARE(spy.count(), 1);
+
+    m_custom->setInteractiveDownsampling(8);
+    QCOMPARE(m_custom->interactiveDownsampling(), 8);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).toInt(), 8);
+
+    // Invalid factors are ignored with a warning
+    QList<int> invalidFactors;
+    invalidFactors << -2 << 0 << 3 << 6 << 16;
+    foreach (int factor, invalidFactors) {
+        QTest::ignoreMessage(QtWarningMsg,
+                             QRegularExpression(QStringLiteral("invalid downsampling factor: %1$")
+                                                .arg(factor)));
+        m_custom->setInteractiveDownsampling(factor);
+        QCOMPARE(m_custom->interactiveDownsampling(), 8);
+    }
+    QCOMPARE(spy.count(), 2);
+
+    m_custom->setInteractiveDownsampling(1);
+    QCOMPARE(m_custom->interactiveDownsampling(), 1);
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy.at(2).at(0).toInt(), 1);
+}
+
+// Color of the texel at x, y, z of the volumes written to files
+QRgb tst_custom::texelColor(int x, int y, int z)
+{
+    return qRgba(x * 40, y * 50, z * 60, 255 - x - y - z);
+}
+
+void tst_custom::textureDataFile()
+{
+    const int width = 6;
+    const int height = 5;
+    const int depth = 4;
+    const int offset = 16;
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray contents(offset, char(0x5a));
+    for (int z = 0; z < depth; z++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                QRgb color = texelColor(x, y, z);
+                contents.append(reinterpret_cast<const char *>(&color), sizeof(color));
+            }
+        }
+    }
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    QVERIFY(file.flush());
+
+    VolumeAccessor volume;
+    volume.setTextureFormat(QImage::Format_ARGB32);
+    volume.setTextureDimensions(width, height, depth);
+    QVERIFY(volume.setTextureDataFile(file.fileName(), offset));
+    QCOMPARE(volume.textureDataFile(), file.fileName());
+    QVERIFY(!volume.textureData());
+
+    // Slices are read from the mapped file
+    QImage slice = volume.renderSlice(Qt::ZAxis, 2);
+    QCOMPARE(slice.size(), QSize(width, height));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++)
+            QCOMPARE(slice.pixel(x, y), texelColor(x, y, 2));
+    }
+    slice = volume.renderSlice(Qt::YAxis, 1);
+    QCOMPARE(slice.size(), QSize(width, depth));
+    for (int z = 0; z < depth; z++) {
+        for (int x = 0; x < width; x++)
+            QCOMPARE(slice.pixel(x, depth - 1 - z), texelColor(x, 1, z));
+    }
+
+    // Full resolution level is the mapped data itself
+    QCustom3DVolumePrivate *d = volume.dptr();
+    QCustom3DVolumePrivate::TextureLevel level;
+    QVERIFY(d->textureLevel(0, level));
+    QCOMPARE(level.level, 0);
+    QCOMPARE(level.width, width);
+    QVERIFY(level.storage.isEmpty());
+    QVERIFY(!memcmp(level.data, contents.constData() + offset, contents.size() - offset));
+
+    // Levels that don't fit the maximum texture size are point sampled from the file
+    QVERIFY(d->textureLevel(3, level));
+    QCOMPARE(level.level, 1);
+    QCOMPARE(level.width, 3);
+    QCOMPARE(level.height, 3);
+    QCOMPARE(level.depth, 2);
+    for (int z = 0; z < level.depth; z++) {
+        for (int y = 0; y < level.height; y++) {
+            for (int x = 0; x < level.width; x++) {
+                QRgb color;
+                memcpy(&color, level.data + (z * level.height + y) * d->lineSize(level.width)
+                       + x * 4, sizeof(color));
+                QCOMPARE(color, texelColor(x * 2, y * 2, z * 2));
+            }
+        }
+    }
+
+    // The level used for rendering is built in the thread pool and taken once it is ready
+    QCustom3DVolumePrivate::TextureLevel takenLevel;
+    QVERIFY(!d->takeTextureLevel(3, takenLevel));
+    QTRY_VERIFY(d->takeTextureLevel(3, takenLevel));
+    QCOMPARE(takenLevel.level, 1);
+    QCOMPARE(takenLevel.width, 3);
+    QCOMPARE(takenLevel.height, 3);
+    QCOMPARE(takenLevel.depth, 2);
+    QCOMPARE(takenLevel.storage, level.storage);
+
+    // Changing the data drops the level being built
+    QVERIFY(!d->takeTextureLevel(3, takenLevel));
+    volume.setTextureMemoryBudget(1);
+    QVERIFY(!d->takeTextureLevel(3, takenLevel));
+    QTRY_VERIFY(d->takeTextureLevel(3, takenLevel));
+    QCOMPARE(takenLevel.storage, level.storage);
 }
 
 QTEST_MAIN(tst_custom)
@@ -0,0 +1,11 @@
+QT += testlib datavisualization
+
+TARGET = tst_cpptest
+CONFIG += console testcase
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../../../src/datavisualization/global \
+               ../../../../src/datavisualization/utils
+
+SOURCES += tst_staging.cpp
@@ -0,0 +1,274 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+
+#include "abstractobjecthelper_p.h"
+
+using namespace QtDataVisualization;
+
+// Loads vertices to the vertex buffer the way the series buffer helpers do
+class StagingHelper : public AbstractObjectHelper
+{
+public:
+    StagingHelper()
+    {
+        QVector<QVector3D> vertices(3);
+        glGenBuffers(1, &m_vertexbuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(QVector3D),
+                     vertices.constData(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_indexCount = vertices.size();
+        m_meshDataLoaded = true;
+    }
+
+    bool load(const QVector<QVector3D> &vertices)
+    {
+        const int size = vertices.size() * sizeof(QVector3D);
+        if (!stagesUpload(size))
+            return false;
+        stageBuffer(GL_ARRAY_BUFFER, &m_vertexbuffer, vertices, size, GL_STATIC_DRAW);
+        setStagedCounts(vertices.size());
+        return true;
+    }
+
+    void discard() { discardPendingUpload(); }
+    int pendingCount() const { return m_pendingBuffers.size(); }
+    const void *pendingData() const { return m_pendingBuffers.at(0).data->data; }
+
+    GLint bufferSize(GLuint buffer)
+    {
+        GLint size = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return size;
+    }
+};
+
+class tst_staging: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void stagesUpload();
+    void stage();
+    void swap();
+    void swapInSlices();
+    void replace();
+    void queue();
+    void restageEveryFrame();
+    void discard();
+
+private:
+    QOffscreenSurface *m_surface;
+    QOpenGLContext *m_context;
+    StagingHelper *m_helper;
+};
+
+// Slices of 8 MB are uploaded per frame, so this takes three
+static const int largeCount = 20 * 1024 * 1024 / sizeof(QVector3D);
+// Staged, but uploaded in one slice
+static const int smallCount = 512 * 1024;
+
+void tst_staging::initTestCase()
+{
+    m_surface = new QOffscreenSurface;
+    m_surface->create();
+    m_context = new QOpenGLContext;
+    m_context->create();
+    m_helper = 0;
+}
+
+void tst_staging::cleanupTestCase()
+{
+    delete m_context;
+    delete m_surface;
+}
+
+void tst_staging::init()
+{
+    if (!m_context->makeCurrent(m_surface))
+        QSKIP("No OpenGL context");
+    m_helper = new StagingHelper;
+}
+
+void tst_staging::cleanup()
+{
+    delete m_helper;
+    m_helper = 0;
+    m_context->doneCurrent();
+}
+
+void tst_staging::stagesUpload()
+{
+    QVector<QVector3D> vertices(smallCount);
+    QVERIFY(m_helper->load(vertices));
+    m_helper->discard();
+
+    QVERIFY(!m_helper->load(QVector<QVector3D>(100)));
+
+    // Nothing to draw while uploading
+    m_helper->m_meshDataLoaded = false;
+    QVERIFY(!m_helper->load(vertices));
+}
+
+void tst_staging::stage()
+{
+    const GLuint frontBuffer = m_helper->vertexBuf();
+    QVector<QVector3D> vertices(smallCount);
+    QVERIFY(m_helper->load(vertices));
+
+    QVERIFY(m_helper->hasPendingUpload());
+    QCOMPARE(m_helper->pendingCount(), 1);
+    // The data is shared, not copied
+    QCOMPARE(m_helper->pendingData(), static_cast<const void *>(vertices.constData()));
+    QCOMPARE(m_helper->vertexBuf(), frontBuffer);
+    QCOMPARE(m_helper->indexCount(), GLuint(3));
+}
+
+void tst_staging::swap()
+{
+    const GLuint frontBuffer = m_helper->vertexBuf();
+    QVERIFY(m_helper->load(QVector<QVector3D>(smallCount)));
+
+    QVERIFY(m_helper->uploadPending());
+    QVERIFY(!m_helper->hasPendingUpload());
+    QVERIFY(m_helper->vertexBuf() != frontBuffer);
+    QCOMPARE(m_helper->bufferSize(m_helper->vertexBuf()), GLint(smallCount * sizeof(QVector3D)));
+    QCOMPARE(m_helper->indexCount(), GLuint(smallCount));
+}
+
+void tst_staging::swapInSlices()
+{
+    const GLuint frontBuffer = m_helper->vertexBuf();
+    QVERIFY(m_helper->load(QVector<QVector3D>(largeCount)));
+
+    QVERIFY(!m_helper->uploadPending());
+    QVERIFY(!m_helper->uploadPending());
+    QVERIFY(m_helper->hasPendingUpload());
+    QCOMPARE(m_helper->vertexBuf(), frontBuffer);
+    QCOMPARE(m_helper->indexCount(), GLuint(3));
+
+    QVERIFY(m_helper->uploadPending());
+    QVERIFY(!m_helper->hasPendingUpload());
+    QCOMPARE(m_helper->bufferSize(m_helper->vertexBuf()), GLint(largeCount * sizeof(QVector3D)));
+    QCOMPARE(m_helper->indexCount(), GLuint(largeCount));
+}
+
+void tst_staging::replace()
+{
+    const GLuint frontBuffer = m_helper->vertexBuf();
+    QVERIFY(m_helper->load(QVector<QVector3D>(largeCount)));
+
+    // A new load replaces the pending one while its upload has not started
+    QVector<QVector3D> vertices(smallCount);
+    QVERIFY(m_helper->load(vertices));
+    QCOMPARE(m_helper->pendingCount(), 1);
+    QCOMPARE(m_helper->pendingData(), static_cast<const void *>(vertices.constData()));
+    QCOMPARE(m_helper->vertexBuf(), frontBuffer);
+
+    QVERIFY(m_helper->uploadPending());
+    QVERIFY(!m_helper->hasPendingUpload());
+    QCOMPARE(m_helper->bufferSize(m_helper->vertexBuf()), GLint(smallCount * sizeof(QVector3D)));
+    QCOMPARE(m_helper->indexCount(), GLuint(smallCount));
+}
+
+void tst_staging::queue()
+{
+    const GLuint frontBuffer = m_helper->vertexBuf();
+    QVector<QVector3D> pendingVertices(largeCount);
+    QVERIFY(m_helper->load(pendingVertices));
+    QVERIFY(!m_helper->uploadPending());
+
+    // A load staged during the upload is queued, and the pending upload carries on
+    QVector<QVector3D> queuedVertices(smallCount);
+    QVERIFY(m_helper->load(queuedVertices));
+    QCOMPARE(m_helper->pendingCount(), 1);
+    QCOMPARE(m_helper->pendingData(), static_cast<const void *>(pendingVertices.constData()));
+    QCOMPARE(m_helper->vertexBuf(), frontBuffer);
+
+    QVERIFY(!m_helper->uploadPending());
+    QVERIFY(m_helper->uploadPending());
+    QCOMPARE(m_helper->indexCount(), GLuint(largeCount));
+
+    // The queued load is staged after the swap
+    QVERIFY(m_helper->hasPendingUpload());
+    QCOMPARE(m_helper->pendingData(), static_cast<const void *>(queuedVertices.constData()));
+    QVERIFY(m_helper->uploadPending());
+    QVERIFY(!m_helper->hasPendingUpload());
+    QCOMPARE(m_helper->indexCount(), GLuint(smallCount));
+}
+
+void tst_staging::restageEveryFrame()
+{
+    // Loads of three slices change every frame, each with its own vertex count. The pending load
+    // is swapped in every third frame, and the latest queued load is uploaded next.
+    int swaps = 0;
+    for (int frame = 0; frame < 9; frame++) {
+        QVERIFY(m_helper->load(QVector<QVector3D>(largeCount + frame)));
+        if (m_helper->uploadPending()) {
+            QCOMPARE(frame % 3, 2);
+            QCOMPARE(m_helper->indexCount(), GLuint(largeCount + frame - 2));
+            QCOMPARE(m_helper->bufferSize(m_helper->vertexBuf()),
+                     GLint((largeCount + frame - 2) * sizeof(QVector3D)));
+            swaps++;
+        }
+    }
+    QCOMPARE(swaps, 3);
+
+    // The last load is drawn once the loads stop
+    m_helper->finishPendingUpload();
+    QCOMPARE(m_helper->indexCount(), GLuint(largeCount + 8));
+}
+
+void tst_staging::discard()
+{
+    const GLuint frontBuffer = m_helper->vertexBuf();
+    QVERIFY(m_helper->load(QVector<QVector3D>(largeCount)));
+    QVERIFY(!m_helper->uploadPending());
+
+    m_helper->discard();
+    QVERIFY(!m_helper->hasPendingUpload());
+    QVERIFY(!m_helper->uploadPending());
+    QCOMPARE(m_helper->vertexBuf(), frontBuffer);
+    QCOMPARE(m_helper->bufferSize(frontBuffer), GLint(3 * sizeof(QVector3D)));
+    QCOMPARE(m_helper->indexCount(), GLuint(3));
+}
+
+QTEST_MAIN(tst_staging)
+#include "tst_staging.moc"
@@ -0,0 +1,12 @@
+QT += testlib datavisualization
+
+TARGET = tst_cpptest
+CONFIG += console testcase
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../../../src/datavisualization/global \
+               ../../../../src/datavisualization/data \
+               ../../../../src/datavisualization/utils
+
+SOURCES += tst_octree.cpp
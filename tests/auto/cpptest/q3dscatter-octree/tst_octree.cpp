@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "scatteroctree_p.h"
+
+using namespace QtDataVisualization;
+
+class tst_octree: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void selectVisible();
+    void selectVisibleWholeTree();
+    void selectVisibleLightView();
+    void pick();
+    void pickDrawn();
+
+private:
+    ScatterRenderItemArray m_renderArray;
+    ScatterOctree m_octree;
+};
+
+void tst_octree::initTestCase()
+{
+}
+
+void tst_octree::cleanupTestCase()
+{
+}
+
+void tst_octree::init()
+{
+    // Items on the X axis from -10 to 10
+    const int itemCount = 1001;
+    m_renderArray.resize(itemCount);
+    for (int i = 0; i < itemCount; i++) {
+        m_renderArray.setTranslation(i, QVector3D(float(i - itemCount / 2) / 50.0f, 0.0f, 0.0f));
+        m_renderArray.setVisible(i, true);
+    }
+    m_octree.build(m_renderArray);
+}
+
+void tst_octree::cleanup()
+{
+    m_octree.clear();
+    m_renderArray.clear();
+}
+
+void tst_octree::selectVisible()
+{
+    QMatrix4x4 view;
+    view.ortho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+
+    QVector<int> indices;
+    QVERIFY(m_octree.selectVisible(view, 0.0f, indices));
+
+    // Every item in the view is selected, items far outside it are not
+    QSet<int> selected;
+    foreach (int index, indices) {
+        QVERIFY(!selected.contains(index));
+        selected.insert(index);
+    }
+    for (int i = 0; i < m_renderArray.size(); i++) {
+        const float x = m_renderArray.translation(i).x();
+        if (qAbs(x) <= 1.0f)
+            QVERIFY(selected.contains(i));
+        else if (qAbs(x) > 3.0f)
+            QVERIFY(!selected.contains(i));
+    }
+
+    // Items just outside the view are selected when they are within the margin
+    QMatrix4x4 shiftedView;
+    shiftedView.ortho(10.5f, 12.5f, -1.0f, 1.0f, -1.0f, 1.0f);
+    QVERIFY(m_octree.selectVisible(shiftedView, 0.0f, indices));
+    QVERIFY(indices.isEmpty());
+    QVERIFY(m_octree.selectVisible(shiftedView, 1.0f, indices));
+    QVERIFY(indices.contains(m_renderArray.size() - 1));
+}
+
+void tst_octree::selectVisibleWholeTree()
+{
+    QMatrix4x4 view;
+    view.ortho(-20.0f, 20.0f, -20.0f, 20.0f, -20.0f, 20.0f);
+
+    // No subset is needed when everything is in the view
+    QVector<int> indices;
+    QVERIFY(!m_octree.selectVisible(view, 0.0f, indices));
+    QVERIFY(indices.isEmpty());
+}
+
+void tst_octree::selectVisibleLightView()
+{
+    // Shadow casters are culled against the view of the light, which can contain items that
+    // are outside the view of the camera
+    QMatrix4x4 cameraView;
+    cameraView.ortho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+    QMatrix4x4 lightView;
+    lightView.ortho(-5.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+
+    QVector<int> cameraIndices;
+    QVector<int> lightIndices;
+    QVERIFY(m_octree.selectVisible(cameraView, 0.0f, cameraIndices));
+    QVERIFY(m_octree.selectVisible(lightView, 0.0f, lightIndices));
+
+    // Item at x = -4 casts a shadow but is not drawn
+    const int casterIndex = m_renderArray.size() / 2 - 200;
+    QCOMPARE(m_renderArray.translation(casterIndex).x(), -4.0f);
+    QVERIFY(!cameraIndices.contains(casterIndex));
+    QVERIFY(lightIndices.contains(casterIndex));
+}
+
+void tst_octree::pick()
+{
+    const QVector3D origin(0.0f, 0.0f, 10.0f);
+    const QVector3D direction(0.0f, 0.0f, -1.0f);
+    const int centerIndex = m_renderArray.size() / 2;
+
+    float distance;
+    QCOMPARE(m_octree.pick(m_renderArray, origin, direction, 0.005f, distance), centerIndex);
+    QCOMPARE(distance, 9.995f);
+
+    // Rays between the items miss them
+    QCOMPARE(m_octree.pick(m_renderArray, origin + QVector3D(0.01f, 0.0f, 0.0f), direction,
+                           0.005f, distance), -1);
+}
+
+void tst_octree::pickDrawn()
+{
+    // Items that are not drawn, such as the ones left out of a level of detail subset, can't
+    // be picked
+    const QVector3D origin(0.0f, 0.0f, 10.0f);
+    const QVector3D direction(0.0f, 0.0f, -1.0f);
+    const int centerIndex = m_renderArray.size() / 2;
+
+    QVector<uchar> drawn(m_renderArray.size(), 1);
+    drawn[centerIndex] = 0;
+    float distance;
+    QCOMPARE(m_octree.pick(m_renderArray, origin, direction, 0.005f, distance,
+                           drawn.constData()), -1);
+
+    // A larger radius reaches the neighbor that is drawn
+    drawn.fill(0);
+    drawn[centerIndex + 1] = 1;
+    QCOMPARE(m_octree.pick(m_renderArray, origin, direction, 0.05f, distance,
+                           drawn.constData()), centerIndex + 1);
+}
+
+QTEST_MAIN(tst_octree)
+#include "tst_octree.moc"
@@ -48,6 +48,9 @@ private slots:
     void initialProperties();
     void initializeProperties();
 
+    void externalBuffer();
+    void ringBuffer();
+
 private:
     QScatterDataProxy *m_proxy;
 };
@@ -98,5 +101,61 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->itemCount(), 2);
 }
 
+void tst_proxy::externalBuffer()
+{
+    QVERIFY(m_proxy);
+
+    // Positions with an extra padding float per item
+    float buffer[] = { 0.5f, 0.5f, 0.5f, 0.0f, -0.3f, -0.5f, -0.4f, 0.0f };
+    m_proxy->setExternalBuffer(buffer, 2, 4);
+
+    QVERIFY(m_proxy->hasExternalBuffer());
+    QCOMPARE(m_proxy->itemCount(), 2);
+    QCOMPARE(m_proxy->array()->size(), 0);
+    QCOMPARE(m_proxy->itemAt(1)->position(), QVector3D(-0.3f, -0.5f, -0.4f));
+    QVERIFY(m_proxy->itemAt(1)->rotation().isIdentity());
+
+    QSignalSpy changedSpy(m_proxy, &QScatterDataProxy::itemsChanged);
+    buffer[4] = 1.0f;
+    m_proxy->invalidateExternalBuffer(1, 5);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.at(0).at(1).toInt(), 1);
+    QCOMPARE(m_proxy->itemAt(1)->x(), 1.0f);
+
+    m_proxy->releaseExternalBuffer();
+    QVERIFY(!m_proxy->hasExternalBuffer());
+    QCOMPARE(m_proxy->itemCount(), 0);
+}
+
+void tst_proxy::ringBuffer()
+{
+    QVERIFY(m_proxy);
+
+    m_proxy->setRingBufferCapacity(3);
+    QCOMPARE(m_proxy->ringBufferCapacity(), 3);
+
+    QSignalSpy addedSpy(m_proxy, &QScatterDataProxy::itemsAdded);
+    QSignalSpy changedSpy(m_proxy, &QScatterDataProxy::itemsChanged);
+
+    QScatterDataArray data;
+    data << QVector3D(0.0f, 0.0f, 0.0f) << QVector3D(1.0f, 1.0f, 1.0f);
+    QCOMPARE(m_proxy->addItems(data), 0);
+    QCOMPARE(addedSpy.count(), 1);
+
+    // Fills the last free slot and overwrites the oldest item
+    data.clear();
+    data << QVector3D(2.0f, 2.0f, 2.0f) << QVector3D(3.0f, 3.0f, 3.0f);
+    QCOMPARE(m_proxy->addItems(data), 2);
+    QCOMPARE(m_proxy->itemCount(), 3);
+    QCOMPARE(addedSpy.count(), 2);
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(m_proxy->itemAt(0)->x(), 3.0f);
+
+    // Disabling the ring buffer moves the oldest item first
+    m_proxy->setRingBufferCapacity(0);
+    QCOMPARE(m_proxy->itemAt(0)->x(), 1.0f);
+    QCOMPARE(m_proxy->itemAt(2)->x(), 3.0f);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
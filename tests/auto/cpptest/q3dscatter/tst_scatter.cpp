@@ -107,6 +107,7 @@ void tst_scatter::initialProperties()
     QVERIFY(m_graph);
     QCOMPARE(m_graph->seriesList().length(), 0);
     QVERIFY(!m_graph->selectedSeries());
+    QCOMPARE(m_graph->pointBudget(), 0);
     QCOMPARE(m_graph->axisX()->orientation(), QAbstract3DAxis::AxisOrientationX);
     QCOMPARE(m_graph->axisY()->orientation(), QAbstract3DAxis::AxisOrientationY);
     QCOMPARE(m_graph->axisZ()->orientation(), QAbstract3DAxis::AxisOrientationZ);
@@ -164,6 +165,14 @@ void tst_scatter::initializeProperties()
     QCOMPARE(m_graph->reflectivity(), 0.1);
     QCOMPARE(m_graph->locale(), QLocale("FI"));
     QCOMPARE(m_graph->margin(), 1.0);
+
+    m_graph->setOptimizationHints(QAbstract3DGraph::OptimizationStatic
+                                  | QAbstract3DGraph::OptimizationCpuPicking);
+    QVERIFY(m_graph->optimizationHints().testFlag(QAbstract3DGraph::OptimizationStatic));
+    QVERIFY(m_graph->optimizationHints().testFlag(QAbstract3DGraph::OptimizationCpuPicking));
+
+    m_graph->setPointBudget(100000);
+    QCOMPARE(m_graph->pointBudget(), 100000);
 }
 
 void tst_scatter::invalidProperties()
@@ -179,6 +188,9 @@ void tst_scatter::invalidProperties()
     QCOMPARE(m_graph->horizontalAspectRatio(), -1.0/*0.0*/); // TODO: Fix once QTRD-3367 is done
     QCOMPARE(m_graph->reflectivity(), -1.0/*0.5*/); // TODO: Fix once QTRD-3367 is done
     QCOMPARE(m_graph->locale(), QLocale("C"));
+
+    m_graph->setPointBudget(-1);
+    QCOMPARE(m_graph->pointBudget(), 0);
 }
 
 void tst_scatter::addSeries()
@@ -49,6 +49,9 @@ private slots:
     void initializeProperties();
     void invalidProperties();
 
+    void rawHeightMapFile();
+    void concurrentResolves();
+
 private:
     QHeightMapSurfaceDataProxy *m_proxy;
 };
@@ -165,5 +168,77 @@ void tst_proxy::invalidProperties()
     QCOMPARE(m_proxy->minZValue(), 10.0f);
 }
 
+void tst_proxy::rawHeightMapFile()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const float heights[] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+    file.write(reinterpret_cast<const char *>(heights), sizeof(heights));
+    file.close();
+
+    m_proxy->setRawHeightMapFile(file.fileName(), 3,
+                                 QHeightMapSurfaceDataProxy::RawHeightFloat32);
+
+    QCoreApplication::processEvents();
+
+    QCOMPARE(m_proxy->columnCount(), 3);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QVERIFY(m_proxy->heightArray());
+    // The first row of the file has the maximum Z value
+    QCOMPARE(m_proxy->itemAt(0, 0)->y(), 4.0f);
+    QCOMPARE(m_proxy->itemAt(1, 2)->y(), 3.0f);
+    QCOMPARE(m_proxy->itemAt(1, 2)->x(), 10.0f);
+    QCOMPARE(m_proxy->itemAt(1, 2)->z(), 10.0f);
+
+    // Changing the value ranges only rescales the resolved heights
+    m_proxy->setValueRanges(0.0f, 20.0f, -5.0f, 5.0f);
+
+    QCoreApplication::processEvents();
+
+    QCOMPARE(m_proxy->itemAt(1, 2)->y(), 3.0f);
+    QCOMPARE(m_proxy->itemAt(1, 2)->x(), 20.0f);
+    QCOMPARE(m_proxy->itemAt(1, 2)->z(), 5.0f);
+}
+
+void tst_proxy::concurrentResolves()
+{
+    // Large maps are resolved in the thread pool, and each resolve splits the conversion into
+    // more pool tasks. This must not deadlock when resolves occupy every pool thread.
+    const int columns = 1024;
+    const int rows = 1024;
+    QVector<float> heights(columns * rows, 1.0f);
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(reinterpret_cast<const char *>(heights.constData()),
+               heights.size() * int(sizeof(float)));
+    file.close();
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int maxThreadCount = pool->maxThreadCount();
+    pool->setMaxThreadCount(1);
+
+    QList<QHeightMapSurfaceDataProxy *> proxies;
+    for (int i = 0; i < 3; i++) {
+        QHeightMapSurfaceDataProxy *proxy = new QHeightMapSurfaceDataProxy;
+        proxy->setRawHeightMapFile(file.fileName(), columns,
+                                   QHeightMapSurfaceDataProxy::RawHeightFloat32);
+        proxies.append(proxy);
+    }
+    foreach (QHeightMapSurfaceDataProxy *proxy, proxies) {
+        QTRY_COMPARE_WITH_TIMEOUT(proxy->rowCount(), rows, 10000);
+        QCOMPARE(proxy->columnCount(), columns);
+    }
+
+    // A proxy deleted while resolving waits for the resolve to finish
+    QHeightMapSurfaceDataProxy *proxy = new QHeightMapSurfaceDataProxy;
+    proxy->setRawHeightMapFile(file.fileName(), columns,
+                               QHeightMapSurfaceDataProxy::RawHeightFloat32);
+    QCoreApplication::processEvents();
+    proxies.append(proxy);
+    qDeleteAll(proxies);
+
+    pool->setMaxThreadCount(maxThreadCount);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
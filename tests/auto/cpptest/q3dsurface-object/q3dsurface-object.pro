@@ -0,0 +1,16 @@
+QT += testlib datavisualization
+
+TARGET = tst_cpptest
+CONFIG += console testcase
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../../../src/datavisualization/engine \
+               ../../../../src/datavisualization/global \
+               ../../../../src/datavisualization/data \
+               ../../../../src/datavisualization/theme \
+               ../../../../src/datavisualization/axis \
+               ../../../../src/datavisualization/input \
+               ../../../../src/datavisualization/utils
+
+SOURCES += tst_object.cpp
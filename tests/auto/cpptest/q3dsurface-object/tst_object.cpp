@@ -0,0 +1,452 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Data Visualization module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtDataVisualization/QValue3DAxis>
+#include <QtDataVisualization/QValue3DAxisFormatter>
+
+#include "surfaceobject_p.h"
+#include "surfaceminmaxmipmap_p.h"
+#include "axisrendercache_p.h"
+
+using namespace QtDataVisualization;
+
+// Makes the copy of an axis formatter that the renderer keeps in its axis caches
+class CopyableFormatter : public QValue3DAxisFormatter
+{
+public:
+    QValue3DAxisFormatter *copy() const
+    {
+        QValue3DAxisFormatter *formatter = createNewInstance();
+        populateCopy(*formatter);
+        return formatter;
+    }
+};
+
+class tst_object: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void detailLevels();
+    void detailStitching();
+    void detailToggle();
+    void mipmapPick();
+
+    void bandBenchmark_data();
+    void bandBenchmark();
+
+private:
+    static void setUpAxis(AxisRenderCache &cache, QValue3DAxis &axis, float max);
+    static SurfaceHeightGrid createGrid(int columns, int rows);
+    void setUpDetailSurface(SurfaceObject &object, const SurfaceHeightGrid &grid, int rows);
+    static int tileStepAt(const QVector<SurfaceObject::DetailTile> &tiles, int column, int row);
+    static QVector<int> tileLine(int start, int last, int step);
+    static bool selectMixedLevels(SurfaceObject &object);
+
+    QOffscreenSurface *m_surface;
+    QOpenGLContext *m_context;
+    QValue3DAxis m_axisX;
+    QValue3DAxis m_axisY;
+    QValue3DAxis m_axisZ;
+    AxisRenderCache *m_axisCacheX;
+    AxisRenderCache *m_axisCacheY;
+    AxisRenderCache *m_axisCacheZ;
+};
+
+void tst_object::initTestCase()
+{
+    m_surface = new QOffscreenSurface;
+    m_surface->create();
+    m_context = new QOpenGLContext;
+    m_context->create();
+    m_axisCacheX = 0;
+    m_axisCacheY = 0;
+    m_axisCacheZ = 0;
+}
+
+void tst_object::cleanupTestCase()
+{
+    delete m_context;
+    delete m_surface;
+}
+
+void tst_object::init()
+{
+    if (!m_context->makeCurrent(m_surface))
+        QSKIP("No OpenGL context");
+    m_axisCacheX = new AxisRenderCache;
+    m_axisCacheY = new AxisRenderCache;
+    m_axisCacheZ = new AxisRenderCache;
+}
+
+void tst_object::cleanup()
+{
+    delete m_axisCacheX;
+    delete m_axisCacheY;
+    delete m_axisCacheZ;
+    m_axisCacheX = 0;
+    m_axisCacheY = 0;
+    m_axisCacheZ = 0;
+    m_context->doneCurrent();
+}
+
+// Maps the axis range [0, max] to [-1, 1], the way the renderer sets up its axis caches
+void tst_object::setUpAxis(AxisRenderCache &cache, QValue3DAxis &axis, float max)
+{
+    CopyableFormatter *formatter = new CopyableFormatter;
+    axis.setFormatter(formatter);
+    axis.setRange(0.0f, max);
+    axis.labels(); // Recalculates the formatter
+    cache.setFormatter(formatter->copy());
+    cache.setMin(0.0f);
+    cache.setMax(max);
+    cache.setScale(2.0f);
+    cache.setTranslate(-1.0f);
+}
+
+// Grid of wavy heights between 0 and 1, with unit steps between the columns and rows
+SurfaceHeightGrid tst_object::createGrid(int columns, int rows)
+{
+    SurfaceHeightGrid grid;
+    grid.columnCount = columns;
+    grid.heights.resize(columns * rows);
+    for (int i = 0; i < grid.heights.size(); i++) {
+        grid.heights[i] = 0.5f + 0.5f * qSin(float(i % columns) * 0.05f)
+                * qCos(float(i / columns) * 0.05f);
+    }
+    return grid;
+}
+
+// Sets up a smooth surface large enough for detail tiles, with level of detail enabled
+void tst_object::setUpDetailSurface(SurfaceObject &object, const SurfaceHeightGrid &grid,
+                                    int rows)
+{
+    const int columns = grid.columnCount;
+    setUpAxis(*m_axisCacheX, m_axisX, float(columns - 1));
+    setUpAxis(*m_axisCacheY, m_axisY, 1.0f);
+    setUpAxis(*m_axisCacheZ, m_axisZ, float(rows - 1));
+    object.setLevelOfDetail(true);
+    object.setUpSmoothData(SurfaceDataView(grid), QRect(0, 0, columns, rows), true, false);
+}
+
+// Returns the step of the selected tile that covers the cell at column and row, or 0
+int tst_object::tileStepAt(const QVector<SurfaceObject::DetailTile> &tiles, int column, int row)
+{
+    foreach (const SurfaceObject::DetailTile &tile, tiles) {
+        const int size = 32 * tile.step;
+        if (column >= tile.column && column < tile.column + size
+                && row >= tile.row && row < tile.row + size) {
+            return tile.step;
+        }
+    }
+    return 0;
+}
+
+// Vertex positions a tile uses along one of its sides from start to last
+QVector<int> tst_object::tileLine(int start, int last, int step)
+{
+    QVector<int> positions;
+    for (int i = start; i < last; i += step)
+        positions.append(i);
+    positions.append(last);
+    return positions;
+}
+
+// Selects tiles of different levels for a perspective view from close above the first corner
+// of the surface. Returns false if no pixel scale gives different levels.
+bool tst_object::selectMixedLevels(SurfaceObject &object)
+{
+    const QVector3D eyePosition = object.vertexAt(0, 0) + QVector3D(0.0f, 0.2f, 0.0f);
+    for (float pixelsPerUnit = 1.0f; pixelsPerUnit <= 1.0e6f; pixelsPerUnit *= 10.0f) {
+        object.selectDetailLevels(eyePosition, pixelsPerUnit, true);
+        const QVector<SurfaceObject::DetailTile> tiles = object.selectedDetailTiles();
+        foreach (const SurfaceObject::DetailTile &tile, tiles) {
+            if (tile.step != tiles.first().step)
+                return true;
+        }
+    }
+    return false;
+}
+
+void tst_object::detailLevels()
+{
+    const int columns = 600;
+    const int rows = 530;
+    const SurfaceHeightGrid grid = createGrid(columns, rows);
+    SurfaceObject object(*m_axisCacheX, *m_axisCacheY, *m_axisCacheZ);
+    setUpDetailSurface(object, grid, rows);
+    QVERIFY(object.hasDetailLevels());
+
+    // The root covers 599 cells with 32 cells per side, and is drawn until the first selection
+    QVector<SurfaceObject::DetailTile> tiles = object.selectedDetailTiles();
+    QCOMPARE(tiles.size(), 1);
+    QCOMPARE(tiles.at(0).step, 32);
+
+    // Errors don't show from far away
+    object.selectDetailLevels(QVector3D(0.0f, 10.0f, 0.0f), 0.001f, false);
+    tiles = object.selectedDetailTiles();
+    QCOMPARE(tiles.size(), 1);
+    QCOMPARE(tiles.at(0).step, 32);
+    QVERIFY(object.stitchIndices().isEmpty());
+
+    // All errors show up close, so the full resolution leaves are drawn
+    object.selectDetailLevels(QVector3D(0.0f, 10.0f, 0.0f), 1.0e9f, false);
+    tiles = object.selectedDetailTiles();
+    QCOMPARE(tiles.size(), ((columns - 2) / 32 + 1) * ((rows - 2) / 32 + 1));
+    foreach (const SurfaceObject::DetailTile &tile, tiles)
+        QCOMPARE(tile.step, 1);
+    QVERIFY(object.stitchIndices().isEmpty());
+
+    // Tiles close to the eye are finer than the distant ones
+    QVERIFY(selectMixedLevels(object));
+    tiles = object.selectedDetailTiles();
+    QVERIFY(tileStepAt(tiles, 0, 0) < tileStepAt(tiles, columns - 2, rows - 2));
+
+    // The selected tiles cover each cell once
+    QVector<int> coverage((columns - 1) * (rows - 1));
+    foreach (const SurfaceObject::DetailTile &tile, tiles) {
+        const int lastColumn = qMin(tile.column + 32 * tile.step, columns - 1);
+        const int lastRow = qMin(tile.row + 32 * tile.step, rows - 1);
+        for (int i = tile.row; i < lastRow; i++) {
+            for (int j = tile.column; j < lastColumn; j++)
+                coverage[i * (columns - 1) + j]++;
+        }
+    }
+    QCOMPARE(coverage.count(1), coverage.size());
+}
+
+// The edges of the selected tiles and the stitching triangles must form a closed surface. Each
+// edge inside the surface is shared by exactly two of them, so the edge of a coarse tile next to
+// finer tiles is matched by the stitching triangles over the vertices of the finer tiles.
+void tst_object::detailStitching()
+{
+    const int columns = 600;
+    const int rows = 530;
+    const SurfaceHeightGrid grid = createGrid(columns, rows);
+    SurfaceObject object(*m_axisCacheX, *m_axisCacheY, *m_axisCacheZ);
+    setUpDetailSurface(object, grid, rows);
+    QVERIFY(selectMixedLevels(object));
+
+    const QVector<GLint> &stitchIndices = object.stitchIndices();
+    QVERIFY(!stitchIndices.isEmpty());
+    QCOMPARE(stitchIndices.size() % 3, 0);
+
+    QHash<QPair<int, int>, int> edgeCounts;
+    foreach (const SurfaceObject::DetailTile &tile, object.selectedDetailTiles()) {
+        const int lastColumn = qMin(tile.column + 32 * tile.step, columns - 1);
+        const int lastRow = qMin(tile.row + 32 * tile.step, rows - 1);
+        const QVector<int> alongRows = tileLine(tile.column, lastColumn, tile.step);
+        const QVector<int> alongColumns = tileLine(tile.row, lastRow, tile.step);
+        for (int i = 1; i < alongRows.size(); i++) {
+            edgeCounts[qMakePair(tile.row * columns + alongRows.at(i - 1),
+                                 tile.row * columns + alongRows.at(i))]++;
+            edgeCounts[qMakePair(lastRow * columns + alongRows.at(i - 1),
+                                 lastRow * columns + alongRows.at(i))]++;
+        }
+        for (int i = 1; i < alongColumns.size(); i++) {
+            edgeCounts[qMakePair(alongColumns.at(i - 1) * columns + tile.column,
+                                 alongColumns.at(i) * columns + tile.column)]++;
+            edgeCounts[qMakePair(alongColumns.at(i - 1) * columns + lastColumn,
+                                 alongColumns.at(i) * columns + lastColumn)]++;
+        }
+    }
+    for (int i = 0; i < stitchIndices.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            const int a = stitchIndices.at(i + k);
+            const int b = stitchIndices.at(i + (k + 1) % 3);
+            QVERIFY(a != b);
+            edgeCounts[qMakePair(qMin(a, b), qMax(a, b))]++;
+        }
+    }
+
+    QHashIterator<QPair<int, int>, int> it(edgeCounts);
+    while (it.hasNext()) {
+        it.next();
+        const int a = it.key().first;
+        const int b = it.key().second;
+        const bool border = (a / columns == b / columns
+                             && (a / columns == 0 || a / columns == rows - 1))
+                || (a % columns == b % columns
+                    && (a % columns == 0 || a % columns == columns - 1));
+        if (it.value() != (border ? 1 : 2)) {
+            QFAIL(qPrintable(QStringLiteral("Edge from %1, %2 to %3, %4 is used %5 times")
+                             .arg(a % columns).arg(a / columns)
+                             .arg(b % columns).arg(b / columns).arg(it.value())));
+        }
+    }
+}
+
+// Toggling level of detail creates or drops the tiles when the surface is set up again, and
+// scrolling is refused in between so that the old tiles aren't kept
+void tst_object::detailToggle()
+{
+    const int columns = 600;
+    const int rows = 530;
+    const SurfaceHeightGrid grid = createGrid(columns, rows);
+    const SurfaceDataView view(grid);
+    const QRect space(0, 0, columns, rows);
+    SurfaceObject object(*m_axisCacheX, *m_axisCacheY, *m_axisCacheZ);
+    setUpDetailSurface(object, grid, rows);
+    QVERIFY(selectMixedLevels(object));
+
+    object.setLevelOfDetail(false);
+    object.setUpSmoothData(view, space, false, false);
+    QVERIFY(!object.hasDetailLevels());
+    QVERIFY(object.selectedDetailTiles().isEmpty());
+    QVERIFY(object.stitchIndices().isEmpty());
+    QCOMPARE(object.indexCount(), GLuint(6 * (columns - 1) * (rows - 1)));
+
+    object.setLevelOfDetail(true);
+    QVERIFY(!object.scrollSmoothRows(view, 1));
+    object.setUpSmoothData(view, space, false, false);
+    QVERIFY(object.hasDetailLevels());
+    QCOMPARE(object.selectedDetailTiles().size(), 1);
+
+    // Small surfaces are always drawn at full resolution
+    const QRect smallSpace(0, 0, 100, 100);
+    const SurfaceDataView smallView(grid, smallSpace);
+    object.setUpSmoothData(smallView, smallSpace, true, false);
+    QVERIFY(!object.hasDetailLevels());
+    QVERIFY(object.scrollSmoothRows(smallView, 1));
+}
+
+void tst_object::mipmapPick()
+{
+    const int columns = 100;
+    const int rows = 80;
+    const SurfaceHeightGrid grid = createGrid(columns, rows);
+    setUpAxis(*m_axisCacheX, m_axisX, float(columns - 1));
+    setUpAxis(*m_axisCacheY, m_axisY, 1.0f);
+    setUpAxis(*m_axisCacheZ, m_axisZ, float(rows - 1));
+    SurfaceObject object(*m_axisCacheX, *m_axisCacheY, *m_axisCacheZ);
+    object.setUpSmoothData(SurfaceDataView(grid), QRect(0, 0, columns, rows), true, false);
+
+    SurfaceMinMaxMipmap mipmap;
+    QVERIFY(mipmap.isEmpty());
+    mipmap.build(&object, columns, rows);
+    QVERIFY(!mipmap.isEmpty());
+
+    const QVector3D down(0.0f, -1.0f, 0.0f);
+    const QVector3D up(0.0f, 1.0f, 0.0f);
+    const QVector3D vertex = object.vertexAt(37, 21);
+    QPoint position;
+    float distance = 0.0f;
+
+    // Straight down at a vertex
+    QVERIFY(mipmap.pick(&object, vertex + 2.0f * up, down, position, distance));
+    QCOMPARE(position, QPoint(21, 37));
+    QVERIFY(qAbs(distance - 2.0f) < 1.0e-4f);
+
+    // Straight up from below the surface
+    QVERIFY(mipmap.pick(&object, vertex + 3.0f * down, up, position, distance));
+    QCOMPARE(position, QPoint(21, 37));
+    QVERIFY(qAbs(distance - 3.0f) < 1.0e-4f);
+
+    // Between two vertices, closer to the first one
+    const QVector3D between = 0.7f * vertex + 0.3f * object.vertexAt(38, 21);
+    QVERIFY(mipmap.pick(&object, between + 2.0f * up, down, position, distance));
+    QCOMPARE(position, QPoint(21, 37));
+
+    // Oblique ray through the vertex, which is hit first from above
+    const QVector3D direction = QVector3D(1.0f, -4.0f, 0.5f).normalized();
+    QVERIFY(mipmap.pick(&object, vertex - 0.2f * direction, direction, position, distance));
+    QCOMPARE(position, QPoint(21, 37));
+    QVERIFY(qAbs(distance - 0.2f) < 1.0e-4f);
+
+    // Misses beside the surface and away from it
+    QVERIFY(!mipmap.pick(&object, QVector3D(1.5f, 2.0f, 0.0f), down, position, distance));
+    QCOMPARE(position, QPoint(-1, -1));
+    QVERIFY(!mipmap.pick(&object, vertex + 2.0f * up, up, position, distance));
+
+    mipmap.clear();
+    QVERIFY(mipmap.isEmpty());
+    QVERIFY(!mipmap.pick(&object, vertex + 2.0f * up, down, position, distance));
+}
+
+void tst_object::bandBenchmark_data()
+{
+    QTest::addColumn<bool>("flat");
+
+    QTest::newRow("smooth") << false;
+    QTest::newRow("flat") << true;
+}
+
+// Reports the time the vertex and normal bands of a surface rebuild take in milliseconds per
+// million vertices. Rebuilds that keep the geometry only run the bands and stage the buffers,
+// and the staged buffers are uploaded outside the measured time.
+void tst_object::bandBenchmark()
+{
+    if (!qEnvironmentVariableIsSet("QTDATAVIS_BENCHMARK"))
+        QSKIP("Set QTDATAVIS_BENCHMARK to run the band benchmark");
+
+    QFETCH(bool, flat);
+
+    const int size = 1024;
+    const int iterations = 10;
+    const SurfaceHeightGrid grid = createGrid(size, size);
+    const SurfaceDataView view(grid);
+    const QRect space(0, 0, size, size);
+    setUpAxis(*m_axisCacheX, m_axisX, float(size - 1));
+    setUpAxis(*m_axisCacheY, m_axisY, 1.0f);
+    setUpAxis(*m_axisCacheZ, m_axisZ, float(size - 1));
+
+    SurfaceObject object(*m_axisCacheX, *m_axisCacheY, *m_axisCacheZ);
+    if (flat)
+        object.setUpData(view, space, true, false);
+    else
+        object.setUpSmoothData(view, space, true, false);
+
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    for (int i = 0; i < iterations; i++) {
+        timer.start();
+        if (flat)
+            object.setUpData(view, space, false, false);
+        else
+            object.setUpSmoothData(view, space, false, false);
+        elapsed += timer.nsecsElapsed();
+        QVERIFY(object.hasPendingUpload());
+        object.finishPendingUpload();
+    }
+
+    const qreal vertexMillions = qreal(size) * qreal(size) / 1000000.0;
+    QTest::setBenchmarkResult(qreal(elapsed) / 1000000.0 / (iterations * vertexMillions),
+                              QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(tst_object)
+#include "tst_object.moc"
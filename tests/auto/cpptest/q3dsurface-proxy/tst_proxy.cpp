@@ -47,6 +47,8 @@ private slots:
 
     void initialProperties();
     void initializeProperties();
+    void initializeHeightArray();
+    void shiftRows();
 
 private:
     QSurfaceDataProxy *m_proxy;
@@ -105,5 +107,68 @@ void tst_proxy::initializeProperties()
     QCOMPARE(m_proxy->rowCount(), 2);
 }
 
+void tst_proxy::initializeHeightArray()
+{
+    QVERIFY(m_proxy);
+
+    QVector<float> heights;
+    heights << 0.1f << 0.5f << 0.3f << 1.8f << 1.2f << 0.7f;
+
+    m_proxy->resetHeightArray(heights, 3, 1.0f, 2.0f, 0.5f, 0.25f);
+
+    QCOMPARE(m_proxy->columnCount(), 3);
+    QCOMPARE(m_proxy->rowCount(), 2);
+    QVERIFY(m_proxy->heightArray());
+    QCOMPARE(*m_proxy->heightArray(), heights);
+    QCOMPARE(m_proxy->itemAt(1, 2)->position(), QVector3D(2.0f, 0.7f, 2.25f));
+    // Items are not created for the whole grid when reading it
+    QVERIFY(m_proxy->array()->isEmpty());
+
+    // Heights that don't fill the rows are ignored
+    QSignalSpy resetSpy(m_proxy, &QSurfaceDataProxy::arrayReset);
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression(QStringLiteral("multiple of the column count")));
+    m_proxy->resetHeightArray(heights, 4, 1.0f, 2.0f, 0.5f, 0.25f);
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression(QStringLiteral("multiple of the column count")));
+    m_proxy->resetHeightArray(heights, 0, 1.0f, 2.0f, 0.5f, 0.25f);
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(m_proxy->columnCount(), 3);
+    QCOMPARE(*m_proxy->heightArray(), heights);
+
+    // Modifying the items converts the height array
+    m_proxy->setItem(0, 0, QSurfaceDataItem(QVector3D(1.0f, 0.2f, 2.0f)));
+    QVERIFY(!m_proxy->heightArray());
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(m_proxy->array()->size(), 2);
+    QCOMPARE(m_proxy->columnCount(), 3);
+    QCOMPARE(m_proxy->itemAt(0, 0)->y(), 0.2f);
+    QCOMPARE(m_proxy->itemAt(1, 1)->y(), 1.2f);
+}
+
+void tst_proxy::shiftRows()
+{
+    QVERIFY(m_proxy);
+
+    QSurfaceDataArray *data = new QSurfaceDataArray;
+    for (int i = 0; i < 3; i++) {
+        QSurfaceDataRow *dataRow = new QSurfaceDataRow;
+        *dataRow << QVector3D(0.0f, 0.1f, float(i)) << QVector3D(1.0f, 0.5f, float(i));
+        *data << dataRow;
+    }
+    m_proxy->resetArray(data);
+
+    QSignalSpy spy(m_proxy, &QSurfaceDataProxy::rowsShifted);
+    QSurfaceDataRow *newRow = new QSurfaceDataRow;
+    *newRow << QVector3D(0.0f, 1.8f, 3.0f) << QVector3D(1.0f, 1.2f, 3.0f);
+    m_proxy->shiftRow(newRow);
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toInt(), 1);
+    QCOMPARE(m_proxy->rowCount(), 3);
+    QCOMPARE(m_proxy->itemAt(0, 0)->z(), 1.0f);
+    QCOMPARE(m_proxy->itemAt(2, 1)->y(), 1.2f);
+}
+
 QTEST_MAIN(tst_proxy)
 #include "tst_proxy.moc"
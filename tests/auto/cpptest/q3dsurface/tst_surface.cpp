@@ -54,6 +54,7 @@ private slots:
     void addSeries();
     void addMultipleSeries();
     void selectSeries();
+    void shiftSelectedRow();
     void removeSeries();
     void removeMultipleSeries();
 
@@ -174,6 +175,12 @@ void tst_surface::initializeProperties()
     QCOMPARE(m_graph->reflectivity(), 0.1);
     QCOMPARE(m_graph->locale(), QLocale("FI"));
     QCOMPARE(m_graph->margin(), 1.0);
+
+    m_graph->setOptimizationHints(QAbstract3DGraph::OptimizationGpuSurface);
+    QCOMPARE(m_graph->optimizationHints(), QAbstract3DGraph::OptimizationGpuSurface);
+    m_graph->setOptimizationHints(QAbstract3DGraph::OptimizationGpuSurface
+                                  | QAbstract3DGraph::OptimizationLevelOfDetail);
+    QVERIFY(m_graph->optimizationHints().testFlag(QAbstract3DGraph::OptimizationLevelOfDetail));
 }
 
 void tst_surface::invalidProperties()
@@ -226,6 +233,29 @@ void tst_surface::selectSeries()
     QVERIFY(!m_graph->selectedSeries());
 }
 
+void tst_surface::shiftSelectedRow()
+{
+    QSurface3DSeries *series = newSeries();
+
+    m_graph->addSeries(series);
+    series->setSelectedPoint(QPoint(1, 1));
+    QCOMPARE(m_graph->selectedSeries(), series);
+
+    // The selection moves down with its row
+    QSurfaceDataRow *dataRow = new QSurfaceDataRow;
+    *dataRow << QVector3D(0.0f, 0.4f, 1.5f) << QVector3D(1.0f, 0.6f, 1.5f);
+    series->dataProxy()->shiftRow(dataRow);
+    QCOMPARE(series->selectedPoint(), QPoint(0, 1));
+    QCOMPARE(m_graph->selectedSeries(), series);
+
+    // The selection is cleared when its row is shifted out
+    dataRow = new QSurfaceDataRow;
+    *dataRow << QVector3D(0.0f, 0.9f, 2.0f) << QVector3D(1.0f, 0.3f, 2.0f);
+    series->dataProxy()->shiftRow(dataRow);
+    QCOMPARE(series->selectedPoint(), QSurface3DSeries::invalidSelectionPosition());
+    QVERIFY(!m_graph->selectedSeries());
+}
+
 void tst_surface::removeSeries()
 {
     QSurface3DSeries *series = newSeries();